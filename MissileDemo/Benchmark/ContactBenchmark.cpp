@@ -0,0 +1,280 @@
+/********************************************************************
+ * File   : ContactBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Scalar vs. wide (SIMD) contact solver on a pile-up.
+ *
+ * Swarm missiles start on rings around the origin and
+ * are all told to seek it, so after a few seconds they
+ * are jammed into one dense pile with most of them
+ * touching several others.  The same run is made with
+ * the world's scalar contact solver and with the wide
+ * one (see b2WideContactSolver).
+ *
+ * Reported for each are the velocity solver time (from
+ * the world's b2Profile), the number of touching
+ * contacts at the end, the mean and max penetration over
+ * every touching contact on every tick, and the state
+ * checksum.  The wide solver is run again with a
+ * different thread count; its checksum must not change.
+ *
+ * The scalar and wide checksums are not expected to
+ * match: the wide solver goes through the contacts a
+ * color at a time, not in island order, and the pile is
+ * chaotic, so the two runs soon end up as different
+ * piles.  The penetration of any one tick can differ a
+ * lot between them.  Over the whole run, the wide mean
+ * must be within MEAN_PENETRATION_TOLERANCE of the scalar
+ * mean and the wide max within MAX_PENETRATION_TOLERANCE
+ * (the max is a single contact, so it is noisier).  From
+ * 300 to 2000 missiles the mean is within 10% and the
+ * max within 20%, deeper or shallower.
+ *
+ * Usage:
+ *    contact_benchmark [missiles] [ticks] [threads]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Simulation.h"
+#include "MissileSwarm.h"
+#include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
+#include <cstdlib>
+#include <cstring>
+
+const float32 RING_SPACING = 8.0;
+// How much deeper (as a fraction) the wide solver's
+// penetration may be than the scalar solver's.
+const double MEAN_PENETRATION_TOLERANCE = 0.10;
+const double MAX_PENETRATION_TOLERANCE = 0.25;
+
+// FNV-1a over the raw bits of the body states.
+static void HashBytes(uint64& hash, const void* data, uint32 size)
+{
+   const uint8* bytes = (const uint8*)data;
+   for(uint32 idx = 0; idx < size; idx++)
+   {
+      hash ^= bytes[idx];
+      hash *= 1099511628211ull;
+   }
+}
+
+static uint64 StateChecksum(b2World& world)
+{
+   uint64 hash = 14695981039346656037ull;
+   for(const b2Body* body = world.GetBodyList(); body != NULL; body = body->GetNext())
+   {
+      Vec2 position = body->GetPosition();
+      Vec2 velocity = body->GetLinearVelocity();
+      float32 angle = body->GetAngle();
+      float32 angularVelocity = body->GetAngularVelocity();
+      HashBytes(hash,&position,sizeof(position));
+      HashBytes(hash,&velocity,sizeof(velocity));
+      HashBytes(hash,&angle,sizeof(angle));
+      HashBytes(hash,&angularVelocity,sizeof(angularVelocity));
+   }
+   return hash;
+}
+
+// The separation of each manifold point, the same way
+// the position solver works it out (negative is overlap).
+static float32 DeepestSeparation(const b2Contact* contact)
+{
+   const b2Manifold* manifold = contact->GetManifold();
+   const b2Fixture* fixtureA = contact->GetFixtureA();
+   const b2Fixture* fixtureB = contact->GetFixtureB();
+   const b2Transform& xfA = fixtureA->GetBody()->GetTransform();
+   const b2Transform& xfB = fixtureB->GetBody()->GetTransform();
+   float32 radius = fixtureA->GetShape()->m_radius + fixtureB->GetShape()->m_radius;
+   float32 deepest = 0;
+   for(int32 idx = 0; idx < manifold->pointCount; idx++)
+   {
+      float32 separation = 0;
+      switch(manifold->type)
+      {
+         case b2Manifold::e_circles:
+         {
+            Vec2 pointA = b2Mul(xfA,manifold->localPoint);
+            Vec2 pointB = b2Mul(xfB,manifold->points[0].localPoint);
+            separation = b2Distance(pointA,pointB) - radius;
+         }
+            break;
+         case b2Manifold::e_faceA:
+         {
+            Vec2 normal = b2Mul(xfA.q,manifold->localNormal);
+            Vec2 planePoint = b2Mul(xfA,manifold->localPoint);
+            Vec2 clipPoint = b2Mul(xfB,manifold->points[idx].localPoint);
+            separation = b2Dot(clipPoint - planePoint,normal) - radius;
+         }
+            break;
+         case b2Manifold::e_faceB:
+         {
+            Vec2 normal = b2Mul(xfB.q,manifold->localNormal);
+            Vec2 planePoint = b2Mul(xfB,manifold->localPoint);
+            Vec2 clipPoint = b2Mul(xfA,manifold->points[idx].localPoint);
+            separation = b2Dot(clipPoint - planePoint,normal) - radius;
+         }
+            break;
+      }
+      deepest = min(deepest,separation);
+   }
+   return deepest;
+}
+
+typedef struct
+{
+   double velocityMs;
+   double stepMs;
+   // Touching contacts at the end.
+   uint32 touching;
+   // Over every touching contact on every tick.
+   double meanPenetration;
+   float32 maxPenetration;
+   uint64 checksum;
+} RUN_RESULT_T;
+
+static RUN_RESULT_T RunPileUp(b2ContactSolverType solverType, uint32 missiles, uint32 ticks, uint32 threads)
+{
+   Simulation sim;
+   sim.SetThreadCount(threads);
+   sim.Init(solverType);
+   MissileSwarm& swarm = sim.GetSwarm();
+   swarm.Reserve(missiles);
+   
+   // Rings of missiles, spaced out so none start out
+   // overlapping, all seeking the middle.
+   uint32 ring = 1;
+   uint32 placed = 0;
+   while(placed < missiles)
+   {
+      float32 radius = RING_SPACING*ring;
+      uint32 count = (uint32)(2*M_PI*radius/RING_SPACING);
+      for(uint32 idx = 0; idx < count && placed < missiles; idx++, placed++)
+      {
+         float32 angle = 2*M_PI*idx/count;
+         uint32 missile = swarm.AddMissile(Vec2(radius*cosf(angle),radius*sinf(angle)));
+         swarm.CommandSeek(missile,Vec2(0,0));
+      }
+      ring++;
+   }
+   
+   RUN_RESULT_T result;
+   memset(&result,0,sizeof(result));
+   double contactTicks = 0;
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      sim.Update();
+      result.velocityMs += sim.GetProfile().solveVelocity;
+      result.stepMs += sim.GetProfile().step;
+      
+      result.touching = 0;
+      for(const b2Contact* contact = sim.GetWorld()->GetContactList(); contact != NULL; contact = contact->GetNext())
+      {
+         if(contact->IsTouching())
+         {
+            float32 penetration = -DeepestSeparation(contact);
+            result.touching++;
+            result.meanPenetration += penetration;
+            result.maxPenetration = max(result.maxPenetration,penetration);
+         }
+      }
+      contactTicks += result.touching;
+   }
+   result.velocityMs /= ticks;
+   result.stepMs /= ticks;
+   result.meanPenetration /= max(contactTicks,1.0);
+   result.checksum = StateChecksum(*sim.GetWorld());
+   return result;
+}
+
+static void PrintResult(const char* name, uint32 threads, const RUN_RESULT_T& result)
+{
+   printf("   %-8s %8u %10.4f %10.4f %9u %10.4f %10.4f   %016llx\n",name,threads,result.velocityMs,result.stepMs,
+          result.touching,result.meanPenetration,result.maxPenetration,(unsigned long long)result.checksum);
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 missiles = 1000;
+   uint32 ticks = 600;
+   uint32 threads = 4;
+   if(argc > 1)
+   {
+      missiles = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      ticks = atoi(argv[2]);
+   }
+   if(argc > 3)
+   {
+      threads = atoi(argv[3]);
+   }
+   if(missiles == 0 || ticks == 0 || threads == 0)
+   {
+      printf("Usage: %s [missiles] [ticks] [threads]\n",argv[0]);
+      return 1;
+   }
+   
+   Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   
+   printf("Missiles         : %u\n",missiles);
+   printf("Ticks            : %u\n",ticks);
+   printf("Lanes            : %d\n\n",b2_wideLanes);
+   printf("   %-8s %8s %10s %10s %9s %10s %10s   %16s\n","solver","threads","vel (ms)","step (ms)","touching",
+          "mean pen","max pen","state");
+   
+   RUN_RESULT_T scalar = RunPileUp(b2_scalarContactSolver,missiles,ticks,1);
+   PrintResult("scalar",1,scalar);
+   RUN_RESULT_T wide = RunPileUp(b2_wideContactSolver,missiles,ticks,1);
+   PrintResult("wide",1,wide);
+   RUN_RESULT_T wideThreaded = RunPileUp(b2_wideContactSolver,missiles,ticks,threads);
+   PrintResult("wide",threads,wideThreaded);
+   
+   printf("\nVelocity solver speedup : %.2fx\n",scalar.velocityMs/max(wide.velocityMs,1.0E-9));
+   printf("Mean penetration        : %+.1f%% (limit %+.0f%%)\n",
+          100.0*(wide.meanPenetration/max(scalar.meanPenetration,1.0E-9) - 1),100.0*MEAN_PENETRATION_TOLERANCE);
+   printf("Max penetration         : %+.1f%% (limit %+.0f%%)\n",
+          100.0*(wide.maxPenetration/max(scalar.maxPenetration,1.0E-9f) - 1),100.0*MAX_PENETRATION_TOLERANCE);
+   bool failed = false;
+   if(wide.checksum != wideThreaded.checksum)
+   {
+      printf("\nFAILED: the wide solver runs do not match.\n");
+      failed = true;
+   }
+   if(wide.meanPenetration > (1 + MEAN_PENETRATION_TOLERANCE)*scalar.meanPenetration ||
+      wide.maxPenetration > (1 + MAX_PENETRATION_TOLERANCE)*scalar.maxPenetration)
+   {
+      printf("\nFAILED: the wide solver lets the missiles sink in too far.\n");
+      failed = true;
+   }
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,494 @@
+/********************************************************************
+ * File   : FlowFieldBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Flow field build, repair and steering check.
+ *
+ * The field covers a WORLD_SIZE world in CELL_SIZE cells,
+ * with the goal in the middle of a walled box (gaps on
+ * alternating sides) and pseudo-random boxes scattered
+ * around it.
+ *
+ *    build   - a full rebuild with Dijkstra's algorithm
+ *              (one thread) and with the parallel sweeps
+ *              on 2, 4 and all the hardware threads.  The
+ *              integration fields must match.
+ *    repair  - boxes opened and closed (and made costly)
+ *              one at a time, repaired with Update(...),
+ *              against rebuilding.  After each, the field
+ *              must match one rebuilt from scratch.
+ *    agents  - entities crossing the world to the goal,
+ *              each following its own path (traced from
+ *              the field, one point per cell) or all of
+ *              them following the field, and the swarm
+ *              following the field.  Reported are the
+ *              entity update time, the memory used to
+ *              steer, the average distance left to the
+ *              goal (along the field) at the start and
+ *              end, and how many got to the goal.
+ *
+ * Usage:
+ *    flowfield_benchmark [agents] [ticks]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Simulation.h"
+#include "MovingEntity.h"
+#include "MissileSwarm.h"
+#include "FlowField.h"
+#include "JobSystem.h"
+#include "Path.h"
+#include "Stopwatch.h"
+#include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include <cstdlib>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+typedef enum
+{
+   AT_PATH,
+   AT_FLOW,
+   AT_SWARM_FLOW,
+   AT_MAX
+} AGENT_TYPE_T;
+
+static const char* AgentTypeString(AGENT_TYPE_T agentType)
+{
+   static const char* names[] =
+   {
+      "path",
+      "flow",
+      "swarm",
+   };
+   return names[agentType];
+}
+
+typedef struct
+{
+   Vec2 lowerBound;
+   Vec2 upperBound;
+} BOX_T;
+
+const float32 WORLD_SIZE = 400.0;
+const float32 CELL_SIZE = 1.0;
+const float32 INNER_WALL = 40.0;
+const float32 OUTER_WALL = 100.0;
+const float32 WALL_THICKNESS = 2.0;
+const float32 GAP_SIZE = 12.0;
+const uint32 BOX_COUNT = 60;
+const uint8 MUD_COST = 5;
+const uint32 BUILD_REPEATS = 5;
+const uint32 REPAIR_ROUNDS = 40;
+const float32 SPAWN_SPACING = 8.0;
+
+// Square walls around the goal, with a gap in one side
+// (on a different side for each wall).
+static void AddWalls(FlowField& field)
+{
+   const float32 walls[] = { INNER_WALL, OUTER_WALL };
+   for(uint32 wdx = 0; wdx < 2; wdx++)
+   {
+      float32 half = walls[wdx];
+      float32 t = WALL_THICKNESS;
+      float32 gap = 0.5*GAP_SIZE;
+      if(wdx == 0)
+      {  // Gap in the top.
+         field.SetCost(Vec2(-half,half-t),Vec2(-gap,half),FlowField::COST_BLOCKED);
+         field.SetCost(Vec2(gap,half-t),Vec2(half,half),FlowField::COST_BLOCKED);
+         field.SetCost(Vec2(-half,-half),Vec2(half,-half+t),FlowField::COST_BLOCKED);
+      }
+      else
+      {  // Gap in the bottom.
+         field.SetCost(Vec2(-half,half-t),Vec2(half,half),FlowField::COST_BLOCKED);
+         field.SetCost(Vec2(-half,-half),Vec2(-gap,-half+t),FlowField::COST_BLOCKED);
+         field.SetCost(Vec2(gap,-half),Vec2(half,-half+t),FlowField::COST_BLOCKED);
+      }
+      field.SetCost(Vec2(-half,-half),Vec2(-half+t,half),FlowField::COST_BLOCKED);
+      field.SetCost(Vec2(half-t,-half),Vec2(half,half),FlowField::COST_BLOCKED);
+   }
+}
+
+static void MakeBoxes(vector<BOX_T>& boxes)
+{
+   BenchmarkRandom rnd(4242);
+   float32 half = 0.5*WORLD_SIZE;
+   boxes.clear();
+   while(boxes.size() < BOX_COUNT)
+   {
+      BOX_T box;
+      Vec2 center(rnd.Next(-half,half),rnd.Next(-half,half));
+      Vec2 size(rnd.Next(4,20),rnd.Next(4,20));
+      // Keep the goal box clear.
+      if(fabsf(center.x) < INNER_WALL + 10 && fabsf(center.y) < INNER_WALL + 10)
+      {
+         continue;
+      }
+      box.lowerBound = center - 0.5f*size;
+      box.upperBound = center + 0.5f*size;
+      boxes.push_back(box);
+   }
+}
+
+static void SetupField(FlowField& field, const vector<BOX_T>& boxes)
+{
+   field.Init(WORLD_SIZE,WORLD_SIZE,CELL_SIZE);
+   field.SetGoal(Vec2(0,0));
+   AddWalls(field);
+   for(uint32 idx = 0; idx < boxes.size(); idx++)
+   {
+      field.SetCost(boxes[idx].lowerBound,boxes[idx].upperBound,FlowField::COST_BLOCKED);
+   }
+}
+
+static bool SameIntegration(const FlowField& lhs, const FlowField& rhs)
+{
+   for(uint32 y = 0; y < lhs.GetHeight(); y++)
+   {
+      for(uint32 x = 0; x < lhs.GetWidth(); x++)
+      {
+         if(lhs.GetIntegration(x,y) != rhs.GetIntegration(x,y))
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+static bool SameDirections(const FlowField& lhs, const FlowField& rhs)
+{
+   for(uint32 y = 0; y < lhs.GetHeight(); y++)
+   {
+      for(uint32 x = 0; x < lhs.GetWidth(); x++)
+      {
+         Vec2 center = lhs.GetCellCenter(x,y);
+         if(!(lhs.GetDirection(center) == rhs.GetDirection(center)))
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+static uint32 CountReachable(const FlowField& field)
+{
+   uint32 count = 0;
+   for(uint32 y = 0; y < field.GetHeight(); y++)
+   {
+      for(uint32 x = 0; x < field.GetWidth(); x++)
+      {
+         if(field.GetIntegration(x,y) != FlowField::UNREACHABLE)
+         {
+            count++;
+         }
+      }
+   }
+   return count;
+}
+
+static bool RunBuilds(const vector<BOX_T>& boxes, FlowField& reference)
+{
+   SetupField(reference,boxes);
+   StopWatch watch;
+   watch.Start();
+   for(uint32 rep = 0; rep < BUILD_REPEATS; rep++)
+   {
+      reference.Rebuild(NULL);
+   }
+   watch.Stop();
+   double dijkstraMs = 1.0E3*watch.GetSeconds()/BUILD_REPEATS;
+   printf("Grid             : %u x %u cells, %u reachable\n\n",reference.GetWidth(),reference.GetHeight(),
+          CountReachable(reference));
+   printf("   %-10s %8s %10s %8s\n","build","threads","time (ms)","same");
+   printf("   %-10s %8u %10.3f %8s\n","dijkstra",1,dijkstraMs,"-");
+   
+   const uint32 threadCounts[] = { 2, 4, JobSystem::GetHardwareThreadCount() };
+   bool same = true;
+   for(uint32 tdx = 0; tdx < 3; tdx++)
+   {
+      if(tdx == 2 && threadCounts[tdx] <= 4)
+      {
+         break;
+      }
+      JobSystem jobs;
+      jobs.Init(threadCounts[tdx]);
+      FlowField field;
+      SetupField(field,boxes);
+      watch.Start();
+      for(uint32 rep = 0; rep < BUILD_REPEATS; rep++)
+      {
+         field.Rebuild(&jobs);
+      }
+      watch.Stop();
+      bool match = SameIntegration(field,reference) && SameDirections(field,reference);
+      printf("   %-10s %8u %10.3f %8s\n","sweeps",jobs.GetThreadCount(),1.0E3*watch.GetSeconds()/BUILD_REPEATS,
+             match ? "yes" : "NO");
+      same = same && match;
+      jobs.Shutdown();
+   }
+   printf("\n");
+   return same;
+}
+
+static bool RunRepairs(const vector<BOX_T>& boxes)
+{
+   FlowField field;
+   SetupField(field,boxes);
+   field.Update(NULL);
+   
+   BenchmarkRandom rnd(777);
+   vector<uint8> boxCosts(boxes.size(),(uint8)FlowField::COST_BLOCKED);
+   // The boxes overlap, so the changes are replayed in
+   // order for the rebuilt field.
+   vector< pair<uint32,uint8> > changes;
+   StopWatch watch;
+   double repairMs = 0;
+   double rebuildMs = 0;
+   bool same = true;
+   for(uint32 round = 0; round < REPAIR_ROUNDS; round++)
+   {
+      // Open, close or muddy one of the boxes.
+      uint32 bdx = (uint32)rnd.Next(0,boxes.size()) % boxes.size();
+      const uint8 costs[] = { FlowField::COST_MIN, MUD_COST, FlowField::COST_BLOCKED };
+      uint8 cost = costs[(uint32)rnd.Next(0,3) % 3];
+      if(cost == boxCosts[bdx])
+      {
+         cost = (cost == FlowField::COST_BLOCKED) ? FlowField::COST_MIN : FlowField::COST_BLOCKED;
+      }
+      boxCosts[bdx] = cost;
+      changes.push_back(pair<uint32,uint8>(bdx,cost));
+      field.SetCost(boxes[bdx].lowerBound,boxes[bdx].upperBound,cost);
+      watch.Start();
+      field.Update(NULL);
+      watch.Stop();
+      repairMs += 1.0E3*watch.GetSeconds();
+      
+      FlowField rebuilt;
+      SetupField(rebuilt,boxes);
+      for(uint32 idx = 0; idx < changes.size(); idx++)
+      {
+         const BOX_T& box = boxes[changes[idx].first];
+         rebuilt.SetCost(box.lowerBound,box.upperBound,changes[idx].second);
+      }
+      watch.Start();
+      rebuilt.Rebuild(NULL);
+      watch.Stop();
+      rebuildMs += 1.0E3*watch.GetSeconds();
+      same = same && SameIntegration(field,rebuilt) && SameDirections(field,rebuilt);
+   }
+   printf("   %-10s %8s %10s %8s\n","change","rounds","time (ms)","same");
+   printf("   %-10s %8u %10.3f %8s\n","repair",REPAIR_ROUNDS,repairMs/REPAIR_ROUNDS,same ? "yes" : "NO");
+   printf("   %-10s %8u %10.3f %8s\n\n","rebuild",REPAIR_ROUNDS,rebuildMs/REPAIR_ROUNDS,"-");
+   return same;
+}
+
+// One point per cell, from the position down the field
+// to the goal; what a grid planner hands each entity.
+static Path* TracePath(const FlowField& field, const Vec2& position)
+{
+   vector<Vec2> points;
+   points.push_back(position);
+   uint32 x;
+   uint32 y;
+   field.GetCell(position,x,y);
+   Vec2 center = field.GetCellCenter(x,y);
+   for(uint32 step = 0; step < field.GetWidth()*field.GetHeight(); step++)
+   {
+      const Vec2& direction = field.GetDirection(center);
+      if(direction.x == 0 && direction.y == 0)
+      {
+         break;
+      }
+      Vec2 offset((direction.x > 0) ? 1.0f : ((direction.x < 0) ? -1.0f : 0.0f),
+                  (direction.y > 0) ? 1.0f : ((direction.y < 0) ? -1.0f : 0.0f));
+      center += field.GetCellSize()*offset;
+      points.push_back(center);
+   }
+   points.push_back(field.GetGoal());
+   return Path::Create(points);
+}
+
+static void RunAgents(AGENT_TYPE_T agentType, const FlowField& field, uint32 agents, uint32 ticks)
+{
+   Simulation sim;
+   sim.Init();
+   MissileSwarm& swarm = sim.GetSwarm();
+   
+   // On a grid, outside the outer wall and off the boxes.
+   uint32 added = 0;
+   uint32 side = (uint32)(WORLD_SIZE/SPAWN_SPACING);
+   uint64 pathBytes = 0;
+   double startDistance = 0;
+   for(uint32 idx = 0; idx < side*side && added < agents; idx++)
+   {
+      Vec2 position(-0.5f*WORLD_SIZE + SPAWN_SPACING*(0.5f + idx % side),
+                    -0.5f*WORLD_SIZE + SPAWN_SPACING*(0.5f + idx / side));
+      if(fabsf(position.x) < OUTER_WALL + SPAWN_SPACING && fabsf(position.y) < OUTER_WALL + SPAWN_SPACING)
+      {
+         continue;
+      }
+      uint32 x;
+      uint32 y;
+      field.GetCell(position,x,y);
+      if(field.GetIntegration(x,y) == FlowField::UNREACHABLE)
+      {
+         continue;
+      }
+      added++;
+      startDistance += field.GetDistance(position);
+      if(agentType == AT_SWARM_FLOW)
+      {
+         swarm.CommandFollowFlowField(swarm.AddMissile(position),&field);
+         continue;
+      }
+      MovingEntity* entity = new MovingEntity(*sim.GetWorld(),position);
+      sim.AddEntity(entity);
+      if(agentType == AT_PATH)
+      {
+         Path* path = TracePath(field,position);
+         pathBytes += path->GetPointCount()*(sizeof(Vec2) + sizeof(float32));
+         entity->CommandFollowPath(path);
+         path->Release();
+      }
+      else
+      {
+         entity->CommandFollowFlowField(&field);
+      }
+   }
+   
+   StopWatch watch;
+   double entityMs = 0;
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      watch.Start();
+      sim.UpdateEntities();
+      watch.Stop();
+      entityMs += 1.0E3*watch.GetSeconds();
+      sim.UpdatePhysics();
+   }
+   
+   uint32 arrived = 0;
+   double endDistance = 0;
+   for(uint32 idx = 0; idx < sim.GetEntityCount(); idx++)
+   {
+      MovingEntityIFace* entity = sim.GetEntity(idx);
+      float32 distance = field.GetDistance(entity->GetPosition());
+      endDistance += Max(distance,0.0f);
+      if(entity->GetState() == MovingEntityIFace::ST_IDLE)
+      {
+         arrived++;
+      }
+   }
+   for(uint32 idx = 0; idx < swarm.GetCount(); idx++)
+   {
+      float32 distance = field.GetDistance(swarm.GetBody(idx)->GetPosition());
+      endDistance += Max(distance,0.0f);
+      if(swarm.GetState(idx) == MissileSwarm::ST_IDLE)
+      {
+         arrived++;
+      }
+   }
+   // The field is shared, whatever the number of agents.
+   uint64 steeringBytes = pathBytes;
+   if(agentType != AT_PATH)
+   {
+      uint64 cells = field.GetWidth()*field.GetHeight();
+      steeringBytes = cells*(sizeof(uint8) + sizeof(uint32) + sizeof(Vec2));
+   }
+   printf("   %-10s %8u %12.3f %12.1f %8.1f %8.1f %8u\n",AgentTypeString(agentType),added,entityMs/ticks,
+          steeringBytes/1024.0,startDistance/added,endDistance/added,arrived);
+   sim.Shutdown();
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 agents = 1000;
+   uint32 ticks = 600;
+   if(argc > 1)
+   {
+      agents = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      ticks = atoi(argv[2]);
+   }
+   if(agents == 0 || ticks == 0)
+   {
+      printf("Usage: %s [agents] [ticks]\n",argv[0]);
+      return 1;
+   }
+   
+   // Singletons are initialized explicitly, just like
+   // the AppDelegate does.
+   Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   Profiler::Instance().SetThreadName("Main");
+   
+   printf("World            : %.0f m, %.1f m cells\n",WORLD_SIZE,CELL_SIZE);
+   vector<BOX_T> boxes;
+   MakeBoxes(boxes);
+   FlowField field;
+   bool buildsMatch = RunBuilds(boxes,field);
+   bool repairsMatch = RunRepairs(boxes);
+   
+   printf("Ticks            : %u\n\n",ticks);
+   printf("   %-10s %8s %12s %12s %8s %8s %8s\n","agents","count","update (ms)","steer (KB)","start (m)",
+          "end (m)","arrived");
+   for(uint32 agentType = 0; agentType < AT_MAX; agentType++)
+   {
+      RunAgents((AGENT_TYPE_T)agentType,field,agents,ticks);
+   }
+   
+   Profiler::Instance().Shutdown();
+   Telemetry::Instance().Shutdown();
+   Notifier::Instance().Shutdown();
+   if(!buildsMatch || !repairsMatch)
+   {
+      printf("\nFAILED: the fields do not match.\n");
+      return 1;
+   }
+   return 0;
+}
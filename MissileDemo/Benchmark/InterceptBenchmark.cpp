@@ -0,0 +1,381 @@
+/********************************************************************
+ * File   : InterceptBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Engagement benchmark for the intercept guidance.
+ *
+ * Sets up N engagements, each a missile sitting still
+ * (pointed in a random direction) and a target 40-80m
+ * away flying at TARGET_SPEED in a random direction.  The
+ * engagements are far enough apart not to interfere.  The
+ * same engagements are flown with each way of chasing the
+ * target:
+ *
+ *    seek    - Missile seeking the target position, which is
+ *              updated every tick (the PID turn controller).
+ *    pursuit - Missile intercepting with GL_PURSUIT.
+ *    PN      - Missile intercepting with GL_PN.
+ *    APN     - Missile intercepting with GL_APN.
+ *    lead    - MovingEntity intercepting (it seeks the
+ *              predicted intercept point).
+ *    swarm   - MissileSwarm intercepting with GL_APN.  This
+ *              must give the same times as APN.
+ *
+ * and for targets flying straight, weaving and turning.  A hit is
+ * getting within the minimum seek distance (4m) of the
+ * target.  The time to intercept is reported for the hits.
+ *
+ * Usage:
+ *    intercept_benchmark [engagements] [navigation constant]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Simulation.h"
+#include "Missile.h"
+#include "MovingEntity.h"
+#include "MissileSwarm.h"
+#include "Target.h"
+#include "InterceptGuidance.h"
+#include "Stopwatch.h"
+#include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include <cstdlib>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+typedef enum
+{
+   CM_SEEK,
+   CM_PURSUIT,
+   CM_PN,
+   CM_APN,
+   CM_LEAD,
+   CM_SWARM,
+   CM_MAX
+} CHASE_MODE_T;
+
+static const char* ChaseModeString(CHASE_MODE_T mode)
+{
+   static const char* names[] =
+   {
+      "seek",
+      "pursuit",
+      "PN",
+      "APN",
+      "lead",
+      "swarm",
+   };
+   return names[mode];
+}
+
+typedef enum
+{
+   TM_STRAIGHT,
+   TM_WEAVE,
+   TM_TURN,
+   TM_MAX
+} TARGET_MOTION_T;
+
+static const char* TargetMotionString(TARGET_MOTION_T motion)
+{
+   static const char* names[] =
+   {
+      "Straight",
+      "Weaving",
+      "Turning",
+   };
+   return names[motion];
+}
+
+typedef struct
+{
+   Vec2 missilePos;
+   float32 missileAngle;
+   Vec2 targetPos;
+   Vec2 targetVel;
+} ENGAGEMENT_T;
+
+typedef struct
+{
+   uint32 hits;
+   double meanSeconds;
+   double maxSeconds;
+   // Entity update time per missile per tick.
+   double updateSeconds;
+   // The tick each engagement ended on (or the
+   // maximum number of ticks for a miss).
+   vector<uint32> hitTicks;
+} RESULT_T;
+
+const float32 TARGET_SPEED = 8.0;
+const float32 ENGAGEMENT_SPACING = 400.0;
+const float32 WEAVE_AMPLITUDE = 0.6;
+const float32 WEAVE_PERIOD = 4.0;
+const float32 TURN_RATE = 0.3;
+const uint32 MAX_TICKS = 30*TICKS_PER_SECOND;
+
+static void CreateEngagements(uint32 count, vector<ENGAGEMENT_T>& engagements)
+{
+   BenchmarkRandom rnd(12345);
+   uint32 side = (uint32)ceil(sqrt((double)count));
+   engagements.resize(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      ENGAGEMENT_T& engagement = engagements[idx];
+      engagement.missilePos = Vec2(ENGAGEMENT_SPACING*(idx % side), ENGAGEMENT_SPACING*(idx / side));
+      engagement.missileAngle = rnd.Next(-M_PI,M_PI);
+      float32 range = rnd.Next(40,80);
+      float32 bearing = rnd.Next(-M_PI,M_PI);
+      float32 heading = rnd.Next(-M_PI,M_PI);
+      engagement.targetPos = engagement.missilePos + range*Vec2(cosf(bearing),sinf(bearing));
+      engagement.targetVel = TARGET_SPEED*Vec2(cosf(heading),sinf(heading));
+   }
+}
+
+static void FlyEngagements(CHASE_MODE_T mode, TARGET_MOTION_T motion, float32 navigationConstant,
+                           const vector<ENGAGEMENT_T>& engagements, RESULT_T& result)
+{
+   const uint32 count = engagements.size();
+   Simulation sim;
+   sim.SetThreadCount(1);
+   sim.Init();
+   MissileSwarm& swarm = sim.GetSwarm();
+   swarm.SetGuidanceLaw(InterceptGuidance::GL_APN);
+   swarm.SetNavigationConstant(navigationConstant);
+   
+   vector<Target*> targets;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      const ENGAGEMENT_T& engagement = engagements[idx];
+      Target* target = new Target(*sim.GetWorld(),engagement.targetPos,engagement.targetVel);
+      if(motion == TM_WEAVE)
+      {
+         target->SetWeave(WEAVE_AMPLITUDE,WEAVE_PERIOD);
+      }
+      if(motion == TM_TURN)
+      {  // Half turn left, half right.
+         target->SetTurnRate((idx & 1) ? TURN_RATE : -TURN_RATE);
+      }
+      targets.push_back(target);
+      
+      if(mode == CM_SWARM)
+      {
+         uint32 missile = swarm.AddMissile(engagement.missilePos);
+         swarm.GetBody(missile)->SetTransform(engagement.missilePos,engagement.missileAngle);
+         swarm.CommandIntercept(missile,target->GetBody());
+         continue;
+      }
+      
+      MovingEntityIFace* entity = NULL;
+      if(mode == CM_LEAD)
+      {
+         MovingEntity* moving = new MovingEntity(*sim.GetWorld(),engagement.missilePos);
+         moving->GetBody()->SetTransform(engagement.missilePos,engagement.missileAngle);
+         entity = moving;
+      }
+      else
+      {
+         Missile* missile = new Missile(*sim.GetWorld(),engagement.missilePos);
+         missile->GetBody()->SetTransform(engagement.missilePos,engagement.missileAngle);
+         entity = missile;
+      }
+      entity->SetMinSeekDistance(4.0);
+      entity->SetNavigationConstant(navigationConstant);
+      sim.AddEntity(entity);
+      switch(mode)
+      {
+         case CM_SEEK:
+            entity->CommandSeek(target->GetBody()->GetPosition());
+            break;
+         case CM_PURSUIT:
+            entity->SetGuidanceLaw(InterceptGuidance::GL_PURSUIT);
+            entity->CommandIntercept(target->GetBody());
+            break;
+         case CM_PN:
+            entity->SetGuidanceLaw(InterceptGuidance::GL_PN);
+            entity->CommandIntercept(target->GetBody());
+            break;
+         default:
+            entity->SetGuidanceLaw(InterceptGuidance::GL_APN);
+            entity->CommandIntercept(target->GetBody());
+            break;
+      }
+   }
+   
+   result.hitTicks.assign(count,MAX_TICKS);
+   uint32 flying = count;
+   StopWatch updateWatch;
+   double updateSeconds = 0;
+   uint64 missileTicks = 0;
+   for(uint32 tick = 0; tick < MAX_TICKS && flying > 0; tick++)
+   {
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         targets[idx]->Update();
+      }
+      if(mode == CM_SEEK)
+      {  // The missile seeks where the target is now.
+         for(uint32 idx = 0; idx < count; idx++)
+         {
+            MovingEntityIFace* entity = sim.GetEntity(idx);
+            if(entity->GetState() == MovingEntityIFace::ST_IDLE)
+            {
+               continue;
+            }
+            const Vec2& targetPos = targets[idx]->GetBody()->GetPosition();
+            Vec2 toTarget = targetPos - static_cast<Missile*>(entity)->GetBody()->GetPosition();
+            if(toTarget.LengthSquared() < entity->GetMinSeekDistance()*entity->GetMinSeekDistance())
+            {
+               entity->CommandIdle();
+            }
+            else
+            {
+               entity->SetTargetPosition(targetPos);
+            }
+         }
+      }
+      
+      updateWatch.Start();
+      sim.UpdateEntities();
+      updateWatch.Stop();
+      updateSeconds += updateWatch.GetSeconds();
+      missileTicks += flying;
+      
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         bool idle;
+         if(mode == CM_SWARM)
+         {
+            idle = (swarm.GetState(idx) == MissileSwarm::ST_IDLE);
+         }
+         else
+         {
+            idle = (sim.GetEntity(idx)->GetState() == MovingEntityIFace::ST_IDLE);
+         }
+         if(idle && result.hitTicks[idx] == MAX_TICKS)
+         {
+            result.hitTicks[idx] = tick;
+            flying--;
+         }
+      }
+      sim.UpdatePhysics();
+   }
+   
+   result.hits = 0;
+   result.meanSeconds = 0;
+   result.maxSeconds = 0;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      if(result.hitTicks[idx] < MAX_TICKS)
+      {
+         double seconds = result.hitTicks[idx]*SECONDS_PER_TICK;
+         result.hits++;
+         result.meanSeconds += seconds;
+         result.maxSeconds = Max(result.maxSeconds,seconds);
+      }
+   }
+   if(result.hits > 0)
+   {
+      result.meanSeconds /= result.hits;
+   }
+   result.updateSeconds = updateSeconds/Max(missileTicks,(uint64)1);
+   
+   // The targets go before the world does.
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      delete targets[idx];
+   }
+   sim.Shutdown();
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 count = 200;
+   float32 navigationConstant = InterceptGuidance::DEFAULT_NAVIGATION_CONSTANT;
+   if(argc > 1)
+   {
+      count = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      navigationConstant = atof(argv[2]);
+   }
+   if(count == 0 || navigationConstant <= 0)
+   {
+      printf("Usage: %s [engagements] [navigation constant]\n",argv[0]);
+      return 1;
+   }
+   
+   // Singletons are initialized explicitly, just like
+   // the AppDelegate does.
+   Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   Profiler::Instance().SetThreadName("Main");
+   
+   vector<ENGAGEMENT_T> engagements;
+   CreateEngagements(count,engagements);
+   
+   printf("Engagements      : %u, target speed %.1f m/s, N = %.1f\n",count,TARGET_SPEED,navigationConstant);
+   for(uint32 motion = 0; motion < TM_MAX; motion++)
+   {
+      printf("\n%s targets:\n",TargetMotionString((TARGET_MOTION_T)motion));
+      printf("   %-8s %8s %10s %10s %14s\n","mode","hits","mean (s)","max (s)","update (ns)");
+      RESULT_T results[CM_MAX];
+      for(uint32 mode = 0; mode < CM_MAX; mode++)
+      {
+         RESULT_T& result = results[mode];
+         FlyEngagements((CHASE_MODE_T)mode,(TARGET_MOTION_T)motion,navigationConstant,engagements,result);
+         printf("   %-8s %4u/%-4u %10.2f %10.2f %14.1f\n",ChaseModeString((CHASE_MODE_T)mode),
+                result.hits,count,result.meanSeconds,result.maxSeconds,
+                1.0E9*result.updateSeconds);
+      }
+      printf("   swarm matches APN: %s\n",
+             (results[CM_SWARM].hitTicks == results[CM_APN].hitTicks) ? "yes" : "NO");
+   }
+   
+   Profiler::Instance().Shutdown();
+   Telemetry::Instance().Shutdown();
+   Notifier::Instance().Shutdown();
+   return 0;
+}
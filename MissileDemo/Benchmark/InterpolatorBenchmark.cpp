@@ -0,0 +1,337 @@
+/********************************************************************
+ * File   : InterpolatorBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Accuracy and speed check for the Interpolator.
+ *
+ * Builds curves from a few and from many control points
+ * (evenly and unevenly spaced) and compares Interpolate(...)
+ * and InterpolateBatch(...) against a copy of the original
+ * implementation (linear scan of the intervals).  Also checks
+ * that control pairs added after Create(...) give the same
+ * curve as creating it from scratch.
+ *
+ * Then fits the same curve with a few control points using
+ * the spline interpolators and compares the error and the cost
+ * with linear tables, and checks that the monotone spline does
+ * not overshoot a step.
+ *
+ * Usage:
+ *    interpolator_benchmark [lookups]
+ */
+
+#include "CommonSTL.h"
+#include "Interpolator.h"
+#include "CubicSplineInterpolator.h"
+#include "MonotoneCubicInterpolator.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+#include <cstring>
+
+// The original lookup, kept here as the reference for
+// the results.
+template<typename Number>
+class ReferenceInterpolator : public Interpolator<Number>
+{
+public:
+   bool ReferenceInterpolate(Number x, Number& result) const
+   {
+      for(uint32 idx = 0; idx < this->_intervals.size(); idx++)
+      {
+         if(this->_intervals[idx].IsInInterval(x))
+         {
+            const typename Interpolator<Number>::INTERVAL_T& iv = this->_intervals[idx];
+            result = iv.A*x*x*x + iv.B*x*x + iv.C*x + iv.D;
+            return true;
+         }
+      }
+      return false;
+   }
+};
+
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   // 0..1
+   double Next()
+   {
+      _state = _state*1664525 + 1013904223;
+      return (_state >> 8)*(1.0/16777216.0);
+   }
+};
+
+// A thrust like curve over 0..100.
+static double Curve(double x)
+{
+   return 50.0*(1.0-exp(-x/20.0)) + 3.0*sin(x/7.0);
+}
+
+template<typename Number>
+static void AddCurve(Interpolator<Number>& interpolator, uint32 points, bool uniform, BenchmarkRandom& rnd)
+{
+   for(uint32 idx = 0; idx < points; idx++)
+   {
+      double x = 100.0*idx/(points-1);
+      if(!uniform && idx > 0 && idx < points-1)
+      {
+         x += (rnd.Next()-0.5)*50.0/(points-1);
+      }
+      interpolator.AddControlPair(x,Curve(x));
+   }
+}
+
+template<typename Number>
+static void RunCase(const char* name, uint32 points, bool uniform, uint32 lookups)
+{
+   BenchmarkRandom rnd(12345);
+   ReferenceInterpolator<Number> interpolator;
+   AddCurve(interpolator,points,uniform,rnd);
+   interpolator.Create();
+   
+   // A little outside the range on both ends.
+   vector<Number> unsorted(lookups);
+   for(uint32 idx = 0; idx < lookups; idx++)
+   {
+      unsorted[idx] = -1.0 + 102.0*rnd.Next();
+   }
+   vector<Number> sorted(unsorted);
+   sort(sorted.begin(),sorted.end());
+   
+   vector<Number> expected(lookups);
+   vector<uint8> expectedInRange(lookups);
+   for(uint32 idx = 0; idx < lookups; idx++)
+   {
+      expectedInRange[idx] = interpolator.ReferenceInterpolate(unsorted[idx],expected[idx]);
+   }
+   
+   StopWatch watch;
+   Number sink = 0;
+   Number result = 0;
+   
+   // Speed of the reference is O(n) per lookup; only time a few.
+   uint32 referenceLookups = Min(lookups,(uint32)100000);
+   watch.Start();
+   for(uint32 idx = 0; idx < referenceLookups; idx++)
+   {
+      if(interpolator.ReferenceInterpolate(unsorted[idx],result))
+         sink += result;
+   }
+   watch.Stop();
+   double referenceSeconds = watch.GetSeconds();
+   
+   vector<Number> single(lookups);
+   uint32 singleMismatch = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < lookups; idx++)
+   {
+      bool inRange = interpolator.Interpolate(unsorted[idx],single[idx]);
+      if(inRange != (expectedInRange[idx] != 0))
+         singleMismatch++;
+   }
+   watch.Stop();
+   double singleSeconds = watch.GetSeconds();
+   
+   vector<Number> batch(lookups);
+   vector<uint8> batchInRange(lookups);
+   watch.Start();
+   interpolator.InterpolateBatch(&unsorted[0],&batch[0],lookups,&batchInRange[0]);
+   watch.Stop();
+   double batchSeconds = watch.GetSeconds();
+   
+   vector<Number> sortedBatch(lookups);
+   watch.Start();
+   interpolator.InterpolateBatch(&sorted[0],&sortedBatch[0],lookups);
+   watch.Stop();
+   double sortedSeconds = watch.GetSeconds();
+   sink += sortedBatch[lookups/2];
+   
+   double maxSingleDiff = 0;
+   double maxBatchDiff = 0;
+   uint32 batchMismatch = 0;
+   for(uint32 idx = 0; idx < lookups; idx++)
+   {
+      if(batchInRange[idx] != expectedInRange[idx])
+         batchMismatch++;
+      if(!expectedInRange[idx])
+         continue;
+      maxSingleDiff = Max(maxSingleDiff,fabs((double)(single[idx]-expected[idx])));
+      maxBatchDiff = Max(maxBatchDiff,fabs((double)(batch[idx]-expected[idx])));
+   }
+   
+   printf("%-22s: %4u points\n",name,points);
+   printf("   Reference (scan)  : %8.2f ns/lookup\n",1.0E9*referenceSeconds/referenceLookups);
+   printf("   Interpolate       : %8.2f ns/lookup (max diff %.3e, range mismatches %u)\n",
+          1.0E9*singleSeconds/lookups,maxSingleDiff,singleMismatch);
+   printf("   Batch (unsorted)  : %8.2f ns/lookup (max diff %.3e, range mismatches %u)\n",
+          1.0E9*batchSeconds/lookups,maxBatchDiff,batchMismatch);
+   printf("   Batch (sorted)    : %8.2f ns/lookup\n",1.0E9*sortedSeconds/lookups);
+   printf("   (checksum %g)\n",(double)sink);
+}
+
+// Adding control pairs after Create(...) must give the same
+// curve as adding them all first.
+template<typename Number>
+static double IncrementalDifference(uint32 points)
+{
+   BenchmarkRandom rnd(777);
+   vector<Number> xs;
+   for(uint32 idx = 0; idx < points; idx++)
+   {
+      xs.push_back(-10.0 + 120.0*rnd.Next());
+   }
+   Interpolator<Number> incremental;
+   Interpolator<Number> fresh;
+   for(uint32 idx = 0; idx < points; idx++)
+   {
+      fresh.AddControlPair(xs[idx],Curve(xs[idx]));
+      if(idx < 3)
+         incremental.AddControlPair(xs[idx],Curve(xs[idx]));
+   }
+   incremental.Create();
+   for(uint32 idx = 3; idx < points; idx++)
+   {
+      incremental.AddControlPair(xs[idx],Curve(xs[idx]));
+   }
+   // Change a few existing points too.
+   for(uint32 idx = 0; idx < points; idx += 7)
+   {
+      incremental.AddControlPair(xs[idx],Curve(xs[idx])+1.0);
+      fresh.AddControlPair(xs[idx],Curve(xs[idx])+1.0);
+   }
+   fresh.Create();
+   
+   double maxDiff = 0;
+   for(uint32 idx = 0; idx <= 10000; idx++)
+   {
+      Number x = -10.0 + 120.0*idx/10000;
+      Number lhs = 0;
+      Number rhs = 0;
+      bool lhsOk = incremental.Interpolate(x,lhs);
+      bool rhsOk = fresh.Interpolate(x,rhs);
+      if(lhsOk != rhsOk)
+         return numeric_limits<double>::infinity();
+      if(lhsOk)
+         maxDiff = Max(maxDiff,fabs((double)(lhs-rhs)));
+   }
+   return maxDiff;
+}
+
+// Max error against Curve(...) over the range, and the cost
+// of a lookup.
+static void FitCurve(const char* name, Interpolator<float>& interpolator, uint32 points, uint32 lookups)
+{
+   BenchmarkRandom rnd(99);
+   AddCurve(interpolator,points,true,rnd);
+   interpolator.Create();
+   
+   double maxError = 0;
+   for(uint32 idx = 0; idx <= 10000; idx++)
+   {
+      float x = 100.0*idx/10000;
+      float y = 0;
+      interpolator.Interpolate(x,y);
+      maxError = Max(maxError,fabs(y - Curve(x)));
+   }
+   
+   vector<float> xs(lookups);
+   for(uint32 idx = 0; idx < lookups; idx++)
+   {
+      xs[idx] = 100.0*rnd.Next();
+   }
+   StopWatch watch;
+   float sink = 0;
+   float result = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < lookups; idx++)
+   {
+      interpolator.Interpolate(xs[idx],result);
+      sink += result;
+   }
+   watch.Stop();
+   printf("   %-18s: %4u points, max error %.3e, %6.2f ns/lookup (checksum %g)\n",
+          name,points,maxError,1.0E9*watch.GetSeconds()/lookups,sink);
+}
+
+// Largest distance the curve goes outside 0..1 for a step.
+static float StepOvershoot(Interpolator<float>& interpolator)
+{
+   static const float steps[] = { 0, 0, 0, 0.1, 1, 1, 1 };
+   for(uint32 idx = 0; idx < sizeof(steps)/sizeof(steps[0]); idx++)
+   {
+      interpolator.AddControlPair(idx,steps[idx]);
+   }
+   interpolator.Create();
+   float overshoot = 0;
+   for(uint32 idx = 0; idx <= 600; idx++)
+   {
+      float y = 0;
+      interpolator.Interpolate(idx/100.0f,y);
+      overshoot = Max(overshoot,Max(-y,y-1));
+   }
+   return overshoot;
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 lookups = 1000000;
+   if(argc > 1)
+   {
+      lookups = atoi(argv[1]);
+   }
+   if(lookups == 0)
+   {
+      printf("Usage: %s [lookups]\n",argv[0]);
+      return 1;
+   }
+   
+   RunCase<float>("float, uniform",16,true,lookups);
+   RunCase<float>("float, non-uniform",16,false,lookups);
+   RunCase<float>("float, uniform",256,true,lookups);
+   RunCase<float>("float, non-uniform",256,false,lookups);
+   RunCase<double>("double, non-uniform",256,false,lookups);
+   
+   printf("Incremental adds     : max diff %.3e (float), %.3e (double)\n",
+          IncrementalDifference<float>(200),IncrementalDifference<double>(200));
+   
+   printf("Curve fit:\n");
+   Interpolator<float> linearDense;
+   Interpolator<float> linearSparse;
+   CubicSplineInterpolator<float> cubic;
+   MonotoneCubicInterpolator<float> monotone;
+   FitCurve("Linear",linearDense,256,lookups);
+   FitCurve("Linear",linearSparse,16,lookups);
+   FitCurve("Cubic spline",cubic,48,lookups);
+   FitCurve("Monotone cubic",monotone,48,lookups);
+   
+   CubicSplineInterpolator<float> cubicStep;
+   MonotoneCubicInterpolator<float> monotoneStep;
+   printf("Step overshoot       : %.3e (cubic spline), %.3e (monotone cubic)\n",
+          StepOvershoot(cubicStep),StepOvershoot(monotoneStep));
+   return 0;
+}
@@ -0,0 +1,268 @@
+/********************************************************************
+ * File   : IslandBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+/* Parallel island solving check.
+ *
+ * The world has a grid of pens, each with a pile of
+ * boxes dropped into it (one island per pen), and a row
+ * of chains hanging from one shared static ceiling (so
+ * those islands have to take turns).  A contact listener
+ * hashes every PostSolve(...) impulse it gets.
+ *
+ * The world is stepped with no task executor, then with
+ * the islands solved on a JobSystem with 1, 2, 4 and all
+ * of the hardware threads.  Reported are the step time
+ * and the checksums of the body states and the impulses,
+ * which must be the same for all of them.
+ *
+ * Usage:
+ *    island_benchmark [pens] [ticks]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "JobSystem.h"
+#include "PhysicsTasks.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+
+const float32 TIME_STEP = 1.0/60;
+const int32 VELOCITY_ITERATIONS = 8;
+const int32 POSITION_ITERATIONS = 3;
+const uint32 BOXES_PER_PEN = 12;
+const float32 PEN_SIZE = 8.0;
+const float32 PEN_SPACING = 12.0;
+const uint32 CHAIN_COUNT = 8;
+const uint32 LINKS_PER_CHAIN = 10;
+
+// FNV-1a over raw bits.
+static void HashBytes(uint64& hash, const void* data, uint32 size)
+{
+   const uint8* bytes = (const uint8*)data;
+   for(uint32 idx = 0; idx < size; idx++)
+   {
+      hash ^= bytes[idx];
+      hash *= 1099511628211ull;
+   }
+}
+
+class ImpulseHasher : public ContactListener
+{
+private:
+   uint64 _hash;
+   uint32 _count;
+   
+public:
+   ImpulseHasher() : _hash(14695981039346656037ull), _count(0) { }
+   
+   virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+   {
+      // Which contact it is (the pointers change from run
+      // to run).
+      Vec2 positionA = contact->GetFixtureA()->GetBody()->GetPosition();
+      Vec2 positionB = contact->GetFixtureB()->GetBody()->GetPosition();
+      HashBytes(_hash,&positionA,sizeof(positionA));
+      HashBytes(_hash,&positionB,sizeof(positionB));
+      HashBytes(_hash,impulse->normalImpulses,impulse->count*sizeof(float32));
+      HashBytes(_hash,impulse->tangentImpulses,impulse->count*sizeof(float32));
+      _count++;
+   }
+   
+   uint64 GetHash() const { return _hash; }
+   uint32 GetCount() const { return _count; }
+};
+
+static uint64 StateChecksum(b2World& world)
+{
+   uint64 hash = 14695981039346656037ull;
+   for(const b2Body* body = world.GetBodyList(); body != NULL; body = body->GetNext())
+   {
+      Vec2 position = body->GetPosition();
+      Vec2 velocity = body->GetLinearVelocity();
+      float32 angle = body->GetAngle();
+      float32 angularVelocity = body->GetAngularVelocity();
+      bool awake = body->IsAwake();
+      HashBytes(hash,&position,sizeof(position));
+      HashBytes(hash,&velocity,sizeof(velocity));
+      HashBytes(hash,&angle,sizeof(angle));
+      HashBytes(hash,&angularVelocity,sizeof(angularVelocity));
+      HashBytes(hash,&awake,sizeof(awake));
+   }
+   return hash;
+}
+
+static b2Body* CreateBody(b2World& world, b2BodyType bodyType, const Vec2& position, float32 angle = 0)
+{
+   b2BodyDef bodyDef;
+   bodyDef.type = bodyType;
+   bodyDef.position = position;
+   bodyDef.angle = angle;
+   return world.CreateBody(&bodyDef);
+}
+
+static void AddBox(b2Body* body, float32 halfWidth, float32 halfHeight, const Vec2& center = Vec2(0,0))
+{
+   b2PolygonShape shape;
+   shape.SetAsBox(halfWidth,halfHeight,center,0);
+   body->CreateFixture(&shape,1.0);
+}
+
+// A U shaped pen (its own static body) with boxes
+// stacked over it, a little off center so they tumble.
+static void AddPen(b2World& world, const Vec2& center)
+{
+   float32 half = 0.5*PEN_SIZE;
+   b2Body* pen = CreateBody(world,b2_staticBody,center);
+   AddBox(pen,half,0.25,Vec2(0,-half));
+   AddBox(pen,0.25,half,Vec2(-half,0));
+   AddBox(pen,0.25,half,Vec2(half,0));
+   for(uint32 idx = 0; idx < BOXES_PER_PEN; idx++)
+   {
+      Vec2 offset(0.3f*((idx % 3) - 1.0f) + 0.05f*idx,-half + 0.75f + 1.1f*idx);
+      b2Body* box = CreateBody(world,b2_dynamicBody,center + offset,0.1f*idx);
+      AddBox(box,0.5,0.5);
+   }
+}
+
+// Chains of links from one ceiling, started off to the
+// side so they swing (and hit each other).
+static void AddChains(b2World& world, const Vec2& center)
+{
+   b2Body* ceiling = CreateBody(world,b2_staticBody,center);
+   AddBox(ceiling,0.5*PEN_SPACING*CHAIN_COUNT,0.25);
+   for(uint32 chain = 0; chain < CHAIN_COUNT; chain++)
+   {
+      Vec2 anchor = center + Vec2(PEN_SPACING*(chain - 0.5f*(CHAIN_COUNT - 1)),0);
+      b2Body* previous = ceiling;
+      for(uint32 link = 0; link < LINKS_PER_CHAIN; link++)
+      {
+         b2Body* body = CreateBody(world,b2_dynamicBody,anchor + Vec2(link + 0.5f,0));
+         AddBox(body,0.5,0.125);
+         b2RevoluteJointDef jointDef;
+         jointDef.Initialize(previous,body,anchor + Vec2((float32)link,0));
+         world.CreateJoint(&jointDef);
+         previous = body;
+      }
+   }
+}
+
+static void BuildWorld(b2World& world, uint32 pens)
+{
+   uint32 side = (uint32)ceilf(sqrtf((float32)pens));
+   for(uint32 idx = 0; idx < pens; idx++)
+   {
+      AddPen(world,Vec2(PEN_SPACING*(idx % side),PEN_SPACING*(idx / side)));
+   }
+   AddChains(world,Vec2(0.5f*PEN_SPACING*side,PEN_SPACING*side + 20));
+}
+
+// Returns the step time in ms.
+static double RunWorld(uint32 pens, uint32 ticks, JobSystem* jobs, uint64& stateHash, uint64& impulseHash,
+                       uint32& impulseCount)
+{
+   b2World world(Vec2(0,-10));
+   PhysicsTasks tasks(jobs);
+   if(jobs != NULL)
+   {
+      world.SetTaskExecutor(&tasks);
+   }
+   ImpulseHasher hasher;
+   world.SetContactListener(&hasher);
+   BuildWorld(world,pens);
+   
+   StopWatch watch;
+   double stepMs = 0;
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      watch.Start();
+      world.Step(TIME_STEP,VELOCITY_ITERATIONS,POSITION_ITERATIONS);
+      watch.Stop();
+      stepMs += 1.0E3*watch.GetSeconds();
+   }
+   stateHash = StateChecksum(world);
+   impulseHash = hasher.GetHash();
+   impulseCount = hasher.GetCount();
+   return stepMs/ticks;
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 pens = 256;
+   uint32 ticks = 300;
+   if(argc > 1)
+   {
+      pens = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      ticks = atoi(argv[2]);
+   }
+   if(pens == 0 || ticks == 0)
+   {
+      printf("Usage: %s [pens] [ticks]\n",argv[0]);
+      return 1;
+   }
+   
+   printf("Pens             : %u, %u boxes each\n",pens,BOXES_PER_PEN);
+   printf("Chains           : %u, %u links each\n",CHAIN_COUNT,LINKS_PER_CHAIN);
+   printf("Ticks            : %u\n\n",ticks);
+   printf("   %-10s %8s %10s %18s %18s %8s\n","islands","threads","step (ms)","state","impulses","same");
+   
+   uint64 stateHash;
+   uint64 impulseHash;
+   uint32 impulseCount;
+   double ms = RunWorld(pens,ticks,NULL,stateHash,impulseHash,impulseCount);
+   printf("   %-10s %8u %10.3f   %016llx   %016llx %8s\n","serial",1,ms,stateHash,impulseHash,"-");
+   
+   const uint32 threadCounts[] = { 1, 2, 4, JobSystem::GetHardwareThreadCount() };
+   bool same = true;
+   for(uint32 tdx = 0; tdx < 4; tdx++)
+   {
+      if(tdx == 3 && threadCounts[tdx] <= 4)
+      {
+         break;
+      }
+      JobSystem jobs;
+      jobs.Init(threadCounts[tdx]);
+      uint64 parallelState;
+      uint64 parallelImpulses;
+      uint32 parallelCount;
+      ms = RunWorld(pens,ticks,&jobs,parallelState,parallelImpulses,parallelCount);
+      bool match = (parallelState == stateHash) && (parallelImpulses == impulseHash) &&
+         (parallelCount == impulseCount);
+      printf("   %-10s %8u %10.3f   %016llx   %016llx %8s\n","jobs",jobs.GetThreadCount(),ms,parallelState,
+             parallelImpulses,match ? "yes" : "NO");
+      same = same && match;
+      jobs.Shutdown();
+   }
+   printf("\n%u impulses reported\n",impulseCount);
+   if(!same)
+   {
+      printf("\nFAILED: the worlds do not match.\n");
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,312 @@
+/********************************************************************
+ * File   : MathBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/21/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+/* Accuracy and speed check for the fast math in MathUtilities.
+ *
+ * Measures the largest error of Atan2Fast(...), Atan2Fastest(...),
+ * SinCosFast(...) and WrapAngle(...) against libm (in double)
+ * over sweeps and random inputs, checks that the array versions
+ * give the same results as the scalar ones and that AdjustAngle(...)
+ * still matches the original loops.  Then times libm, the scalar
+ * versions and the array versions.
+ *
+ * Usage:
+ *    math_benchmark [count]
+ */
+
+#include "CommonSTL.h"
+#include "MathUtilities.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+
+// The original AdjustAngle(...), kept here as the reference.
+static float32 ReferenceAdjustAngle(float32 angleRads)
+{
+   if(angleRads > M_PI)
+   {
+      while(angleRads > M_PI)
+      {
+         angleRads -= 2*M_PI;
+      }
+   }
+   else if(angleRads < -M_PI)
+   {
+      while(angleRads < -M_PI)
+      {
+         angleRads += 2*M_PI;
+      }
+   }
+   return angleRads;
+}
+
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   // -1..1
+   double Next()
+   {
+      _state = _state*1664525 + 1013904223;
+      return (_state >> 8)*(2.0/16777216.0) - 1.0;
+   }
+};
+
+// The distance between two angles, around the circle.
+static double AngleDiff(double a, double b)
+{
+   return fabs(remainder(a-b,2*M_PI));
+}
+
+static uint32 CountMismatches(const vector<float32>& a, const vector<float32>& b)
+{
+   uint32 mismatches = 0;
+   for(uint32 idx = 0; idx < a.size(); idx++)
+   {
+      if(memcmp(&a[idx],&b[idx],sizeof(float32)) != 0)
+         mismatches++;
+   }
+   return mismatches;
+}
+
+static void CheckAccuracy(uint32 count)
+{
+   BenchmarkRandom rnd(12345);
+   vector<float32> y(count);
+   vector<float32> x(count);
+   vector<float32> small(count);
+   vector<float32> large(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      // Half sweep round the unit circle, half random points.
+      if(idx < count/2)
+      {
+         double theta = -M_PI + 2*M_PI*idx/(count/2);
+         y[idx] = sin(theta);
+         x[idx] = cos(theta);
+      }
+      else
+      {
+         y[idx] = 100*rnd.Next();
+         x[idx] = 100*rnd.Next();
+      }
+      small[idx] = M_PI*(-1.0 + 2.0*idx/count);
+      large[idx] = 1.0E4*rnd.Next();
+   }
+   
+   double atanFast = 0;
+   double atanFastest = 0;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      double ref = atan2((double)y[idx],(double)x[idx]);
+      atanFast = Max(atanFast,AngleDiff(MathUtilities::Atan2Fast(y[idx],x[idx]),ref));
+      atanFastest = Max(atanFastest,AngleDiff(MathUtilities::Atan2Fastest(y[idx],x[idx]),ref));
+   }
+   
+   double sinCosSmall = 0;
+   double sinCosLarge = 0;
+   double wrapLarge = 0;
+   uint32 adjustMismatch = 0;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      float32 s;
+      float32 c;
+      MathUtilities::SinCosFast(small[idx],s,c);
+      sinCosSmall = Max(sinCosSmall,Max(fabs(s-sin((double)small[idx])),fabs(c-cos((double)small[idx]))));
+      MathUtilities::SinCosFast(large[idx],s,c);
+      sinCosLarge = Max(sinCosLarge,Max(fabs(s-sin((double)large[idx])),fabs(c-cos((double)large[idx]))));
+      wrapLarge = Max(wrapLarge,AngleDiff(MathUtilities::WrapAngle(large[idx]),large[idx]));
+      // Inside +/- 3*PI the result must not change at all.
+      float32 angle = 2.999f*small[idx];
+      if(MathUtilities::AdjustAngle(angle) != ReferenceAdjustAngle(angle))
+         adjustMismatch++;
+   }
+   
+   // The array versions must match the scalar ones exactly.
+   vector<float32> scalar(count);
+   vector<float32> scalar2(count);
+   vector<float32> array(count);
+   vector<float32> array2(count);
+   for(uint32 idx = 0; idx < count; idx++)
+      scalar[idx] = MathUtilities::WrapAngle(large[idx]);
+   MathUtilities::WrapAngle(&large[0],&array[0],count);
+   uint32 wrapMismatch = CountMismatches(scalar,array);
+   for(uint32 idx = 0; idx < count; idx++)
+      scalar[idx] = MathUtilities::Atan2Fast(y[idx],x[idx]);
+   MathUtilities::Atan2Fast(&y[0],&x[0],&array[0],count);
+   uint32 atanFastMismatch = CountMismatches(scalar,array);
+   for(uint32 idx = 0; idx < count; idx++)
+      scalar[idx] = MathUtilities::Atan2Fastest(y[idx],x[idx]);
+   MathUtilities::Atan2Fastest(&y[0],&x[0],&array[0],count);
+   uint32 atanFastestMismatch = CountMismatches(scalar,array);
+   for(uint32 idx = 0; idx < count; idx++)
+      MathUtilities::SinCosFast(large[idx],scalar[idx],scalar2[idx]);
+   MathUtilities::SinCosFast(&large[0],&array[0],&array2[0],count);
+   uint32 sinCosMismatch = CountMismatches(scalar,array) + CountMismatches(scalar2,array2);
+   
+   printf("Accuracy (max abs error vs libm, %u values):\n",count);
+   printf("   Atan2Fast         : %.3e rads\n",atanFast);
+   printf("   Atan2Fastest      : %.3e rads\n",atanFastest);
+   printf("   SinCosFast        : %.3e (|a| <= PI), %.3e (|a| < 1e4)\n",sinCosSmall,sinCosLarge);
+   printf("   WrapAngle         : %.3e rads (|a| < 1e4)\n",wrapLarge);
+   printf("   AdjustAngle       : %u changed results (|a| < 3*PI)\n",adjustMismatch);
+   printf("   Array vs scalar   : %u WrapAngle, %u Atan2Fast, %u Atan2Fastest, %u SinCosFast mismatches\n",
+          wrapMismatch,atanFastMismatch,atanFastestMismatch,sinCosMismatch);
+   printf("   AdjustAngle(1e6)  : %.6f\n",(double)MathUtilities::AdjustAngle(1.0E6f));
+}
+
+static void PrintTime(const char* name, double seconds, uint32 count, double sink)
+{
+   printf("   %-18s: %7.2f ns/value (checksum %g)\n",name,1.0E9*seconds/count,sink);
+}
+
+static void CheckSpeed(uint32 count)
+{
+   BenchmarkRandom rnd(54321);
+   vector<float32> y(count);
+   vector<float32> x(count);
+   vector<float32> angles(count);
+   vector<float32> wound(count);
+   vector<float32> results(count);
+   vector<float32> results2(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      y[idx] = rnd.Next();
+      x[idx] = rnd.Next();
+      angles[idx] = 4*M_PI*rnd.Next();
+      // Angles that have wound up, like a Box2D body that has
+      // been spinning for a while.
+      wound[idx] = 200*M_PI*rnd.Next();
+   }
+   StopWatch watch;
+   double sink;
+   
+   printf("Speed (%u values):\n",count);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+      results[idx] = atan2f(y[idx],x[idx]);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("atan2f",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+      results[idx] = MathUtilities::Atan2Fast(y[idx],x[idx]);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("Atan2Fast",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   MathUtilities::Atan2Fast(&y[0],&x[0],&results[0],count);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("Atan2Fast (array)",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+      results[idx] = MathUtilities::Atan2Fastest(y[idx],x[idx]);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("Atan2Fastest",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   MathUtilities::Atan2Fastest(&y[0],&x[0],&results[0],count);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("Atan2Fastest (arr)",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      results[idx] = sinf(angles[idx]);
+      results2[idx] = cosf(angles[idx]);
+   }
+   watch.Stop();
+   sink += results[count/2] + results2[count/2];
+   PrintTime("sinf + cosf",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+      MathUtilities::SinCosFast(angles[idx],results[idx],results2[idx]);
+   watch.Stop();
+   sink += results[count/2] + results2[count/2];
+   PrintTime("SinCosFast",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   MathUtilities::SinCosFast(&angles[0],&results[0],&results2[0],count);
+   watch.Stop();
+   sink += results[count/2] + results2[count/2];
+   PrintTime("SinCosFast (array)",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+      results[idx] = ReferenceAdjustAngle(wound[idx]);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("Old AdjustAngle",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < count; idx++)
+      results[idx] = MathUtilities::AdjustAngle(wound[idx]);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("AdjustAngle",watch.GetSeconds(),count,sink);
+   
+   sink = 0;
+   watch.Start();
+   MathUtilities::WrapAngle(&wound[0],&results[0],count);
+   watch.Stop();
+   sink += results[count/2];
+   PrintTime("WrapAngle (array)",watch.GetSeconds(),count,sink);
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 count = 1000000;
+   if(argc > 1)
+   {
+      count = atoi(argv[1]);
+   }
+   if(count == 0)
+   {
+      printf("Usage: %s [count]\n",argv[0]);
+      return 1;
+   }
+   CheckAccuracy(count);
+   CheckSpeed(count);
+   return 0;
+}
@@ -0,0 +1,376 @@
+/********************************************************************
+ * File   : MissileBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/2/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Headless throughput benchmark for the simulation core.
+ *
+ * Creates N entities in a grid, commands them to seek
+ * pseudo-random targets and runs M fixed ticks of
+ * SECONDS_PER_TICK, exactly the way the MainScene does
+ * (entity update, then b2World::Step).  Targets are
+ * re-issued periodically so the swarm never settles.
+ *
+ * Usage:
+ *    missile_benchmark [entities] [ticks] [missile|moving|swarm] [exact|fast|fastest] [threads] [trace.json]
+ *
+ * "swarm" puts the missiles in the Simulation's MissileSwarm
+ * instead of creating a Missile entity for each one.  The
+ * last argument is the swarm steering accuracy (see
+ * SteeringBatch).  threads is the number of threads for
+ * the entity update (0, the default, is one per core).
+ * If trace.json is given, the Profiler zones for the last
+ * ticks are written to it (see Profiler::WriteChromeTrace(...)).
+ *
+ * The state checksum at the end is a hash of every
+ * body's position, angle and velocity.  It must not
+ * change with the number of threads.
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Simulation.h"
+#include "Missile.h"
+#include "MovingEntity.h"
+#include "MissileSwarm.h"
+#include "Stopwatch.h"
+#include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include <cstdlib>
+#include <cstring>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+typedef enum
+{
+   BT_MISSILE,
+   BT_MOVING_ENTITY,
+   BT_SWARM,
+} BENCHMARK_TYPE_T;
+
+static const char* BenchmarkTypeString(BENCHMARK_TYPE_T benchmarkType)
+{
+   static const char* names[] =
+   {
+      "missile",
+      "moving",
+      "swarm",
+   };
+   return names[benchmarkType];
+}
+
+typedef struct
+{
+   uint32 entities;
+   uint32 ticks;
+   BENCHMARK_TYPE_T type;
+   SteeringBatch::ACCURACY_T accuracy;
+   uint32 threads;
+   float32 worldSizeMeters;
+   uint32 retargetTicks;
+   const char* tracePath;
+} BENCHMARK_CONFIG_T;
+
+static void PrintUsage(const char* exe)
+{
+   printf("Usage: %s [entities] [ticks] [missile|moving|swarm] [exact|fast|fastest] [threads] [trace.json]\n",exe);
+}
+
+static bool ParseArgs(int argc, char* argv[], BENCHMARK_CONFIG_T& config)
+{
+   config.entities = 1000;
+   config.ticks = 600;
+   config.type = BT_MISSILE;
+   config.accuracy = SteeringBatch::SA_EXACT;
+   config.threads = 0;
+   config.worldSizeMeters = 100.0;
+   config.retargetTicks = 5*TICKS_PER_SECOND;
+   config.tracePath = NULL;
+   
+   if(argc > 1)
+   {
+      config.entities = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      config.ticks = atoi(argv[2]);
+   }
+   if(argc > 3)
+   {
+      bool found = false;
+      for(int32 idx = BT_MISSILE; idx <= BT_SWARM && !found; idx++)
+      {
+         if(strcmp(argv[3],BenchmarkTypeString((BENCHMARK_TYPE_T)idx)) == 0)
+         {
+            config.type = (BENCHMARK_TYPE_T)idx;
+            found = true;
+         }
+      }
+      if(!found)
+      {
+         return false;
+      }
+   }
+   if(argc > 4)
+   {
+      bool found = false;
+      for(int32 idx = SteeringBatch::SA_EXACT; idx < SteeringBatch::SA_MAX && !found; idx++)
+      {
+         if(strcmp(argv[4],SteeringBatch::AccuracyString((SteeringBatch::ACCURACY_T)idx)) == 0)
+         {
+            config.accuracy = (SteeringBatch::ACCURACY_T)idx;
+            found = true;
+         }
+      }
+      if(!found)
+      {
+         return false;
+      }
+   }
+   if(argc > 5)
+   {
+      config.threads = atoi(argv[5]);
+   }
+   if(argc > 6)
+   {
+      config.tracePath = argv[6];
+   }
+   return config.entities > 0 && config.ticks > 0;
+}
+
+static void CreateEntities(Simulation& sim, const BENCHMARK_CONFIG_T& config)
+{
+   // Lay the entities out on a square grid big enough
+   // that they do not start out overlapping.
+   const float32 spacing = 6.0;
+   uint32 side = (uint32)ceil(sqrt((double)config.entities));
+   float32 offset = -0.5*spacing*(side-1);
+   
+   if(config.type == BT_SWARM)
+   {
+      sim.GetSwarm().Reserve(config.entities);
+      sim.GetSwarm().SetSteeringAccuracy(config.accuracy);
+   }
+   for(uint32 idx = 0; idx < config.entities; idx++)
+   {
+      Vec2 position(offset + spacing*(idx % side), offset + spacing*(idx / side));
+      switch(config.type)
+      {
+         case BT_MISSILE:
+            sim.AddEntity(new Missile(*sim.GetWorld(),position));
+            break;
+         case BT_MOVING_ENTITY:
+            sim.AddEntity(new MovingEntity(*sim.GetWorld(),position));
+            break;
+         case BT_SWARM:
+            sim.GetSwarm().AddMissile(position);
+            break;
+      }
+   }
+}
+
+static void Retarget(Simulation& sim, const BENCHMARK_CONFIG_T& config, BenchmarkRandom& rnd)
+{
+   float32 half = 0.5*config.worldSizeMeters;
+   for(uint32 idx = 0; idx < sim.GetEntityCount(); idx++)
+   {
+      sim.GetEntity(idx)->CommandSeek(Vec2(rnd.Next(-half,half),rnd.Next(-half,half)));
+   }
+   MissileSwarm& swarm = sim.GetSwarm();
+   for(uint32 idx = 0; idx < swarm.GetCount(); idx++)
+   {
+      swarm.CommandSeek(idx,Vec2(rnd.Next(-half,half),rnd.Next(-half,half)));
+   }
+}
+
+// FNV-1a over the raw bits of the body states.
+static void HashBytes(uint64& hash, const void* data, uint32 size)
+{
+   const uint8* bytes = (const uint8*)data;
+   for(uint32 idx = 0; idx < size; idx++)
+   {
+      hash ^= bytes[idx];
+      hash *= 1099511628211ull;
+   }
+}
+
+static uint64 StateChecksum(b2World& world)
+{
+   uint64 hash = 14695981039346656037ull;
+   for(const b2Body* body = world.GetBodyList(); body != NULL; body = body->GetNext())
+   {
+      Vec2 position = body->GetPosition();
+      Vec2 velocity = body->GetLinearVelocity();
+      float32 angle = body->GetAngle();
+      float32 angularVelocity = body->GetAngularVelocity();
+      HashBytes(hash,&position,sizeof(position));
+      HashBytes(hash,&velocity,sizeof(velocity));
+      HashBytes(hash,&angle,sizeof(angle));
+      HashBytes(hash,&angularVelocity,sizeof(angularVelocity));
+   }
+   return hash;
+}
+
+static void AccumulateProfile(b2Profile& total, const b2Profile& profile)
+{
+   total.step += profile.step;
+   total.collide += profile.collide;
+   total.solve += profile.solve;
+   total.solveInit += profile.solveInit;
+   total.solveVelocity += profile.solveVelocity;
+   total.solvePosition += profile.solvePosition;
+   total.broadphase += profile.broadphase;
+   total.solveTOI += profile.solveTOI;
+}
+
+static void PrintProfileLine(const char* name, float32 totalMs, uint32 ticks)
+{
+   printf("   %-16s %10.4f ms/tick\n",name,totalMs/ticks);
+}
+
+int main(int argc, char* argv[])
+{
+   BENCHMARK_CONFIG_T config;
+   if(!ParseArgs(argc,argv,config))
+   {
+      PrintUsage(argv[0]);
+      return 1;
+   }
+   
+   // Singletons are initialized explicitly, just like
+   // the AppDelegate does.
+   Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   Profiler::Instance().SetThreadName("Main");
+   
+   Simulation sim;
+   sim.SetThreadCount(config.threads);
+   sim.Init();
+   CreateEntities(sim,config);
+   
+   BenchmarkRandom rnd(12345);
+   b2Profile profileTotal;
+   memset(&profileTotal,0,sizeof(profileTotal));
+   
+   StopWatch entityWatch;
+   StopWatch physicsWatch;
+   StopWatch totalWatch;
+   double entitySeconds = 0.0;
+   double physicsSeconds = 0.0;
+   
+   totalWatch.Start();
+   for(uint32 tick = 0; tick < config.ticks; tick++)
+   {
+      // Each tick is a "frame" here.
+      Profiler::Instance().NextFrame();
+      if(tick % config.retargetTicks == 0)
+      {
+         Retarget(sim,config,rnd);
+      }
+      
+      entityWatch.Start();
+      sim.UpdateEntities();
+      entityWatch.Stop();
+      entitySeconds += entityWatch.GetSeconds();
+      
+      physicsWatch.Start();
+      sim.UpdatePhysics();
+      physicsWatch.Stop();
+      physicsSeconds += physicsWatch.GetSeconds();
+      
+      AccumulateProfile(profileTotal,sim.GetProfile());
+   }
+   Profiler::Instance().NextFrame();
+   totalWatch.Stop();
+   double totalSeconds = totalWatch.GetSeconds();
+   
+   if(config.type == BT_SWARM)
+   {
+      printf("Entities         : %u (%s, %s steering)\n",config.entities,BenchmarkTypeString(config.type),
+             SteeringBatch::AccuracyString(config.accuracy));
+   }
+   else
+   {
+      printf("Entities         : %u (%s)\n",config.entities,BenchmarkTypeString(config.type));
+   }
+   printf("Threads          : %u\n",sim.GetThreadCount());
+   printf("Ticks            : %u @ %.4f s/tick\n",config.ticks,SECONDS_PER_TICK);
+   printf("Wall time        : %.3f s\n",totalSeconds);
+   printf("Ticks/sec        : %.1f\n",config.ticks/totalSeconds);
+   printf("Realtime factor  : %.2fx\n",(config.ticks*SECONDS_PER_TICK)/totalSeconds);
+   printf("Entity update    : %.1f ns/entity\n",1.0E9*entitySeconds/((double)config.ticks*config.entities));
+   printf("Physics step     : %.4f ms/tick\n",1.0E3*physicsSeconds/config.ticks);
+   printf("b2Profile (avg):\n");
+   PrintProfileLine("step",profileTotal.step,config.ticks);
+   PrintProfileLine("collide",profileTotal.collide,config.ticks);
+   PrintProfileLine("solve",profileTotal.solve,config.ticks);
+   PrintProfileLine("solveInit",profileTotal.solveInit,config.ticks);
+   PrintProfileLine("solveVelocity",profileTotal.solveVelocity,config.ticks);
+   PrintProfileLine("solvePosition",profileTotal.solvePosition,config.ticks);
+   PrintProfileLine("broadphase",profileTotal.broadphase,config.ticks);
+   PrintProfileLine("solveTOI",profileTotal.solveTOI,config.ticks);
+   Profiler::FRAME_STATS_T frameStats;
+   if(Profiler::Instance().GetFrameStats(frameStats))
+   {
+      printf("Tick time (last %u): p50 %.4f ms, p99 %.4f ms, max %.4f ms\n",frameStats.frames,
+             1.0E3*frameStats.p50,1.0E3*frameStats.p99,1.0E3*frameStats.max);
+   }
+   if(config.tracePath != NULL)
+   {
+      if(Profiler::Instance().WriteChromeTrace(config.tracePath))
+      {
+         printf("Trace            : %s\n",config.tracePath);
+      }
+      else
+      {
+         printf("Trace            : could not write %s\n",config.tracePath);
+      }
+   }
+   
+   printf("State checksum   : %016llx\n",StateChecksum(*sim.GetWorld()));
+   
+   sim.Shutdown();
+   Profiler::Instance().Shutdown();
+   Telemetry::Instance().Shutdown();
+   Notifier::Instance().Shutdown();
+   return 0;
+}
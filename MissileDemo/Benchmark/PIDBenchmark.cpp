@@ -0,0 +1,322 @@
+/********************************************************************
+ * File   : PIDBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/6/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Accuracy and speed check for the PIDController.
+ *
+ * Feeds the same error signal to the PIDController and
+ * to a copy of the original implementation (history in
+ * a vector, Extended Simpson's Rule recomputed over the
+ * whole history on every sample) and reports the largest
+ * difference in the outputs and the cost per sample.
+ *
+ * Then runs a set of controllers as PIDController
+ * objects and as a PIDControllerBank (scalar and SIMD
+ * kernels) over the same errors and reports the cost
+ * per controller update.
+ *
+ * Usage:
+ *    pid_benchmark [samples] [history] [controllers]
+ */
+
+#include "CommonSTL.h"
+#include "PIDController.h"
+#include "PIDControllerBank.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+#include <cstring>
+
+// The original vector based controller, kept here as
+// the reference for the results.
+class ReferencePIDController
+{
+private:
+   double _dt;
+   uint32 _maxHistory;
+   double _kIntegral;
+   double _kProportional;
+   double _kDerivative;
+   double _kPlant;
+   vector<double> _errors;
+   vector<double> _outputs;
+   
+   void CalculateNextOutput()
+   {
+      if(_errors.size() < PIDController::MIN_SAMPLES)
+      {
+         _outputs.push_back(0.0);
+      }
+      else
+      {
+         size_t errorSize = _errors.size();
+         double prop = _kProportional * _errors[errorSize-1];
+         double integral = 0;
+         for(uint32 idx = 1; idx < errorSize-1; idx+=2)
+         {
+            integral += 4*_errors[idx];
+         }
+         for(uint32 idx = 2; idx < errorSize-1; idx+=2)
+         {
+            integral += 2*_errors[idx];
+         }
+         integral += _errors[0];
+         integral += _errors[errorSize-1];
+         integral /= (3*_dt);
+         integral *= _kIntegral;
+         double deriv = _kDerivative * (_errors[errorSize-1]-_errors[errorSize-2]) / _dt;
+         _outputs.push_back(_kPlant * (prop + integral + deriv));
+      }
+   }
+   
+public:
+   ReferencePIDController(uint32 maxHistory) :
+      _dt(1.0/100),
+      _maxHistory(maxHistory),
+      _kIntegral(0.05),
+      _kProportional(1.0),
+      _kDerivative(5.0),
+      _kPlant(1.0)
+   {
+   }
+   
+   void AddSample(double error)
+   {
+      _errors.push_back(error);
+      while(_errors.size() > _maxHistory)
+      {
+         _errors.erase(_errors.begin());
+      }
+      CalculateNextOutput();
+   }
+   
+   double GetLastOutput() { size_t os = _outputs.size(); if(os == 0) return 0.0; return _outputs[os-1]; }
+};
+
+static void SetupController(PIDController& controller, uint32 maxHistory)
+{
+   controller.SetMaxHistory(maxHistory);
+   controller.SetKProportional(1.0);
+   controller.SetKIntegral(0.05);
+   controller.SetKDerivative(5.0);
+   controller.SetKPlant(1.0);
+}
+
+static void SetupBank(PIDControllerBank& bank, uint32 maxHistory, uint32 controllers)
+{
+   bank.Init(maxHistory);
+   bank.Reserve(controllers);
+   for(uint32 idx = 0; idx < controllers; idx++)
+   {
+      bank.AddController();
+      bank.SetKProportional(idx,1.0);
+      bank.SetKIntegral(idx,0.05);
+      bank.SetKDerivative(idx,5.0);
+      bank.SetKPlant(idx,1.0);
+   }
+}
+
+// Each controller sees the error signal with its own
+// phase offset.  The table is a power of two long so the
+// lookup does not cost more than the controllers do.
+enum
+{
+   ERROR_TABLE_SIZE = 1024
+};
+
+static inline double ControllerError(const vector<double>& errors, uint32 tick, uint32 controller)
+{
+   return errors[(tick + controller*37) & (ERROR_TABLE_SIZE-1)];
+}
+
+static double RunObjects(const vector<double>& errors, uint32 maxHistory, uint32 controllers, uint32 ticks,
+                         vector<double>& outputs)
+{
+   vector<PIDController> objects(controllers);
+   for(uint32 idx = 0; idx < controllers; idx++)
+   {
+      SetupController(objects[idx],maxHistory);
+   }
+   StopWatch watch;
+   watch.Start();
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      for(uint32 idx = 0; idx < controllers; idx++)
+      {
+         objects[idx].AddSample(ControllerError(errors,tick,idx));
+         outputs[idx] = objects[idx].GetLastOutput();
+      }
+   }
+   watch.Stop();
+   return watch.GetSeconds();
+}
+
+static double RunBank(const vector<double>& errors, uint32 maxHistory, uint32 controllers, uint32 ticks,
+                      PIDControllerBank::KERNEL_TYPE_T kernel, vector<double>& outputs)
+{
+   PIDControllerBank bank;
+   SetupBank(bank,maxHistory,controllers);
+   bank.SetKernel(kernel);
+   StopWatch watch;
+   watch.Start();
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      for(uint32 idx = 0; idx < controllers; idx++)
+      {
+         bank.AddSample(idx,ControllerError(errors,tick,idx));
+      }
+      bank.Evaluate();
+   }
+   watch.Stop();
+   for(uint32 idx = 0; idx < controllers; idx++)
+   {
+      outputs[idx] = bank.GetLastOutput(idx);
+   }
+   return watch.GetSeconds();
+}
+
+static double MaxDifference(const vector<double>& lhs, const vector<double>& rhs)
+{
+   double result = 0.0;
+   for(uint32 idx = 0; idx < lhs.size(); idx++)
+   {
+      result = Max(result,fabs(lhs[idx]-rhs[idx]));
+   }
+   return result;
+}
+
+// A wandering angle error, roughly what a missile
+// chasing a moving point sees.
+static double ErrorSignal(uint32 sample)
+{
+   double t = sample*SECONDS_PER_TICK;
+   return 2.0*sin(0.7*t) + 0.5*sin(5.3*t+1.0) + 0.01*((sample*7919) % 101 - 50);
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 samples = 1000000;
+   uint32 maxHistory = 7;
+   uint32 controllers = 10000;
+   if(argc > 1)
+   {
+      samples = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      maxHistory = atoi(argv[2]);
+   }
+   if(argc > 3)
+   {
+      controllers = atoi(argv[3]);
+   }
+   if(samples == 0 || controllers == 0 ||
+      maxHistory < PIDController::MIN_SAMPLES ||
+      maxHistory > PIDController::MAX_HISTORY_CAPACITY)
+   {
+      printf("Usage: %s [samples] [history (%d..%d)] [controllers]\n",argv[0],
+             PIDController::MIN_SAMPLES,PIDController::MAX_HISTORY_CAPACITY);
+      return 1;
+   }
+   
+   vector<double> errors(samples);
+   for(uint32 idx = 0; idx < samples; idx++)
+   {
+      errors[idx] = ErrorSignal(idx);
+   }
+   
+   // Accuracy
+   PIDController controller;
+   SetupController(controller,maxHistory);
+   ReferencePIDController reference(maxHistory);
+   double maxOutputDiff = 0.0;
+   double maxRelativeDiff = 0.0;
+   for(uint32 idx = 0; idx < samples; idx++)
+   {
+      controller.AddSample(errors[idx]);
+      reference.AddSample(errors[idx]);
+      double diff = fabs(controller.GetLastOutput() - reference.GetLastOutput());
+      maxOutputDiff = Max(maxOutputDiff,diff);
+      if(fabs(reference.GetLastOutput()) > 1.0E-6)
+      {
+         maxRelativeDiff = Max(maxRelativeDiff,diff/fabs(reference.GetLastOutput()));
+      }
+   }
+   
+   // Speed
+   StopWatch watch;
+   double sink = 0.0;
+   
+   PIDController timedController;
+   SetupController(timedController,maxHistory);
+   watch.Start();
+   for(uint32 idx = 0; idx < samples; idx++)
+   {
+      timedController.AddSample(errors[idx]);
+      sink += timedController.GetLastOutput();
+   }
+   watch.Stop();
+   double ringSeconds = watch.GetSeconds();
+   
+   ReferencePIDController timedReference(maxHistory);
+   watch.Start();
+   for(uint32 idx = 0; idx < samples; idx++)
+   {
+      timedReference.AddSample(errors[idx]);
+      sink += timedReference.GetLastOutput();
+   }
+   watch.Stop();
+   double referenceSeconds = watch.GetSeconds();
+   
+   printf("Samples          : %u (history %u)\n",samples,maxHistory);
+   printf("Max output diff  : %.3e (relative %.3e)\n",maxOutputDiff,maxRelativeDiff);
+   printf("PIDController    : %.2f ns/sample\n",1.0E9*ringSeconds/samples);
+   printf("Reference        : %.2f ns/sample\n",1.0E9*referenceSeconds/samples);
+   
+   // Many controllers:  objects vs. the bank.
+   uint32 ticks = Max(samples/controllers,(uint32)1);
+   double updates = (double)ticks*controllers;
+   vector<double> objectOutputs(controllers);
+   vector<double> scalarOutputs(controllers);
+   vector<double> simdOutputs(controllers);
+   vector<double> errorTable(ERROR_TABLE_SIZE);
+   for(uint32 idx = 0; idx < ERROR_TABLE_SIZE; idx++)
+   {
+      errorTable[idx] = errors[idx % errors.size()];
+   }
+   double objectSeconds = RunObjects(errorTable,maxHistory,controllers,ticks,objectOutputs);
+   double scalarSeconds = RunBank(errorTable,maxHistory,controllers,ticks,PIDControllerBank::KT_SCALAR,scalarOutputs);
+   double simdSeconds = RunBank(errorTable,maxHistory,controllers,ticks,PIDControllerBank::KT_SIMD,simdOutputs);
+   
+   printf("Controllers      : %u x %u ticks\n",controllers,ticks);
+   printf("PIDController    : %.2f ns/update\n",1.0E9*objectSeconds/updates);
+   printf("Bank (scalar)    : %.2f ns/update (max diff %.3e)\n",1.0E9*scalarSeconds/updates,
+          MaxDifference(objectOutputs,scalarOutputs));
+   printf("Bank (%s)%*s: %.2f ns/update (max diff %.3e)\n",PIDControllerBank::GetSIMDName(),
+          (int)(10-strlen(PIDControllerBank::GetSIMDName())),"",
+          1.0E9*simdSeconds/updates,MaxDifference(objectOutputs,simdOutputs));
+   printf("(checksum %g)\n",sink);
+   return 0;
+}
@@ -0,0 +1,426 @@
+/********************************************************************
+ * File   : PathfindingBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+/* Grid pathfinder cache and repair check.
+ *
+ * The world is WORLD_SIZE across, with pseudo-random static
+ * boxes and a few kinematic "gates" that move around.
+ *
+ *    cache   - missiles launched from a few sites at a few
+ *              targets each ask for a path, with the path
+ *              cache on and off.  Reported are the time for
+ *              all of the requests, the cache hits and
+ *              misses and the cells the planners expanded.
+ *    repair  - the gates move, then the pathfinder repairs
+ *              its planners (UpdateObstacles()) and the
+ *              paths are asked for again, against a new
+ *              pathfinder planning from scratch.  Every
+ *              path's cost must match the one from a flow
+ *              field built over the same blocked cells.
+ *    follow  - an entity from each site to each target
+ *              follows its planned path; reported is how
+ *              many got to the end.
+ *
+ * Usage:
+ *    pathfinding_benchmark [missiles] [rounds]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Simulation.h"
+#include "MovingEntity.h"
+#include "GridPathfinder.h"
+#include "FlowField.h"
+#include "Path.h"
+#include "Stopwatch.h"
+#include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include <cstdlib>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+const float32 WORLD_SIZE = 200.0;
+const float32 CELL_SIZE = 1.0;
+// About half the length of an entity.
+const float32 CLEARANCE = 3.0;
+const uint32 BOX_COUNT = 40;
+const uint32 GATE_COUNT = 6;
+const float32 GATE_STEP = 3.0;
+const uint32 SITE_COUNT = 4;
+const uint32 GOAL_COUNT = 3;
+const float32 SITE_SPREAD = 1.0;
+// One entity from each site to each target.
+const uint32 FOLLOW_COUNT = SITE_COUNT*GOAL_COUNT;
+const uint32 FOLLOW_TICKS = 1800;
+
+typedef struct
+{
+   Vec2 start;
+   Vec2 goal;
+} REQUEST_T;
+
+static b2Body* AddBox(b2World& world, b2BodyType bodyType, const Vec2& center, const Vec2& size)
+{
+   b2BodyDef bodyDef;
+   bodyDef.type = bodyType;
+   bodyDef.position = center;
+   b2Body* body = world.CreateBody(&bodyDef);
+   b2PolygonShape shape;
+   shape.SetAsBox(0.5*size.x,0.5*size.y);
+   body->CreateFixture(&shape,1.0);
+   return body;
+}
+
+// Static boxes, kept off the launch sites and targets
+// (which are near the edges and in the middle).
+static void AddBoxes(b2World& world, vector<b2Body*>& gates)
+{
+   BenchmarkRandom rnd(1313);
+   float32 half = 0.35*WORLD_SIZE;
+   for(uint32 idx = 0; idx < BOX_COUNT; idx++)
+   {
+      Vec2 center(rnd.Next(-half,half),rnd.Next(-half,half));
+      Vec2 size(rnd.Next(2,16),rnd.Next(2,16));
+      if(center.Length() < 15)
+      {
+         center *= 2;
+      }
+      AddBox(world,b2_staticBody,center,size);
+   }
+   gates.clear();
+   for(uint32 idx = 0; idx < GATE_COUNT; idx++)
+   {
+      Vec2 center(rnd.Next(-half,half),rnd.Next(-half,half));
+      gates.push_back(AddBox(world,b2_kinematicBody,center,Vec2(20,2)));
+   }
+}
+
+// Gates slide a few meters and turn a little.
+static void MoveGates(const vector<b2Body*>& gates, BenchmarkRandom& rnd)
+{
+   float32 half = 0.35*WORLD_SIZE;
+   for(uint32 idx = 0; idx < gates.size(); idx++)
+   {
+      Vec2 center = gates[idx]->GetPosition() + Vec2(rnd.Next(-GATE_STEP,GATE_STEP),rnd.Next(-GATE_STEP,GATE_STEP));
+      center.x = Max(-half,Min(half,center.x));
+      center.y = Max(-half,Min(half,center.y));
+      gates[idx]->SetTransform(center,gates[idx]->GetAngle() + rnd.Next(-0.2,0.2));
+   }
+}
+
+// Missiles around a few sites at the edges of the world,
+// each going to one of the targets near the middle.
+static void MakeRequests(uint32 missiles, vector<REQUEST_T>& requests)
+{
+   BenchmarkRandom rnd(99);
+   float32 edge = 0.45*WORLD_SIZE;
+   const Vec2 sites[SITE_COUNT] =
+   {
+      Vec2(-edge,-edge),
+      Vec2(edge,-edge),
+      Vec2(edge,edge),
+      Vec2(-edge,edge)
+   };
+   const Vec2 goals[GOAL_COUNT] =
+   {
+      Vec2(0,0),
+      Vec2(8,-6),
+      Vec2(-6,8)
+   };
+   requests.clear();
+   for(uint32 idx = 0; idx < missiles; idx++)
+   {
+      REQUEST_T request;
+      request.start = sites[idx % SITE_COUNT] + Vec2(rnd.Next(-SITE_SPREAD,SITE_SPREAD),
+                                                      rnd.Next(-SITE_SPREAD,SITE_SPREAD));
+      request.goal = goals[(idx / SITE_COUNT) % GOAL_COUNT];
+      requests.push_back(request);
+   }
+}
+
+// The cost of a path in the planner's units (10 for a
+// straight step, 14 for a diagonal).  The paths only keep
+// the turns, so each leg is all straight or all diagonal.
+static uint32 PathCost(const Path* path)
+{
+   uint32 cost = 0;
+   for(uint32 idx = 1; idx < path->GetPointCount(); idx++)
+   {
+      Vec2 leg = path->GetPoint(idx) - path->GetPoint(idx-1);
+      uint32 dx = (uint32)(fabsf(leg.x)/CELL_SIZE + 0.5f);
+      uint32 dy = (uint32)(fabsf(leg.y)/CELL_SIZE + 0.5f);
+      cost += (dx == 0 || dy == 0) ? 10*(dx + dy) : 14*dx;
+   }
+   return cost;
+}
+
+// Checks every path the pathfinder gives against a flow
+// field over the same cells.
+class CostChecker
+{
+private:
+   map<uint32,FlowField*> _fields;
+   
+public:
+   ~CostChecker()
+   {
+      for(map<uint32,FlowField*>::iterator iter = _fields.begin(); iter != _fields.end(); ++iter)
+      {
+         delete iter->second;
+      }
+   }
+   
+   // After the obstacles have moved.
+   void Reset(const GridPathfinder& pathfinder)
+   {
+      for(map<uint32,FlowField*>::iterator iter = _fields.begin(); iter != _fields.end(); ++iter)
+      {
+         FlowField* field = iter->second;
+         for(uint32 cell = 0; cell < pathfinder.GetWidth()*pathfinder.GetHeight(); cell++)
+         {
+            uint32 x = cell % pathfinder.GetWidth();
+            uint32 y = cell / pathfinder.GetWidth();
+            field->SetCost(x,y,pathfinder.IsBlocked(cell) ? (uint8)FlowField::COST_BLOCKED : (uint8)FlowField::COST_MIN);
+         }
+         field->Update(NULL);
+      }
+   }
+   
+   bool Check(const GridPathfinder& pathfinder, const REQUEST_T& request, const Path* path)
+   {
+      uint32 goalCell = pathfinder.GetCell(request.goal);
+      FlowField*& field = _fields[goalCell];
+      if(field == NULL)
+      {
+         field = new FlowField();
+         field->Init(WORLD_SIZE,WORLD_SIZE,CELL_SIZE);
+         field->SetGoal(pathfinder.GetCellCenter(goalCell));
+         _fields[goalCell] = field;
+         Reset(pathfinder);
+      }
+      uint32 startCell = pathfinder.GetCell(request.start);
+      uint32 expected = pathfinder.IsBlocked(goalCell) ? (uint32)FlowField::UNREACHABLE :
+         field->GetIntegration(startCell % pathfinder.GetWidth(),startCell / pathfinder.GetWidth());
+      if(path == NULL)
+      {
+         return expected == FlowField::UNREACHABLE;
+      }
+      return expected == PathCost(path);
+   }
+};
+
+static double FindPaths(GridPathfinder& pathfinder, const vector<REQUEST_T>& requests)
+{
+   StopWatch watch;
+   watch.Start();
+   for(uint32 idx = 0; idx < requests.size(); idx++)
+   {
+      pathfinder.FindPath(requests[idx].start,requests[idx].goal);
+   }
+   watch.Stop();
+   return 1.0E3*watch.GetSeconds();
+}
+
+static void RunCache(b2World& world, const vector<REQUEST_T>& requests)
+{
+   printf("   %-10s %10s %8s %8s %10s\n","cache","time (ms)","hits","misses","expanded");
+   for(uint32 cached = 0; cached < 2; cached++)
+   {
+      GridPathfinder pathfinder;
+      pathfinder.Init(&world,WORLD_SIZE,WORLD_SIZE,CELL_SIZE,CLEARANCE);
+      pathfinder.SetMaxPaths(cached ? (uint32)GridPathfinder::DEFAULT_MAX_PATHS : 0);
+      double ms = FindPaths(pathfinder,requests);
+      printf("   %-10s %10.3f %8u %8u %10u\n",cached ? "on" : "off",ms,pathfinder.GetHitCount(),
+             pathfinder.GetMissCount(),pathfinder.GetExpandedCount());
+      pathfinder.Shutdown();
+   }
+   printf("\n");
+}
+
+static bool RunRepairs(b2World& world, const vector<b2Body*>& gates, const vector<REQUEST_T>& requests,
+                       uint32 rounds)
+{
+   GridPathfinder repaired;
+   repaired.Init(&world,WORLD_SIZE,WORLD_SIZE,CELL_SIZE,CLEARANCE);
+   // Enough planners for all of the targets.
+   repaired.SetMaxPlanners(GOAL_COUNT);
+   FindPaths(repaired,requests);
+   CostChecker checker;
+   
+   BenchmarkRandom rnd(2024);
+   StopWatch watch;
+   double repairMs = 0;
+   double scratchMs = 0;
+   uint32 repairExpanded = 0;
+   uint32 scratchExpanded = 0;
+   uint32 changedCells = 0;
+   uint32 noPath = 0;
+   bool same = true;
+   for(uint32 round = 0; round < rounds; round++)
+   {
+      MoveGates(gates,rnd);
+      
+      uint32 expandedBefore = repaired.GetExpandedCount();
+      watch.Start();
+      changedCells += repaired.UpdateObstacles();
+      watch.Stop();
+      repairMs += 1.0E3*watch.GetSeconds();
+      repairMs += FindPaths(repaired,requests);
+      repairExpanded += repaired.GetExpandedCount() - expandedBefore;
+      
+      GridPathfinder scratch;
+      watch.Start();
+      scratch.Init(&world,WORLD_SIZE,WORLD_SIZE,CELL_SIZE,CLEARANCE);
+      scratch.SetMaxPlanners(GOAL_COUNT);
+      watch.Stop();
+      scratchMs += 1.0E3*watch.GetSeconds();
+      scratchMs += FindPaths(scratch,requests);
+      scratchExpanded += scratch.GetExpandedCount();
+      
+      checker.Reset(repaired);
+      for(uint32 idx = 0; idx < requests.size(); idx++)
+      {
+         const Path* path = repaired.FindPath(requests[idx].start,requests[idx].goal);
+         const Path* fresh = scratch.FindPath(requests[idx].start,requests[idx].goal);
+         if(path == NULL)
+         {
+            noPath++;
+         }
+         same = same && checker.Check(repaired,requests[idx],path) && checker.Check(scratch,requests[idx],fresh);
+      }
+      scratch.Shutdown();
+   }
+   repaired.Shutdown();
+   printf("Rounds           : %u, %.1f cells changed each\n\n",rounds,(double)changedCells/rounds);
+   printf("   %-10s %10s %10s %8s\n","plan","time (ms)","expanded","same");
+   printf("   %-10s %10.3f %10u %8s\n","repair",repairMs/rounds,repairExpanded/rounds,same ? "yes" : "NO");
+   printf("   %-10s %10.3f %10u %8s\n","scratch",scratchMs/rounds,scratchExpanded/rounds,"-");
+   printf("   (%u requests without a path)\n\n",noPath);
+   return same;
+}
+
+static void RunFollow(Simulation& sim, GridPathfinder& pathfinder, const vector<REQUEST_T>& requests)
+{
+   pathfinder.UpdateObstacles();
+   uint32 added = 0;
+   for(uint32 idx = 0; idx < requests.size() && idx < FOLLOW_COUNT; idx++)
+   {
+      const Path* path = pathfinder.FindPath(requests[idx].start,requests[idx].goal);
+      if(path == NULL)
+      {
+         continue;
+      }
+      MovingEntity* entity = new MovingEntity(*sim.GetWorld(),requests[idx].start);
+      sim.AddEntity(entity);
+      entity->CommandFollowPath(path);
+      added++;
+   }
+   for(uint32 tick = 0; tick < FOLLOW_TICKS; tick++)
+   {
+      sim.UpdateEntities();
+      sim.UpdatePhysics();
+   }
+   uint32 arrived = 0;
+   for(uint32 idx = 0; idx < sim.GetEntityCount(); idx++)
+   {
+      if(sim.GetEntity(idx)->GetState() == MovingEntityIFace::ST_IDLE)
+      {
+         arrived++;
+      }
+   }
+   printf("Follow           : %u entities, %u at the end after %u ticks\n",added,arrived,FOLLOW_TICKS);
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 missiles = 1000;
+   uint32 rounds = 20;
+   if(argc > 1)
+   {
+      missiles = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      rounds = atoi(argv[2]);
+   }
+   if(missiles == 0 || rounds == 0)
+   {
+      printf("Usage: %s [missiles] [rounds]\n",argv[0]);
+      return 1;
+   }
+   
+   // Singletons are initialized explicitly, just like
+   // the AppDelegate does.
+   Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   Profiler::Instance().SetThreadName("Main");
+   
+   Simulation sim;
+   sim.Init();
+   b2World& world = *sim.GetWorld();
+   vector<b2Body*> gates;
+   AddBoxes(world,gates);
+   vector<REQUEST_T> requests;
+   MakeRequests(missiles,requests);
+   
+   printf("World            : %.0f m, %.1f m cells, %.1f m clearance\n",WORLD_SIZE,CELL_SIZE,CLEARANCE);
+   printf("Requests         : %u missiles, %u sites, %u targets\n\n",missiles,SITE_COUNT,GOAL_COUNT);
+   RunCache(world,requests);
+   bool repairsMatch = RunRepairs(world,gates,requests,rounds);
+   
+   GridPathfinder pathfinder;
+   pathfinder.Init(&world,WORLD_SIZE,WORLD_SIZE,CELL_SIZE,CLEARANCE);
+   RunFollow(sim,pathfinder,requests);
+   pathfinder.Shutdown();
+   sim.Shutdown();
+   
+   Profiler::Instance().Shutdown();
+   Telemetry::Instance().Shutdown();
+   Notifier::Instance().Shutdown();
+   if(!repairsMatch)
+   {
+      printf("\nFAILED: the path costs do not match.\n");
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,236 @@
+/********************************************************************
+ * File   : SeparationBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Contact check for the separation steering.
+ *
+ * A dense crowd (the same layout as missile_benchmark)
+ * seeks pseudo-random points, re-issued periodically so
+ * the paths keep crossing.  Each kind of entity is run
+ * with the separation off and on, and the contacts and
+ * the time spent on them are compared:
+ *
+ *    contacts - contacts in the world (AABBs overlapping).
+ *    touching - contacts with the shapes touching.
+ *    collide  - b2Profile collide time.
+ *    solve    - b2Profile solve time.
+ *    entities - the entity update, including the neighbor
+ *               queries when the separation is on.
+ *
+ * Usage:
+ *    separation_benchmark [entities] [ticks] [radius (m)] [weight]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Simulation.h"
+#include "Missile.h"
+#include "MovingEntity.h"
+#include "MissileSwarm.h"
+#include "Stopwatch.h"
+#include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
+#include <cstdlib>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+typedef enum
+{
+   CT_MISSILE,
+   CT_MOVING_ENTITY,
+   CT_SWARM,
+   CT_MAX
+} CROWD_TYPE_T;
+
+static const char* CrowdTypeString(CROWD_TYPE_T crowdType)
+{
+   static const char* names[] =
+   {
+      "missile",
+      "moving",
+      "swarm",
+   };
+   return names[crowdType];
+}
+
+typedef struct
+{
+   double contacts;
+   double touching;
+   double collideMs;
+   double solveMs;
+   double entityMs;
+} RESULT_T;
+
+const float32 WORLD_SIZE = 400.0;
+const float32 SPACING = 12.0;
+const uint32 RETARGET_TICKS = 5*TICKS_PER_SECOND;
+
+static void RunCrowd(CROWD_TYPE_T crowdType, uint32 entities, uint32 ticks, float32 radius, float32 weight,
+                     RESULT_T& result)
+{
+   Simulation sim;
+   sim.Init();
+   MissileSwarm& swarm = sim.GetSwarm();
+   sim.SetSeparation(crowdType != CT_SWARM ? radius : 0,weight);
+   swarm.SetSeparation(crowdType == CT_SWARM ? radius : 0,weight);
+   
+   uint32 side = (uint32)ceil(sqrt((double)entities));
+   float32 offset = -0.5*SPACING*(side-1);
+   for(uint32 idx = 0; idx < entities; idx++)
+   {
+      Vec2 position(offset + SPACING*(idx % side), offset + SPACING*(idx / side));
+      switch(crowdType)
+      {
+         case CT_MISSILE:
+            sim.AddEntity(new Missile(*sim.GetWorld(),position));
+            break;
+         case CT_MOVING_ENTITY:
+            sim.AddEntity(new MovingEntity(*sim.GetWorld(),position));
+            break;
+         default:
+            swarm.AddMissile(position);
+            break;
+      }
+   }
+   
+   BenchmarkRandom rnd(12345);
+   StopWatch entityWatch;
+   memset(&result,0,sizeof(result));
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      if(tick % RETARGET_TICKS == 0)
+      {
+         float32 half = 0.5*WORLD_SIZE;
+         for(uint32 idx = 0; idx < sim.GetEntityCount(); idx++)
+         {
+            sim.GetEntity(idx)->CommandSeek(Vec2(rnd.Next(-half,half),rnd.Next(-half,half)));
+         }
+         for(uint32 idx = 0; idx < swarm.GetCount(); idx++)
+         {
+            swarm.CommandSeek(idx,Vec2(rnd.Next(-half,half),rnd.Next(-half,half)));
+         }
+      }
+      
+      entityWatch.Start();
+      sim.UpdateEntities();
+      entityWatch.Stop();
+      result.entityMs += 1.0E3*entityWatch.GetSeconds();
+      sim.UpdatePhysics();
+      
+      const b2Profile& profile = sim.GetProfile();
+      result.collideMs += profile.collide;
+      result.solveMs += profile.solve;
+      result.contacts += sim.GetWorld()->GetContactCount();
+      for(const b2Contact* contact = sim.GetWorld()->GetContactList(); contact != NULL; contact = contact->GetNext())
+      {
+         if(contact->IsTouching())
+         {
+            result.touching++;
+         }
+      }
+   }
+   result.contacts /= ticks;
+   result.touching /= ticks;
+   result.collideMs /= ticks;
+   result.solveMs /= ticks;
+   result.entityMs /= ticks;
+   sim.Shutdown();
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 entities = 1000;
+   uint32 ticks = 600;
+   float32 radius = 12.0;
+   float32 weight = 3.0;
+   if(argc > 1)
+   {
+      entities = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      ticks = atoi(argv[2]);
+   }
+   if(argc > 3)
+   {
+      radius = atof(argv[3]);
+   }
+   if(argc > 4)
+   {
+      weight = atof(argv[4]);
+   }
+   if(entities == 0 || ticks == 0 || radius <= 0)
+   {
+      printf("Usage: %s [entities] [ticks] [radius (m)] [weight]\n",argv[0]);
+      return 1;
+   }
+   
+   // Singletons are initialized explicitly, just like
+   // the AppDelegate does.
+   Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   Profiler::Instance().SetThreadName("Main");
+   
+   printf("Entities         : %u\n",entities);
+   printf("Ticks            : %u\n",ticks);
+   printf("Separation       : %.1f m, weight %.2f\n\n",radius,weight);
+   printf("   %-8s %-4s %10s %10s %12s %10s %13s\n","crowd","sep","contacts","touching","collide (ms)",
+          "solve (ms)","entities (ms)");
+   for(uint32 crowdType = 0; crowdType < CT_MAX; crowdType++)
+   {
+      for(uint32 separation = 0; separation < 2; separation++)
+      {
+         RESULT_T result;
+         RunCrowd((CROWD_TYPE_T)crowdType,entities,ticks,separation ? radius : 0,weight,result);
+         printf("   %-8s %-4s %10.1f %10.1f %12.3f %10.3f %13.3f\n",CrowdTypeString((CROWD_TYPE_T)crowdType),
+                separation ? "on" : "off",result.contacts,result.touching,result.collideMs,result.solveMs,
+                result.entityMs);
+      }
+   }
+   
+   Profiler::Instance().Shutdown();
+   Telemetry::Instance().Shutdown();
+   Notifier::Instance().Shutdown();
+   return 0;
+}
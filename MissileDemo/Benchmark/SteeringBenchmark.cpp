@@ -0,0 +1,208 @@
+/********************************************************************
+ * File   : SteeringBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/9/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Accuracy and speed check for the SteeringBatch kernels.
+ *
+ * Creates N missile bodies with random positions,
+ * headings, velocities and targets, runs the steering
+ * kernels over them and reports the cost per body and
+ * the largest difference from the exact calculation
+ * (the same one Missile does).
+ *
+ * Usage:
+ *    steering_benchmark [bodies] [passes]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "MathUtilities.h"
+#include "Missile.h"
+#include "SteeringBatch.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+// Difference between two angles, allowing for one
+// of them wrapping around at +/- PI.
+static double AngleDifference(double lhs, double rhs)
+{
+   double diff = fabs(lhs - rhs);
+   return Min(diff,fabs(diff - 2*M_PI));
+}
+
+static void CheckAtan2(uint32 points)
+{
+   BenchmarkRandom rnd(4321);
+   double maxFast = 0.0;
+   double maxFastest = 0.0;
+   for(uint32 idx = 0; idx < points; idx++)
+   {
+      float32 x = rnd.Next(-100,100);
+      float32 y = rnd.Next(-100,100);
+      double exact = atan2((double)y,(double)x);
+      maxFast = Max(maxFast,AngleDifference(MathUtilities::Atan2Fast(y,x),exact));
+      maxFastest = Max(maxFastest,AngleDifference(MathUtilities::Atan2Fastest(y,x),exact));
+   }
+   printf("Atan2Fast        : max error %.3e rads\n",maxFast);
+   printf("Atan2Fastest     : max error %.3e rads\n",maxFastest);
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 count = 10000;
+   uint32 passes = 200;
+   if(argc > 1)
+   {
+      count = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      passes = atoi(argv[2]);
+   }
+   if(count == 0 || passes == 0)
+   {
+      printf("Usage: %s [bodies] [passes]\n",argv[0]);
+      return 1;
+   }
+   
+   // The bodies.  Some of them are not moving, so the
+   // heading comes from the body angle.
+   b2World world(Vec2(0,0));
+   BenchmarkRandom rnd(12345);
+   SteeringBatch batch;
+   vector<Body*> bodies(count);
+   vector<float32> maxSpeeds(count);
+   vector<double> outputs(count);
+   const float32 maxAngularAcceleration = 4*M_PI;
+   const float32 maxLinearAcceleration = 100;
+   batch.SetCount(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      Body* body = Missile::CreateBody(world,Vec2(rnd.Next(-50,50),rnd.Next(-50,50)));
+      body->SetTransform(body->GetPosition(),rnd.Next(-20,20));
+      if(idx % 8 != 0)
+      {
+         body->SetLinearVelocity(Vec2(rnd.Next(-10,10),rnd.Next(-10,10)));
+      }
+      bodies[idx] = body;
+      maxSpeeds[idx] = rnd.Next(5,15);
+      outputs[idx] = rnd.Next(-20,20);
+      batch.SetBody(idx,body,Vec2(rnd.Next(-50,50),rnd.Next(-50,50)),
+                    maxAngularAcceleration,maxLinearAcceleration,maxSpeeds[idx]);
+      batch.SetTurnOutput(idx,outputs[idx]);
+   }
+   
+   printf("Bodies           : %u x %u passes (%s)\n",count,passes,SteeringBatch::GetSIMDName());
+   CheckAtan2(1000000);
+   
+   // Turn errors in each accuracy.
+   vector<float32> exact(count);
+   for(int32 accuracy = SteeringBatch::SA_EXACT; accuracy < SteeringBatch::SA_MAX; accuracy++)
+   {
+      StopWatch watch;
+      watch.Start();
+      for(uint32 pass = 0; pass < passes; pass++)
+      {
+         batch.CalculateTurnErrors((SteeringBatch::ACCURACY_T)accuracy);
+      }
+      watch.Stop();
+      double maxDiff = 0.0;
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         if(accuracy == SteeringBatch::SA_EXACT)
+         {
+            exact[idx] = batch.GetTurnError(idx);
+         }
+         maxDiff = Max(maxDiff,AngleDifference(batch.GetTurnError(idx),exact[idx]));
+      }
+      printf("Turn error %-6s: %.2f ns/body (max diff %.3e rads)\n",
+             SteeringBatch::AccuracyString((SteeringBatch::ACCURACY_T)accuracy),
+             1.0E9*watch.GetSeconds()/((double)passes*count),maxDiff);
+   }
+   
+   // Torques and thrust.  These must match the Missile
+   // calculation exactly.
+   StopWatch watch;
+   watch.Start();
+   for(uint32 pass = 0; pass < passes; pass++)
+   {
+      batch.CalculateTurnTorques();
+   }
+   watch.Stop();
+   double torqueSeconds = watch.GetSeconds();
+   watch.Start();
+   for(uint32 pass = 0; pass < passes; pass++)
+   {
+      batch.CalculateThrust();
+   }
+   watch.Stop();
+   double thrustSeconds = watch.GetSeconds();
+   
+   // Missile::ApplyTurnOutput(...) and Missile::ApplyThrust().
+   double maxTorqueDiff = 0.0;
+   double maxThrustDiff = 0.0;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      Body* body = bodies[idx];
+      float32 angAcc = -outputs[idx];
+      if(angAcc > maxAngularAcceleration)
+         angAcc = maxAngularAcceleration;
+      if(angAcc < -maxAngularAcceleration)
+         angAcc = -maxAngularAcceleration;
+      float32 torque = angAcc * body->GetInertia();
+      maxTorqueDiff = Max(maxTorqueDiff,fabs(torque - batch.GetTorque(idx)));
+      
+      Vec2 direction = body->GetWorldVector(Vec2(1.0,0.0));
+      float32 speed = body->GetLinearVelocity().Length();
+      if(speed >= maxSpeeds[idx])
+         speed = maxSpeeds[idx];
+      float32 thrust = maxLinearAcceleration * body->GetMass();
+      maxThrustDiff = Max(maxThrustDiff,(double)(speed*direction - batch.GetVelocity(idx)).Length());
+      maxThrustDiff = Max(maxThrustDiff,(double)(thrust*direction - batch.GetForce(idx)).Length());
+   }
+   printf("Turn torques     : %.2f ns/body (max diff %.3e)\n",1.0E9*torqueSeconds/((double)passes*count),
+          maxTorqueDiff);
+   printf("Thrust           : %.2f ns/body (max diff %.3e)\n",1.0E9*thrustSeconds/((double)passes*count),
+          maxThrustDiff);
+   return 0;
+}
@@ -0,0 +1,110 @@
+/********************************************************************
+ * File   : StopWatchBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/22/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+/* Cost and accuracy check for the StopWatch clock.
+ *
+ * Times a read of the StopWatch clock, a read of the
+ * monotonic clock (the system call it replaces when the TSC
+ * is used) and a Lap(), then checks the calibrated clock
+ * against the monotonic clock over a longer interval.
+ *
+ * Usage:
+ *    stopwatch_benchmark [reads]
+ */
+
+#include "CommonSTL.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+#include <time.h>
+
+static double MonotonicSeconds()
+{
+   timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec*1.0E-9;
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 reads = 10000000;
+   if(argc > 1)
+   {
+      reads = atoi(argv[1]);
+   }
+   if(reads == 0)
+   {
+      printf("Usage: %s [reads]\n",argv[0]);
+      return 1;
+   }
+   
+   printf("Clock            : %s (%.4f ticks/ns)\n",StopWatch::GetClockName(),
+          1.0E-9/StopWatch::GetSecondsPerTick());
+   
+   StopWatch watch;
+   uint64 sink = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < reads; idx++)
+   {
+      sink += StopWatch::GetTicks();
+   }
+   watch.Stop();
+   printf("GetTicks()       : %6.2f ns/read\n",1.0E9*watch.GetSeconds()/reads);
+   
+   double seconds = 0;
+   watch.Start();
+   for(uint32 idx = 0; idx < reads; idx++)
+   {
+      seconds += MonotonicSeconds();
+   }
+   watch.Stop();
+   printf("clock_gettime()  : %6.2f ns/read\n",1.0E9*watch.GetSeconds()/reads);
+   
+   StopWatch lapWatch;
+   watch.Start();
+   lapWatch.StartLap();
+   for(uint32 idx = 0; idx < reads; idx++)
+   {
+      lapWatch.Lap();
+   }
+   watch.Stop();
+   StopWatch::LAP_STATS_T stats;
+   lapWatch.GetLapStats(stats);
+   printf("Lap()            : %6.2f ns/lap (laps: %u, mean %.2f ns, min %.2f ns, max %.2f us, sd %.2f ns)\n",
+          1.0E9*watch.GetSeconds()/reads,stats.count,1.0E9*stats.mean,1.0E9*stats.min,1.0E6*stats.max,1.0E9*stats.stdDev);
+   
+   // Busy wait so the process is not descheduled.
+   const double interval = 0.2;
+   double monotonicStart = MonotonicSeconds();
+   watch.Start();
+   while(MonotonicSeconds() - monotonicStart < interval)
+   {
+   }
+   watch.Stop();
+   double monotonicSeconds = MonotonicSeconds() - monotonicStart;
+   double watchSeconds = watch.GetSeconds();
+   printf("Drift over %.1f s : %.2f ppm\n",interval,1.0E6*(watchSeconds-monotonicSeconds)/monotonicSeconds);
+   printf("(checksum %llu %g)\n",sink,seconds);
+   return 0;
+}
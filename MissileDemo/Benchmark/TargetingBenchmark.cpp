@@ -0,0 +1,324 @@
+/********************************************************************
+ * File   : TargetingBenchmark.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+/* Speed and correctness check for the SpatialHash and
+ * the TargetAssigner.
+ *
+ * Scatters missiles and targets at random over a square
+ * world, then compares each query with checking every
+ * missile against every target:
+ *
+ *    nearest   - the nearest target to each missile.
+ *    k-nearest - the K_NEAREST nearest, in order.
+ *    radius    - the targets within QUERY_RADIUS.
+ *
+ * The hash times include building it.  Then the
+ * TargetAssigner is compared with the same greedy
+ * assignment over every pair, and with sending every
+ * missile at its nearest target.
+ *
+ * Usage:
+ *    targeting_benchmark [missiles] [targets] [world size (m)]
+ */
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "SpatialHash.h"
+#include "TargetAssigner.h"
+#include "Stopwatch.h"
+#include <cstdlib>
+
+// A tiny LCG so that runs are repeatable across
+// platforms (rand() is not).
+class BenchmarkRandom
+{
+private:
+   uint32 _state;
+public:
+   BenchmarkRandom(uint32 seed) : _state(seed) { }
+   
+   float32 Next(float32 low, float32 high)
+   {
+      _state = _state*1664525u + 1013904223u;
+      float32 t = (_state >> 8) * (1.0f/16777216.0f);
+      return low + t*(high-low);
+   }
+};
+
+const uint32 K_NEAREST = 8;
+const float32 QUERY_RADIUS = 50.0;
+
+static bool NeighborLess(const SpatialHash::NEIGHBOR_T& left, const SpatialHash::NEIGHBOR_T& right)
+{
+   if(left.distanceSquared != right.distanceSquared)
+      return left.distanceSquared < right.distanceSquared;
+   return left.index < right.index;
+}
+
+// The k nearest targets, checking every one.
+static void BruteNearest(const Vec2& center, const vector<Vec2>& targets, uint32 k,
+                         vector<SpatialHash::NEIGHBOR_T>& scratch, SpatialHash::NEIGHBOR_T* results)
+{
+   scratch.resize(targets.size());
+   for(uint32 tdx = 0; tdx < targets.size(); tdx++)
+   {
+      scratch[tdx].index = tdx;
+      scratch[tdx].distanceSquared = (targets[tdx] - center).LengthSquared();
+   }
+   partial_sort(scratch.begin(),scratch.begin()+k,scratch.end(),NeighborLess);
+   copy(scratch.begin(),scratch.begin()+k,results);
+}
+
+typedef struct
+{
+   float32 distanceSquared;
+   uint32 missile;
+   uint32 target;
+} PAIR_T;
+
+static bool PairLess(const PAIR_T& left, const PAIR_T& right)
+{
+   if(left.distanceSquared != right.distanceSquared)
+      return left.distanceSquared < right.distanceSquared;
+   if(left.missile != right.missile)
+      return left.missile < right.missile;
+   return left.target < right.target;
+}
+
+// The same greedy assignment as the TargetAssigner,
+// over every pair.
+static void BruteAssign(const vector<Vec2>& missiles, const vector<Vec2>& targets, uint32 capacity,
+                        vector<int32>& assignment)
+{
+   vector<PAIR_T> pairs;
+   pairs.reserve(missiles.size()*targets.size());
+   for(uint32 idx = 0; idx < missiles.size(); idx++)
+   {
+      for(uint32 tdx = 0; tdx < targets.size(); tdx++)
+      {
+         PAIR_T pair;
+         pair.distanceSquared = (targets[tdx] - missiles[idx]).LengthSquared();
+         pair.missile = idx;
+         pair.target = tdx;
+         pairs.push_back(pair);
+      }
+   }
+   sort(pairs.begin(),pairs.end(),PairLess);
+   vector<uint32> load(targets.size(),0);
+   assignment.assign(missiles.size(),-1);
+   for(uint32 idx = 0; idx < pairs.size(); idx++)
+   {
+      const PAIR_T& pair = pairs[idx];
+      if(assignment[pair.missile] < 0 && load[pair.target] < capacity)
+      {
+         assignment[pair.missile] = pair.target;
+         load[pair.target]++;
+      }
+   }
+}
+
+static void PrintAssignment(const char* name, double seconds, const vector<Vec2>& missiles,
+                            const vector<Vec2>& targets, const vector<int32>& assignment)
+{
+   double totalDistance = 0;
+   float32 maxDistance = 0;
+   vector<uint32> load(targets.size(),0);
+   for(uint32 idx = 0; idx < missiles.size(); idx++)
+   {
+      float32 distance = (targets[assignment[idx]] - missiles[idx]).Length();
+      totalDistance += distance;
+      maxDistance = Max(maxDistance,distance);
+      load[assignment[idx]]++;
+   }
+   uint32 maxLoad = *max_element(load.begin(),load.end());
+   uint32 untargeted = count(load.begin(),load.end(),0u);
+   printf("   %-10s %10.3f %10.1f %10.1f %8u %10u\n",name,1.0E3*seconds,
+          totalDistance/missiles.size(),maxDistance,maxLoad,untargeted);
+}
+
+int main(int argc, char* argv[])
+{
+   uint32 missileCount = 5000;
+   uint32 targetCount = 1000;
+   float32 worldSize = 2000.0;
+   if(argc > 1)
+   {
+      missileCount = atoi(argv[1]);
+   }
+   if(argc > 2)
+   {
+      targetCount = atoi(argv[2]);
+   }
+   if(argc > 3)
+   {
+      worldSize = atof(argv[3]);
+   }
+   if(missileCount == 0 || targetCount < K_NEAREST || worldSize <= 0)
+   {
+      printf("Usage: %s [missiles] [targets (>= %u)] [world size (m)]\n",argv[0],K_NEAREST);
+      return 1;
+   }
+   
+   BenchmarkRandom rnd(12345);
+   vector<Vec2> missiles(missileCount);
+   vector<Vec2> targets(targetCount);
+   for(uint32 idx = 0; idx < missileCount; idx++)
+   {
+      missiles[idx] = Vec2(rnd.Next(0,worldSize),rnd.Next(0,worldSize));
+   }
+   for(uint32 tdx = 0; tdx < targetCount; tdx++)
+   {
+      targets[tdx] = Vec2(rnd.Next(0,worldSize),rnd.Next(0,worldSize));
+   }
+   printf("Missiles         : %u\n",missileCount);
+   printf("Targets          : %u\n",targetCount);
+   printf("World            : %.0f m square\n\n",worldSize);
+   
+   StopWatch watch;
+   SpatialHash hash;
+   vector<SpatialHash::NEIGHBOR_T> scratch;
+   vector<SpatialHash::NEIGHBOR_T> bruteResults(missileCount*K_NEAREST);
+   vector<SpatialHash::NEIGHBOR_T> hashResults(missileCount*K_NEAREST);
+   vector<uint32> found(missileCount);
+   
+   printf("   %-10s %12s %12s %8s %11s\n","query","brute (ms)","hash (ms)","speedup","mismatches");
+   for(uint32 k = 1; k <= K_NEAREST; k += K_NEAREST-1)
+   {
+      watch.Start();
+      for(uint32 idx = 0; idx < missileCount; idx++)
+      {
+         BruteNearest(missiles[idx],targets,k,scratch,&bruteResults[idx*k]);
+      }
+      watch.Stop();
+      double bruteSeconds = watch.GetSeconds();
+      
+      watch.Start();
+      hash.Build(&targets[0],targetCount);
+      hash.QueryNearest(&missiles[0],missileCount,k,&hashResults[0],&found[0]);
+      watch.Stop();
+      double hashSeconds = watch.GetSeconds();
+      
+      uint32 mismatches = 0;
+      for(uint32 idx = 0; idx < missileCount*k; idx++)
+      {
+         if(found[idx/k] != k || hashResults[idx].index != bruteResults[idx].index)
+         {
+            mismatches++;
+         }
+      }
+      printf("   %-10s %12.3f %12.3f %7.1fx %11u\n",(k == 1) ? "nearest" : "k-nearest",1.0E3*bruteSeconds,
+             1.0E3*hashSeconds,bruteSeconds/hashSeconds,mismatches);
+   }
+   
+   {
+      // The targets found for missile idx are
+      // [start[idx],start[idx+1]).
+      vector<uint32> bruteFound;
+      vector<uint32> bruteStart(missileCount+1,0);
+      vector<uint32> hashFound;
+      vector<uint32> hashStart(missileCount+1,0);
+      watch.Start();
+      for(uint32 idx = 0; idx < missileCount; idx++)
+      {
+         for(uint32 tdx = 0; tdx < targetCount; tdx++)
+         {
+            if((targets[tdx] - missiles[idx]).LengthSquared() <= QUERY_RADIUS*QUERY_RADIUS)
+            {
+               bruteFound.push_back(tdx);
+            }
+         }
+         bruteStart[idx+1] = bruteFound.size();
+      }
+      watch.Stop();
+      double bruteSeconds = watch.GetSeconds();
+      
+      watch.Start();
+      hash.Build(&targets[0],targetCount,QUERY_RADIUS);
+      for(uint32 idx = 0; idx < missileCount; idx++)
+      {
+         hash.QueryRadius(missiles[idx],QUERY_RADIUS,hashFound);
+         hashStart[idx+1] = hashFound.size();
+      }
+      watch.Stop();
+      double hashSeconds = watch.GetSeconds();
+      
+      // Same targets for each missile, in any order.
+      uint32 mismatches = 0;
+      for(uint32 idx = 0; idx < missileCount; idx++)
+      {
+         vector<uint32> hashSet(hashFound.begin()+hashStart[idx],hashFound.begin()+hashStart[idx+1]);
+         sort(hashSet.begin(),hashSet.end());
+         if(!equal(hashSet.begin(),hashSet.end(),bruteFound.begin()+bruteStart[idx]) ||
+            hashSet.size() != bruteStart[idx+1]-bruteStart[idx])
+         {
+            mismatches++;
+         }
+      }
+      printf("   %-10s %12.3f %12.3f %7.1fx %11u   (%.1f targets/missile)\n","radius",1.0E3*bruteSeconds,
+             1.0E3*hashSeconds,bruteSeconds/hashSeconds,mismatches,(double)hashFound.size()/missileCount);
+   }
+   
+   // Assignment.
+   uint32 capacity = (missileCount + targetCount - 1)/targetCount;
+   printf("\nAssignment (at most %u missiles per target):\n",capacity);
+   printf("   %-10s %10s %10s %10s %8s %10s\n","method","time (ms)","mean (m)","max (m)","max/tgt","untargeted");
+   vector<int32> assignment;
+   
+   watch.Start();
+   hash.Build(&targets[0],targetCount);
+   hash.QueryNearest(&missiles[0],missileCount,1,&hashResults[0],&found[0]);
+   watch.Stop();
+   for(uint32 idx = 0; idx < missileCount; idx++)
+   {
+      assignment.push_back(hashResults[idx].index);
+   }
+   PrintAssignment("nearest",watch.GetSeconds(),missiles,targets,assignment);
+   
+   TargetAssigner assigner;
+   vector<int32> greedy;
+   watch.Start();
+   assigner.Assign(&missiles[0],missileCount,&targets[0],targetCount,greedy,capacity);
+   watch.Stop();
+   PrintAssignment("assigner",watch.GetSeconds(),missiles,targets,greedy);
+   
+   if((uint64)missileCount*targetCount <= 50000000)
+   {
+      vector<int32> brute;
+      watch.Start();
+      BruteAssign(missiles,targets,capacity,brute);
+      watch.Stop();
+      PrintAssignment("all pairs",watch.GetSeconds(),missiles,targets,brute);
+      uint32 same = 0;
+      for(uint32 idx = 0; idx < missileCount; idx++)
+      {
+         if(brute[idx] == greedy[idx])
+            same++;
+      }
+      printf("   assigner agrees with all pairs for %.1f%% of the missiles\n",100.0*same/missileCount);
+   }
+   return 0;
+}
@@ -0,0 +1,105 @@
+/********************************************************************
+ * File   : BodyForceBuffer.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/10/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "BodyForceBuffer.h"
+
+BodyForceBuffer::BodyForceBuffer() :
+   _nextSegment(0)
+{
+}
+
+void BodyForceBuffer::Clear()
+{
+   _forces.clear();
+   _segments.clear();
+   _nextSegment = 0;
+}
+
+void BodyForceBuffer::BeginSegment(uint32 key)
+{
+   SEGMENT_T segment = { key, (uint32)_forces.size(), (uint32)_forces.size() };
+   _segments.push_back(segment);
+}
+
+bool BodyForceBuffer::SegmentKeyLess(const SEGMENT_T& lhs, const SEGMENT_T& rhs)
+{
+   return lhs.key < rhs.key;
+}
+
+void BodyForceBuffer::ApplySegment(const SEGMENT_T& segment)
+{
+   for(uint32 idx = segment.first; idx < segment.last; idx++)
+   {
+      const FORCE_T& entry = _forces[idx];
+      switch(entry.type)
+      {
+         case FT_FORCE_TO_CENTER:
+            entry.body->ApplyForceToCenter(entry.value);
+            break;
+         case FT_TORQUE:
+            entry.body->ApplyTorque(entry.value.x);
+            break;
+         default:
+            assert(false);
+      }
+   }
+}
+
+void BodyForceBuffer::ApplyInOrder(vector<BodyForceBuffer>& buffers)
+{
+   // A worker does not run its chunks in order (it may
+   // steal some), so sort each buffer's segments and then
+   // merge the buffers.
+   for(uint32 idx = 0; idx < buffers.size(); idx++)
+   {
+      sort(buffers[idx]._segments.begin(),buffers[idx]._segments.end(),SegmentKeyLess);
+   }
+   for(;;)
+   {
+      BodyForceBuffer* next = NULL;
+      for(uint32 idx = 0; idx < buffers.size(); idx++)
+      {
+         BodyForceBuffer& buffer = buffers[idx];
+         if(buffer._nextSegment < buffer._segments.size() &&
+            (next == NULL ||
+             buffer._segments[buffer._nextSegment].key < next->_segments[next->_nextSegment].key))
+         {
+            next = &buffer;
+         }
+      }
+      if(next == NULL)
+      {
+         break;
+      }
+      next->ApplySegment(next->_segments[next->_nextSegment]);
+      next->_nextSegment++;
+   }
+   for(uint32 idx = 0; idx < buffers.size(); idx++)
+   {
+      buffers[idx].Clear();
+   }
+}
@@ -0,0 +1,104 @@
+/********************************************************************
+ * File   : BodyForceBuffer.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/10/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__BodyForceBuffer__
+#define __MissileDemo__BodyForceBuffer__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+
+/* This class collects the forces and torques that a
+ * worker thread wants to apply to bodies, so they can be
+ * applied later on one thread.
+ *
+ * Each job chunk starts a segment with BeginSegment(...),
+ * keyed by the index of the first item in the chunk.
+ * ApplyInOrder(...) applies all the buffers a segment at
+ * a time in key order.  That is the same order a single
+ * thread would have applied them, no matter how many
+ * workers there were or which chunks they ran, so the
+ * results do not depend on the thread count.
+ */
+class BodyForceBuffer
+{
+private:
+   typedef enum
+   {
+      FT_FORCE_TO_CENTER,
+      FT_TORQUE,
+   } FORCE_TYPE_T;
+   
+   typedef struct
+   {
+      Body* body;
+      FORCE_TYPE_T type;
+      // The torque is in value.x.
+      Vec2 value;
+   } FORCE_T;
+   
+   typedef struct
+   {
+      uint32 key;
+      uint32 first;
+      uint32 last;
+   } SEGMENT_T;
+   
+   vector<FORCE_T> _forces;
+   vector<SEGMENT_T> _segments;
+   // Next segment for ApplyInOrder(...).
+   uint32 _nextSegment;
+   
+   static bool SegmentKeyLess(const SEGMENT_T& lhs, const SEGMENT_T& rhs);
+   void ApplySegment(const SEGMENT_T& segment);
+   
+public:
+   BodyForceBuffer();
+   
+   void Clear();
+   void BeginSegment(uint32 key);
+   
+   inline void AddForceToCenter(Body* body, const Vec2& force)
+   {
+      assert(!_segments.empty());
+      FORCE_T entry = { body, FT_FORCE_TO_CENTER, force };
+      _forces.push_back(entry);
+      _segments.back().last++;
+   }
+   
+   inline void AddTorque(Body* body, float32 torque)
+   {
+      assert(!_segments.empty());
+      FORCE_T entry = { body, FT_TORQUE, Vec2(torque,0) };
+      _forces.push_back(entry);
+      _segments.back().last++;
+   }
+   
+   // Applies the forces in all the buffers and clears them.
+   static void ApplyInOrder(vector<BodyForceBuffer>& buffers);
+};
+
+#endif /* defined(__MissileDemo__BodyForceBuffer__) */
@@ -32,6 +32,24 @@ Box2dDebugDraw::Box2dDebugDraw()
 {
    mShaderProgram = CCShaderCache::sharedShaderCache()->programForKey(kCCShader_Position_uColor);
    mColorLocation = glGetUniformLocation( mShaderProgram->getProgram(), "u_color");
+   
+   const float32 k_increment = 2.0f * b2_pi / CIRCLE_SEGMENTS;
+   float32 theta = 0.0f;
+   for (int32 i = 0; i < CIRCLE_SEGMENTS; ++i)
+   {
+      mUnitCircle[i].Set(cosf(theta), sinf(theta));
+      theta += k_increment;
+   }
+}
+
+void Box2dDebugDraw::CircleVertices(const b2Vec2& center, float32 radius, GLfloat* glVertices)
+{
+   for (int32 i = 0; i < CIRCLE_SEGMENTS; ++i)
+   {
+      CCPoint v = Viewport::Instance().Convert(center + radius * mUnitCircle[i]);
+      glVertices[i*2]=v.x;
+      glVertices[i*2+1]=v.y;
+   }
 }
 
 void Box2dDebugDraw::DrawPolygon(const b2Vec2* old_vertices, int32 vertexCount, const b2Color& color)
@@ -123,19 +141,10 @@ void Box2dDebugDraw::DrawCircle(const b2Vec2& center, float32 radius, const b2Co
    mShaderProgram->use();
    mShaderProgram->setUniformsForBuiltins();
    
-   const float32 k_segments = 16.0f;
-   const int vertexCount=16;
-   const float32 k_increment = 2.0f * b2_pi / k_segments;
-   float32 theta = 0.0f;
+   const int vertexCount=CIRCLE_SEGMENTS;
    
    GLfloat                glVertices[vertexCount*2];
-   for (int32 i = 0; i < k_segments; ++i)
-   {
-      CCPoint v = Viewport::Instance().Convert(center + radius * b2Vec2(cosf(theta), sinf(theta)));
-      glVertices[i*2]=v.x;
-      glVertices[i*2+1]=v.y;
-      theta += k_increment;
-   }
+   CircleVertices(center, radius, glVertices);
    
    mShaderProgram->setUniformLocationWith4f(mColorLocation, color.r, color.g, color.b, 1);
    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, glVertices);
@@ -152,19 +161,10 @@ void Box2dDebugDraw::DrawSolidCircle(const b2Vec2& center, float32 radius, const
    mShaderProgram->use();
    mShaderProgram->setUniformsForBuiltins();
    
-   const float32 k_segments = 16.0f;
-   const int vertexCount=16;
-   const float32 k_increment = 2.0f * b2_pi / k_segments;
-   float32 theta = 0.0f;
+   const int vertexCount=CIRCLE_SEGMENTS;
    
    GLfloat                glVertices[vertexCount*2];
-   for (int32 i = 0; i < k_segments; ++i)
-   {
-      CCPoint v = Viewport::Instance().Convert(center + radius * b2Vec2(cosf(theta), sinf(theta)));
-      glVertices[i*2]=v.x;
-      glVertices[i*2+1]=v.y;
-      theta += k_increment;
-   }
+   CircleVertices(center, radius, glVertices);
    
    mShaderProgram->setUniformLocationWith4f(mColorLocation, color.r*0.5f, color.g*0.5f, color.b*0.5f, 0.75f);
    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, glVertices);
@@ -9,8 +9,18 @@
 class Box2dDebugDraw : public b2Draw
 {
 private:
+   enum
+   {
+      CIRCLE_SEGMENTS = 16
+   };
+   
    cocos2d::CCGLProgram *mShaderProgram;
    GLint mColorLocation;
+   // Points on the unit circle for the circle segments, worked
+   // out once instead of on every DrawCircle(...) call.
+   b2Vec2 mUnitCircle[CIRCLE_SEGMENTS];
+   
+   void CircleVertices(const b2Vec2& center, float32 radius, GLfloat* glVertices);
    
 public:
    Box2dDebugDraw();
@@ -7,11 +7,14 @@
 //
 
 #include "Box2DDebugDrawLayer.h"
+#include "Simulation.h"
+#include "Profiler.h"
 
 
 Box2DDebugDrawLayer::Box2DDebugDrawLayer() :
 _world(NULL),
-_debugDraw(NULL)
+_debugDraw(NULL),
+_simulation(NULL)
 {
    
 }
@@ -33,6 +36,7 @@ Box2DDebugDrawLayer* Box2DDebugDrawLayer::create(b2World* world)
 
 void Box2DDebugDrawLayer::draw()
 {
+   PROFILE_ZONE("Box2DDebugDrawLayer::draw");
    if(_world != NULL)
    {
       CCLayer::draw();
@@ -41,12 +45,104 @@ void Box2DDebugDrawLayer::draw()
       
       kmGLPushMatrix();
       
-      _world->DrawDebugData();
+      if(_simulation != NULL)
+      {  // The shapes and centers are drawn here, the
+         // world draws the rest.
+         DrawInterpolatedBodies();
+         uint32 flags = _debugDraw->GetFlags();
+         _debugDraw->SetFlags(flags & ~(b2Draw::e_shapeBit | b2Draw::e_centerOfMassBit));
+         _world->DrawDebugData();
+         _debugDraw->SetFlags(flags);
+      }
+      else
+      {
+         _world->DrawDebugData();
+      }
       
       kmGLPopMatrix();
    }
 }
 
+// Same as b2World::DrawShape(...), which is private.
+void Box2DDebugDrawLayer::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
+{
+   switch (fixture->GetType())
+   {
+      case b2Shape::e_circle:
+      {
+         b2CircleShape* circle = (b2CircleShape*)fixture->GetShape();
+         b2Vec2 center = b2Mul(xf, circle->m_p);
+         b2Vec2 axis = b2Mul(xf.q, b2Vec2(1.0f, 0.0f));
+         _debugDraw->DrawSolidCircle(center, circle->m_radius, axis, color);
+      }
+         break;
+      case b2Shape::e_edge:
+      {
+         b2EdgeShape* edge = (b2EdgeShape*)fixture->GetShape();
+         _debugDraw->DrawSegment(b2Mul(xf, edge->m_vertex1), b2Mul(xf, edge->m_vertex2), color);
+      }
+         break;
+      case b2Shape::e_chain:
+      {
+         b2ChainShape* chain = (b2ChainShape*)fixture->GetShape();
+         b2Vec2 v1 = b2Mul(xf, chain->m_vertices[0]);
+         for (int32 i = 1; i < chain->m_count; ++i)
+         {
+            b2Vec2 v2 = b2Mul(xf, chain->m_vertices[i]);
+            _debugDraw->DrawSegment(v1, v2, color);
+            _debugDraw->DrawCircle(v1, 0.05f, color);
+            v1 = v2;
+         }
+      }
+         break;
+      case b2Shape::e_polygon:
+      {
+         b2PolygonShape* poly = (b2PolygonShape*)fixture->GetShape();
+         b2Vec2 vertices[b2_maxPolygonVertices];
+         for (int32 i = 0; i < poly->m_vertexCount; ++i)
+         {
+            vertices[i] = b2Mul(xf, poly->m_vertices[i]);
+         }
+         _debugDraw->DrawSolidPolygon(vertices, poly->m_vertexCount, color);
+      }
+         break;
+      default:
+         break;
+   }
+}
+
+// The shape and center of mass parts of b2World::DrawDebugData(),
+// using the interpolated transforms.
+void Box2DDebugDrawLayer::DrawInterpolatedBodies()
+{
+   uint32 flags = _debugDraw->GetFlags();
+   for(b2Body* body = _world->GetBodyList(); body != NULL; body = body->GetNext())
+   {
+      b2Transform xf = _simulation->GetInterpolatedTransform(body);
+      if(flags & b2Draw::e_shapeBit)
+      {
+         b2Color color(0.9f, 0.7f, 0.7f);
+         if(body->IsActive() == false)
+            color.Set(0.5f, 0.5f, 0.3f);
+         else if(body->GetType() == b2_staticBody)
+            color.Set(0.5f, 0.9f, 0.5f);
+         else if(body->GetType() == b2_kinematicBody)
+            color.Set(0.5f, 0.5f, 0.9f);
+         else if(body->IsAwake() == false)
+            color.Set(0.6f, 0.6f, 0.6f);
+         for(b2Fixture* fixture = body->GetFixtureList(); fixture != NULL; fixture = fixture->GetNext())
+         {
+            DrawShape(fixture,xf,color);
+         }
+      }
+      if(flags & b2Draw::e_centerOfMassBit)
+      {
+         xf.p = b2Mul(xf,body->GetLocalCenter());
+         _debugDraw->DrawTransform(xf);
+      }
+   }
+}
+
 bool Box2DDebugDrawLayer::init(b2World* world)
 {
    if(!CCLayer::init())
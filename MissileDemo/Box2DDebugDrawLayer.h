@@ -14,13 +14,22 @@
 
 using namespace cocos2d;
 
+class Simulation;
+
 class Box2DDebugDrawLayer : public CCLayer
 {
 private:
    // Weak reference, do not delete here.
    b2World* _world;
    Box2dDebugDraw* _debugDraw;
+   // Weak reference, do not delete here.  When set, the
+   // bodies are drawn between ticks using the simulation's
+   // interpolation alpha.
+   const Simulation* _simulation;
    Box2DDebugDrawLayer();
+   
+   void DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color);
+   void DrawInterpolatedBodies();
 protected:
    bool init(b2World* world);
 
@@ -32,6 +41,10 @@ public:
    // Use this to get the drawing tool in case the size needs
    // to be adjusted.
    Box2dDebugDraw& GetDebugDraw() { return *_debugDraw; }
+   
+   // The simulation that steps the world, for render
+   // interpolation.  NULL draws the bodies where they are.
+   void SetSimulation(const Simulation* simulation) { _simulation = simulation; }
 
 };
 
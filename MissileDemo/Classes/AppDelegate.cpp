@@ -11,6 +11,8 @@
 #include "cocos2d.h"
 #include "SimpleAudioEngine.h"
 #include "Notifier.h"
+#include "Telemetry.h"
+#include "Profiler.h"
 #include "MainScene.h"
 
 USING_NS_CC;
@@ -43,6 +45,9 @@ bool AppDelegate::applicationDidFinishLaunching()
    pDirector->setAnimationInterval(1.0 / 60);
    
    Notifier::Instance().Init();
+   Telemetry::Instance().Init();
+   Profiler::Instance().Init();
+   Profiler::Instance().SetThreadName("Main");
    
    // create a scene. it's an autorelease object
    CCScene *pScene = MainScene::create();
@@ -0,0 +1,63 @@
+/********************************************************************
+ * File   : CommonPhysics.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/2/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__CommonPhysics__
+#define __MissileDemo__CommonPhysics__
+
+/* These are the definitions shared by everything that
+ * touches the physics simulation (entities, controllers,
+ * math).  Nothing in here depends on cocos2d-x, so the
+ * simulation core can be built and run without a
+ * renderer (e.g. the headless benchmark).
+ *
+ * Anything that needs cocos2d-x types should include
+ * CommonProject.h instead (which includes this file).
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include "Box2D.h"
+
+
+#define TICKS_PER_SECOND (30)
+#define SECONDS_PER_TICK (1.0/30)
+
+
+// Some convenient shortcuts.
+typedef b2World World;
+typedef b2Body Body;
+typedef b2Vec2 Vec2;
+typedef b2ContactListener ContactListener;
+typedef b2Fixture Fixture;
+typedef b2FixtureDef FixtureDef;
+typedef b2PolygonShape PolygonShape;
+typedef b2AABB AABB;
+typedef b2Joint Joint;
+typedef b2JointEdge JointEdge;
+typedef b2Transform Transform;
+
+#endif /* defined(__MissileDemo__CommonPhysics__) */
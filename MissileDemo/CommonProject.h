@@ -29,28 +29,10 @@
 
 #include "cocos2d.h"
 #include "cocos-ext.h"
-#include "Box2D.h"
+#include "CommonPhysics.h"
 #include "tnt.h"
 #include "jama.h"
 
-
-#define TICKS_PER_SECOND (30)
-#define SECONDS_PER_TICK (1.0/30)
-
-
-// Some convenient shortcuts.
-typedef b2World World;
-typedef b2Body Body;
-typedef b2Vec2 Vec2;
-typedef b2ContactListener ContactListener;
-typedef b2Fixture Fixture;
-typedef b2FixtureDef FixtureDef;
-typedef b2PolygonShape PolygonShape;
-typedef b2AABB AABB;
-typedef b2Joint Joint;
-typedef b2JointEdge JointEdge;
-typedef b2Transform Transform;
-
 using namespace cocos2d;
 using namespace cocos2d::extension;
 using namespace TNT;
@@ -0,0 +1,123 @@
+/********************************************************************
+ * File   : CubicSplineInterpolator.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__CubicSplineInterpolator__
+#define __MissileDemo__CubicSplineInterpolator__
+
+#include "Interpolator.h"
+
+/* A natural cubic spline through the control points (the
+ * second derivative is zero at both ends).
+ *
+ * The curve is smooth (continuous first and second derivatives)
+ * so a few control points can replace a dense linear table.  It
+ * may overshoot between points where the data turns sharply; use
+ * the MonotoneCubicInterpolator if that matters.  Because of the
+ * natural end condition, it is least accurate in the first and
+ * last intervals if the real curve bends there; put the control
+ * points closer together near the ends.
+ *
+ * Create(...) solves the tridiagonal system for the second
+ * derivatives in O(n) and stores each interval as a cubic.  A
+ * spline is not local; a new control pair redoes all of it.
+ */
+template<typename Number>
+class CubicSplineInterpolator : public Interpolator<Number>
+{
+private:
+   typedef typename Interpolator<Number>::INTERVAL_T INTERVAL_T;
+   
+   // Scratch space for the solve.
+   vector<Number> _secondDerivs;
+   vector<Number> _diagonal;
+   vector<Number> _rhs;
+   
+protected:
+   virtual bool CreateInterpolation()
+   {
+      vector<INTERVAL_T>& intervals = this->_intervals;
+      const uint32 count = intervals.size();
+      if(count == 0)
+         return false;
+      
+      /* For the second derivatives M(i) at the points:
+       *
+       *    h(i-1)*M(i-1) + 2*(h(i-1)+h(i))*M(i) + h(i)*M(i+1)
+       *       = 6*(s(i) - s(i-1))
+       *
+       * where h(i) is the width of interval i and s(i) its slope.
+       * M(0) = M(n) = 0.  Solved with the Thomas algorithm.
+       */
+      _secondDerivs.assign(count+1,0);
+      _diagonal.resize(count+1);
+      _rhs.resize(count+1);
+      for(uint32 idx = 1; idx < count; idx++)
+      {
+         const INTERVAL_T& left = intervals[idx-1];
+         const INTERVAL_T& right = intervals[idx];
+         Number hLeft = left.end.x - left.start.x;
+         Number hRight = right.end.x - right.start.x;
+         Number slopeLeft = (left.end.y - left.start.y)/hLeft;
+         Number slopeRight = (right.end.y - right.start.y)/hRight;
+         _diagonal[idx] = 2*(hLeft+hRight);
+         _rhs[idx] = 6*(slopeRight - slopeLeft);
+         if(idx > 1)
+         {  // Eliminate the sub diagonal.
+            Number factor = hLeft/_diagonal[idx-1];
+            _diagonal[idx] -= factor*hLeft;
+            _rhs[idx] -= factor*_rhs[idx-1];
+         }
+      }
+      for(uint32 idx = count-1; idx >= 1; idx--)
+      {
+         const INTERVAL_T& right = intervals[idx];
+         Number hRight = right.end.x - right.start.x;
+         _secondDerivs[idx] = (_rhs[idx] - hRight*_secondDerivs[idx+1])/_diagonal[idx];
+      }
+      
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         INTERVAL_T& iv = intervals[idx];
+         Number h = iv.end.x - iv.start.x;
+         Number m0 = _secondDerivs[idx];
+         Number m1 = _secondDerivs[idx+1];
+         this->SetLocalCubic(iv,
+                             iv.start.y,
+                             (iv.end.y - iv.start.y)/h - h*(2*m0 + m1)/6,
+                             m0/2,
+                             (m1 - m0)/(6*h));
+      }
+      return true;
+   }
+   
+   virtual bool UpdateInterpolation(uint32 /*first*/, uint32 /*last*/)
+   {
+      return CreateInterpolation();
+   }
+};
+
+#endif /* defined(__MissileDemo__CubicSplineInterpolator__) */
@@ -0,0 +1,264 @@
+/********************************************************************
+ * File   : DStarLite.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "DStarLite.h"
+
+// The 8 neighbors, straight ones first.
+static const int32 NEIGHBOR_DX[8] = { 1, -1, 0,  0, 1, -1,  1, -1 };
+static const int32 NEIGHBOR_DY[8] = { 0,  0, 1, -1, 1,  1, -1, -1 };
+
+DStarLite::DStarLite() :
+   _blocked(NULL),
+   _width(0),
+   _height(0),
+   _goal(0),
+   _start(0),
+   _lastStart(0),
+   _km(0),
+   _expandedCount(0)
+{
+}
+
+void DStarLite::Init(const vector<uint8>* blocked, uint32 width, uint32 height, uint32 goal)
+{
+   assert(blocked != NULL);
+   assert(blocked->size() == width*height);
+   assert(goal < width*height);
+   _blocked = blocked;
+   _width = width;
+   _height = height;
+   _goal = goal;
+   _start = goal;
+   _lastStart = goal;
+   _km = 0;
+   _expandedCount = 0;
+   const uint32 cellCount = width*height;
+   _g.assign(cellCount,(uint32)INFINITE_COST);
+   _rhs.assign(cellCount,(uint32)INFINITE_COST);
+   _open.assign(cellCount,0);
+   _openKeys.resize(cellCount);
+   _queue = QUEUE_T();
+   UpdateVertex(goal);
+}
+
+DStarLite::KEY_T DStarLite::CalculateKey(uint32 cell) const
+{
+   KEY_T key;
+   key.k2 = Min(_g[cell],_rhs[cell]);
+   key.k1 = (key.k2 == INFINITE_COST) ? (uint32)INFINITE_COST : key.k2 + Heuristic(_start,cell) + _km;
+   return key;
+}
+
+void DStarLite::Push(uint32 cell, const KEY_T& key)
+{
+   QUEUE_ENTRY_T entry;
+   entry.key = key;
+   entry.cell = cell;
+   _open[cell] = 1;
+   _openKeys[cell] = key;
+   _queue.push(entry);
+}
+
+bool DStarLite::Top(QUEUE_ENTRY_T& entry)
+{
+   while(!_queue.empty())
+   {
+      entry = _queue.top();
+      const KEY_T& key = _openKeys[entry.cell];
+      if(_open[entry.cell] && key.k1 == entry.key.k1 && key.k2 == entry.key.k2)
+      {
+         return true;
+      }
+      _queue.pop();
+   }
+   return false;
+}
+
+void DStarLite::UpdateVertex(uint32 cell)
+{
+   if(cell == _goal)
+   {  // A blocked goal cannot be reached.
+      _rhs[cell] = ((*_blocked)[cell] != 0) ? (uint32)INFINITE_COST : 0;
+   }
+   else
+   {
+      uint32 x = cell % _width;
+      uint32 y = cell / _width;
+      uint32 best = INFINITE_COST;
+      for(uint32 ndx = 0; ndx < 8; ndx++)
+      {
+         uint32 nx = x + NEIGHBOR_DX[ndx];
+         uint32 ny = y + NEIGHBOR_DY[ndx];
+         // Off the grid wraps around to a big number.
+         if(nx >= _width || ny >= _height)
+         {
+            continue;
+         }
+         uint32 g = _g[ny*_width + nx];
+         if(g == INFINITE_COST)
+         {
+            continue;
+         }
+         uint32 step = StepCost(x,y,NEIGHBOR_DX[ndx],NEIGHBOR_DY[ndx]);
+         if(step != INFINITE_COST && g + step < best)
+         {
+            best = g + step;
+         }
+      }
+      _rhs[cell] = best;
+   }
+   if(_g[cell] != _rhs[cell])
+   {
+      Push(cell,CalculateKey(cell));
+   }
+   else
+   {
+      _open[cell] = 0;
+   }
+}
+
+void DStarLite::UpdateNeighbors(uint32 cell)
+{
+   uint32 x = cell % _width;
+   uint32 y = cell / _width;
+   for(uint32 ndx = 0; ndx < 8; ndx++)
+   {
+      uint32 nx = x + NEIGHBOR_DX[ndx];
+      uint32 ny = y + NEIGHBOR_DY[ndx];
+      if(nx < _width && ny < _height)
+      {
+         UpdateVertex(ny*_width + nx);
+      }
+   }
+}
+
+void DStarLite::SetStart(uint32 start)
+{
+   assert(start < _width*_height);
+   if(start == _start)
+   {
+      return;
+   }
+   // The keys in the queue were made with the old start.
+   // Rather than redo them all, the rest are raised by how
+   // far the start moved (which is never more than the
+   // heuristic changed by).
+   _start = start;
+   _km += Heuristic(_lastStart,start);
+   _lastStart = start;
+}
+
+void DStarLite::CellsChanged(const vector<uint32>& cells)
+{
+   // Blocking or opening a cell changes the moves into and
+   // out of it, and the diagonal moves past its corners,
+   // so all the cells around it are looked at again.
+   for(uint32 idx = 0; idx < cells.size(); idx++)
+   {
+      UpdateVertex(cells[idx]);
+      UpdateNeighbors(cells[idx]);
+   }
+}
+
+void DStarLite::ComputeShortestPath()
+{
+   QUEUE_ENTRY_T top;
+   while(Top(top))
+   {
+      KEY_T startKey = CalculateKey(_start);
+      if(!KeyLess(top.key,startKey) && _rhs[_start] == _g[_start])
+      {
+         break;
+      }
+      uint32 cell = top.cell;
+      KEY_T newKey = CalculateKey(cell);
+      if(KeyLess(top.key,newKey))
+      {  // Made before the start moved.
+         Push(cell,newKey);
+         continue;
+      }
+      _expandedCount++;
+      if(_g[cell] > _rhs[cell])
+      {
+         _g[cell] = _rhs[cell];
+         _open[cell] = 0;
+         UpdateNeighbors(cell);
+      }
+      else
+      {
+         _g[cell] = INFINITE_COST;
+         UpdateVertex(cell);
+         UpdateNeighbors(cell);
+      }
+   }
+}
+
+bool DStarLite::GetPath(vector<uint32>& cells) const
+{
+   cells.clear();
+   if(_g[_start] == INFINITE_COST)
+   {
+      return false;
+   }
+   uint32 cell = _start;
+   cells.push_back(cell);
+   while(cell != _goal)
+   {
+      uint32 x = cell % _width;
+      uint32 y = cell / _width;
+      uint32 best = INFINITE_COST;
+      uint32 next = cell;
+      for(uint32 ndx = 0; ndx < 8; ndx++)
+      {
+         uint32 nx = x + NEIGHBOR_DX[ndx];
+         uint32 ny = y + NEIGHBOR_DY[ndx];
+         if(nx >= _width || ny >= _height)
+         {
+            continue;
+         }
+         uint32 g = _g[ny*_width + nx];
+         uint32 step = StepCost(x,y,NEIGHBOR_DX[ndx],NEIGHBOR_DY[ndx]);
+         if(g == INFINITE_COST || step == INFINITE_COST)
+         {
+            continue;
+         }
+         if(g + step < best)
+         {
+            best = g + step;
+            next = ny*_width + nx;
+         }
+      }
+      if(next == cell || cells.size() > _g.size())
+      {  // Should not happen once the search is done.
+         cells.clear();
+         return false;
+      }
+      cell = next;
+      cells.push_back(cell);
+   }
+   return true;
+}
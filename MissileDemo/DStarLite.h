@@ -0,0 +1,184 @@
+/********************************************************************
+ * File   : DStarLite.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__DStarLite__
+#define __MissileDemo__DStarLite__
+
+#include "CommonSTL.h"
+
+/* An incremental shortest path planner on a grid
+ * (D* Lite, Koenig and Likhachev).
+ *
+ * The grid is a row by row array of flags, non-zero for
+ * blocked cells, owned by the caller.  Moves go to any of
+ * the 8 neighbors; diagonal moves cost 14 to the 10 of a
+ * straight one and may not cut the corner of a blocked
+ * cell.
+ *
+ * The search runs backwards from the goal, so the cost to
+ * the goal is known for every cell it has looked at.  When
+ * the start moves or cells are blocked or opened, only the
+ * part of the search that depends on them is done again:
+ *
+ * 1. Init(...) with the grid and the goal.
+ * 2. SetStart(...), then ComputeShortestPath().
+ * 3. GetPath(...) for the cells from the start to the goal.
+ * 4. After cells change, CellsChanged(...) and go back to
+ *    2 (the start may be moved too).
+ */
+class DStarLite
+{
+public:
+   enum
+   {
+      INFINITE_COST = 0xFFFFFFFF
+   };
+   
+private:
+   enum
+   {
+      STEP_STRAIGHT = 10,
+      STEP_DIAGONAL = 14
+   };
+   
+   typedef struct
+   {
+      uint32 k1;
+      uint32 k2;
+   } KEY_T;
+   
+   typedef struct
+   {
+      KEY_T key;
+      uint32 cell;
+   } QUEUE_ENTRY_T;
+   
+   // Orders the queue smallest key first.
+   class QueueEntryGreater
+   {
+   public:
+      bool operator()(const QUEUE_ENTRY_T& lhs, const QUEUE_ENTRY_T& rhs) const
+      {
+         return KeyLess(rhs.key,lhs.key);
+      }
+   };
+   
+   typedef priority_queue<QUEUE_ENTRY_T, vector<QUEUE_ENTRY_T>, QueueEntryGreater> QUEUE_T;
+   
+   const vector<uint8>* _blocked;
+   uint32 _width;
+   uint32 _height;
+   uint32 _goal;
+   uint32 _start;
+   uint32 _lastStart;
+   uint32 _km;
+   vector<uint32> _g;
+   vector<uint32> _rhs;
+   // Cells in the queue and their keys.  Entries in
+   // _queue that do not match are stale.
+   vector<uint8> _open;
+   vector<KEY_T> _openKeys;
+   QUEUE_T _queue;
+   uint32 _expandedCount;
+   
+   static inline bool KeyLess(const KEY_T& lhs, const KEY_T& rhs)
+   {
+      return lhs.k1 < rhs.k1 || (lhs.k1 == rhs.k1 && lhs.k2 < rhs.k2);
+   }
+   
+   inline bool IsBlocked(uint32 x, uint32 y) const { return (*_blocked)[y*_width + x] != 0; }
+   
+   // Octile distance, in step costs.
+   inline uint32 Heuristic(uint32 cellA, uint32 cellB) const
+   {
+      uint32 ax = cellA % _width;
+      uint32 ay = cellA / _width;
+      uint32 bx = cellB % _width;
+      uint32 by = cellB / _width;
+      uint32 dx = (ax > bx) ? ax - bx : bx - ax;
+      uint32 dy = (ay > by) ? ay - by : by - ay;
+      uint32 diagonal = Min(dx,dy);
+      uint32 straight = Max(dx,dy) - diagonal;
+      return STEP_DIAGONAL*diagonal + STEP_STRAIGHT*straight;
+   }
+   
+   // The cost of the move from (x,y) to (x+dx,y+dy), which
+   // must be on the grid.
+   inline uint32 StepCost(uint32 x, uint32 y, int32 dx, int32 dy) const
+   {
+      uint32 nx = x + dx;
+      uint32 ny = y + dy;
+      if(IsBlocked(x,y) || IsBlocked(nx,ny))
+      {
+         return INFINITE_COST;
+      }
+      if(dx != 0 && dy != 0)
+      {
+         if(IsBlocked(nx,y) || IsBlocked(x,ny))
+         {
+            return INFINITE_COST;
+         }
+         return STEP_DIAGONAL;
+      }
+      return STEP_STRAIGHT;
+   }
+   
+   KEY_T CalculateKey(uint32 cell) const;
+   void UpdateVertex(uint32 cell);
+   void UpdateNeighbors(uint32 cell);
+   void Push(uint32 cell, const KEY_T& key);
+   // Drops stale entries; false if the queue is empty.
+   bool Top(QUEUE_ENTRY_T& entry);
+   
+public:
+   DStarLite();
+   
+   // blocked must stay the same size while this is in use.
+   void Init(const vector<uint8>* blocked, uint32 width, uint32 height, uint32 goal);
+   
+   inline uint32 GetGoal() const { return _goal; }
+   inline uint32 GetStart() const { return _start; }
+   void SetStart(uint32 start);
+   
+   // The flags of these cells have changed.
+   void CellsChanged(const vector<uint32>& cells);
+   
+   void ComputeShortestPath();
+   
+   // The cost from the start to the goal (INFINITE_COST if
+   // there is no way), after ComputeShortestPath().
+   inline uint32 GetCost() const { return _g[_start]; }
+   
+   // The cells from the start to the goal, both included.
+   // False (and no cells) if there is no way.
+   bool GetPath(vector<uint32>& cells) const;
+   
+   // Cells expanded since Init(...), to see how much work
+   // the repairs save.
+   inline uint32 GetExpandedCount() const { return _expandedCount; }
+};
+
+#endif /* defined(__MissileDemo__DStarLite__) */
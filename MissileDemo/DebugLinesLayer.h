@@ -30,6 +30,7 @@
 #include "CommonSTL.h"
 #include "CommonProject.h"
 #include "Notifier.h"
+#include "Profiler.h"
 
 
 class DebugLinesLayer : public CCLayer, public Notified
@@ -90,6 +91,7 @@ public:
    
    virtual void draw()
    {
+      PROFILE_ZONE("DebugLinesLayer::draw");
       CCLayer::draw();
       if(_enabled)
       {
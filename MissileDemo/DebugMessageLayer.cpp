@@ -28,7 +28,9 @@
 #include "DebugMessageLayer.h"
 #define TAG_LABEL 1000
 
-DebugMessageLayer::DebugMessageLayer()
+DebugMessageLayer::DebugMessageLayer() :
+_telemetryRate(0),
+_lastTelemetryCount(0)
 {
 	
 }
@@ -45,6 +47,7 @@ bool DebugMessageLayer::init()
    Notifier::Instance().Attach(this,Notifier::NE_RESET_DRAW_CYCLE);
    Notifier::Instance().Attach(this, Notifier::NE_DEBUG_MESSAGE);
    Notifier::Instance().Attach(this, Notifier::NE_DEBUG_TOGGLE_VISIBILITY);
+   SetTelemetryRate(DEFAULT_TELEMETRY_RATE);
    return true;
 }
 
@@ -84,11 +87,43 @@ void DebugMessageLayer::Notify(NOTIFIED_EVENT_TYPE_T eventType, const void* even
 
 void DebugMessageLayer::UpdateLabel(const char* msg)
 {
+   if(_lastMessage == msg)
+      return;
    CCLabelBMFont* label = (CCLabelBMFont*)getChildByTag(TAG_LABEL);
    _lastMessage = msg;
    label->setString(msg);
 }
 
+void DebugMessageLayer::SetTelemetryRate(float32 rate)
+{
+   assert(rate >= 0);
+   unschedule(schedule_selector(DebugMessageLayer::SampleTelemetry));
+   _telemetryRate = rate;
+   if(rate > 0)
+   {
+      schedule(schedule_selector(DebugMessageLayer::SampleTelemetry), 1.0f/rate);
+   }
+}
+
+void DebugMessageLayer::SampleTelemetry(float dt)
+{
+   const Telemetry& telemetry = Telemetry::Instance();
+   if(telemetry.GetRecordedCount() == _lastTelemetryCount)
+   {  // Nothing new.
+      return;
+   }
+   _lastTelemetryCount = telemetry.GetRecordedCount();
+   
+   Telemetry::SAMPLE_T sample;
+   if(telemetry.GetLatest(sample))
+   {
+      char buffer[128];
+      sprintf(buffer,"Speed = %8.3f m/s\nError = %6.3f rad, Thrust = %8.1f N",
+              sample.speed,sample.angleError,sample.thrust);
+      UpdateLabel(buffer);
+   }
+}
+
 void DebugMessageLayer::InitLabel()
 {
    CCSize scrSize = CCDirector::sharedDirector()->getWinSize();
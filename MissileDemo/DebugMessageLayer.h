@@ -30,20 +30,40 @@
 #include "CommonProject.h"
 #include "CommonSTL.h"
 #include "Notifier.h"
+#include "Telemetry.h"
 
+/* Shows NE_DEBUG_MESSAGE text and the latest Telemetry sample.
+ *
+ * The Telemetry is sampled a few times a second (see
+ * SetTelemetryRate(...)) rather than every tick; setting the
+ * label string lays out the whole label again.
+ */
 class DebugMessageLayer : public CCLayer, public Notified
 {
 private:
+   enum
+   {
+      DEFAULT_TELEMETRY_RATE = 4,
+   };
+   
    string _lastMessage;
+   float32 _telemetryRate;
+   uint32 _lastTelemetryCount;
    DebugMessageLayer();
    void InitLabel();
    void UpdateLabel(const char*);
+   void SampleTelemetry(float dt);
 protected:
    bool init();
    virtual ~DebugMessageLayer();
 public:
    static DebugMessageLayer* create();
    virtual void Notify(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData);
+   
+   // Times per second the Telemetry is shown.  Zero
+   // turns it off.
+   void SetTelemetryRate(float32 rate);
+   float32 GetTelemetryRate() const { return _telemetryRate; }
 };
 
 #endif /* defined(__MissileDemo__DebugMessageLayer__) */
@@ -28,7 +28,7 @@
 #define __Entity__
 
 #include "CommonSTL.h"
-#include "CommonProject.h"
+#include "CommonPhysics.h"
 
 // This class is the base class for all the "things" in this
 // this simulation.  It allows us to have something to put
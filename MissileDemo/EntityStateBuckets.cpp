@@ -0,0 +1,114 @@
+/********************************************************************
+ * File   : EntityStateBuckets.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/10/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "EntityStateBuckets.h"
+
+EntityStateBuckets::EntityStateBuckets() :
+   _movedCount(0)
+{
+}
+
+void EntityStateBuckets::Add(MovingEntityIFace* entity)
+{
+   assert(entity != NULL);
+   assert(entity->_buckets == NULL);
+   entity->_buckets = this;
+   entity->_bucketState = entity->GetState();
+   entity->_bucketMovePending = false;
+   AddToBucket(entity);
+   _moved.resize(_moved.size()+1);
+}
+
+void EntityStateBuckets::Clear()
+{
+   for(uint32 state = 0; state < MovingEntityIFace::ST_MAX; state++)
+   {
+      _buckets[state].clear();
+   }
+   _moved.clear();
+   _movedCount = 0;
+}
+
+void EntityStateBuckets::RemoveFromBucket(MovingEntityIFace* entity)
+{
+   vector<MovingEntityIFace*>& bucket = _buckets[entity->_bucketState];
+   uint32 idx = entity->_bucketIndex;
+   assert(bucket[idx] == entity);
+   bucket[idx] = bucket.back();
+   bucket[idx]->_bucketIndex = idx;
+   bucket.pop_back();
+}
+
+void EntityStateBuckets::AddToBucket(MovingEntityIFace* entity)
+{
+   vector<MovingEntityIFace*>& bucket = _buckets[entity->_bucketState];
+   entity->_bucketIndex = bucket.size();
+   bucket.push_back(entity);
+}
+
+void EntityStateBuckets::StateChanged(MovingEntityIFace* entity)
+{
+   // Only the thread updating this entity touches the
+   // flag.  The slot in _moved is claimed atomically.
+   if(!entity->_bucketMovePending)
+   {
+      entity->_bucketMovePending = true;
+      uint32 slot = __sync_fetch_and_add(&_movedCount,1);
+      assert(slot < _moved.size());
+      _moved[slot] = entity;
+   }
+}
+
+bool EntityStateBuckets::BucketPositionLess(const MovingEntityIFace* lhs, const MovingEntityIFace* rhs)
+{
+   if(lhs->_bucketState != rhs->_bucketState)
+   {
+      return lhs->_bucketState < rhs->_bucketState;
+   }
+   return lhs->_bucketIndex < rhs->_bucketIndex;
+}
+
+void EntityStateBuckets::Reconcile(vector<MovingEntityIFace*>* stopped)
+{
+   sort(_moved.begin(),_moved.begin()+_movedCount,BucketPositionLess);
+   for(uint32 idx = 0; idx < _movedCount; idx++)
+   {
+      MovingEntityIFace* entity = _moved[idx];
+      entity->_bucketMovePending = false;
+      if(entity->GetState() != entity->_bucketState)
+      {
+         RemoveFromBucket(entity);
+         entity->_bucketState = entity->GetState();
+         AddToBucket(entity);
+         if(stopped != NULL && entity->_bucketState == MovingEntityIFace::ST_IDLE)
+         {
+            stopped->push_back(entity);
+         }
+      }
+   }
+   _movedCount = 0;
+}
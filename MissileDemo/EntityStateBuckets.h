@@ -0,0 +1,78 @@
+/********************************************************************
+ * File   : EntityStateBuckets.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/10/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__EntityStateBuckets__
+#define __MissileDemo__EntityStateBuckets__
+
+#include "CommonSTL.h"
+#include "MovingEntityIFace.h"
+
+/* This class keeps moving entities in one bucket per
+ * steering state, so each state can be updated as a
+ * batch and the idle entities can be skipped entirely.
+ *
+ * When an entity changes state it calls StateChanged(...),
+ * which just puts it on the list of moved entities.  This
+ * is safe to do from any thread, including while the
+ * buckets are being run on the JobSystem.  Reconcile()
+ * then moves each of them into its new bucket in O(1)
+ * (swap with the last entity in the old bucket).  It
+ * sorts the moved entities by where they were first, so
+ * the order of the buckets does not depend on which
+ * thread called StateChanged(...) first.
+ */
+class EntityStateBuckets
+{
+private:
+   vector<MovingEntityIFace*> _buckets[MovingEntityIFace::ST_MAX];
+   // Entities that changed state since the last
+   // Reconcile().  Sized to hold every entity once.
+   vector<MovingEntityIFace*> _moved;
+   uint32 _movedCount;
+   
+   static bool BucketPositionLess(const MovingEntityIFace* lhs, const MovingEntityIFace* rhs);
+   void RemoveFromBucket(MovingEntityIFace* entity);
+   void AddToBucket(MovingEntityIFace* entity);
+   
+public:
+   EntityStateBuckets();
+   
+   void Add(MovingEntityIFace* entity);
+   void Clear();
+   
+   inline const vector<MovingEntityIFace*>& GetBucket(MovingEntityIFace::STATE_T state) const { return _buckets[state]; }
+   
+   // Called by the entity (MovingEntityIFace::SetState(...)).
+   void StateChanged(MovingEntityIFace* entity);
+   
+   // Put the moved entities in their new buckets.  The
+   // ones that went idle are appended to stopped (if it
+   // is not NULL).
+   void Reconcile(vector<MovingEntityIFace*>* stopped = NULL);
+};
+
+#endif /* defined(__MissileDemo__EntityStateBuckets__) */
@@ -0,0 +1,636 @@
+/********************************************************************
+ * File   : FlowField.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "FlowField.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+// The 8 neighbors, straight ones first.
+static const int32 NEIGHBOR_DX[8] = { 1, -1, 0,  0, 1, -1,  1, -1 };
+static const int32 NEIGHBOR_DY[8] = { 0,  0, 1, -1, 1,  1, -1, -1 };
+static const float32 DIAGONAL_UNIT = 0.70710678f;
+
+FlowField::FlowField() :
+   _width(0),
+   _height(0),
+   _cellSize(1.0),
+   _invCellSize(1.0),
+   _lowerBound(0,0),
+   _goal(0,0),
+   _goalCell(0),
+   _rebuild(true),
+   _dirtyLowerX(0),
+   _dirtyLowerY(0),
+   _dirtyUpperX(0),
+   _dirtyUpperY(0)
+{
+}
+
+void FlowField::Init(float32 width, float32 height, float32 cellSize)
+{
+   assert(width > 0);
+   assert(height > 0);
+   assert(cellSize > 0);
+   _cellSize = cellSize;
+   _invCellSize = 1.0f/cellSize;
+   _width = (uint32)ceilf(width*_invCellSize);
+   _height = (uint32)ceilf(height*_invCellSize);
+   _width = Max(_width,1u);
+   _height = Max(_height,1u);
+   _lowerBound = Vec2(-0.5f*_width*cellSize,-0.5f*_height*cellSize);
+   
+   const uint32 cellCount = _width*_height;
+   _costs.assign(cellCount,(uint8)COST_MIN);
+   _integration.assign(cellCount,(uint32)UNREACHABLE);
+   _directions.assign(cellCount,Vec2(0,0));
+   _marks.assign(cellCount,0);
+   _changes.clear();
+   _dirtyLowerX = _width;
+   _dirtyLowerY = _height;
+   _dirtyUpperX = 0;
+   _dirtyUpperY = 0;
+   SetGoal(Vec2(0,0));
+}
+
+Vec2 FlowField::GetCellCenter(uint32 x, uint32 y) const
+{
+   return _lowerBound + Vec2((x + 0.5f)*_cellSize,(y + 0.5f)*_cellSize);
+}
+
+void FlowField::SetGoal(const Vec2& position)
+{
+   uint32 x;
+   uint32 y;
+   GetCell(position,x,y);
+   _goal = position;
+   _goalCell = CellIndex(x,y);
+   _rebuild = true;
+}
+
+void FlowField::SetCost(uint32 x, uint32 y, uint8 cost)
+{
+   assert(x < _width);
+   assert(y < _height);
+   assert(cost >= COST_MIN);
+   uint32 cell = CellIndex(x,y);
+   uint8 oldCost = _costs[cell];
+   if(cost == oldCost)
+   {
+      return;
+   }
+   if(cell == _goalCell && (cost == COST_BLOCKED || oldCost == COST_BLOCKED))
+   {  // The goal is opened or closed; everything changes.
+      _rebuild = true;
+   }
+   if((_marks[cell] & MARK_CHANGED) == 0)
+   {
+      COST_CHANGE_T change;
+      change.cell = cell;
+      change.builtCost = oldCost;
+      change.newCost = cost;
+      _changes.push_back(change);
+      _marks[cell] |= MARK_CHANGED;
+   }
+   _costs[cell] = cost;
+}
+
+void FlowField::SetCost(const Vec2& lowerBound, const Vec2& upperBound, uint8 cost)
+{
+   // The cells with centers inside.
+   float32 fx0 = ceilf((lowerBound.x - _lowerBound.x)*_invCellSize - 0.5f);
+   float32 fy0 = ceilf((lowerBound.y - _lowerBound.y)*_invCellSize - 0.5f);
+   float32 fx1 = floorf((upperBound.x - _lowerBound.x)*_invCellSize - 0.5f);
+   float32 fy1 = floorf((upperBound.y - _lowerBound.y)*_invCellSize - 0.5f);
+   int32 x0 = Max((int32)fx0,0);
+   int32 y0 = Max((int32)fy0,0);
+   int32 x1 = Min((int32)fx1,(int32)_width-1);
+   int32 y1 = Min((int32)fy1,(int32)_height-1);
+   for(int32 y = y0; y <= y1; y++)
+   {
+      for(int32 x = x0; x <= x1; x++)
+      {
+         SetCost(x,y,cost);
+      }
+   }
+}
+
+uint32 FlowField::CheapestThroughNeighbors(uint32 x, uint32 y) const
+{
+   uint32 best = UNREACHABLE;
+   for(uint32 ndx = 0; ndx < 8; ndx++)
+   {
+      uint32 nx = x + NEIGHBOR_DX[ndx];
+      uint32 ny = y + NEIGHBOR_DY[ndx];
+      // Off the grid wraps around to a big number.
+      if(nx >= _width || ny >= _height)
+      {
+         continue;
+      }
+      uint32 cost = CostThrough(x,y,NEIGHBOR_DX[ndx],NEIGHBOR_DY[ndx]);
+      if(cost < best)
+      {
+         best = cost;
+      }
+   }
+   return best;
+}
+
+void FlowField::MarkDirty(uint32 x, uint32 y)
+{
+   if(x < _dirtyLowerX)
+      _dirtyLowerX = x;
+   if(y < _dirtyLowerY)
+      _dirtyLowerY = y;
+   if(x >= _dirtyUpperX)
+      _dirtyUpperX = x+1;
+   if(y >= _dirtyUpperY)
+      _dirtyUpperY = y+1;
+}
+
+void FlowField::MarkAllDirty()
+{
+   _dirtyLowerX = 0;
+   _dirtyLowerY = 0;
+   _dirtyUpperX = _width;
+   _dirtyUpperY = _height;
+}
+
+void FlowField::ResetIntegration()
+{
+   std::fill(_integration.begin(),_integration.end(),(uint32)UNREACHABLE);
+   if(_costs[_goalCell] != COST_BLOCKED)
+   {
+      _integration[_goalCell] = 0;
+   }
+}
+
+void FlowField::RunQueue()
+{
+   while(!_queue.empty())
+   {
+      QUEUE_ENTRY_T entry = _queue.top();
+      _queue.pop();
+      uint32 cell = entry.second;
+      if(entry.first != _integration[cell])
+      {  // There was a cheaper way here after all.
+         continue;
+      }
+      uint32 x = cell % _width;
+      uint32 y = cell / _width;
+      uint32 cost = _costs[cell];
+      for(uint32 ndx = 0; ndx < 8; ndx++)
+      {
+         uint32 nx = x + NEIGHBOR_DX[ndx];
+         uint32 ny = y + NEIGHBOR_DY[ndx];
+         if(nx >= _width || ny >= _height)
+         {
+            continue;
+         }
+         uint32 neighbor = CellIndex(nx,ny);
+         if(_costs[neighbor] == COST_BLOCKED || neighbor == _goalCell)
+         {
+            continue;
+         }
+         uint32 step = STEP_STRAIGHT;
+         if(nx != x && ny != y)
+         {
+            if(IsBlocked(nx,y) || IsBlocked(x,ny))
+            {
+               continue;
+            }
+            step = STEP_DIAGONAL;
+         }
+         uint32 integration = entry.first + step*cost;
+         if(integration < _integration[neighbor])
+         {
+            _integration[neighbor] = integration;
+            _queue.push(QUEUE_ENTRY_T(integration,neighbor));
+            MarkDirty(nx,ny);
+         }
+      }
+   }
+}
+
+void FlowField::BuildDijkstra()
+{
+   PROFILE_ZONE("FlowField::BuildDijkstra");
+   ResetIntegration();
+   if(_integration[_goalCell] == 0)
+   {
+      _queue.push(QUEUE_ENTRY_T(0,_goalCell));
+   }
+   RunQueue();
+}
+
+bool FlowField::SweepBlock(uint32 lowerX, uint32 upperX, uint32 lowerY, uint32 upperY, int32 dirX, int32 dirY)
+{
+   // Only the neighbors behind (x,y) in the sweep
+   // direction are looked at.  They are either in this
+   // block and already swept, or in a block on an earlier
+   // anti-diagonal.
+   bool changed = false;
+   for(uint32 row = 0; row < upperY - lowerY; row++)
+   {
+      uint32 y = (dirY > 0) ? lowerY + row : upperY - 1 - row;
+      bool hasRowBehind = (dirY > 0) ? (y > 0) : (y+1 < _height);
+      for(uint32 col = 0; col < upperX - lowerX; col++)
+      {
+         uint32 x = (dirX > 0) ? lowerX + col : upperX - 1 - col;
+         uint32 cell = CellIndex(x,y);
+         if(_costs[cell] == COST_BLOCKED || cell == _goalCell)
+         {
+            continue;
+         }
+         bool hasColBehind = (dirX > 0) ? (x > 0) : (x+1 < _width);
+         uint32 best = _integration[cell];
+         uint32 through = UNREACHABLE;
+         if(hasColBehind)
+         {
+            through = CostThrough(x,y,-dirX,0);
+            if(through < best)
+               best = through;
+         }
+         if(hasRowBehind)
+         {
+            through = CostThrough(x,y,0,-dirY);
+            if(through < best)
+               best = through;
+            if(hasColBehind)
+            {
+               through = CostThrough(x,y,-dirX,-dirY);
+               if(through < best)
+                  best = through;
+            }
+         }
+         if(best < _integration[cell])
+         {
+            _integration[cell] = best;
+            changed = true;
+         }
+      }
+   }
+   return changed;
+}
+
+void FlowField::SweepJob(void* context, uint32 begin, uint32 end, uint32 worker)
+{
+   const SWEEP_JOB_T* job = (const SWEEP_JOB_T*)context;
+   FlowField* field = job->field;
+   const uint32 blocksX = (field->_width + SWEEP_BLOCK_SIZE - 1)/SWEEP_BLOCK_SIZE;
+   const uint32 blocksY = (field->_height + SWEEP_BLOCK_SIZE - 1)/SWEEP_BLOCK_SIZE;
+   bool changed = false;
+   for(uint32 idx = begin; idx < end; idx++)
+   {
+      // Block coordinates counted in the sweep direction.
+      uint32 sweepX = job->firstBlockX + idx;
+      uint32 sweepY = job->diagonal - sweepX;
+      uint32 blockX = (job->dirX > 0) ? sweepX : blocksX - 1 - sweepX;
+      uint32 blockY = (job->dirY > 0) ? sweepY : blocksY - 1 - sweepY;
+      uint32 lowerX = blockX*SWEEP_BLOCK_SIZE;
+      uint32 lowerY = blockY*SWEEP_BLOCK_SIZE;
+      uint32 upperX = Min(lowerX + SWEEP_BLOCK_SIZE,field->_width);
+      uint32 upperY = Min(lowerY + SWEEP_BLOCK_SIZE,field->_height);
+      if(field->SweepBlock(lowerX,upperX,lowerY,upperY,job->dirX,job->dirY))
+      {
+         changed = true;
+      }
+   }
+   if(changed)
+   {
+      field->_sweepChanged[worker] = 1;
+   }
+}
+
+void FlowField::BuildSweeps(JobSystem* jobs)
+{
+   PROFILE_ZONE("FlowField::BuildSweeps");
+   static const int32 SWEEP_DIRECTIONS[4][2] = { { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } };
+   const uint32 blocksX = (_width + SWEEP_BLOCK_SIZE - 1)/SWEEP_BLOCK_SIZE;
+   const uint32 blocksY = (_height + SWEEP_BLOCK_SIZE - 1)/SWEEP_BLOCK_SIZE;
+   ResetIntegration();
+   _sweepChanged.resize(jobs->GetThreadCount());
+   
+   SWEEP_JOB_T job;
+   job.field = this;
+   bool changed = true;
+   while(changed)
+   {
+      std::fill(_sweepChanged.begin(),_sweepChanged.end(),0);
+      for(uint32 sweep = 0; sweep < 4; sweep++)
+      {
+         job.dirX = SWEEP_DIRECTIONS[sweep][0];
+         job.dirY = SWEEP_DIRECTIONS[sweep][1];
+         // The blocks on an anti-diagonal only depend on
+         // the blocks on the ones before it.
+         for(uint32 diagonal = 0; diagonal < blocksX + blocksY - 1; diagonal++)
+         {
+            uint32 first = (diagonal >= blocksY) ? diagonal - (blocksY - 1) : 0;
+            uint32 last = Min(diagonal,blocksX - 1);
+            job.diagonal = diagonal;
+            job.firstBlockX = first;
+            jobs->ParallelFor(last - first + 1,1,SweepJob,&job);
+         }
+      }
+      changed = false;
+      for(uint32 idx = 0; idx < _sweepChanged.size(); idx++)
+      {
+         if(_sweepChanged[idx] != 0)
+         {
+            changed = true;
+         }
+      }
+   }
+}
+
+void FlowField::ClearCell(uint32 x, uint32 y)
+{
+   uint32 cell = CellIndex(x,y);
+   if((_marks[cell] & MARK_CLEARED) != 0 || cell == _goalCell)
+   {
+      return;
+   }
+   _marks[cell] |= MARK_CLEARED;
+   _cleared.push_back(cell);
+}
+
+void FlowField::ClearDependents(uint32 x, uint32 y)
+{
+   for(uint32 ndx = 0; ndx < 8; ndx++)
+   {
+      uint32 nx = x + NEIGHBOR_DX[ndx];
+      uint32 ny = y + NEIGHBOR_DY[ndx];
+      if(nx >= _width || ny >= _height)
+      {
+         continue;
+      }
+      if(!IsBlocked(nx,ny) && DependsOn(nx,ny,-NEIGHBOR_DX[ndx],-NEIGHBOR_DY[ndx]))
+      {
+         ClearCell(nx,ny);
+      }
+   }
+}
+
+void FlowField::RelaxCell(uint32 x, uint32 y)
+{
+   uint32 cell = CellIndex(x,y);
+   if(_costs[cell] == COST_BLOCKED || cell == _goalCell)
+   {
+      return;
+   }
+   uint32 integration = CheapestThroughNeighbors(x,y);
+   if(integration < _integration[cell])
+   {
+      _integration[cell] = integration;
+      _queue.push(QUEUE_ENTRY_T(integration,cell));
+      MarkDirty(x,y);
+   }
+}
+
+void FlowField::Repair()
+{
+   PROFILE_ZONE("FlowField::Repair");
+   // Find what depended on the old costs, with the old
+   // costs in place.
+   for(uint32 idx = 0; idx < _changes.size(); idx++)
+   {
+      COST_CHANGE_T& change = _changes[idx];
+      change.newCost = _costs[change.cell];
+      _costs[change.cell] = change.builtCost;
+   }
+   _cleared.clear();
+   for(uint32 idx = 0; idx < _changes.size(); idx++)
+   {
+      const COST_CHANGE_T& change = _changes[idx];
+      if(change.newCost <= change.builtCost)
+      {
+         continue;
+      }
+      uint32 x = change.cell % _width;
+      uint32 y = change.cell / _width;
+      ClearDependents(x,y);
+      if(change.newCost == COST_BLOCKED)
+      {  // A wall cell, and the diagonal steps past its
+         // corners are gone too.
+         ClearCell(x,y);
+         for(uint32 ndx = 0; ndx < 4; ndx++)
+         {
+            uint32 ax = x + NEIGHBOR_DX[ndx];
+            uint32 ay = y + NEIGHBOR_DY[ndx];
+            // The next straight neighbor around.
+            uint32 bx = x + NEIGHBOR_DY[ndx];
+            uint32 by = y - NEIGHBOR_DX[ndx];
+            if(ax >= _width || ay >= _height || bx >= _width || by >= _height)
+            {
+               continue;
+            }
+            if(IsBlocked(ax,ay) || IsBlocked(bx,by))
+            {
+               continue;
+            }
+            if(DependsOn(ax,ay,bx-ax,by-ay))
+            {
+               ClearCell(ax,ay);
+            }
+            if(DependsOn(bx,by,ax-bx,ay-by))
+            {
+               ClearCell(bx,by);
+            }
+         }
+      }
+   }
+   for(uint32 idx = 0; idx < _cleared.size(); idx++)
+   {
+      uint32 cell = _cleared[idx];
+      ClearDependents(cell % _width,cell / _width);
+   }
+   
+   // Now the new costs.  The cleared cells are filled in
+   // from the cells around them, and the cells next to a
+   // cheaper cell may have a cheaper way.
+   for(uint32 idx = 0; idx < _changes.size(); idx++)
+   {
+      const COST_CHANGE_T& change = _changes[idx];
+      _costs[change.cell] = change.newCost;
+      MarkDirty(change.cell % _width,change.cell / _width);
+   }
+   for(uint32 idx = 0; idx < _cleared.size(); idx++)
+   {
+      uint32 cell = _cleared[idx];
+      _integration[cell] = UNREACHABLE;
+      MarkDirty(cell % _width,cell / _width);
+   }
+   for(uint32 idx = 0; idx < _cleared.size(); idx++)
+   {
+      uint32 cell = _cleared[idx];
+      RelaxCell(cell % _width,cell / _width);
+      _marks[cell] &= ~MARK_CLEARED;
+   }
+   for(uint32 idx = 0; idx < _changes.size(); idx++)
+   {
+      const COST_CHANGE_T& change = _changes[idx];
+      if(change.newCost >= change.builtCost)
+      {
+         continue;
+      }
+      uint32 x = change.cell % _width;
+      uint32 y = change.cell / _width;
+      RelaxCell(x,y);
+      for(uint32 ndx = 0; ndx < 8; ndx++)
+      {
+         uint32 nx = x + NEIGHBOR_DX[ndx];
+         uint32 ny = y + NEIGHBOR_DY[ndx];
+         if(nx < _width && ny < _height)
+         {
+            RelaxCell(nx,ny);
+         }
+      }
+   }
+   RunQueue();
+}
+
+void FlowField::CalculateDirections(uint32 lowerX, uint32 upperX, uint32 lowerY, uint32 upperY)
+{
+   for(uint32 y = lowerY; y < upperY; y++)
+   {
+      for(uint32 x = lowerX; x < upperX; x++)
+      {
+         uint32 cell = CellIndex(x,y);
+         Vec2& direction = _directions[cell];
+         direction = Vec2(0,0);
+         if(cell == _goalCell)
+         {
+            continue;
+         }
+         bool blocked = (_costs[cell] == COST_BLOCKED);
+         uint32 best = UNREACHABLE;
+         uint32 bestNdx = 8;
+         for(uint32 ndx = 0; ndx < 8; ndx++)
+         {
+            uint32 nx = x + NEIGHBOR_DX[ndx];
+            uint32 ny = y + NEIGHBOR_DY[ndx];
+            if(nx >= _width || ny >= _height)
+            {
+               continue;
+            }
+            uint32 cost;
+            if(blocked)
+            {  // Out of the wall to the closest open cell.
+               cost = IsBlocked(nx,ny) ? (uint32)UNREACHABLE : _integration[CellIndex(nx,ny)];
+            }
+            else
+            {
+               cost = CostThrough(x,y,NEIGHBOR_DX[ndx],NEIGHBOR_DY[ndx]);
+            }
+            if(cost < best)
+            {
+               best = cost;
+               bestNdx = ndx;
+            }
+         }
+         if(bestNdx < 8)
+         {
+            float32 scale = (bestNdx < 4) ? 1.0f : DIAGONAL_UNIT;
+            direction = Vec2(scale*NEIGHBOR_DX[bestNdx],scale*NEIGHBOR_DY[bestNdx]);
+         }
+      }
+   }
+}
+
+void FlowField::DirectionJob(void* context, uint32 begin, uint32 end, uint32 /*worker*/)
+{
+   const DIRECTION_JOB_T* job = (const DIRECTION_JOB_T*)context;
+   job->field->CalculateDirections(job->lowerX,job->upperX,job->lowerY + begin,job->lowerY + end);
+}
+
+void FlowField::CalculateDirections(JobSystem* jobs)
+{
+   PROFILE_ZONE("FlowField::CalculateDirections");
+   if(_dirtyLowerX >= _dirtyUpperX || _dirtyLowerY >= _dirtyUpperY)
+   {
+      return;
+   }
+   // A direction depends on the cells around it.
+   DIRECTION_JOB_T job;
+   job.field = this;
+   job.lowerX = (_dirtyLowerX > 0) ? _dirtyLowerX - 1 : 0;
+   job.upperX = Min(_dirtyUpperX + 1,_width);
+   job.lowerY = (_dirtyLowerY > 0) ? _dirtyLowerY - 1 : 0;
+   uint32 upperY = Min(_dirtyUpperY + 1,_height);
+   if(jobs != NULL)
+   {
+      jobs->ParallelFor(upperY - job.lowerY,DIRECTION_GRAIN_SIZE,DirectionJob,&job);
+   }
+   else
+   {
+      CalculateDirections(job.lowerX,job.upperX,job.lowerY,upperY);
+   }
+   _dirtyLowerX = _width;
+   _dirtyLowerY = _height;
+   _dirtyUpperX = 0;
+   _dirtyUpperY = 0;
+}
+
+void FlowField::Rebuild(JobSystem* jobs)
+{
+   PROFILE_ZONE("FlowField::Rebuild");
+   for(uint32 idx = 0; idx < _changes.size(); idx++)
+   {
+      _marks[_changes[idx].cell] = 0;
+   }
+   _changes.clear();
+   if(jobs != NULL && jobs->GetThreadCount() > 1)
+   {
+      BuildSweeps(jobs);
+   }
+   else
+   {
+      BuildDijkstra();
+   }
+   MarkAllDirty();
+   CalculateDirections(jobs);
+   _rebuild = false;
+}
+
+void FlowField::Update(JobSystem* jobs)
+{
+   if(_rebuild || _changes.size() > _costs.size()/4)
+   {  // Cheaper to start over.
+      Rebuild(jobs);
+      return;
+   }
+   if(_changes.empty())
+   {
+      return;
+   }
+   Repair();
+   for(uint32 idx = 0; idx < _changes.size(); idx++)
+   {
+      _marks[_changes[idx].cell] = 0;
+   }
+   _changes.clear();
+   CalculateDirections(jobs);
+}
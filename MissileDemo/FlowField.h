@@ -0,0 +1,309 @@
+/********************************************************************
+ * File   : FlowField.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__FlowField__
+#define __MissileDemo__FlowField__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+
+class JobSystem;
+
+/* A shared steering field for a crowd heading to one goal.
+ *
+ * Following a Path, each entity carries its own list of
+ * points.  With thousands of entities going to the same
+ * place, that is thousands of copies of nearly the same
+ * path.  The flow field is a grid over the world where
+ * each cell holds the direction to go from there to the
+ * goal, so steering an entity is one array lookup
+ * (GetDirection(...)) no matter how many there are.
+ *
+ * Each cell has a cost of entering it (COST_MIN and up,
+ * COST_BLOCKED for walls).  The integration field is the
+ * cheapest total cost from each cell to the goal, moving
+ * to any of the 8 neighbors (diagonal moves cost about
+ * sqrt(2) more and may not cut the corner of a wall).
+ * The costs are integers, so the integration field is
+ * exact and any way of calculating it gets the same
+ * numbers.  The direction of a cell points at the
+ * neighbor its cheapest path goes through.
+ *
+ * 1. Init(...) with the world size (e.g. the Viewport's
+ *    GetWorldSizeMeters()).  The world is centered on
+ *    the origin, like the Viewport.
+ * 2. SetGoal(...) and SetCost(...) for the obstacles.
+ * 3. Update(...), then steer with GetDirection(...) or
+ *    GetSteeringTarget(...).
+ *
+ * A new goal rebuilds the whole field.  Given a JobSystem
+ * with more than one thread, the rebuild is a set of
+ * sweeps in the four diagonal directions, block by block
+ * along the block anti-diagonals, with the blocks on each
+ * anti-diagonal done in parallel.  The sweeps are repeated
+ * until nothing changes.  On one thread it is Dijkstra's
+ * algorithm.
+ *
+ * Cost changes since the last Update(...) are repaired
+ * in place.  Cells whose cheapest path ran through a cell
+ * that got more expensive are cleared and filled in again
+ * from the cells around them, and cells next to a cell
+ * that got cheaper are relaxed, both with Dijkstra's
+ * algorithm seeded with just those cells.  Only the
+ * directions around the cells that changed are
+ * calculated again.  The result is the same as a full
+ * rebuild.
+ *
+ * The field must not change while entities are steering
+ * with it.
+ */
+class FlowField
+{
+public:
+   enum
+   {
+      COST_MIN = 1,
+      COST_BLOCKED = 255
+   };
+   
+   enum
+   {
+      // The integration value of a cell with no way to the goal.
+      UNREACHABLE = 0xFFFFFFFF
+   };
+   
+private:
+   enum
+   {
+      // The cost of a step is this times the cost of the
+      // cell stepped into.  14/10 is close to sqrt(2).
+      STEP_STRAIGHT = 10,
+      STEP_DIAGONAL = 14,
+      // Cells on a side of a sweep block.
+      SWEEP_BLOCK_SIZE = 32,
+      // Rows per job chunk when calculating the directions.
+      DIRECTION_GRAIN_SIZE = 8,
+      // How far ahead GetSteeringTarget(...) looks, in cells.
+      LOOKAHEAD_CELLS = 2
+   };
+   
+   // The cells that changed cost since the last Update(...).
+   typedef struct
+   {
+      uint32 cell;
+      // The cost the integration field was built with.
+      uint8 builtCost;
+      uint8 newCost;
+   } COST_CHANGE_T;
+   
+   // Bits in _marks.
+   enum
+   {
+      MARK_CHANGED = 1,
+      MARK_CLEARED = 2
+   };
+   
+   typedef struct
+   {
+      FlowField* field;
+      int32 dirX;
+      int32 dirY;
+      // The block anti-diagonal being swept.
+      uint32 diagonal;
+      uint32 firstBlockX;
+   } SWEEP_JOB_T;
+   
+   typedef struct
+   {
+      FlowField* field;
+      uint32 lowerX;
+      uint32 upperX;
+      uint32 lowerY;
+   } DIRECTION_JOB_T;
+   
+   typedef pair<uint32,uint32> QUEUE_ENTRY_T;
+   typedef priority_queue<QUEUE_ENTRY_T, vector<QUEUE_ENTRY_T>, greater<QUEUE_ENTRY_T> > QUEUE_T;
+   
+   uint32 _width;
+   uint32 _height;
+   float32 _cellSize;
+   float32 _invCellSize;
+   Vec2 _lowerBound;
+   Vec2 _goal;
+   uint32 _goalCell;
+   bool _rebuild;
+   vector<uint8> _costs;
+   vector<uint32> _integration;
+   vector<Vec2> _directions;
+   vector<COST_CHANGE_T> _changes;
+   // MARK_CHANGED for the cells in _changes and, while
+   // repairing, MARK_CLEARED for the cells cleared.
+   vector<uint8> _marks;
+   // Scratch space for the rebuild and repair.
+   QUEUE_T _queue;
+   vector<uint32> _cleared;
+   vector<uint8> _sweepChanged;
+   // The cells whose directions need calculating again.
+   uint32 _dirtyLowerX;
+   uint32 _dirtyLowerY;
+   uint32 _dirtyUpperX;
+   uint32 _dirtyUpperY;
+   
+   inline uint32 CellIndex(uint32 x, uint32 y) const { return y*_width + x; }
+   inline bool IsBlocked(uint32 x, uint32 y) const { return _costs[CellIndex(x,y)] == COST_BLOCKED; }
+   
+   // The cost to the goal from (x,y) through the neighbor
+   // at (x+dx,y+dy), which must be on the grid.
+   inline uint32 CostThrough(uint32 x, uint32 y, int32 dx, int32 dy) const
+   {
+      uint32 nx = x + dx;
+      uint32 ny = y + dy;
+      uint32 neighbor = CellIndex(nx,ny);
+      uint32 integration = _integration[neighbor];
+      if(integration == UNREACHABLE || _costs[neighbor] == COST_BLOCKED)
+      {
+         return UNREACHABLE;
+      }
+      if(dx != 0 && dy != 0)
+      {
+         if(IsBlocked(nx,y) || IsBlocked(x,ny))
+         {
+            return UNREACHABLE;
+         }
+         return integration + STEP_DIAGONAL*_costs[neighbor];
+      }
+      return integration + STEP_STRAIGHT*_costs[neighbor];
+   }
+   
+   // True if the cheapest path from (x,y) can go through
+   // the neighbor at (x+dx,y+dy).
+   inline bool DependsOn(uint32 x, uint32 y, int32 dx, int32 dy) const
+   {
+      uint32 integration = _integration[CellIndex(x,y)];
+      return integration != UNREACHABLE && CostThrough(x,y,dx,dy) == integration;
+   }
+   
+   // The cheapest cost to the goal from (x,y) through any
+   // of its neighbors.
+   uint32 CheapestThroughNeighbors(uint32 x, uint32 y) const;
+   
+   void MarkDirty(uint32 x, uint32 y);
+   void MarkAllDirty();
+   void ResetIntegration();
+   void BuildDijkstra();
+   void BuildSweeps(JobSystem* jobs);
+   bool SweepBlock(uint32 lowerX, uint32 upperX, uint32 lowerY, uint32 upperY, int32 dirX, int32 dirY);
+   // Dijkstra's algorithm from the cells in _queue.
+   void RunQueue();
+   void Repair();
+   void ClearDependents(uint32 x, uint32 y);
+   void ClearCell(uint32 x, uint32 y);
+   void RelaxCell(uint32 x, uint32 y);
+   void CalculateDirections(JobSystem* jobs);
+   void CalculateDirections(uint32 lowerX, uint32 upperX, uint32 lowerY, uint32 upperY);
+   static void SweepJob(void* context, uint32 begin, uint32 end, uint32 worker);
+   static void DirectionJob(void* context, uint32 begin, uint32 end, uint32 worker);
+   
+public:
+   FlowField();
+   
+   // A grid of cellSize cells covering a width x height
+   // world centered on the origin.  Every cell costs
+   // COST_MIN and the goal is the origin.
+   void Init(float32 width, float32 height, float32 cellSize);
+   
+   inline uint32 GetWidth() const { return _width; }
+   inline uint32 GetHeight() const { return _height; }
+   inline float32 GetCellSize() const { return _cellSize; }
+   
+   // The cell a position is in.  Positions off the grid
+   // are clamped to the nearest edge cell.
+   inline void GetCell(const Vec2& position, uint32& x, uint32& y) const
+   {
+      float32 fx = (position.x - _lowerBound.x)*_invCellSize;
+      float32 fy = (position.y - _lowerBound.y)*_invCellSize;
+      x = (fx <= 0) ? 0 : ((fx >= _width) ? _width-1 : (uint32)fx);
+      y = (fy <= 0) ? 0 : ((fy >= _height) ? _height-1 : (uint32)fy);
+   }
+   Vec2 GetCellCenter(uint32 x, uint32 y) const;
+   
+   void SetGoal(const Vec2& position);
+   inline const Vec2& GetGoal() const { return _goal; }
+   
+   void SetCost(uint32 x, uint32 y, uint8 cost);
+   // All the cells with centers in the rectangle.
+   void SetCost(const Vec2& lowerBound, const Vec2& upperBound, uint8 cost);
+   inline uint8 GetCost(uint32 x, uint32 y) const { return _costs[CellIndex(x,y)]; }
+   
+   // Brings the field up to date with the goal and costs.
+   // jobs may be NULL.
+   void Update(JobSystem* jobs = NULL);
+   // Rebuilds the whole field, even if nothing changed.
+   void Rebuild(JobSystem* jobs = NULL);
+   
+   inline uint32 GetIntegration(uint32 x, uint32 y) const { return _integration[CellIndex(x,y)]; }
+   
+   // The cost to the goal from position, in meters of
+   // COST_MIN cells, or -1 if the goal cannot be reached.
+   inline float32 GetDistance(const Vec2& position) const
+   {
+      uint32 x;
+      uint32 y;
+      GetCell(position,x,y);
+      uint32 integration = _integration[CellIndex(x,y)];
+      if(integration == UNREACHABLE)
+      {
+         return -1;
+      }
+      return integration*(_cellSize/STEP_STRAIGHT);
+   }
+   
+   // The unit direction to go from position, or zero in
+   // the goal cell and where the goal cannot be reached.
+   // In a blocked cell, it points out of the wall.
+   inline const Vec2& GetDirection(const Vec2& position) const
+   {
+      uint32 x;
+      uint32 y;
+      GetCell(position,x,y);
+      return _directions[CellIndex(x,y)];
+   }
+   
+   // The point to steer for from position: a little way
+   // along the direction, or the goal when there is no
+   // direction.
+   inline Vec2 GetSteeringTarget(const Vec2& position) const
+   {
+      const Vec2& direction = GetDirection(position);
+      if(direction.x == 0 && direction.y == 0)
+      {
+         return _goal;
+      }
+      return position + (LOOKAHEAD_CELLS*_cellSize)*direction;
+   }
+};
+
+#endif /* defined(__MissileDemo__FlowField__) */
@@ -8,6 +8,7 @@
 
 #include "GridLayer.h"
 #include "Viewport.h"
+#include "Profiler.h"
 
 #define DRAW_GRID
 //#define DRAW_GRID_LABELS
@@ -173,6 +174,7 @@ void GridLayer::UpdateGridScale()
 
 void GridLayer::draw()
 {
+   PROFILE_ZONE("GridLayer::draw");
    CCLayer::draw();
 #ifdef DRAW_GRID
    DrawGridLines();
@@ -0,0 +1,328 @@
+/********************************************************************
+ * File   : GridPathfinder.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "GridPathfinder.h"
+#include "Profiler.h"
+
+GridPathfinder::GridPathfinder() :
+   _world(NULL),
+   _width(0),
+   _height(0),
+   _cellSize(1.0),
+   _invCellSize(1.0),
+   _lowerBound(0,0),
+   _clearance(0),
+   _lastPath(NULL),
+   _maxPlanners(DEFAULT_MAX_PLANNERS),
+   _maxPaths(DEFAULT_MAX_PATHS),
+   _clock(0),
+   _hitCount(0),
+   _missCount(0)
+{
+}
+
+GridPathfinder::~GridPathfinder()
+{
+   Shutdown();
+}
+
+void GridPathfinder::Init(b2World* world, float32 width, float32 height, float32 cellSize, float32 clearance)
+{
+   assert(world != NULL);
+   assert(width > 0);
+   assert(height > 0);
+   assert(cellSize > 0);
+   assert(clearance >= 0);
+   Shutdown();
+   _world = world;
+   _cellSize = cellSize;
+   _invCellSize = 1.0f/cellSize;
+   _width = (uint32)ceilf(width*_invCellSize);
+   _height = (uint32)ceilf(height*_invCellSize);
+   _width = Max(_width,1u);
+   _height = Max(_height,1u);
+   _lowerBound = Vec2(-0.5f*_width*cellSize,-0.5f*_height*cellSize);
+   _clearance = clearance;
+   _hitCount = 0;
+   _missCount = 0;
+   Rasterize(_blocked);
+}
+
+void GridPathfinder::Shutdown()
+{
+   ClearPaths();
+   for(map<uint32,PLANNER_T>::iterator iter = _planners.begin(); iter != _planners.end(); ++iter)
+   {
+      delete iter->second.planner;
+   }
+   _planners.clear();
+   _blocked.clear();
+   _world = NULL;
+}
+
+Vec2 GridPathfinder::GetCellCenter(uint32 cell) const
+{
+   uint32 x = cell % _width;
+   uint32 y = cell / _width;
+   return _lowerBound + Vec2((x + 0.5f)*_cellSize,(y + 0.5f)*_cellSize);
+}
+
+void GridPathfinder::Rasterize(vector<uint8>& blocked)
+{
+   PROFILE_ZONE("GridPathfinder::Rasterize");
+   blocked.assign(_width*_height,0);
+   // A cell is blocked if the cell grown by the clearance
+   // touches a fixture.
+   const float32 half = 0.5f*_cellSize + _clearance;
+   PolygonShape cellShape;
+   cellShape.SetAsBox(half,half);
+   Transform cellXf;
+   cellXf.SetIdentity();
+   const float32 maxX = _width - 1;
+   const float32 maxY = _height - 1;
+   for(Body* body = _world->GetBodyList(); body != NULL; body = body->GetNext())
+   {
+      if(body->GetType() == b2_dynamicBody)
+      {
+         continue;
+      }
+      const Transform& xf = body->GetTransform();
+      for(Fixture* fixture = body->GetFixtureList(); fixture != NULL; fixture = fixture->GetNext())
+      {
+         if(fixture->IsSensor())
+         {
+            continue;
+         }
+         const b2Shape* shape = fixture->GetShape();
+         for(int32 child = 0; child < shape->GetChildCount(); child++)
+         {
+            AABB aabb;
+            shape->ComputeAABB(&aabb,xf,child);
+            float32 fx0 = ceilf((aabb.lowerBound.x - half - _lowerBound.x)*_invCellSize - 0.5f);
+            float32 fy0 = ceilf((aabb.lowerBound.y - half - _lowerBound.y)*_invCellSize - 0.5f);
+            float32 fx1 = floorf((aabb.upperBound.x + half - _lowerBound.x)*_invCellSize - 0.5f);
+            float32 fy1 = floorf((aabb.upperBound.y + half - _lowerBound.y)*_invCellSize - 0.5f);
+            if(fx1 < 0 || fy1 < 0 || fx0 > maxX || fy0 > maxY)
+            {  // Off the grid.
+               continue;
+            }
+            uint32 x0 = (fx0 < 0) ? 0 : (uint32)fx0;
+            uint32 y0 = (fy0 < 0) ? 0 : (uint32)fy0;
+            uint32 x1 = (fx1 > maxX) ? _width - 1 : (uint32)fx1;
+            uint32 y1 = (fy1 > maxY) ? _height - 1 : (uint32)fy1;
+            for(uint32 y = y0; y <= y1; y++)
+            {
+               for(uint32 x = x0; x <= x1; x++)
+               {
+                  uint32 cell = y*_width + x;
+                  if(blocked[cell] != 0)
+                  {
+                     continue;
+                  }
+                  cellXf.p = GetCellCenter(cell);
+                  if(b2TestOverlap(shape,child,&cellShape,0,xf,cellXf))
+                  {
+                     blocked[cell] = 1;
+                  }
+               }
+            }
+         }
+      }
+   }
+}
+
+uint32 GridPathfinder::UpdateObstacles()
+{
+   PROFILE_ZONE("GridPathfinder::UpdateObstacles");
+   assert(_world != NULL);
+   Rasterize(_rasterized);
+   _changed.clear();
+   for(uint32 cell = 0; cell < _blocked.size(); cell++)
+   {
+      if(_rasterized[cell] != _blocked[cell])
+      {
+         _changed.push_back(cell);
+      }
+   }
+   if(_changed.empty())
+   {
+      return 0;
+   }
+   _blocked.swap(_rasterized);
+   // The planners look at _blocked, so they see the new
+   // cells from here on.  The searches are repaired the
+   // next time each one is asked for a path.
+   for(map<uint32,PLANNER_T>::iterator iter = _planners.begin(); iter != _planners.end(); ++iter)
+   {
+      iter->second.planner->CellsChanged(_changed);
+   }
+   ClearPaths();
+   return _changed.size();
+}
+
+DStarLite* GridPathfinder::GetPlanner(uint32 goalCell)
+{
+   map<uint32,PLANNER_T>::iterator iter = _planners.find(goalCell);
+   if(iter != _planners.end())
+   {
+      iter->second.lastUsed = _clock;
+      return iter->second.planner;
+   }
+   if(_planners.size() >= _maxPlanners)
+   {  // Drop the least used one.
+      map<uint32,PLANNER_T>::iterator oldest = _planners.begin();
+      for(iter = _planners.begin(); iter != _planners.end(); ++iter)
+      {
+         if(iter->second.lastUsed < oldest->second.lastUsed)
+         {
+            oldest = iter;
+         }
+      }
+      delete oldest->second.planner;
+      _planners.erase(oldest);
+   }
+   PLANNER_T planner;
+   planner.planner = new DStarLite();
+   planner.planner->Init(&_blocked,_width,_height,goalCell);
+   planner.lastUsed = _clock;
+   _planners[goalCell] = planner;
+   return planner.planner;
+}
+
+Path* GridPathfinder::CreatePath(const DStarLite* planner)
+{
+   if(!planner->GetPath(_cells))
+   {
+      return NULL;
+   }
+   // Only the cells where the path turns are needed.
+   _points.clear();
+   _points.push_back(GetCellCenter(_cells[0]));
+   for(uint32 idx = 1; idx+1 < _cells.size(); idx++)
+   {
+      int32 stepIn = (int32)_cells[idx] - (int32)_cells[idx-1];
+      int32 stepOut = (int32)_cells[idx+1] - (int32)_cells[idx];
+      if(stepIn != stepOut)
+      {
+         _points.push_back(GetCellCenter(_cells[idx]));
+      }
+   }
+   if(_cells.size() > 1)
+   {
+      _points.push_back(GetCellCenter(_cells.back()));
+   }
+   return Path::Create(_points);
+}
+
+void GridPathfinder::ClearPaths()
+{
+   for(PATH_CACHE_T::iterator iter = _paths.begin(); iter != _paths.end(); ++iter)
+   {
+      if(iter->second.path != NULL)
+      {
+         iter->second.path->Release();
+      }
+   }
+   _paths.clear();
+   if(_lastPath != NULL)
+   {
+      _lastPath->Release();
+      _lastPath = NULL;
+   }
+}
+
+void GridPathfinder::TrimPaths()
+{
+   while(_paths.size() > _maxPaths)
+   {
+      PATH_CACHE_T::iterator oldest = _paths.begin();
+      for(PATH_CACHE_T::iterator iter = _paths.begin(); iter != _paths.end(); ++iter)
+      {
+         if(iter->second.lastUsed < oldest->second.lastUsed)
+         {
+            oldest = iter;
+         }
+      }
+      if(oldest->second.path != NULL)
+      {
+         oldest->second.path->Release();
+      }
+      _paths.erase(oldest);
+   }
+}
+
+const Path* GridPathfinder::FindPath(const Vec2& start, const Vec2& goal)
+{
+   PROFILE_ZONE("GridPathfinder::FindPath");
+   assert(_world != NULL);
+   _clock++;
+   uint32 startCell = GetCell(start);
+   uint32 goalCell = GetCell(goal);
+   PATH_KEY_T key(startCell,goalCell);
+   if(_maxPaths > 0)
+   {
+      PATH_CACHE_T::iterator iter = _paths.find(key);
+      if(iter != _paths.end())
+      {
+         _hitCount++;
+         iter->second.lastUsed = _clock;
+         return iter->second.path;
+      }
+   }
+   _missCount++;
+   DStarLite* planner = GetPlanner(goalCell);
+   planner->SetStart(startCell);
+   planner->ComputeShortestPath();
+   Path* path = CreatePath(planner);
+   if(_maxPaths > 0)
+   {
+      CACHED_PATH_T cached;
+      cached.path = path;
+      cached.lastUsed = _clock;
+      _paths[key] = cached;
+      TrimPaths();
+   }
+   else
+   {
+      if(_lastPath != NULL)
+      {
+         _lastPath->Release();
+      }
+      _lastPath = path;
+   }
+   return path;
+}
+
+uint32 GridPathfinder::GetExpandedCount() const
+{
+   uint32 count = 0;
+   for(map<uint32,PLANNER_T>::const_iterator iter = _planners.begin(); iter != _planners.end(); ++iter)
+   {
+      count += iter->second.planner->GetExpandedCount();
+   }
+   return count;
+}
@@ -0,0 +1,174 @@
+/********************************************************************
+ * File   : GridPathfinder.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__GridPathfinder__
+#define __MissileDemo__GridPathfinder__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "DStarLite.h"
+#include "Path.h"
+
+/* Plans paths around the fixed obstacles in the world.
+ *
+ * The world is covered by a grid centered on the origin
+ * (like the Viewport), and every cell within the clearance
+ * of a fixture of a static or kinematic body is blocked.
+ * Sensors and dynamic bodies (the entities) are not
+ * obstacles.
+ *
+ * The paths come from a DStarLite planner per goal cell.
+ * Asking for a path from a new start to the same goal
+ * moves the planner's start and only searches the part
+ * that is new.  When obstacles have moved,
+ * UpdateObstacles() blocks and opens the cells that
+ * changed, and the planners repair their searches instead
+ * of starting over.
+ *
+ * Finished paths are cached by (start cell, goal cell), so
+ * a flight of missiles launched from the same place at the
+ * same target all get the same Path.  The cache is
+ * emptied when the obstacles change; asking again gives
+ * the repaired path.
+ *
+ * The paths go from the center of the start cell to the
+ * center of the goal cell, and can be given straight to
+ * CommandFollowPath(...):
+ *
+ *    entity->CommandFollowPath(pathfinder.FindPath(from,to));
+ *
+ * The least used planners and paths are dropped when
+ * there are more than the limits.
+ */
+class GridPathfinder
+{
+public:
+   enum
+   {
+      DEFAULT_MAX_PLANNERS = 4,
+      DEFAULT_MAX_PATHS = 256
+   };
+   
+private:
+   typedef struct
+   {
+      DStarLite* planner;
+      uint32 lastUsed;
+   } PLANNER_T;
+   
+   typedef struct
+   {
+      // NULL when there is no way to the goal.
+      Path* path;
+      uint32 lastUsed;
+   } CACHED_PATH_T;
+   
+   typedef pair<uint32,uint32> PATH_KEY_T;
+   typedef map<PATH_KEY_T,CACHED_PATH_T> PATH_CACHE_T;
+   
+   b2World* _world;
+   uint32 _width;
+   uint32 _height;
+   float32 _cellSize;
+   float32 _invCellSize;
+   Vec2 _lowerBound;
+   float32 _clearance;
+   vector<uint8> _blocked;
+   // Scratch space for UpdateObstacles().
+   vector<uint8> _rasterized;
+   vector<uint32> _changed;
+   vector<uint32> _cells;
+   vector<Vec2> _points;
+   // By goal cell.
+   map<uint32,PLANNER_T> _planners;
+   PATH_CACHE_T _paths;
+   // The last path found with the cache off.
+   Path* _lastPath;
+   uint32 _maxPlanners;
+   uint32 _maxPaths;
+   // Counts FindPath(...) calls, for the least used.
+   uint32 _clock;
+   uint32 _hitCount;
+   uint32 _missCount;
+   
+   void Rasterize(vector<uint8>& blocked);
+   DStarLite* GetPlanner(uint32 goalCell);
+   Path* CreatePath(const DStarLite* planner);
+   void ClearPaths();
+   void TrimPaths();
+   
+public:
+   GridPathfinder();
+   ~GridPathfinder();
+   
+   // A grid of cellSize cells over a width x height world.
+   // Cells within clearance of an obstacle are blocked.
+   // The world must outlive the pathfinder (or Shutdown()).
+   void Init(b2World* world, float32 width, float32 height, float32 cellSize, float32 clearance);
+   void Shutdown();
+   
+   inline uint32 GetWidth() const { return _width; }
+   inline uint32 GetHeight() const { return _height; }
+   inline float32 GetCellSize() const { return _cellSize; }
+   // The cell a position is in.  Positions off the grid
+   // are clamped to the nearest edge cell.
+   inline uint32 GetCell(const Vec2& position) const
+   {
+      float32 fx = (position.x - _lowerBound.x)*_invCellSize;
+      float32 fy = (position.y - _lowerBound.y)*_invCellSize;
+      uint32 x = (fx <= 0) ? 0 : ((fx >= _width) ? _width-1 : (uint32)fx);
+      uint32 y = (fy <= 0) ? 0 : ((fy >= _height) ? _height-1 : (uint32)fy);
+      return y*_width + x;
+   }
+   Vec2 GetCellCenter(uint32 cell) const;
+   inline bool IsBlocked(uint32 cell) const { return _blocked[cell] != 0; }
+   
+   // Blocks and opens cells for obstacles that have moved
+   // (or been added or removed) and repairs the planners.
+   // Returns the number of cells that changed.
+   uint32 UpdateObstacles();
+   
+   // The path from start to goal, or NULL if there is no
+   // way (or either end is in a blocked cell).  The cache
+   // holds a reference to the path until the next
+   // FindPath(...) or UpdateObstacles(); Retain() it to
+   // keep it longer (entities following it do).
+   const Path* FindPath(const Vec2& start, const Vec2& goal);
+   
+   inline void SetMaxPlanners(uint32 maxPlanners) { assert(maxPlanners > 0); _maxPlanners = maxPlanners; }
+   inline uint32 GetMaxPlanners() const { return _maxPlanners; }
+   // Zero turns the cache off.
+   inline void SetMaxPaths(uint32 maxPaths) { _maxPaths = maxPaths; }
+   inline uint32 GetMaxPaths() const { return _maxPaths; }
+   
+   // FindPath(...) calls answered from the cache, and not.
+   inline uint32 GetHitCount() const { return _hitCount; }
+   inline uint32 GetMissCount() const { return _missCount; }
+   // Cells expanded by all the planners there are now.
+   uint32 GetExpandedCount() const;
+};
+
+#endif /* defined(__MissileDemo__GridPathfinder__) */
@@ -0,0 +1,131 @@
+/********************************************************************
+ * File   : InterceptGuidance.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "InterceptGuidance.h"
+
+Vec2 InterceptGuidance::PredictInterceptPoint(const Vec2& chaserPos, float32 speed,
+                                              const Vec2& targetPos, const Vec2& targetVel)
+{
+   // Solve |toTarget + targetVel*t| = speed*t for the
+   // first t > 0.
+   Vec2 toTarget = targetPos - chaserPos;
+   float32 a = b2Dot(targetVel,targetVel) - speed*speed;
+   float32 b = 2*b2Dot(toTarget,targetVel);
+   float32 c = b2Dot(toTarget,toTarget);
+   float32 t = -1;
+   if(fabsf(a) < b2_epsilon)
+   {  // Same speed; only works if the target is coming.
+      if(b < 0)
+         t = -c/b;
+   }
+   else
+   {
+      float32 disc = b*b - 4*a*c;
+      if(disc >= 0)
+      {
+         float32 root = sqrtf(disc);
+         float32 t1 = (-b - root)/(2*a);
+         float32 t2 = (-b + root)/(2*a);
+         if(t1 > t2)
+         {
+            float32 temp = t1;
+            t1 = t2;
+            t2 = temp;
+         }
+         t = (t1 > 0) ? t1 : t2;
+      }
+   }
+   if(t <= 0)
+   {
+      return targetPos;
+   }
+   return targetPos + t*targetVel;
+}
+
+const char* InterceptGuidance::LawString(LAW_T law)
+{
+   switch(law)
+   {
+      case GL_PURSUIT:
+         return "pursuit";
+      case GL_PN:
+         return "PN";
+      case GL_APN:
+         return "APN";
+      default:
+         assert(false);
+         return "unknown";
+   }
+}
+
+InterceptGuidanceBatch::InterceptGuidanceBatch() :
+   _count(0)
+{
+}
+
+void InterceptGuidanceBatch::SetCount(uint32 count)
+{
+   _count = count;
+   if(count <= _posX.size())
+   {
+      return;
+   }
+   _posX.resize(count);
+   _posY.resize(count);
+   _dirX.resize(count);
+   _dirY.resize(count);
+   _velX.resize(count);
+   _velY.resize(count);
+   _angularVelocity.resize(count);
+   _inertia.resize(count);
+   _maxAngularAcceleration.resize(count);
+   _targetX.resize(count);
+   _targetY.resize(count);
+   _targetVelX.resize(count);
+   _targetVelY.resize(count);
+   _targetAccX.resize(count);
+   _targetAccY.resize(count);
+   _headingError.resize(count);
+   _torque.resize(count);
+}
+
+void InterceptGuidanceBatch::Calculate(InterceptGuidance::LAW_T law, float32 navigationConstant)
+{
+   for(uint32 idx = 0; idx < _count; idx++)
+   {
+      float32 turnRate = InterceptGuidance::CalculateTurnRate(law,navigationConstant,
+                                                              Vec2(_posX[idx],_posY[idx]),
+                                                              Vec2(_dirX[idx],_dirY[idx]),
+                                                              Vec2(_velX[idx],_velY[idx]),
+                                                              Vec2(_targetX[idx],_targetY[idx]),
+                                                              Vec2(_targetVelX[idx],_targetVelY[idx]),
+                                                              Vec2(_targetAccX[idx],_targetAccY[idx]),
+                                                              _headingError[idx]);
+      _torque[idx] = InterceptGuidance::TurnRateTorque(turnRate,_angularVelocity[idx],_inertia[idx],
+                                                       _maxAngularAcceleration[idx],SECONDS_PER_TICK);
+   }
+}
@@ -0,0 +1,249 @@
+/********************************************************************
+ * File   : InterceptGuidance.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__InterceptGuidance__
+#define __MissileDemo__InterceptGuidance__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "MathUtilities.h"
+
+/* Guidance laws for flying a missile into a moving target.
+ *
+ * Seeking steers the missile straight at where the target
+ * is (pure pursuit).  Against a moving target that always
+ * chases where the target was and ends in a tail chase.
+ * Proportional navigation (PN) turns the missile at a rate
+ * proportional to how fast the line of sight (LOS) to the
+ * target is rotating.  That drives the LOS rate to zero,
+ * which is a collision course:
+ *
+ *    PN  : turn rate = N * Vc * LOSRate / Vm
+ *    APN : PN + (N/2) * (target accel normal to LOS) / Vm
+ *
+ * Vc is the closing speed, Vm the missile speed and N the
+ * navigation constant (3 to 5).  These are the "true PN"
+ * forms; the acceleration is normal to the LOS and the
+ * missile gets it by turning at (acceleration / Vm).
+ * Augmented PN (APN) also leads a target that is turning.
+ *
+ * PN only works when the missile is closing on the target
+ * and already close to the collision course.  Otherwise
+ * (just launched, or the target got behind it) PN and APN
+ * turn onto the collision course first.  That is the
+ * heading that leads the LOS enough to match the target's
+ * speed across it.  GL_PURSUIT always turns straight at
+ * the target.
+ *
+ * The laws give a turn rate.  TurnRateTorque(...) is the
+ * torque that gets the body to that rate in one tick,
+ * limited by its maximum angular acceleration.
+ *
+ * The batch class below runs the same law for a lot of
+ * missile/target pairs held in parallel arrays (like the
+ * SteeringBatch), so a MissileSwarm missile flies exactly
+ * like a Missile.
+ */
+class InterceptGuidance
+{
+public:
+   typedef enum
+   {
+      GL_PURSUIT,
+      GL_PN,
+      GL_APN,
+      GL_MAX
+   } LAW_T;
+   
+   enum
+   {
+      DEFAULT_NAVIGATION_CONSTANT = 4
+   };
+   
+   // The turn rate (rads/s, + is CCW) for one missile.
+   // missileDir is the body x axis in world coordinates.
+   // targetAcc is only used by GL_APN.
+   //
+   // headingError is the angle from the missile axis to
+   // the LOS (for the Telemetry).
+   static inline float32 CalculateTurnRate(LAW_T law, float32 navigationConstant,
+                                           const Vec2& missilePos, const Vec2& missileDir, const Vec2& missileVel,
+                                           const Vec2& targetPos, const Vec2& targetVel, const Vec2& targetAcc,
+                                           float32& headingError)
+   {
+      // Turn rate per radian of heading error when not on PN.
+      const float32 PURSUIT_GAIN = 3.0;
+      // PN takes over inside this error from the collision
+      // course.  Much wider and PN is left to fix big
+      // heading errors, which it does slowly.
+      const float32 HANDOVER_ANGLE = 0.2;
+      // Keeps the divides sane when the missile is on top
+      // of the target or has not got going yet.
+      const float32 MIN_RANGE = 0.1;
+      const float32 MIN_SPEED = 1.0;
+      
+      Vec2 los = targetPos - missilePos;
+      headingError = atan2f(b2Cross(missileDir,los),b2Dot(missileDir,los));
+      if(law == GL_PURSUIT)
+      {
+         return PURSUIT_GAIN*headingError;
+      }
+      
+      float32 range = los.Length();
+      if(range < MIN_RANGE)
+         range = MIN_RANGE;
+      float32 missileSpeed = missileVel.Length();
+      if(missileSpeed < MIN_SPEED)
+         missileSpeed = MIN_SPEED;
+      Vec2 relVel = targetVel - missileVel;
+      float32 losRate = b2Cross(los,relVel)/(range*range);
+      float32 closingSpeed = -b2Dot(los,relVel)/range;
+      
+      // The collision course leads the LOS by the angle
+      // that matches the target's speed across the LOS.
+      float32 leadSin = b2Cross(los,targetVel)/(range*missileSpeed);
+      float32 leadAngle = (fabsf(leadSin) < 1) ? asinf(leadSin) : 0;
+      float32 courseError = MathUtilities::AdjustAngle(headingError + leadAngle);
+      if(closingSpeed <= 0 || fabsf(courseError) > HANDOVER_ANGLE)
+      {  // Turn onto the collision course first.
+         return PURSUIT_GAIN*courseError;
+      }
+      
+      float32 turnRate = navigationConstant*closingSpeed*losRate/missileSpeed;
+      if(law == GL_APN)
+      {
+         float32 normalAcc = b2Cross(los,targetAcc)/range;
+         turnRate += 0.5f*navigationConstant*normalAcc/missileSpeed;
+      }
+      return turnRate;
+   }
+   
+   // The torque to go from angularVelocity to turnRate in
+   // one time step, within the maximum angular acceleration.
+   // This stands in for the PID turn controller.
+   static inline float32 TurnRateTorque(float32 turnRate, float32 angularVelocity, float32 inertia,
+                                        float32 maxAngularAcceleration, float32 timeStep)
+   {
+      float32 angAcc = (turnRate - angularVelocity)/timeStep;
+      if(angAcc > maxAngularAcceleration)
+         angAcc = maxAngularAcceleration;
+      if(angAcc < -maxAngularAcceleration)
+         angAcc = -maxAngularAcceleration;
+      return angAcc*inertia;
+   }
+   
+   // The target acceleration for GL_APN, from the change in
+   // the target velocity over the last time step.
+   static inline Vec2 EstimateAcceleration(const Vec2& velocity, const Vec2& lastVelocity, float32 timeStep)
+   {
+      return (1.0f/timeStep)*(velocity - lastVelocity);
+   }
+   
+   // Where a chaser moving at speed would meet a target
+   // moving at constant velocity (first order prediction).
+   // If it cannot catch the target, this is the target
+   // position.
+   static Vec2 PredictInterceptPoint(const Vec2& chaserPos, float32 speed,
+                                     const Vec2& targetPos, const Vec2& targetVel);
+   
+   static const char* LawString(LAW_T law);
+};
+
+/* The guidance for a batch of missile/target pairs.
+ *
+ * 1. SetCount(...), then SetPair(...) for each pair.
+ * 2. Calculate(...).
+ * 3. GetTorque(...) is the torque to apply to the missile.
+ *    GetHeadingError(...) is the heading error.
+ */
+class InterceptGuidanceBatch
+{
+private:
+   uint32 _count;
+   
+   // Missile state (inputs).
+   vector<float32> _posX;
+   vector<float32> _posY;
+   vector<float32> _dirX;
+   vector<float32> _dirY;
+   vector<float32> _velX;
+   vector<float32> _velY;
+   vector<float32> _angularVelocity;
+   vector<float32> _inertia;
+   vector<float32> _maxAngularAcceleration;
+   // Target state (inputs).
+   vector<float32> _targetX;
+   vector<float32> _targetY;
+   vector<float32> _targetVelX;
+   vector<float32> _targetVelY;
+   vector<float32> _targetAccX;
+   vector<float32> _targetAccY;
+   
+   // Results.
+   vector<float32> _headingError;
+   vector<float32> _torque;
+   
+public:
+   InterceptGuidanceBatch();
+   
+   // The arrays only grow, so after the first few
+   // ticks this does not allocate.
+   void SetCount(uint32 count);
+   inline uint32 GetCount() const { return _count; }
+   
+   inline void SetPair(uint32 idx, const Body* missile, const Body* target,
+                       const Vec2& lastTargetVel, float32 maxAngularAcceleration)
+   {
+      const b2Transform& xf = missile->GetTransform();
+      const Vec2& vel = missile->GetLinearVelocity();
+      const Vec2& targetVel = target->GetLinearVelocity();
+      Vec2 targetAcc = InterceptGuidance::EstimateAcceleration(targetVel,lastTargetVel,SECONDS_PER_TICK);
+      _posX[idx] = xf.p.x;
+      _posY[idx] = xf.p.y;
+      // Same as body->GetWorldVector(Vec2(1.0,0.0)).
+      _dirX[idx] = xf.q.c;
+      _dirY[idx] = xf.q.s;
+      _velX[idx] = vel.x;
+      _velY[idx] = vel.y;
+      _angularVelocity[idx] = missile->GetAngularVelocity();
+      _inertia[idx] = missile->GetInertia();
+      _maxAngularAcceleration[idx] = maxAngularAcceleration;
+      _targetX[idx] = target->GetPosition().x;
+      _targetY[idx] = target->GetPosition().y;
+      _targetVelX[idx] = targetVel.x;
+      _targetVelY[idx] = targetVel.y;
+      _targetAccX[idx] = targetAcc.x;
+      _targetAccY[idx] = targetAcc.y;
+   }
+   
+   inline float32 GetHeadingError(uint32 idx) const { return _headingError[idx]; }
+   inline float32 GetTorque(uint32 idx) const { return _torque[idx]; }
+   
+   void Calculate(InterceptGuidance::LAW_T law, float32 navigationConstant);
+};
+
+#endif /* defined(__MissileDemo__InterceptGuidance__) */
@@ -39,15 +39,21 @@
  * 2. Execute the Create(...) function.
  * 3. Use the boolean Interpolate(...) to get an interpolated value.  If
  *    the input value is out of the range of the original data points,
- *    the function will return false.
+ *    the function will return false.  InterpolateBatch(...) does the
+ *    same for an array of values.
  *
  * If only one control point is provided, the Interpolation will fail.
  * If two control points are provided, the interval will be split to add
  * a new control point which is the average of the two ends, yielding a
  * linear interpolation.
  *
- * You can add new points at any time and call Create(...) again.
- * Do not do this very often...the implementation may be expensive.
+ * Finding the interval for a value is a direct index into a grid
+ * over the range of x, so it does not depend on the number of
+ * control points.
+ *
+ * Control pairs added after Create(...) only update the intervals
+ * next to them (see UpdateInterpolation(...)); there is no need to
+ * call Create(...) again.
  */
 
 #include "CommonSTL.h"
@@ -57,7 +63,79 @@ template<typename Number>
 class Interpolator
 {
 private:
+   enum
+   {
+      // InterpolateBatch(...) finds the intervals for this
+      // many values, then evaluates them all in one loop.
+      BATCH_BLOCK_SIZE = 64,
+      GRID_CELLS_PER_INTERVAL = 2,
+   };
    
+   bool _created;
+   
+   // Lookup grid over the range of x.  Each cell holds the
+   // first interval that ends at or after the start of the
+   // cell, so a lookup is an index and (usually) no more than
+   // a step or two.
+   vector<uint32> _grid;
+   Number _gridStart;
+   Number _gridScale;
+   
+   void CreateGrid()
+   {
+      _grid.clear();
+      const uint32 count = _intervals.size();
+      if(count == 0)
+         return;
+      Number start = _intervals[0].start.x;
+      Number range = _intervals[count-1].end.x - start;
+      if(!(range > 0))
+         return;
+      // A couple of cells per interval keeps the steps down
+      // when the spacing is uneven.
+      uint32 cells = GRID_CELLS_PER_INTERVAL*count;
+      _grid.resize(cells);
+      _gridStart = start;
+      _gridScale = cells/range;
+      uint32 idx = 0;
+      for(uint32 cell = 0; cell < cells; cell++)
+      {
+         Number cellStart = start + cell/_gridScale;
+         while(idx < count-1 && _intervals[idx].end.x < cellStart)
+            idx++;
+         _grid[cell] = idx;
+      }
+   }
+   
+   // Returns true and the interval for x if it is in the range.
+   // Values on the boundary go to the interval on the left, as
+   // they always have.  hint is an interval to try first.
+   inline bool FindInterval(Number x, uint32& index, uint32 hint = 0) const
+   {
+      const uint32 count = _intervals.size();
+      if(count == 0 || !(x >= _intervals[0].start.x && x <= _intervals[count-1].end.x))
+         return false;
+      if(hint < count && _intervals[hint].IsInInterval(x) &&
+         (hint == 0 || x > _intervals[hint].start.x))
+      {
+         index = hint;
+         return true;
+      }
+      uint32 idx = 0;
+      if(!_grid.empty())
+      {
+         Number cell = (x - _gridStart)*_gridScale;
+         idx = _grid[(cell < _grid.size()) ? (uint32)cell : _grid.size()-1];
+         // The cell may be off by one from rounding.
+         while(idx > 0 && x <= _intervals[idx-1].end.x)
+            idx--;
+      }
+      // First interval that ends at or after x.
+      while(idx < count-1 && x > _intervals[idx].end.x)
+         idx++;
+      index = idx;
+      return true;
+   }
    
 protected:
    typedef struct
@@ -91,9 +169,9 @@ protected:
          return x>= start.x && x <= end.x;
       }
       
-      inline float Evaluate(Number x) const
-      {
-         return A*x*x*x + B*x*x + C*x + D;
+      inline Number Evaluate(Number x) const
+      {  // Horner's rule
+         return ((A*x + B)*x + C)*x + D;
       }
       
       inline void Init(Number a, Number b, Number c, Number d,
@@ -110,28 +188,67 @@ protected:
       }
    };
    
-   
-   typedef map<Number,Number> CONTROL_MAP_T;
-   typedef typename CONTROL_MAP_T::iterator CONTROL_MAP_ITER_T;
-   CONTROL_MAP_T _controlPoints;
+   // The control points, sorted by x.
+   vector<CONTROL_PAIR_T> _controlPoints;
    vector<INTERVAL_T> _intervals;
    
+   // Returns the index of the first control point at or after x.
+   uint32 FindControlPoint(Number x) const
+   {
+      uint32 low = 0;
+      uint32 high = _controlPoints.size();
+      while(low < high)
+      {
+         uint32 middle = (low+high)/2;
+         if(_controlPoints[middle].x < x)
+            low = middle+1;
+         else
+            high = middle;
+      }
+      return low;
+   }
+   
    void CreateIntervals()
    {
       _intervals.clear();
-      for(CONTROL_MAP_ITER_T iter = _controlPoints.begin(); iter != _controlPoints.end(); iter++)
+      for(uint32 idx = 1; idx < _controlPoints.size(); idx++)
       {
+         const CONTROL_PAIR_T& start = _controlPoints[idx-1];
+         const CONTROL_PAIR_T& end = _controlPoints[idx];
          INTERVAL_T interval;
-         interval.Init(0,0,0,0, iter->first, iter->second, 0, 0);
+         interval.Init(0,0,0,0, start.x, start.y, end.x, end.y);
          _intervals.push_back(interval);
       }
-      for(int idx = 1; idx < _intervals.size(); idx++)
-      {
-         _intervals[idx-1].end = _intervals[idx].start;
-      }
-      sort(_intervals.begin(),_intervals.end());
-      // We end up with an extra interval; remove it.
-      _intervals.resize(_intervals.size()-1);
+      CreateGrid();
+   }
+   
+   inline static void CreateLinear(INTERVAL_T& iv)
+   {
+      /* Given y0 = m*x0 + b
+       *       y1 = m*x1 + b
+       *
+       *       Sovle for m, b
+       *
+       *       => m = (y1-y0)/(x1-x0)
+       *          b = y1-m*x1
+       */
+      iv.A = 0;
+      iv.B = 0;
+      iv.C = (iv.end.y-iv.start.y)/(iv.end.x-iv.start.x);
+      iv.D = iv.end.y-iv.C*iv.end.x;
+   }
+   
+   // Sets the interval to the cubic
+   //    f(x) = a + b*t + c*t^2 + d*t^3, t = x - start.x
+   // (the usual form for splines), in the form used by
+   // Evaluate(...).
+   inline static void SetLocalCubic(INTERVAL_T& iv, Number a, Number b, Number c, Number d)
+   {
+      Number x0 = iv.start.x;
+      iv.A = d;
+      iv.B = c - 3*d*x0;
+      iv.C = b + (3*d*x0 - 2*c)*x0;
+      iv.D = a + ((c - d*x0)*x0 - b)*x0;
    }
    
    /* This function is declared virtual so that derived
@@ -145,19 +262,27 @@ protected:
     */
    virtual bool CreateInterpolation()
    {
-      /* Given y0 = m*x0 + b
-       *       y1 = m*x1 + b
-       *
-       *       Sovle for m, b
-       *
-       *       => m = (y1-y0)/(x1-x0)
-       *          b = y1-m*x1
-       */
-      for(int idx = 0; idx < _intervals.size(); idx++)
+      for(uint32 idx = 0; idx < _intervals.size(); idx++)
       {  // Linear Interpolation
-         INTERVAL_T& iv = _intervals[idx];
-         iv.C = (iv.end.y-iv.start.y)/(iv.end.x-iv.start.x);
-         iv.D = iv.end.y-iv.C*iv.end.x;
+         CreateLinear(_intervals[idx]);
+      }
+      return true;
+   }
+   
+   /* Called when a control pair added after Create(...) has
+    * changed the intervals first..last (their start/end points
+    * are already set).  A linear interpolation only needs those
+    * intervals redone.
+    *
+    * Derived classes that override CreateInterpolation() MUST
+    * override this as well; redo as much as the scheme needs
+    * (e.g. all of it, by calling CreateInterpolation()).
+    */
+   virtual bool UpdateInterpolation(uint32 first, uint32 last)
+   {
+      for(uint32 idx = first; idx <= last; idx++)
+      {
+         CreateLinear(_intervals[idx]);
       }
       return true;
    }
@@ -167,6 +292,8 @@ public:
    {
       _controlPoints.clear();
       _intervals.clear();
+      _created = false;
+      _grid.clear();
    }
    
    void Dump()
@@ -175,18 +302,18 @@ public:
       cout << "---------------------------------" << endl;
       cout << "Interpolator Intervals" << endl;
       cout << "---------------------------------" << endl;
-      for(int idx = 0; idx < _intervals.size(); idx++)
+      for(uint32 idx = 0; idx < _intervals.size(); idx++)
       {
          char buffer[1024];
          INTERVAL_T& intv = _intervals[idx];
          sprintf(buffer,"[%d] (%10.5f,%10.5f) -> (%10.5f,%10.5f) A = %10.5f, B = %10.5f, C = %10.5f, D = %10.5f",
                  idx,
-                 intv.start.x,intv.start.y,
-                 intv.end.x,intv.end.y,
-                 intv.A,
-                 intv.B,
-                 intv.C,
-                 intv.D
+                 (double)intv.start.x,(double)intv.start.y,
+                 (double)intv.end.x,(double)intv.end.y,
+                 (double)intv.A,
+                 (double)intv.B,
+                 (double)intv.C,
+                 (double)intv.D
                  );
          cout << buffer << endl;
       }
@@ -204,20 +331,136 @@ public:
    
    void AddControlPair(Number x, Number y)
    {
-      _controlPoints[x] = y;
+      uint32 index = FindControlPoint(x);
+      bool found = index < _controlPoints.size() && _controlPoints[index].x == x;
+      if(found)
+      {
+         _controlPoints[index].y = y;
+      }
+      else
+      {
+         CONTROL_PAIR_T pair;
+         pair.x = x;
+         pair.y = y;
+         _controlPoints.insert(_controlPoints.begin()+index,pair);
+      }
+      if(!_created)
+         return;
+      
+      // Only touch the intervals next to the control point.
+      uint32 first;
+      uint32 last;
+      if(found)
+      {
+         first = (index > 0) ? index-1 : 0;
+         last = (index < _intervals.size()) ? index : index-1;
+         if(index > 0)
+            _intervals[index-1].end.y = y;
+         if(index < _intervals.size())
+            _intervals[index].start.y = y;
+      }
+      else
+      {
+         INTERVAL_T interval;
+         if(index == 0)
+         {  // New first point.
+            const CONTROL_PAIR_T& next = _controlPoints[1];
+            interval.Init(0,0,0,0, x, y, next.x, next.y);
+            _intervals.insert(_intervals.begin(),interval);
+            first = last = 0;
+         }
+         else if(index == _controlPoints.size()-1)
+         {  // New last point.
+            const CONTROL_PAIR_T& prev = _controlPoints[index-1];
+            interval.Init(0,0,0,0, prev.x, prev.y, x, y);
+            _intervals.push_back(interval);
+            first = last = _intervals.size()-1;
+         }
+         else
+         {  // Split the interval it falls in.
+            const CONTROL_PAIR_T& next = _controlPoints[index+1];
+            _intervals[index-1].end = _controlPoints[index];
+            interval.Init(0,0,0,0, x, y, next.x, next.y);
+            _intervals.insert(_intervals.begin()+index,interval);
+            first = index-1;
+            last = index;
+         }
+         // The intervals have moved; this is a quick pass
+         // over integers.
+         CreateGrid();
+      }
+      UpdateInterpolation(first,last);
+   }
+   
+   bool Interpolate(Number x, Number& result) const
+   {
+      uint32 index;
+      if(FindInterval(x,index))
+      {
+         result = _intervals[index].Evaluate(x);
+         return true;
+      }
+      return false;
    }
    
-   bool Interpolate(Number x, Number& result)
+   /* Interpolates count values of x into results.  The values
+    * do not have to be sorted, but it is faster when values
+    * next to each other are in the same (or next) interval.
+    *
+    * Results for values out of range are not changed.  If
+    * inRange is not NULL, it is set to 1 for the values in
+    * range and 0 otherwise.  Returns the number in range.
+    */
+   uint32 InterpolateBatch(const Number* x, Number* results, uint32 count, uint8* inRange = NULL) const
    {
-      for(int idx = 0; idx < _intervals.size(); idx++)
+      Number blockX[BATCH_BLOCK_SIZE];
+      Number blockA[BATCH_BLOCK_SIZE];
+      Number blockB[BATCH_BLOCK_SIZE];
+      Number blockC[BATCH_BLOCK_SIZE];
+      Number blockD[BATCH_BLOCK_SIZE];
+      uint32 blockIndex[BATCH_BLOCK_SIZE];
+      uint32 hint = 0;
+      uint32 total = 0;
+      
+      for(uint32 base = 0; base < count; base += BATCH_BLOCK_SIZE)
       {
-         if(_intervals[idx].IsInInterval(x))
+         uint32 blockCount = Min(count-base,(uint32)BATCH_BLOCK_SIZE);
+         // Look up the intervals and gather their coefficients.
+         uint32 found = 0;
+         for(uint32 idx = 0; idx < blockCount; idx++)
          {
-            result = _intervals[idx].Evaluate(x);
-            return true;
+            Number value = x[base+idx];
+            uint32 interval;
+            bool ok = FindInterval(value,interval,hint);
+            if(inRange != NULL)
+               inRange[base+idx] = ok;
+            if(!ok)
+               continue;
+            // The next value is most likely in this or the next one.
+            hint = interval;
+            const INTERVAL_T& iv = _intervals[interval];
+            blockX[found] = value;
+            blockA[found] = iv.A;
+            blockB[found] = iv.B;
+            blockC[found] = iv.C;
+            blockD[found] = iv.D;
+            blockIndex[found] = base+idx;
+            found++;
          }
+         // Straight line code over arrays; the compiler turns this
+         // into SIMD.
+         for(uint32 idx = 0; idx < found; idx++)
+         {
+            Number value = blockX[idx];
+            blockX[idx] = ((blockA[idx]*value + blockB[idx])*value + blockC[idx])*value + blockD[idx];
+         }
+         for(uint32 idx = 0; idx < found; idx++)
+         {
+            results[blockIndex[idx]] = blockX[idx];
+         }
+         total += found;
       }
-      return false;
+      return total;
    }
    
    bool Create()
@@ -230,21 +473,18 @@ public:
             break;
          case 2:
          {
-            vector<CONTROL_PAIR_T> pairs;
-            for(CONTROL_MAP_ITER_T iter = _controlPoints.begin(); iter != _controlPoints.end(); iter++)
-            {
-               CONTROL_PAIR_T pair;
-               pair.x = iter->first;
-               pair.y = iter->second;
-               pairs.push_back(pair);
-            }
-            _controlPoints[(pairs[0].x+pairs[1].x)/2] = (pairs[0].y+pairs[1].y)/2;
+            CONTROL_PAIR_T middle;
+            middle.x = (_controlPoints[0].x+_controlPoints[1].x)/2;
+            middle.y = (_controlPoints[0].y+_controlPoints[1].y)/2;
+            _controlPoints.insert(_controlPoints.begin()+1,middle);
             CreateIntervals();
-            return CreateInterpolation();
+            _created = CreateInterpolation();
+            return _created;
          }
          default:
             CreateIntervals();
-            return CreateInterpolation();
+            _created = CreateInterpolation();
+            return _created;
             break;
       }
    }
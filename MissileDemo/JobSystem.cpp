@@ -0,0 +1,264 @@
+/********************************************************************
+ * File   : JobSystem.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/10/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <unistd.h>
+
+JobSystem::JobSystem() :
+   _threadCount(1),
+   _queues(NULL),
+   _generation(0),
+   _busyWorkers(0),
+   _quit(false),
+   _func(NULL),
+   _context(NULL),
+   _count(0),
+   _grainSize(1)
+{
+   pthread_mutex_init(&_lock,NULL);
+   pthread_cond_init(&_startCond,NULL);
+   pthread_cond_init(&_doneCond,NULL);
+}
+
+JobSystem::~JobSystem()
+{
+   Shutdown();
+   pthread_cond_destroy(&_doneCond);
+   pthread_cond_destroy(&_startCond);
+   pthread_mutex_destroy(&_lock);
+}
+
+uint32 JobSystem::GetHardwareThreadCount()
+{
+   long count = sysconf(_SC_NPROCESSORS_ONLN);
+   return count < 1 ? 1 : (uint32)count;
+}
+
+void JobSystem::Init(uint32 threadCount)
+{
+   Shutdown();
+   if(threadCount == 0)
+   {
+      threadCount = GetHardwareThreadCount();
+   }
+   _threadCount = threadCount;
+   _quit = false;
+   // The old workers are gone; the new ones start counting at 0.
+   _generation = 0;
+   _busyWorkers = 0;
+   
+   _queues = new WORK_QUEUE_T[_threadCount];
+   for(uint32 idx = 0; idx < _threadCount; idx++)
+   {
+      pthread_mutex_init(&_queues[idx].lock,NULL);
+      _queues[idx].head = 0;
+      _queues[idx].tail = 0;
+   }
+   
+   // Worker 0 is the thread that calls ParallelFor(...).
+   _workers.resize(_threadCount);
+   _threads.resize(_threadCount);
+   for(uint32 idx = 1; idx < _threadCount; idx++)
+   {
+      _workers[idx].jobSystem = this;
+      _workers[idx].worker = idx;
+      pthread_create(&_threads[idx],NULL,WorkerMain,&_workers[idx]);
+   }
+}
+
+void JobSystem::Shutdown()
+{
+   if(_queues == NULL)
+   {
+      return;
+   }
+   pthread_mutex_lock(&_lock);
+   _quit = true;
+   pthread_cond_broadcast(&_startCond);
+   pthread_mutex_unlock(&_lock);
+   for(uint32 idx = 1; idx < _threadCount; idx++)
+   {
+      pthread_join(_threads[idx],NULL);
+   }
+   for(uint32 idx = 0; idx < _threadCount; idx++)
+   {
+      pthread_mutex_destroy(&_queues[idx].lock);
+   }
+   delete [] _queues;
+   _queues = NULL;
+   _threads.clear();
+   _workers.clear();
+   _threadCount = 1;
+}
+
+void* JobSystem::WorkerMain(void* arg)
+{
+   WORKER_T* worker = (WORKER_T*)arg;
+   worker->jobSystem->WorkerLoop(worker->worker);
+   return NULL;
+}
+
+void JobSystem::WorkerLoop(uint32 worker)
+{
+   Profiler::Instance().SetThreadName("JobSystem Worker");
+   // Init(...) starts _generation at 0 too, so a ParallelFor(...)
+   // made before this thread gets the lock is not missed.
+   uint32 generation = 0;
+   pthread_mutex_lock(&_lock);
+   for(;;)
+   {
+      while(_generation == generation && !_quit)
+      {
+         pthread_cond_wait(&_startCond,&_lock);
+      }
+      if(_quit)
+      {
+         break;
+      }
+      generation = _generation;
+      pthread_mutex_unlock(&_lock);
+      
+      RunChunks(worker);
+      
+      pthread_mutex_lock(&_lock);
+      _busyWorkers--;
+      if(_busyWorkers == 0)
+      {
+         pthread_cond_signal(&_doneCond);
+      }
+   }
+   pthread_mutex_unlock(&_lock);
+}
+
+bool JobSystem::PopChunk(uint32 worker, uint32& chunk)
+{
+   WORK_QUEUE_T& queue = _queues[worker];
+   bool result = false;
+   pthread_mutex_lock(&queue.lock);
+   if(queue.head < queue.tail)
+   {
+      chunk = queue.head++;
+      result = true;
+   }
+   pthread_mutex_unlock(&queue.lock);
+   return result;
+}
+
+bool JobSystem::StealChunk(uint32 worker, uint32& chunk)
+{
+   for(uint32 offset = 1; offset < _threadCount; offset++)
+   {
+      WORK_QUEUE_T& victim = _queues[(worker + offset) % _threadCount];
+      uint32 first = 0;
+      uint32 last = 0;
+      pthread_mutex_lock(&victim.lock);
+      if(victim.head < victim.tail)
+      {  // Take the back half.
+         last = victim.tail;
+         first = last - (last - victim.head + 1)/2;
+         victim.tail = first;
+      }
+      pthread_mutex_unlock(&victim.lock);
+      if(first < last)
+      {  // Run the first one now, queue up the rest.
+         WORK_QUEUE_T& queue = _queues[worker];
+         pthread_mutex_lock(&queue.lock);
+         queue.head = first + 1;
+         queue.tail = last;
+         pthread_mutex_unlock(&queue.lock);
+         chunk = first;
+         return true;
+      }
+   }
+   return false;
+}
+
+void JobSystem::RunChunk(uint32 chunk, uint32 worker)
+{
+   uint32 begin = chunk*_grainSize;
+   uint32 end = Min(begin + _grainSize,_count);
+   _func(_context,begin,end,worker);
+}
+
+void JobSystem::RunChunks(uint32 worker)
+{
+   PROFILE_ZONE("JobSystem::RunChunks");
+   uint32 chunk;
+   while(PopChunk(worker,chunk) || StealChunk(worker,chunk))
+   {
+      RunChunk(chunk,worker);
+   }
+}
+
+void JobSystem::ParallelFor(uint32 count, uint32 grainSize, JOB_FUNC_T func, void* context)
+{
+   assert(grainSize > 0);
+   assert(func != NULL);
+   if(count == 0)
+   {
+      return;
+   }
+   uint32 chunks = (count + grainSize - 1)/grainSize;
+   
+   _func = func;
+   _context = context;
+   _count = count;
+   _grainSize = grainSize;
+   
+   if(_threadCount == 1 || chunks == 1)
+   {
+      for(uint32 chunk = 0; chunk < chunks; chunk++)
+      {
+         RunChunk(chunk,0);
+      }
+      return;
+   }
+   
+   // The workers are all waiting, so the queues can
+   // be filled without locking them.
+   for(uint32 idx = 0; idx < _threadCount; idx++)
+   {
+      _queues[idx].head = (uint32)(((uint64)chunks*idx)/_threadCount);
+      _queues[idx].tail = (uint32)(((uint64)chunks*(idx+1))/_threadCount);
+   }
+   
+   pthread_mutex_lock(&_lock);
+   _busyWorkers = _threadCount-1;
+   _generation++;
+   pthread_cond_broadcast(&_startCond);
+   pthread_mutex_unlock(&_lock);
+   
+   RunChunks(0);
+   
+   pthread_mutex_lock(&_lock);
+   while(_busyWorkers > 0)
+   {
+      pthread_cond_wait(&_doneCond,&_lock);
+   }
+   pthread_mutex_unlock(&_lock);
+}
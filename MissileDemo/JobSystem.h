@@ -0,0 +1,121 @@
+/********************************************************************
+ * File   : JobSystem.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/10/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__JobSystem__
+#define __MissileDemo__JobSystem__
+
+#include "CommonSTL.h"
+#include <pthread.h>
+
+/* This class runs a loop over a range of items on a
+ * set of worker threads.
+ *
+ * ParallelFor(...) cuts the range into chunks of
+ * grainSize items and deals the chunks out evenly to
+ * the workers.  Each worker works through its own
+ * chunks front to back.  When a worker runs out, it
+ * steals half of the remaining chunks from the back of
+ * another worker's queue, so the load evens out even
+ * when some items cost more than others.
+ *
+ * The calling thread is worker 0 and works along with
+ * the others.  ParallelFor(...) returns when every
+ * chunk is done.
+ *
+ * The job function is called once per chunk with the
+ * items [begin,end) and the index of the worker running
+ * it, so it can use per-worker scratch space without
+ * locking.  Which worker gets which chunk is NOT
+ * repeatable; anything that has to come out the same
+ * every time must be put back in order by the caller
+ * (see BodyForceBuffer).
+ *
+ * With one thread (or a single chunk), the job runs
+ * on the calling thread and nothing is shared.
+ */
+class JobSystem
+{
+public:
+   typedef void (*JOB_FUNC_T)(void* context, uint32 begin, uint32 end, uint32 worker);
+   
+private:
+   typedef struct
+   {
+      pthread_mutex_t lock;
+      // Chunks [head,tail) belong to this worker.
+      uint32 head;
+      uint32 tail;
+   } WORK_QUEUE_T;
+   
+   typedef struct
+   {
+      JobSystem* jobSystem;
+      uint32 worker;
+   } WORKER_T;
+   
+   uint32 _threadCount;
+   vector<pthread_t> _threads;
+   vector<WORKER_T> _workers;
+   WORK_QUEUE_T* _queues;
+   
+   // Protects the rest of these.
+   pthread_mutex_t _lock;
+   pthread_cond_t _startCond;
+   pthread_cond_t _doneCond;
+   uint32 _generation;
+   uint32 _busyWorkers;
+   bool _quit;
+   
+   // The current job.
+   JOB_FUNC_T _func;
+   void* _context;
+   uint32 _count;
+   uint32 _grainSize;
+   
+   static void* WorkerMain(void* arg);
+   void WorkerLoop(uint32 worker);
+   bool PopChunk(uint32 worker, uint32& chunk);
+   bool StealChunk(uint32 worker, uint32& chunk);
+   void RunChunk(uint32 chunk, uint32 worker);
+   void RunChunks(uint32 worker);
+   
+public:
+   JobSystem();
+   ~JobSystem();
+   
+   // threadCount includes the calling thread.  Zero
+   // means one per hardware thread.
+   void Init(uint32 threadCount = 0);
+   void Shutdown();
+   
+   inline uint32 GetThreadCount() const { return _threadCount; }
+   static uint32 GetHardwareThreadCount();
+   
+   void ParallelFor(uint32 count, uint32 grainSize, JOB_FUNC_T func, void* context);
+};
+
+#endif /* defined(__MissileDemo__JobSystem__) */
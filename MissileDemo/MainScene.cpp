@@ -31,44 +31,54 @@
 #include "DebugMenuLayer.h"
 #include "TapDragPinchInput.h"
 #include "Notifier.h"
+#include "Profiler.h"
 #include "Viewport.h"
 #include "Missile.h"
 #include "MovingEntity.h"
 #include "DebugMessageLayer.h"
 #include "SunBackgroundLayer.h"
+#include "Simulation.h"
 
 
 MainScene::MainScene() :
+_simulation(NULL),
 _entity(NULL),
 _dragBehavior(DB_TRACK),
-_meType(MT_MISSILE)
+_meType(MT_MISSILE),
+_followPath(NULL)
 {
 }
 
 MainScene::~MainScene()
 {
-   delete _entity;
+   // The pathfinder looks at the world, so it goes first.
+   _pathfinder.Shutdown();
+   // This deletes the entity as well.
+   delete _simulation;
+   if(_followPath != NULL)
+   {
+      _followPath->Release();
+   }
 }
 
 void MainScene::CreateEntity()
 {
    Vec2 position(0,0);
-   if(_entity != NULL)
-   {
-      delete _entity;
-   }
+   _simulation->DestroyEntities();
+   _entity = NULL;
    switch(_meType)
    {
       case MT_MISSILE:
-         _entity = new Missile(*_world,position);
+         _entity = new Missile(*_simulation->GetWorld(),position);
          break;
       case MT_MOVING_ENTITY:
-         _entity = new MovingEntity(*_world,position);
+         _entity = new MovingEntity(*_simulation->GetWorld(),position);
          break;
       case MT_MAX:
          assert(false);
          break;
    }
+   _simulation->AddEntity(_entity);
 }
 
 void MainScene::CreatePhysics()
@@ -79,12 +89,15 @@ void MainScene::CreatePhysics()
    // Initialize the Viewport
    Viewport::Instance().Init(worldSizeMeters);
    
-   _world = new b2World(Vec2(0.0,0.0));
-   // Do we want to let bodies sleep?
-   // No for now...makes the debug layer blink
-   // which is annoying.
-   _world->SetAllowSleeping(false);
-   _world->SetContinuousPhysics(true);
+   _simulation = new Simulation();
+   _simulation->Init();
+   
+   // Paths are planned on 1 m cells and kept about half
+   // the entity's length away from the obstacles.
+   static const float32 planCellMeters = 1.0;
+   static const float32 planClearanceMeters = 3.0;
+   CCSize worldSize = Viewport::Instance().GetWorldSizeMeters();
+   _pathfinder.Init(_simulation->GetWorld(),worldSize.width,worldSize.height,planCellMeters,planClearanceMeters);
 }
 
 bool MainScene::init()
@@ -106,7 +119,9 @@ bool MainScene::init()
    addChild(_tapDragPinchInput);
    
    // Box2d Debug
-   addChild(Box2DDebugDrawLayer::create(_world));
+   Box2DDebugDrawLayer* debugDrawLayer = Box2DDebugDrawLayer::create(_simulation->GetWorld());
+   debugDrawLayer->SetSimulation(_simulation);
+   addChild(debugDrawLayer);
    
    // Grid
    addChild(GridLayer::create());
@@ -186,25 +201,16 @@ void MainScene::Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* ev
    }
 }
 
-void MainScene::UpdateMissile()
-{
-   _entity->Update();
-}
-
-void MainScene::UpdatePhysics()
-{
-   const int velocityIterations = 8;
-   const int positionIterations = 1;
-   float32 fixedDT = SECONDS_PER_TICK;
-   // Instruct the world to perform a single step of simulation. It is
-   // generally best to keep the time step and iterations fixed.
-   _world->Step(fixedDT, velocityIterations, positionIterations);
-}
-
 void MainScene::update(float dt)
 {
-   UpdateMissile();
-   UpdatePhysics();
+   // Frame to frame, this covers the update and the draw.
+   Profiler::Instance().NextFrame();
+   PROFILE_ZONE("MainScene::update");
+   // Run as many fixed ticks as fit in the frame time.  The
+   // debug draw layer blends the bodies between the last two.
+   _simulation->Advance(dt);
+   // Send anything posted (from any thread) this frame.
+   Notifier::Instance().DispatchPosted();
 }
 
 void MainScene::PinchViewport(const CCPoint& p0Org,const CCPoint& p1Org,
@@ -231,7 +237,27 @@ void MainScene::PinchViewport(const CCPoint& p0Org,const CCPoint& p1Org,
 // Handler for Tap/Drag/Pinch Events
 void MainScene::TapDragPinchInputTap(const TOUCH_DATA_T& point)
 {
-   
+   if(_dragBehavior != DB_PLAN)
+   {
+      return;
+   }
+   Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+   // The obstacles may have moved since the last plan.
+   _pathfinder.UpdateObstacles();
+   const Path* path = _pathfinder.FindPath(_entity->GetPosition(),Viewport::Instance().Convert(point.pos));
+   if(path == NULL)
+   {  // No way there.
+      _entity->CommandIdle();
+      return;
+   }
+   // The pathfinder only holds it until the next plan.
+   path->Retain();
+   if(_followPath != NULL)
+   {
+      _followPath->Release();
+   }
+   _followPath = path;
+   _entity->CommandFollowPath(_followPath);
 }
 void MainScene::TapDragPinchInputLongTap(const TOUCH_DATA_T& point)
 {
@@ -274,9 +300,13 @@ void MainScene::TapDragPinchInputDragBegin(const TOUCH_DATA_T& point0, const TOU
       {
          LINE_PIXELS_DATA ld;
          Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
-         _path.clear();
-         _path.push_back(Viewport::Instance().Convert(point0.pos));
-         _path.push_back(Viewport::Instance().Convert(point1.pos));
+         // The entity cannot tell apart points closer than
+         // its seek distance, so there is no need to keep them.
+         static const float32 toleranceScale = 0.1;
+         _pathSimplifier.Reset();
+         _pathSimplifier.SetTolerance(toleranceScale*_entity->GetMinSeekDistance());
+         _pathSimplifier.AddPoint(Viewport::Instance().Convert(point0.pos));
+         _pathSimplifier.AddPoint(Viewport::Instance().Convert(point1.pos));
          _entity->CommandIdle();
          
          ld.start = point0.pos;
@@ -286,6 +316,8 @@ void MainScene::TapDragPinchInputDragBegin(const TOUCH_DATA_T& point0, const TOU
          
       }
          break;
+      case DB_PLAN:
+         break;
    }
 }
 void MainScene::TapDragPinchInputDragContinue(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
@@ -306,13 +338,15 @@ void MainScene::TapDragPinchInputDragContinue(const TOUCH_DATA_T& point0, const
       {
          
          LINE_PIXELS_DATA ld;
-         _path.push_back(Viewport::Instance().Convert(point1.pos));
+         _pathSimplifier.AddPoint(Viewport::Instance().Convert(point1.pos));
          ld.start = _lastPoint;
          ld.end = point1.pos;
          _lastPoint = point1.pos;
          Notifier::Instance().Notify(Notifier::NE_DEBUG_LINE_DRAW_ADD_LINE_PIXELS,&ld);
       }
          break;
+      case DB_PLAN:
+         break;
    }
 }
 void MainScene::TapDragPinchInputDragEnd(const TOUCH_DATA_T& point0, const TOUCH_DATA_T& point1)
@@ -328,7 +362,15 @@ void MainScene::TapDragPinchInputDragEnd(const TOUCH_DATA_T& point0, const TOUCH
          _entity->CommandIdle();
          break;
       case DB_PATH:
-         _entity->CommandFollowPath(_path);
+         // The entity keeps its own reference.
+         if(_followPath != NULL)
+         {
+            _followPath->Release();
+         }
+         _followPath = _pathSimplifier.CreatePath();
+         _entity->CommandFollowPath(_followPath);
+         break;
+      case DB_PLAN:
          break;
    }
 }
@@ -343,6 +385,7 @@ void MainScene::CreateMenu()
    labels.push_back("Cmd: Track");
    labels.push_back("Cmd: Seek");
    labels.push_back("Cmd: Path");
+   labels.push_back("Cmd: Plan");
    labels.push_back("Next Type");
    
    
@@ -401,6 +444,10 @@ void MainScene::HandleMenuChoice(uint32 choice)
          _dragBehavior = DB_PATH;
          break;
       case 7:
+         Notifier::Instance().Notify(Notifier::NE_RESET_DRAW_CYCLE);
+         _dragBehavior = DB_PLAN;
+         break;
+      case 8:
          _meType++;
          if(_meType == MT_MAX)
             _meType = MT_MIN;
@@ -410,7 +457,11 @@ void MainScene::HandleMenuChoice(uint32 choice)
          switch(_dragBehavior)
       {
          case DB_PATH:
-            _entity->CommandFollowPath(_path);
+         case DB_PLAN:
+            if(_followPath != NULL)
+            {
+               _entity->CommandFollowPath(_followPath);
+            }
             break;
          case DB_SEEK:
             break;
@@ -33,8 +33,11 @@
 #include "DebugLinesLayer.h"
 #include "TapDragPinchInput.h"
 #include "Notifier.h"
+#include "PathSimplifier.h"
+#include "GridPathfinder.h"
 
 class MovingEntityIFace;
+class Simulation;
 
 class MainScene : public CCScene, public Notified, public TapDragPinchInputTarget
 {
@@ -49,12 +52,14 @@ private:
       DB_TRACK,
       DB_SEEK,
       DB_PATH,
+      // Tap where to go; the path is planned.
+      DB_PLAN,
    } DRAG_BEHAVIOR;
    
    DRAG_BEHAVIOR _dragBehavior;
 
-   // Box2d Physics World
-   b2World* _world;
+   // Box2d Physics World and the entities in it.
+   Simulation* _simulation;
    
    typedef enum
    {
@@ -67,7 +72,8 @@ private:
    MOVING_ENTITY_TYPE_T _meType;
    
    
-   // The moving entity
+   // The moving entity.  This is owned by the
+   // simulation; do not delete it here.
    MovingEntityIFace* _entity;
    //Missile* _entity;
    
@@ -75,7 +81,12 @@ private:
    Vec2 _viewportCenterOrg;
    float32 _viewportScaleOrg;
    TapDragPinchInput* _tapDragPinchInput;
-   list<Vec2> _path;
+   // The path being drawn, and the last path given to
+   // the entity.
+   PathSimplifier _pathSimplifier;
+   const Path* _followPath;
+   // Plans the paths for DB_PLAN.
+   GridPathfinder _pathfinder;
    CCPoint _lastPoint;
    
 protected:
@@ -90,8 +101,6 @@ private:
    void HandleMenuChoice(uint32 choice);
    void ToggleDebug();
    void SetZoom(float zoom);
-   void UpdateMissile();
-   void UpdatePhysics();
    void PinchViewport(const CCPoint& p0Org,const CCPoint& p1Org,
                       const CCPoint& p0,const CCPoint& p1);
 public:
@@ -0,0 +1,211 @@
+/********************************************************************
+ * File   : MathSIMD.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/21/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__MathSIMD__
+#define __MissileDemo__MathSIMD__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* The SIMD versions of MathUtilities::Atan2Fast(...),
+ * Atan2Fastest(...), WrapAngle(...) and SinCosFast(...).
+ * They use the same coefficients and do the operations in
+ * the same order, so the SIMD and scalar results are the
+ * same.
+ *
+ * This is only for the .cpp files that run the batched
+ * kernels (MathUtilities, SteeringBatch).  Only one of the
+ * AVX or SSE2 sets is compiled in.
+ */
+#if defined(__AVX__)
+#define MATH_SIMD_WIDTH 8
+
+static inline __m256 Atan2AVX(__m256 y, __m256 x, bool fastest)
+{
+   const __m256 signMask = _mm256_set1_ps(-0.0f);
+   const __m256 one = _mm256_set1_ps(1.0f);
+   __m256 ax = _mm256_andnot_ps(signMask,x);
+   __m256 ay = _mm256_andnot_ps(signMask,y);
+   __m256 z = _mm256_div_ps(_mm256_min_ps(ax,ay),
+                            _mm256_max_ps(_mm256_max_ps(ax,ay),_mm256_set1_ps(numeric_limits<float32>::min())));
+   __m256 angle;
+   if(fastest)
+   {
+      angle = _mm256_add_ps(_mm256_set1_ps(0.2447f),_mm256_mul_ps(_mm256_set1_ps(0.0663f),z));
+      angle = _mm256_add_ps(_mm256_set1_ps(0.7853982f),_mm256_mul_ps(_mm256_sub_ps(one,z),angle));
+      angle = _mm256_mul_ps(z,angle);
+   }
+   else
+   {
+      __m256 z2 = _mm256_mul_ps(z,z);
+      angle = _mm256_add_ps(_mm256_set1_ps(-0.0851330f),_mm256_mul_ps(z2,_mm256_set1_ps(0.0208351f)));
+      angle = _mm256_add_ps(_mm256_set1_ps(0.1801410f),_mm256_mul_ps(z2,angle));
+      angle = _mm256_add_ps(_mm256_set1_ps(-0.3302995f),_mm256_mul_ps(z2,angle));
+      angle = _mm256_add_ps(_mm256_set1_ps(0.9998660f),_mm256_mul_ps(z2,angle));
+      angle = _mm256_mul_ps(z,angle);
+   }
+   // Into the right octant.
+   angle = _mm256_blendv_ps(angle,_mm256_sub_ps(_mm256_set1_ps(1.5707964f),angle),
+                            _mm256_cmp_ps(ay,ax,_CMP_GT_OQ));
+   angle = _mm256_blendv_ps(angle,_mm256_sub_ps(_mm256_set1_ps(3.1415927f),angle),
+                            _mm256_cmp_ps(x,_mm256_setzero_ps(),_CMP_LT_OQ));
+   angle = _mm256_xor_ps(angle,_mm256_and_ps(signMask,_mm256_cmp_ps(y,_mm256_setzero_ps(),_CMP_LT_OQ)));
+   return angle;
+}
+
+static inline __m256 WrapAngleAVX(__m256 angle)
+{
+   const __m256 twoPi = _mm256_set1_ps((float32)(2*M_PI));
+   const __m256 invTwoPi = _mm256_set1_ps((float32)(1.0/(2*M_PI)));
+   __m256 turns = _mm256_round_ps(_mm256_mul_ps(angle,invTwoPi),_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+   return _mm256_sub_ps(angle,_mm256_mul_ps(twoPi,turns));
+}
+
+// AVX (without AVX2) has no 256 bit integer ops, so the
+// quadrant bits are worked out in float.  quadrant is a whole
+// number, so all of this is exact.
+static inline void SinCosAVX(__m256 angle, __m256& sinOut, __m256& cosOut)
+{
+   const __m256 signMask = _mm256_set1_ps(-0.0f);
+   const __m256 half = _mm256_set1_ps(0.5f);
+   __m256 quadrant = _mm256_round_ps(_mm256_mul_ps(angle,_mm256_set1_ps((float32)(2.0/M_PI))),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+   __m256 x = _mm256_sub_ps(angle,_mm256_mul_ps(quadrant,_mm256_set1_ps(1.5703125f)));
+   x = _mm256_sub_ps(x,_mm256_mul_ps(quadrant,_mm256_set1_ps(4.837512969970703125e-4f)));
+   x = _mm256_sub_ps(x,_mm256_mul_ps(quadrant,_mm256_set1_ps(7.549789948768648e-8f)));
+   __m256 x2 = _mm256_mul_ps(x,x);
+   __m256 s = _mm256_add_ps(_mm256_set1_ps(8.3321608736e-3f),_mm256_mul_ps(x2,_mm256_set1_ps(-1.9515295891e-4f)));
+   s = _mm256_add_ps(_mm256_set1_ps(-1.6666654611e-1f),_mm256_mul_ps(x2,s));
+   s = _mm256_add_ps(x,_mm256_mul_ps(_mm256_mul_ps(x,x2),s));
+   __m256 c = _mm256_add_ps(_mm256_set1_ps(-1.388731625493765e-3f),_mm256_mul_ps(x2,_mm256_set1_ps(2.443315711809948e-5f)));
+   c = _mm256_add_ps(_mm256_set1_ps(4.166664568298827e-2f),_mm256_mul_ps(x2,c));
+   c = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f),_mm256_mul_ps(half,x2)),
+                     _mm256_mul_ps(_mm256_mul_ps(x2,x2),c));
+   // quadrant mod 4, then its bits.
+   __m256 q4 = _mm256_sub_ps(quadrant,_mm256_mul_ps(_mm256_set1_ps(4.0f),
+                             _mm256_floor_ps(_mm256_mul_ps(quadrant,_mm256_set1_ps(0.25f)))));
+   __m256 swap = _mm256_cmp_ps(_mm256_sub_ps(q4,_mm256_mul_ps(_mm256_set1_ps(2.0f),
+                               _mm256_floor_ps(_mm256_mul_ps(q4,half)))),
+                               _mm256_set1_ps(1.0f),_CMP_EQ_OQ);
+   __m256 sinNeg = _mm256_cmp_ps(q4,_mm256_set1_ps(2.0f),_CMP_GE_OQ);
+   __m256 cosNeg = _mm256_and_ps(_mm256_cmp_ps(q4,_mm256_set1_ps(1.0f),_CMP_GE_OQ),
+                                 _mm256_cmp_ps(q4,_mm256_set1_ps(2.0f),_CMP_LE_OQ));
+   sinOut = _mm256_xor_ps(_mm256_blendv_ps(s,c,swap),_mm256_and_ps(signMask,sinNeg));
+   cosOut = _mm256_xor_ps(_mm256_blendv_ps(c,s,swap),_mm256_and_ps(signMask,cosNeg));
+}
+#elif defined(__SSE2__)
+#define MATH_SIMD_WIDTH 4
+
+static inline __m128 SelectSSE(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+   return _mm_or_ps(_mm_and_ps(mask,ifTrue),_mm_andnot_ps(mask,ifFalse));
+}
+
+// Rounds to nearest, like rintf(...).  _mm_cvtps_epi32(...)
+// only works up to 2^31, but from 2^23 up every float is a
+// whole number already, so those (and NaN and inf) are passed
+// through as they are.
+static inline __m128 RoundSSE(__m128 value)
+{
+   const __m128 signMask = _mm_set1_ps(-0.0f);
+   __m128 inRange = _mm_cmplt_ps(_mm_andnot_ps(signMask,value),_mm_set1_ps(8388608.0f));
+   return SelectSSE(inRange,_mm_cvtepi32_ps(_mm_cvtps_epi32(value)),value);
+}
+
+static inline __m128 Atan2SSE(__m128 y, __m128 x, bool fastest)
+{
+   const __m128 signMask = _mm_set1_ps(-0.0f);
+   const __m128 one = _mm_set1_ps(1.0f);
+   __m128 ax = _mm_andnot_ps(signMask,x);
+   __m128 ay = _mm_andnot_ps(signMask,y);
+   __m128 z = _mm_div_ps(_mm_min_ps(ax,ay),
+                         _mm_max_ps(_mm_max_ps(ax,ay),_mm_set1_ps(numeric_limits<float32>::min())));
+   __m128 angle;
+   if(fastest)
+   {
+      angle = _mm_add_ps(_mm_set1_ps(0.2447f),_mm_mul_ps(_mm_set1_ps(0.0663f),z));
+      angle = _mm_add_ps(_mm_set1_ps(0.7853982f),_mm_mul_ps(_mm_sub_ps(one,z),angle));
+      angle = _mm_mul_ps(z,angle);
+   }
+   else
+   {
+      __m128 z2 = _mm_mul_ps(z,z);
+      angle = _mm_add_ps(_mm_set1_ps(-0.0851330f),_mm_mul_ps(z2,_mm_set1_ps(0.0208351f)));
+      angle = _mm_add_ps(_mm_set1_ps(0.1801410f),_mm_mul_ps(z2,angle));
+      angle = _mm_add_ps(_mm_set1_ps(-0.3302995f),_mm_mul_ps(z2,angle));
+      angle = _mm_add_ps(_mm_set1_ps(0.9998660f),_mm_mul_ps(z2,angle));
+      angle = _mm_mul_ps(z,angle);
+   }
+   // Into the right octant.
+   angle = SelectSSE(_mm_cmpgt_ps(ay,ax),_mm_sub_ps(_mm_set1_ps(1.5707964f),angle),angle);
+   angle = SelectSSE(_mm_cmplt_ps(x,_mm_setzero_ps()),_mm_sub_ps(_mm_set1_ps(3.1415927f),angle),angle);
+   angle = _mm_xor_ps(angle,_mm_and_ps(signMask,_mm_cmplt_ps(y,_mm_setzero_ps())));
+   return angle;
+}
+
+static inline __m128 WrapAngleSSE(__m128 angle)
+{
+   const __m128 twoPi = _mm_set1_ps((float32)(2*M_PI));
+   const __m128 invTwoPi = _mm_set1_ps((float32)(1.0/(2*M_PI)));
+   __m128 turns = RoundSSE(_mm_mul_ps(angle,invTwoPi));
+   return _mm_sub_ps(angle,_mm_mul_ps(twoPi,turns));
+}
+
+static inline void SinCosSSE(__m128 angle, __m128& sinOut, __m128& cosOut)
+{
+   const __m128 half = _mm_set1_ps(0.5f);
+   __m128 quadrant = RoundSSE(_mm_mul_ps(angle,_mm_set1_ps((float32)(2.0/M_PI))));
+   // Truncates, like the (int32) cast in SinCosFast(...).
+   __m128i iquadrant = _mm_cvttps_epi32(quadrant);
+   __m128 x = _mm_sub_ps(angle,_mm_mul_ps(quadrant,_mm_set1_ps(1.5703125f)));
+   x = _mm_sub_ps(x,_mm_mul_ps(quadrant,_mm_set1_ps(4.837512969970703125e-4f)));
+   x = _mm_sub_ps(x,_mm_mul_ps(quadrant,_mm_set1_ps(7.549789948768648e-8f)));
+   __m128 x2 = _mm_mul_ps(x,x);
+   __m128 s = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f),_mm_mul_ps(x2,_mm_set1_ps(-1.9515295891e-4f)));
+   s = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f),_mm_mul_ps(x2,s));
+   s = _mm_add_ps(x,_mm_mul_ps(_mm_mul_ps(x,x2),s));
+   __m128 c = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f),_mm_mul_ps(x2,_mm_set1_ps(2.443315711809948e-5f)));
+   c = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f),_mm_mul_ps(x2,c));
+   c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f),_mm_mul_ps(half,x2)),_mm_mul_ps(_mm_mul_ps(x2,x2),c));
+   // Bit 0 swaps sin/cos, bit 1 flips the sign of sin and
+   // bit 1 of (quadrant+1) flips the sign of cos.
+   const __m128i one = _mm_set1_epi32(1);
+   const __m128i two = _mm_set1_epi32(2);
+   __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(iquadrant,one),one));
+   __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(iquadrant,two),30));
+   __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(iquadrant,one),two),30));
+   sinOut = _mm_xor_ps(SelectSSE(swap,c,s),sinSign);
+   cosOut = _mm_xor_ps(SelectSSE(swap,s,c),cosSign);
+}
+#endif
+
+#endif /* defined(__MissileDemo__MathSIMD__) */
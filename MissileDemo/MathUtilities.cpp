@@ -25,3 +25,97 @@
  */
 
 #include "MathUtilities.h"
+#include "MathSIMD.h"
+
+/* Each of these runs the SIMD kernel over as much of the
+ * array as it can and finishes the rest with the scalar
+ * version.  Loads/stores are unaligned so any float32 array
+ * can be passed in.
+ */
+void MathUtilities::WrapAngle(const float32* angles, float32* results, uint32 count)
+{
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      _mm256_storeu_ps(results+idx,WrapAngleAVX(_mm256_loadu_ps(angles+idx)));
+   }
+#elif defined(__SSE2__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      _mm_storeu_ps(results+idx,WrapAngleSSE(_mm_loadu_ps(angles+idx)));
+   }
+#endif
+   for(; idx < count; ++idx)
+   {
+      results[idx] = WrapAngle(angles[idx]);
+   }
+}
+
+void MathUtilities::Atan2Fast(const float32* y, const float32* x, float32* results, uint32 count)
+{
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      _mm256_storeu_ps(results+idx,Atan2AVX(_mm256_loadu_ps(y+idx),_mm256_loadu_ps(x+idx),false));
+   }
+#elif defined(__SSE2__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      _mm_storeu_ps(results+idx,Atan2SSE(_mm_loadu_ps(y+idx),_mm_loadu_ps(x+idx),false));
+   }
+#endif
+   for(; idx < count; ++idx)
+   {
+      results[idx] = Atan2Fast(y[idx],x[idx]);
+   }
+}
+
+void MathUtilities::Atan2Fastest(const float32* y, const float32* x, float32* results, uint32 count)
+{
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      _mm256_storeu_ps(results+idx,Atan2AVX(_mm256_loadu_ps(y+idx),_mm256_loadu_ps(x+idx),true));
+   }
+#elif defined(__SSE2__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      _mm_storeu_ps(results+idx,Atan2SSE(_mm_loadu_ps(y+idx),_mm_loadu_ps(x+idx),true));
+   }
+#endif
+   for(; idx < count; ++idx)
+   {
+      results[idx] = Atan2Fastest(y[idx],x[idx]);
+   }
+}
+
+void MathUtilities::SinCosFast(const float32* angles, float32* sins, float32* coss, uint32 count)
+{
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      __m256 s;
+      __m256 c;
+      SinCosAVX(_mm256_loadu_ps(angles+idx),s,c);
+      _mm256_storeu_ps(sins+idx,s);
+      _mm256_storeu_ps(coss+idx,c);
+   }
+#elif defined(__SSE2__)
+   for(; idx + MATH_SIMD_WIDTH <= count; idx += MATH_SIMD_WIDTH)
+   {
+      __m128 s;
+      __m128 c;
+      SinCosSSE(_mm_loadu_ps(angles+idx),s,c);
+      _mm_storeu_ps(sins+idx,s);
+      _mm_storeu_ps(coss+idx,c);
+   }
+#endif
+   for(; idx < count; ++idx)
+   {
+      SinCosFast(angles[idx],sins[idx],coss[idx]);
+   }
+}
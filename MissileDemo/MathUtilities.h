@@ -29,7 +29,7 @@
 #define __Box2DTestBed__MathUtilities__
 
 #include "CommonSTL.h"
-#include "CommonProject.h"
+#include "CommonPhysics.h"
 
 class MathUtilities
 {
@@ -97,8 +97,17 @@ public:
    // Takes an angle greater than +/- M_PI and converts it back
    // to +/- M_PI.  Useful in Box2D where angles continuously
    // increase/decrease.
+   //
+   // Angles that have wound up more than a turn are brought
+   // back with WrapAngle(...) first, so the loops below never
+   // run more than twice.  Anything within +/- 3*PI takes the
+   // loops only and gives the same result it always has.
    static inline float32 AdjustAngle(float32 angleRads)
    {
+      if(angleRads > 3*M_PI || angleRads < -3*M_PI)
+      {
+         angleRads = WrapAngle(angleRads);
+      }
       if(angleRads > M_PI)
       {
          while(angleRads > M_PI)
@@ -115,7 +124,97 @@ public:
       }
       return angleRads;
    }
-   
+
+   // Same as AdjustAngle(...), but without the loops or
+   // branches.  The result may be off by a float32 ulp or
+   // so from AdjustAngle(...), and by about 2e-7 rads for
+   // each turn wrapped off (2*PI is rounded to float32).
+   static inline float32 WrapAngle(float32 angleRads)
+   {
+      const float32 twoPi = 2*M_PI;
+      const float32 invTwoPi = 1.0/(2*M_PI);
+      return angleRads - twoPi*rintf(angleRads*invTwoPi);
+   }
+
+   // Polynomial approximations of atan2f(...).
+   //
+   // Atan2Fast(...) is good to about 1e-5 rads
+   // (Abramowitz & Stegun 4.4.47).
+   // Atan2Fastest(...) is good to about 2e-3 rads.
+   //
+   // Both return 0 for (0,0), just like atan2f(...).
+   static inline float32 Atan2Fast(float32 y, float32 x)
+   {
+      float32 ax = fabsf(x);
+      float32 ay = fabsf(y);
+      float32 z = Min(ax,ay)/Max(Max(ax,ay),numeric_limits<float32>::min());
+      float32 z2 = z*z;
+      float32 angle = z*(0.9998660f + z2*(-0.3302995f + z2*(0.1801410f + z2*(-0.0851330f + z2*0.0208351f))));
+      return Atan2Quadrant(angle,y,x,ax,ay);
+   }
+
+   static inline float32 Atan2Fastest(float32 y, float32 x)
+   {
+      float32 ax = fabsf(x);
+      float32 ay = fabsf(y);
+      float32 z = Min(ax,ay)/Max(Max(ax,ay),numeric_limits<float32>::min());
+      float32 angle = z*(0.7853982f + (1.0f-z)*(0.2447f + 0.0663f*z));
+      return Atan2Quadrant(angle,y,x,ax,ay);
+   }
+
+   // Polynomial approximation of sinf(...) and cosf(...)
+   // together.  The angle is reduced to +/- PI/4 around the
+   // nearest multiple of PI/2 (with PI/2 split in three parts
+   // so the reduction does not lose bits), then the minimax
+   // polynomials from Cephes are used for both.
+   //
+   // Good to about 1.2e-7 for |angle| < 1e4 and there is
+   // no branch on the quadrant.  Bigger angles lose accuracy
+   // the same way WrapAngle(...) does.
+   static inline void SinCosFast(float32 angleRads, float32& sinOut, float32& cosOut)
+   {
+      float32 quadrant = rintf(angleRads*(float32)(2.0/M_PI));
+      float32 x = angleRads - quadrant*1.5703125f;
+      x = x - quadrant*4.837512969970703125e-4f;
+      x = x - quadrant*7.549789948768648e-8f;
+      float32 x2 = x*x;
+      float32 s = x + x*x2*(-1.6666654611e-1f + x2*(8.3321608736e-3f + x2*-1.9515295891e-4f));
+      float32 c = 1.0f - 0.5f*x2 + x2*x2*(4.166664568298827e-2f + x2*(-1.388731625493765e-3f + x2*2.443315711809948e-5f));
+      SinCosQuadrant((int32)quadrant,s,c,sinOut,cosOut);
+   }
+
+   // Maps sin/cos of the reduced angle into the right quadrant.
+   // Indexing and multiplying by +/-1 (both exact) instead of
+   // branching, since the quadrant is hard to predict.
+   static inline void SinCosQuadrant(int32 quadrant, float32 s, float32 c, float32& sinOut, float32& cosOut)
+   {
+      const float32 values[2] = { s, c };
+      sinOut = values[quadrant & 1]*(float32)(1 - (quadrant & 2));
+      cosOut = values[(quadrant & 1) ^ 1]*(float32)(1 - ((quadrant+1) & 2));
+   }
+
+   // Array versions of WrapAngle(...), Atan2Fast(...),
+   // Atan2Fastest(...) and SinCosFast(...).  These use the SIMD
+   // kernels in MathSIMD.h when they are compiled in and give
+   // the same results as the scalar versions.  The output may
+   // be one of the inputs.
+   static void WrapAngle(const float32* angles, float32* results, uint32 count);
+   static void Atan2Fast(const float32* y, const float32* x, float32* results, uint32 count);
+   static void Atan2Fastest(const float32* y, const float32* x, float32* results, uint32 count);
+   static void SinCosFast(const float32* angles, float32* sins, float32* coss, uint32 count);
+
+   // Maps atan(min/max) (0..PI/4) into the right octant.
+   static inline float32 Atan2Quadrant(float32 angle, float32 y, float32 x, float32 ax, float32 ay)
+   {
+      if(ay > ax)
+         angle = 1.5707964f - angle;
+      if(x < 0)
+         angle = 3.1415927f - angle;
+      if(y < 0)
+         angle = -angle;
+      return angle;
+   }
+
    // Indicate which quadrant a point is in.
    // 0 ==> 0 < x < PI/2
    // 1 ==> PI/2 < x < PI
@@ -150,11 +249,18 @@ public:
       return false;
    }
    
+   // Converts an angle to the range [-1,1] (in units of PI).
+   // Angles more than a turn out are reduced in one step first,
+   // so the loops are bounded.
    template<typename Number>
    static inline Number NormalizedAngle(Number angleRads)
    {
       Number angle = angleRads / M_PI;
       
+      if(angle > 3 || angle < -3)
+      {
+         angle -= 2*floor(angle/2 + 0.5);
+      }
       while(angle > 2)
          angle -= 2;
       while(angle < -2)
@@ -28,43 +28,63 @@
 #define __MissileDemo__Missile__
 
 #include "CommonSTL.h"
-#include "CommonProject.h"
+#include "CommonPhysics.h"
 #include "Entity.h"
 #include "PIDController.h"
+#include "PIDControllerBank.h"
 #include "MathUtilities.h"
 #include "MovingEntityIFace.h"
-#include "Notifier.h"
+#include "InterceptGuidance.h"
+#include "FlowField.h"
+#include "Telemetry.h"
 
 class Missile : public Entity, public MovingEntityIFace
 {
 private:
-   typedef enum
-   {
-      ST_IDLE,
-      ST_TURN_TOWARDS,
-      ST_SEEK,
-      ST_FOLLOW_PATH,
-      ST_MAX
-   } STATE_T;
-   
-   STATE_T _state;
    // Create turning acceleration
    PIDController _turnController;
    
+   // When this is set, the turn controller in the bank
+   // is used instead of _turnController.
+   PIDControllerBank* _turnBank;
+   uint32 _turnBankIndex;
+   bool _turnTorquePending;
+   
+   // The last values used for steering, for the Telemetry.
+   float32 _angleError;
+   float32 _thrust;
+   
+   // The target velocity last tick, to estimate
+   // its acceleration for the guidance.
+   Vec2 _lastTargetVel;
+   
    void SetupTurnController()
    {
       GetBody()->SetAngularDamping(0);
-      _turnController.ResetHistory();
-      _turnController.SetKDerivative(5.0);
-      _turnController.SetKProportional(1.0);
-      _turnController.SetKIntegral(0.05);
-      _turnController.SetKPlant(1.0);
+      if(_turnBank != NULL)
+      {
+         _turnBank->ResetHistory(_turnBankIndex);
+         _turnBank->SetKDerivative(_turnBankIndex,5.0);
+         _turnBank->SetKProportional(_turnBankIndex,1.0);
+         _turnBank->SetKIntegral(_turnBankIndex,0.05);
+         _turnBank->SetKPlant(_turnBankIndex,1.0);
+      }
+      else
+      {
+         _turnController.ResetHistory();
+         _turnController.SetKDerivative(5.0);
+         _turnController.SetKProportional(1.0);
+         _turnController.SetKIntegral(0.05);
+         _turnController.SetKPlant(1.0);
+      }
    }
    
    void StopBody()
    {
       GetBody()->SetLinearVelocity(Vec2(0,0));
       GetBody()->SetAngularVelocity(0);
+      _angleError = 0;
+      _thrust = 0;
    }
    
    
@@ -81,7 +101,7 @@ private:
    
    void ApplyTurnTorque()
    {
-      Vec2 toTarget = GetTargetPos() - GetBody()->GetPosition();
+      Vec2 toTarget = GetSteeringTarget(GetBody()->GetPosition()) - GetBody()->GetPosition();
       
       float32 angleBodyRads = MathUtilities::AdjustAngle(GetBody()->GetAngle());
       if(GetBody()->GetLinearVelocity().LengthSquared() > 0)
@@ -91,10 +111,24 @@ private:
       }
       float32 angleTargetRads = MathUtilities::AdjustAngle(atan2f(toTarget.y, toTarget.x));
       float32 angleError = MathUtilities::AdjustAngle(angleBodyRads - angleTargetRads);
-      _turnController.AddSample(angleError);
-      
+      _angleError = angleError;
+      if(_turnBank != NULL)
+      {  // The output is calculated for all the entities
+         // at once; see ApplyBatchedTurnTorque().
+         _turnBank->AddSample(_turnBankIndex,angleError);
+         _turnTorquePending = true;
+      }
+      else
+      {
+         _turnController.AddSample(angleError);
+         ApplyTurnOutput(_turnController.GetLastOutput());
+      }
+   }
+   
+   void ApplyTurnOutput(double output)
+   {
       // Negative Feedback
-      float32 angAcc = -_turnController.GetLastOutput();
+      float32 angAcc = -output;
       
       // This is as much turn acceleration as this
       // "motor" can generate.
@@ -104,16 +138,13 @@ private:
          angAcc = -GetMaxAngularAcceleration();
       
       float32 torque = angAcc * GetBody()->GetInertia();
-      GetBody()->ApplyTorque(torque);
+      ApplyTorque(GetBody(),torque);
    }
    
-   void NotifySpeed()
+   void RecordTelemetry()
    {
-      Vec2 linVel = GetBody()->GetLinearVelocity();
-      float32 speed = linVel.Length();
-      char buffer[64];
-      sprintf(buffer,"Speed = %8.3f m/s",speed);
-      Notifier::Instance().Notify(Notifier::NE_DEBUG_MESSAGE,buffer);
+      float32 speed = GetBody()->GetLinearVelocity().Length();
+      Telemetry::Instance().Record(this,speed,_angleError,_thrust);
    }
 
    void ApplyThrust()
@@ -132,7 +163,8 @@ private:
       float32 thrust = GetMaxLinearAcceleration() * GetBody()->GetMass();
       
       // Apply Thrust
-      GetBody()->ApplyForceToCenter(thrust*direction);
+      ApplyForceToCenter(GetBody(),thrust*direction);
+      _thrust = thrust;
    }
 
    void EnterSeek()
@@ -154,6 +186,72 @@ private:
    }
    
    
+   // Turns at the rate the guidance law asks for
+   // (instead of using the turn controller).
+   void ApplyGuidanceTorque()
+   {
+      Body* body = GetBody();
+      const Body* target = GetTargetBody();
+      const Vec2& targetVel = target->GetLinearVelocity();
+      Vec2 targetAcc = InterceptGuidance::EstimateAcceleration(targetVel,_lastTargetVel,SECONDS_PER_TICK);
+      _lastTargetVel = targetVel;
+      
+      float32 headingError;
+      float32 turnRate = InterceptGuidance::CalculateTurnRate(GetGuidanceLaw(),GetNavigationConstant(),
+                                                              body->GetPosition(),
+                                                              body->GetWorldVector(Vec2(1.0,0.0)),
+                                                              body->GetLinearVelocity(),
+                                                              target->GetPosition(),targetVel,targetAcc,
+                                                              headingError);
+      // Same sign as the turn controller error.
+      _angleError = -headingError;
+      float32 torque = InterceptGuidance::TurnRateTorque(turnRate,body->GetAngularVelocity(),body->GetInertia(),
+                                                         GetMaxAngularAcceleration(),SECONDS_PER_TICK);
+      ApplyTorque(body,torque);
+   }
+   
+   void EnterIntercept()
+   {
+      GetBody()->SetAngularDamping(0);
+      _lastTargetVel = GetTargetBody()->GetLinearVelocity();
+   }
+   
+   void ExecuteIntercept()
+   {
+      GetTargetPos() = GetTargetBody()->GetPosition();
+      if(IsNearTarget())
+      {  // Hit.
+         ChangeState(ST_IDLE);
+      }
+      else
+      {
+         ApplyGuidanceTorque();
+         ApplyThrust();
+      }
+   }
+   
+   // Steer for a point a little way along the field, like
+   // a seek, until the goal is close.
+   void EnterFollowFlow()
+   {
+      SetupTurnController();
+   }
+   
+   void ExecuteFollowFlow()
+   {
+      const FlowField* field = GetFlowField();
+      Vec2& targetPos = GetTargetPos();
+      targetPos = field->GetGoal();
+      if(IsNearTarget())
+      {  // Made it.
+         ChangeState(ST_IDLE);
+         return;
+      }
+      targetPos = field->GetSteeringTarget(GetBody()->GetPosition());
+      ApplyTurnTorque();
+      ApplyThrust();
+   }
+   
    void EnterIdle()
    {
       StopBody();
@@ -166,6 +264,8 @@ private:
    void EnterTurnTowards()
    {
       SetupTurnController();
+      // Turning only; do not keep showing the last thrust.
+      _thrust = 0;
    }
    
    void ExecuteTurnTowards()
@@ -175,16 +275,16 @@ private:
    
    void UpdatePathTarget()
    {
-      list<Vec2>& path = GetPath();
+      PathCursor& cursor = GetPathCursor();
       Vec2& targetPos = GetTargetPos();
       
-      if(path.size() > 0)
+      if(!cursor.IsDone())
       {
-         targetPos = *path.begin();
-         while(path.size() > 0 && IsNearTarget())
+         targetPos = cursor.GetPoint();
+         while(!cursor.IsDone() && IsNearTarget())
          {
-            targetPos = *path.begin();
-            path.pop_front();
+            targetPos = cursor.GetPoint();
+            cursor.Next();
          }
       }
       else
@@ -195,15 +295,22 @@ private:
    
    void EnterFollowPath()
    {
-      // Make sure the first path point is
-      // the current location of the body.
-      GetPath().insert(GetPath().begin(), GetBody()->GetPosition());
+      // The current location of the body is the
+      // first path point, and it has been reached.
+      // The path is shared, so do not add it there.
+      PathCursor& cursor = GetPathCursor();
+      Vec2& targetPos = GetTargetPos();
+      targetPos = GetBody()->GetPosition();
       
       // If there are any points to follow,
       // then pop the first as the target
       // and follow it.  Otherwise, go idle.
-      UpdatePathTarget();
-      if(GetPath().size() > 0)
+      while(!cursor.IsDone() && IsNearTarget())
+      {
+         targetPos = cursor.GetPoint();
+         cursor.Next();
+      }
+      if(!cursor.IsDone())
       {
          SetupTurnController();
       }
@@ -216,7 +323,7 @@ private:
    void ExecuteFollowPath()
    {
       UpdatePathTarget();
-      if(GetPath().size() > 0)
+      if(!GetPathCursor().IsDone())
       {
          ApplyThrust();
          ApplyTurnTorque();
@@ -243,6 +350,12 @@ private:
          case ST_FOLLOW_PATH:
             ExecuteFollowPath();
             break;
+         case ST_INTERCEPT:
+            ExecuteIntercept();
+            break;
+         case ST_FOLLOW_FLOW:
+            ExecuteFollowFlow();
+            break;
          default:
             assert(false);
       }
@@ -264,6 +377,12 @@ private:
          case ST_FOLLOW_PATH:
             EnterFollowPath();
             break;
+         case ST_INTERCEPT:
+            EnterIntercept();
+            break;
+         case ST_FOLLOW_FLOW:
+            EnterFollowFlow();
+            break;
          default:
             assert(false);
       }
@@ -272,16 +391,16 @@ private:
    void ChangeState(STATE_T state)
    {
       EnterState(state);
-      _state = state;
+      SetState(state);
    }
    
 public:
    // Getters and Setters
       
-   // Constructor
-	Missile(b2World& world,const Vec2& position) :
-      Entity(Entity::ET_MISSILE,10),
-      _state(ST_IDLE)
+   // Create the physical body (with fixtures) used for
+   // a missile.  This is shared with the MissileSwarm so
+   // that swarm missiles are identical to these.
+   static Body* CreateBody(b2World& world,const Vec2& position)
    {
       // Create the body.
       b2BodyDef bodyDef;
@@ -289,8 +408,6 @@ public:
       bodyDef.type = b2_dynamicBody;
       Body* body = world.CreateBody(&bodyDef);
       assert(body != NULL);
-      // Store it in the base.
-      Init(body);
       
       // Now attach fixtures to the body.
       FixtureDef fixtureDef;
@@ -325,6 +442,21 @@ public:
       vertices.push_back(Vec2(-4*VERT_SCALE,0*VERT_SCALE));
       polyShape.Set(&vertices[0],vertices.size());
       body->CreateFixture(&fixtureDef);
+      return body;
+   }
+   
+   // Constructor
+	Missile(b2World& world,const Vec2& position) :
+      Entity(Entity::ET_MISSILE,10),
+      _turnBank(NULL),
+      _turnBankIndex(0),
+      _turnTorquePending(false),
+      _angleError(0),
+      _thrust(0),
+      _lastTargetVel(0,0)
+   {
+      // Store it in the base.
+      Init(CreateBody(world,position));
       
       // Set Parameters
       SetMaxAngularAcceleration(4*M_PI);
@@ -336,9 +468,9 @@ public:
    
    // Commands - Use thse to change the state
    // of the missile.
-   virtual void CommandFollowPath(const list<Vec2> path)
+   virtual void CommandFollowPath(const Path* path)
    {
-      GetPath() = path;
+      GetPathCursor().SetPath(path);
       ChangeState(ST_FOLLOW_PATH);
    }
    
@@ -360,6 +492,22 @@ public:
       GetTargetPos() = position;
    }
    
+   virtual void CommandIntercept(const Body* target)
+   {
+      assert(target != NULL);
+      GetTargetBody() = target;
+      GetTargetPos() = target->GetPosition();
+      ChangeState(ST_INTERCEPT);
+   }
+   
+   virtual void CommandFollowFlowField(const FlowField* field)
+   {
+      assert(field != NULL);
+      GetFlowField() = field;
+      GetTargetPos() = field->GetGoal();
+      ChangeState(ST_FOLLOW_FLOW);
+   }
+   
    virtual void CommandIdle()
    {
       ChangeState(ST_IDLE);
@@ -367,8 +515,46 @@ public:
    
    virtual void Update()
    {
-      ExecuteState(_state);
-      NotifySpeed();
+      UpdateSteering();
+      UpdateNotifications();
+   }
+   
+   virtual const Vec2& GetPosition()
+   {
+      return GetBody()->GetPosition();
+   }
+   
+   virtual void UpdateSteering()
+   {
+      ExecuteState(GetState());
+   }
+   
+   virtual void UpdateNotifications()
+   {
+      RecordTelemetry();
+   }
+   
+   virtual void AttachTurnControllerBank(PIDControllerBank* bank)
+   {
+      assert(bank != NULL);
+      assert(_turnBank == NULL);
+      _turnBank = bank;
+      _turnBankIndex = bank->AddController();
+      // If already steering, restart the turn
+      // controller in the bank.
+      if(GetState() != ST_IDLE)
+      {
+         SetupTurnController();
+      }
+   }
+   
+   virtual void ApplyBatchedTurnTorque()
+   {
+      if(_turnTorquePending)
+      {
+         ApplyTurnOutput(_turnBank->GetLastOutput(_turnBankIndex));
+         _turnTorquePending = false;
+      }
    }
    
 protected:
@@ -0,0 +1,370 @@
+/********************************************************************
+ * File   : MissileSwarm.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/4/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "MissileSwarm.h"
+#include "Missile.h"
+#include "FlowField.h"
+#include "Profiler.h"
+
+MissileSwarm::MissileSwarm() :
+   _world(NULL),
+   _steeringAccuracy(SteeringBatch::SA_EXACT),
+   _guidanceLaw(InterceptGuidance::GL_PN),
+   _navigationConstant(InterceptGuidance::DEFAULT_NAVIGATION_CONSTANT)
+{
+}
+
+MissileSwarm::~MissileSwarm()
+{
+   Reset();
+}
+
+void MissileSwarm::Init(b2World* world)
+{
+   Reset();
+   _world = world;
+}
+
+void MissileSwarm::Reset()
+{
+   if(_world != NULL)
+   {
+      for(uint32 idx = 0; idx < _bodies.size(); idx++)
+      {
+         _world->DestroyBody(_bodies[idx]);
+      }
+   }
+   _bodies.clear();
+   _targetPos.clear();
+   _state.clear();
+   _maxAngularAcceleration.clear();
+   _maxLinearAcceleration.clear();
+   _maxSpeed.clear();
+   _minSeekDistance.clear();
+   _targetBodies.clear();
+   _lastTargetVel.clear();
+   _flowFields.clear();
+   // Same history and time step as PIDController defaults.
+   _turnControllers.Init(7,1.0/100);
+}
+
+void MissileSwarm::Reserve(uint32 count)
+{
+   _bodies.reserve(count);
+   _targetPos.reserve(count);
+   _state.reserve(count);
+   _maxAngularAcceleration.reserve(count);
+   _maxLinearAcceleration.reserve(count);
+   _maxSpeed.reserve(count);
+   _minSeekDistance.reserve(count);
+   _targetBodies.reserve(count);
+   _lastTargetVel.reserve(count);
+   _flowFields.reserve(count);
+   _steered.reserve(count);
+   _guided.reserve(count);
+   _turnControllers.Reserve(count);
+}
+
+uint32 MissileSwarm::AddMissile(const Vec2& position)
+{
+   assert(_world != NULL);
+   Body* body = Missile::CreateBody(*_world,position);
+   
+   _bodies.push_back(body);
+   _targetPos.push_back(position);
+   _state.push_back(ST_IDLE);
+   // Same parameters as the Missile.
+   _maxAngularAcceleration.push_back(4*M_PI);
+   _maxLinearAcceleration.push_back(100);
+   _maxSpeed.push_back(10);
+   _minSeekDistance.push_back(4.0);
+   _targetBodies.push_back(NULL);
+   _lastTargetVel.push_back(Vec2(0,0));
+   _flowFields.push_back(NULL);
+   _turnControllers.AddController();
+   return _bodies.size()-1;
+}
+
+void MissileSwarm::RemoveMissile(uint32 idx)
+{
+   assert(idx < _bodies.size());
+   uint32 last = _bodies.size()-1;
+   
+   _world->DestroyBody(_bodies[idx]);
+   
+   // Move the last one into this slot.
+   _bodies[idx] = _bodies[last];
+   _targetPos[idx] = _targetPos[last];
+   _state[idx] = _state[last];
+   _maxAngularAcceleration[idx] = _maxAngularAcceleration[last];
+   _maxLinearAcceleration[idx] = _maxLinearAcceleration[last];
+   _maxSpeed[idx] = _maxSpeed[last];
+   _minSeekDistance[idx] = _minSeekDistance[last];
+   _targetBodies[idx] = _targetBodies[last];
+   _lastTargetVel[idx] = _lastTargetVel[last];
+   _flowFields[idx] = _flowFields[last];
+   _turnControllers.RemoveController(idx);
+   
+   _bodies.pop_back();
+   _targetPos.pop_back();
+   _state.pop_back();
+   _maxAngularAcceleration.pop_back();
+   _maxLinearAcceleration.pop_back();
+   _maxSpeed.pop_back();
+   _minSeekDistance.pop_back();
+   _targetBodies.pop_back();
+   _lastTargetVel.pop_back();
+   _flowFields.pop_back();
+}
+
+void MissileSwarm::SetupTurnController(uint32 idx)
+{
+   // Same values as Missile::SetupTurnController().
+   _bodies[idx]->SetAngularDamping(0);
+   _turnControllers.ResetHistory(idx);
+   _turnControllers.SetKDerivative(idx,5.0);
+   _turnControllers.SetKProportional(idx,1.0);
+   _turnControllers.SetKIntegral(idx,0.05);
+   _turnControllers.SetKPlant(idx,1.0);
+}
+
+void MissileSwarm::StopBody(uint32 idx)
+{
+   _bodies[idx]->SetLinearVelocity(Vec2(0,0));
+   _bodies[idx]->SetAngularVelocity(0);
+}
+
+void MissileSwarm::EnterState(uint32 idx, STATE_T state)
+{
+   switch(state)
+   {
+      case ST_IDLE:
+         StopBody(idx);
+         break;
+      case ST_TURN_TOWARDS:
+      case ST_SEEK:
+      case ST_FOLLOW_FLOW:
+         SetupTurnController(idx);
+         break;
+      case ST_INTERCEPT:
+         _bodies[idx]->SetAngularDamping(0);
+         _lastTargetVel[idx] = _targetBodies[idx]->GetLinearVelocity();
+         break;
+      default:
+         assert(false);
+   }
+   _state[idx] = state;
+}
+
+void MissileSwarm::CommandTurnTowards(uint32 idx, const Vec2& position)
+{
+   _targetPos[idx] = position;
+   EnterState(idx,ST_TURN_TOWARDS);
+}
+
+void MissileSwarm::CommandSeek(uint32 idx, const Vec2& position)
+{
+   _targetPos[idx] = position;
+   EnterState(idx,ST_SEEK);
+}
+
+void MissileSwarm::CommandIntercept(uint32 idx, const Body* target)
+{
+   assert(target != NULL);
+   _targetBodies[idx] = target;
+   _targetPos[idx] = target->GetPosition();
+   EnterState(idx,ST_INTERCEPT);
+}
+
+void MissileSwarm::CommandInterceptNearest(const vector<const Body*>& targets, uint32 capacity)
+{
+   PROFILE_ZONE("MissileSwarm::CommandInterceptNearest");
+   const uint32 count = _bodies.size();
+   if(count == 0 || targets.empty())
+   {
+      return;
+   }
+   _missilePositions.resize(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      _missilePositions[idx] = _bodies[idx]->GetPosition();
+   }
+   _targetPositions.resize(targets.size());
+   for(uint32 tdx = 0; tdx < targets.size(); tdx++)
+   {
+      _targetPositions[tdx] = targets[tdx]->GetPosition();
+   }
+   _assigner.Assign(&_missilePositions[0],count,&_targetPositions[0],targets.size(),_assignment,capacity);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      CommandIntercept(idx,targets[_assignment[idx]]);
+   }
+}
+
+void MissileSwarm::CommandFollowFlowField(uint32 idx, const FlowField* field)
+{
+   assert(field != NULL);
+   _flowFields[idx] = field;
+   _targetPos[idx] = field->GetGoal();
+   EnterState(idx,ST_FOLLOW_FLOW);
+}
+
+void MissileSwarm::CommandIdle(uint32 idx)
+{
+   EnterState(idx,ST_IDLE);
+}
+
+void MissileSwarm::Update()
+{
+   PROFILE_ZONE("MissileSwarm::Update");
+   const uint32 count = _bodies.size();
+   
+   // Every missile is something to keep away from,
+   // whatever it is doing.
+   if(_separation.IsEnabled())
+   {
+      _separation.SetCount(count);
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         _separation.SetPosition(idx,_bodies[idx]->GetPosition());
+      }
+      _separation.Build();
+      _separation.Calculate();
+   }
+   
+   // Pick out the missiles that are steering and copy
+   // their state into the batch.
+   _steered.clear();
+   _steering.SetCount(count);
+   _guided.clear();
+   _guidance.SetCount(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      const uint8 state = _state[idx];
+      if(state == ST_IDLE)
+      {
+         continue;
+      }
+      
+      Body* body = _bodies[idx];
+      if(state == ST_INTERCEPT)
+      {
+         const Body* target = _targetBodies[idx];
+         _targetPos[idx] = target->GetPosition();
+         if((_targetPos[idx] - body->GetPosition()).LengthSquared() < _minSeekDistance[idx]*_minSeekDistance[idx])
+         {  // Hit.
+            EnterState(idx,ST_IDLE);
+            continue;
+         }
+         _guidance.SetPair(_guided.size(),body,target,_lastTargetVel[idx],_maxAngularAcceleration[idx]);
+         _lastTargetVel[idx] = target->GetLinearVelocity();
+         _guided.push_back(idx);
+         continue;
+      }
+      if(state == ST_FOLLOW_FLOW)
+      {
+         const FlowField* field = _flowFields[idx];
+         if((field->GetGoal() - body->GetPosition()).LengthSquared() < _minSeekDistance[idx]*_minSeekDistance[idx])
+         {  // Made it.
+            EnterState(idx,ST_IDLE);
+            continue;
+         }
+         _targetPos[idx] = field->GetSteeringTarget(body->GetPosition());
+      }
+      if(state == ST_SEEK &&
+         (_targetPos[idx] - body->GetPosition()).LengthSquared() < _minSeekDistance[idx]*_minSeekDistance[idx])
+      {  // Close enough.
+         StopBody(idx);
+         continue;
+      }
+      Vec2 steeringTarget = _targetPos[idx];
+      if((state == ST_SEEK || state == ST_FOLLOW_FLOW) && _separation.IsEnabled())
+      {
+         steeringTarget = SeparationSteering::SteeringTarget(body->GetPosition(),steeringTarget,
+                                                             _separation.GetAvoidance(idx));
+      }
+      _steering.SetBody(_steered.size(),body,steeringTarget,
+                        _maxAngularAcceleration[idx],_maxLinearAcceleration[idx],_maxSpeed[idx]);
+      _steered.push_back(idx);
+   }
+   const uint32 steered = _steered.size();
+   _steering.SetCount(steered);
+   
+   // Turn towards the target.  The turn errors go into
+   // the controller bank.
+   _steering.CalculateTurnErrors(_steeringAccuracy);
+   for(uint32 sdx = 0; sdx < steered; sdx++)
+   {
+      _turnControllers.AddSample(_steered[sdx],_steering.GetTurnError(sdx));
+   }
+   
+   // Thrust along the body axis.  The missile
+   // "cannot" slip sideways.
+   _steering.CalculateThrust();
+   for(uint32 sdx = 0; sdx < steered; sdx++)
+   {
+      uint32 idx = _steered[sdx];
+      if(_state[idx] == ST_SEEK || _state[idx] == ST_FOLLOW_FLOW)
+      {
+         _bodies[idx]->SetLinearVelocity(_steering.GetVelocity(sdx));
+         _bodies[idx]->ApplyForceToCenter(_steering.GetForce(sdx));
+      }
+   }
+   
+   // All the turn controllers at once.
+   _turnControllers.Evaluate();
+   
+   // Turning torques.
+   const double* outputs = _turnControllers.GetOutputs();
+   for(uint32 sdx = 0; sdx < steered; sdx++)
+   {
+      _steering.SetTurnOutput(sdx,outputs[_steered[sdx]]);
+   }
+   _steering.CalculateTurnTorques();
+   for(uint32 sdx = 0; sdx < steered; sdx++)
+   {
+      _bodies[_steered[sdx]]->ApplyTorque(_steering.GetTorque(sdx));
+   }
+   
+   // The intercepting missiles turn at the rate from the
+   // guidance law and thrust like Missile::ApplyThrust().
+   const uint32 guided = _guided.size();
+   _guidance.SetCount(guided);
+   _guidance.Calculate(_guidanceLaw,_navigationConstant);
+   for(uint32 gdx = 0; gdx < guided; gdx++)
+   {
+      uint32 idx = _guided[gdx];
+      Body* body = _bodies[idx];
+      Vec2 direction = body->GetWorldVector(Vec2(1.0,0.0));
+      float32 speed = body->GetLinearVelocity().Length();
+      if(speed >= _maxSpeed[idx])
+         speed = _maxSpeed[idx];
+      body->SetLinearVelocity(speed*direction);
+      body->ApplyForceToCenter((_maxLinearAcceleration[idx]*body->GetMass())*direction);
+      body->ApplyTorque(_guidance.GetTorque(gdx));
+   }
+}
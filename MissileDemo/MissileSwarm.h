@@ -0,0 +1,202 @@
+/********************************************************************
+ * File   : MissileSwarm.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/4/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__MissileSwarm__
+#define __MissileDemo__MissileSwarm__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "PIDControllerBank.h"
+#include "SteeringBatch.h"
+#include "InterceptGuidance.h"
+#include "TargetAssigner.h"
+#include "SeparationSteering.h"
+
+class FlowField;
+
+/* This class holds a large number of missiles in
+ * "structure of arrays" form.  Each missile is an index
+ * into a set of parallel arrays (target, state, limits,
+ * turn controller history) instead of a heap object
+ * with virtual functions.  Update() runs every missile
+ * through the same steering code in a single loop.
+ *
+ * The steering is the same as the Missile class for the
+ * idle, turn towards and seek behaviors, including the
+ * PID turn controller (same gains, time step and history
+ * length), so a swarm missile flies exactly like a
+ * Missile would.  The turn controllers are kept in a
+ * PIDControllerBank and the steering math is done by a
+ * SteeringBatch, so both run in SIMD batches.  The bodies
+ * are ordinary Box2D bodies and are driven through
+ * ApplyTorque/ApplyForceToCenter.
+ *
+ * Intercepting missiles use the guidance law set with
+ * SetGuidanceLaw(...) (GL_PN by default, like a Missile)
+ * instead of the turn controller, and are run through an
+ * InterceptGuidanceBatch.
+ *
+ * Missiles following a FlowField steer like seeking
+ * missiles, for a point a little way along the field.
+ *
+ * With SetSeparation(...), seeking and flow following
+ * missiles steer away from each other (see
+ * SeparationSteering).  It is off by default.
+ *
+ * SetSteeringAccuracy(...) trades turn accuracy for speed
+ * (see SteeringBatch).  With SA_EXACT (the default) a
+ * swarm missile flies exactly like a Missile.
+ *
+ * Missiles are referred to by index.  Removing a missile
+ * moves the last missile into its slot, so the index of
+ * the last missile changes.
+ */
+class MissileSwarm
+{
+public:
+   typedef enum
+   {
+      ST_IDLE,
+      ST_TURN_TOWARDS,
+      ST_SEEK,
+      ST_INTERCEPT,
+      ST_FOLLOW_FLOW,
+      ST_MAX
+   } STATE_T;
+   
+private:
+   b2World* _world;
+   
+   // Per missile data.
+   vector<Body*> _bodies;
+   vector<Vec2> _targetPos;
+   vector<uint8> _state;
+   vector<float32> _maxAngularAcceleration;
+   vector<float32> _maxLinearAcceleration;
+   vector<float32> _maxSpeed;
+   vector<float32> _minSeekDistance;
+   // The body being intercepted and its velocity last
+   // tick (for the target acceleration).
+   vector<const Body*> _targetBodies;
+   vector<Vec2> _lastTargetVel;
+   // The field for ST_FOLLOW_FLOW.
+   vector<const FlowField*> _flowFields;
+   // The turn controllers, one per missile, at the same index.
+   PIDControllerBank _turnControllers;
+   
+   // Scratch space for Update().  _steering holds the
+   // missiles that are steering this tick, and _steered
+   // is the missile index for each of them.
+   SteeringBatch _steering;
+   vector<uint32> _steered;
+   SteeringBatch::ACCURACY_T _steeringAccuracy;
+   // Same for the intercepting missiles.
+   InterceptGuidanceBatch _guidance;
+   vector<uint32> _guided;
+   InterceptGuidance::LAW_T _guidanceLaw;
+   float32 _navigationConstant;
+   SeparationSteering _separation;
+   // Scratch space for CommandInterceptNearest(...).
+   TargetAssigner _assigner;
+   vector<Vec2> _missilePositions;
+   vector<Vec2> _targetPositions;
+   vector<int32> _assignment;
+   
+   void SetupTurnController(uint32 idx);
+   void StopBody(uint32 idx);
+   void EnterState(uint32 idx, STATE_T state);
+   
+public:
+   MissileSwarm();
+   ~MissileSwarm();
+   
+   // The world the bodies are created in.  This must
+   // be set before adding any missiles.
+   void Init(b2World* world);
+   
+   // Destroys all the missile bodies.
+   void Reset();
+   
+   uint32 AddMissile(const Vec2& position);
+   void RemoveMissile(uint32 idx);
+   void Reserve(uint32 count);
+   
+   inline uint32 GetCount() const { return _bodies.size(); }
+   inline Body* GetBody(uint32 idx) { return _bodies[idx]; }
+   inline STATE_T GetState(uint32 idx) const { return (STATE_T)_state[idx]; }
+   inline const Vec2& GetTargetPos(uint32 idx) const { return _targetPos[idx]; }
+   
+   inline float32 GetMaxAngularAcceleration(uint32 idx) const { return _maxAngularAcceleration[idx]; }
+   inline void SetMaxAngularAcceleration(uint32 idx, float32 value) { _maxAngularAcceleration[idx] = value; }
+   inline float32 GetMaxLinearAcceleration(uint32 idx) const { return _maxLinearAcceleration[idx]; }
+   inline void SetMaxLinearAcceleration(uint32 idx, float32 value) { _maxLinearAcceleration[idx] = value; }
+   inline float32 GetMaxSpeed(uint32 idx) const { return _maxSpeed[idx]; }
+   inline void SetMaxSpeed(uint32 idx, float32 value) { _maxSpeed[idx] = value; }
+   inline float32 GetMinSeekDistance(uint32 idx) const { return _minSeekDistance[idx]; }
+   inline void SetMinSeekDistance(uint32 idx, float32 value) { _minSeekDistance[idx] = value; }
+   
+   // Applies to all the missiles.
+   inline SteeringBatch::ACCURACY_T GetSteeringAccuracy() const { return _steeringAccuracy; }
+   inline void SetSteeringAccuracy(SteeringBatch::ACCURACY_T accuracy) { _steeringAccuracy = accuracy; }
+   inline InterceptGuidance::LAW_T GetGuidanceLaw() const { return _guidanceLaw; }
+   inline void SetGuidanceLaw(InterceptGuidance::LAW_T guidanceLaw) { _guidanceLaw = guidanceLaw; }
+   inline float32 GetNavigationConstant() const { return _navigationConstant; }
+   inline void SetNavigationConstant(float32 navigationConstant) { _navigationConstant = navigationConstant; }
+   
+   // Seeking and flow following missiles within radius
+   // of each other steer apart.  A radius of 0 (the default) turns it off.
+   inline void SetSeparation(float32 radius, float32 weight = 1.0)
+   {
+      _separation.SetRadius(radius);
+      _separation.SetWeight(weight);
+   }
+   inline float32 GetSeparationRadius() const { return _separation.GetRadius(); }
+   
+   // Commands - Use these to change the state of a missile.
+   void CommandTurnTowards(uint32 idx, const Vec2& position);
+   void CommandSeek(uint32 idx, const Vec2& position);
+   // The missile goes idle when it gets within the minimum
+   // seek distance of the target.  The body must outlive
+   // the command.
+   void CommandIntercept(uint32 idx, const Body* target);
+   // Every missile intercepts a nearby target, with the
+   // missiles spread over the targets (see TargetAssigner).
+   // No target gets more than capacity missiles (0 spreads
+   // them evenly).
+   void CommandInterceptNearest(const vector<const Body*>& targets, uint32 capacity = 0);
+   // The missile goes idle when it gets within the minimum
+   // seek distance of the field's goal.  The field must
+   // outlive the command and not change during Update().
+   void CommandFollowFlowField(uint32 idx, const FlowField* field);
+   void CommandIdle(uint32 idx);
+   inline void SetTargetPosition(uint32 idx, const Vec2& position) { _targetPos[idx] = position; }
+   
+   // Update every missile for one tick.  Call this
+   // before stepping the world.
+   void Update();
+};
+
+#endif /* defined(__MissileDemo__MissileSwarm__) */
@@ -0,0 +1,132 @@
+/********************************************************************
+ * File   : MonotoneCubicInterpolator.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/20/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__MonotoneCubicInterpolator__
+#define __MissileDemo__MonotoneCubicInterpolator__
+
+#include "Interpolator.h"
+
+/* A monotone cubic (Fritsch-Carlson) through the control
+ * points.
+ *
+ * Between two control points the curve never goes above or
+ * below both of them, so it does not overshoot; where the data
+ * only rises (or falls), so does the curve.  It is smooth in the
+ * first derivative only.  This suits gain schedules and thrust
+ * curves, where an overshoot would be a real (wrong) output.
+ *
+ * Create(...) is O(n).
+ */
+template<typename Number>
+class MonotoneCubicInterpolator : public Interpolator<Number>
+{
+private:
+   typedef typename Interpolator<Number>::INTERVAL_T INTERVAL_T;
+   
+   // Scratch space; the slope of the curve at each point.
+   vector<Number> _tangents;
+   
+protected:
+   virtual bool CreateInterpolation()
+   {
+      vector<INTERVAL_T>& intervals = this->_intervals;
+      const uint32 count = intervals.size();
+      if(count == 0)
+         return false;
+      
+      // Start with the average of the slopes on either side,
+      // or flat at a peak/valley.
+      _tangents.resize(count+1);
+      Number lastSlope = 0;
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         const INTERVAL_T& iv = intervals[idx];
+         Number slope = (iv.end.y - iv.start.y)/(iv.end.x - iv.start.x);
+         if(idx == 0)
+         {
+            _tangents[idx] = slope;
+         }
+         else if(slope*lastSlope <= 0)
+         {
+            _tangents[idx] = 0;
+         }
+         else
+         {
+            _tangents[idx] = (slope+lastSlope)/2;
+         }
+         lastSlope = slope;
+      }
+      _tangents[count] = lastSlope;
+      
+      // Limit the tangents so each interval stays monotone.
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         const INTERVAL_T& iv = intervals[idx];
+         Number slope = (iv.end.y - iv.start.y)/(iv.end.x - iv.start.x);
+         if(slope == 0)
+         {
+            _tangents[idx] = 0;
+            _tangents[idx+1] = 0;
+            continue;
+         }
+         Number alpha = _tangents[idx]/slope;
+         Number beta = _tangents[idx+1]/slope;
+         Number length = alpha*alpha + beta*beta;
+         if(length > 9)
+         {
+            Number tau = 3/sqrt(length);
+            _tangents[idx] = tau*alpha*slope;
+            _tangents[idx+1] = tau*beta*slope;
+         }
+      }
+      
+      // Hermite form to cubic.
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         INTERVAL_T& iv = intervals[idx];
+         Number h = iv.end.x - iv.start.x;
+         Number slope = (iv.end.y - iv.start.y)/h;
+         Number m0 = _tangents[idx];
+         Number m1 = _tangents[idx+1];
+         this->SetLocalCubic(iv,
+                             iv.start.y,
+                             m0,
+                             (3*slope - 2*m0 - m1)/h,
+                             (m0 + m1 - 2*slope)/(h*h));
+      }
+      return true;
+   }
+   
+   // The limits on the tangents are applied in order along
+   // the curve, so redo all of it.
+   virtual bool UpdateInterpolation(uint32 /*first*/, uint32 /*last*/)
+   {
+      return CreateInterpolation();
+   }
+};
+
+#endif /* defined(__MissileDemo__MonotoneCubicInterpolator__) */
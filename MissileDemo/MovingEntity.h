@@ -28,45 +28,60 @@
 #define __MissileDemo__MovingEntity__
 
 #include "CommonSTL.h"
-#include "CommonProject.h"
+#include "CommonPhysics.h"
 #include "PIDController.h"
+#include "PIDControllerBank.h"
 #include "MathUtilities.h"
 #include "Entity.h"
 #include "MovingEntityIFace.h"
-#include "Notifier.h"
+#include "InterceptGuidance.h"
+#include "FlowField.h"
+#include "Telemetry.h"
 
 
 class MovingEntity : public Entity, public MovingEntityIFace
 {
 private:
-   typedef enum
-   {
-      ST_IDLE,
-      ST_TURN_TOWARDS,
-      ST_SEEK,
-      ST_FOLLOW_PATH,
-      ST_MAX
-   } STATE_T;
-   
-   STATE_T _state;
    // Create turning acceleration
    PIDController _turnController;
    
+   // When this is set, the turn controller in the bank
+   // is used instead of _turnController.
+   PIDControllerBank* _turnBank;
+   uint32 _turnBankIndex;
+   bool _turnTorquePending;
+   
+   // The last values used for steering, for the Telemetry.
+   float32 _angleError;
+   float32 _thrust;
+   
    void SetupTurnController()
    {
       GetBody()->SetAngularDamping(0);
-      _turnController.ResetHistory();
-      _turnController.SetKDerivative(5.0);
-      _turnController.SetKProportional(2.0);
-      _turnController.SetKIntegral(0.1);
-      _turnController.SetKPlant(1.0);
+      if(_turnBank != NULL)
+      {
+         _turnBank->ResetHistory(_turnBankIndex);
+         _turnBank->SetKDerivative(_turnBankIndex,5.0);
+         _turnBank->SetKProportional(_turnBankIndex,2.0);
+         _turnBank->SetKIntegral(_turnBankIndex,0.1);
+         _turnBank->SetKPlant(_turnBankIndex,1.0);
+      }
+      else
+      {
+         _turnController.ResetHistory();
+         _turnController.SetKDerivative(5.0);
+         _turnController.SetKProportional(2.0);
+         _turnController.SetKIntegral(0.1);
+         _turnController.SetKPlant(1.0);
+      }
    }
    
-   
    void StopBody()
    {
       GetBody()->SetLinearVelocity(Vec2(0,0));
       GetBody()->SetAngularVelocity(0);
+      _angleError = 0;
+      _thrust = 0;
    }
    
    
@@ -83,15 +98,29 @@ private:
    
    void ApplyTurnTorque()
    {
-      Vec2 toTarget = GetTargetPos() - GetBody()->GetPosition();
+      Vec2 toTarget = GetSteeringTarget(GetBody()->GetPosition()) - GetBody()->GetPosition();
       
       float32 angleBodyRads = MathUtilities::AdjustAngle(GetBody()->GetAngle());
       float32 angleTargetRads = MathUtilities::AdjustAngle(atan2f(toTarget.y, toTarget.x));
       float32 angleError = MathUtilities::AdjustAngle(angleBodyRads - angleTargetRads);
-      _turnController.AddSample(angleError);
-      
+      _angleError = angleError;
+      if(_turnBank != NULL)
+      {  // The output is calculated for all the entities
+         // at once; see ApplyBatchedTurnTorque().
+         _turnBank->AddSample(_turnBankIndex,angleError);
+         _turnTorquePending = true;
+      }
+      else
+      {
+         _turnController.AddSample(angleError);
+         ApplyTurnOutput(_turnController.GetLastOutput());
+      }
+   }
+   
+   void ApplyTurnOutput(double output)
+   {
       // Negative Feedback
-      float32 angAcc = -_turnController.GetLastOutput();
+      float32 angAcc = -output;
       
       // This is as much turn acceleration as this
       // "motor" can generate.
@@ -101,28 +130,26 @@ private:
          angAcc = -GetMaxAngularAcceleration();
       
       float32 torque = angAcc * GetBody()->GetInertia();
-      GetBody()->ApplyTorque(torque);
+      ApplyTorque(GetBody(),torque);
    }
    
-   void NotifySpeed()
+   void RecordTelemetry()
    {
-      Vec2 linVel = GetBody()->GetLinearVelocity();
-      float32 speed = linVel.Length();
-      char buffer[64];
-      sprintf(buffer,"Speed = %8.3f m/s",speed);
-      Notifier::Instance().Notify(Notifier::NE_DEBUG_MESSAGE,buffer);
+      float32 speed = GetBody()->GetLinearVelocity().Length();
+      Telemetry::Instance().Record(this,speed,_angleError,_thrust);
    }
    
    
    void ApplyThrust()
    {
       // Get the distance to the target.
-      Vec2 toTarget = GetTargetPos() - GetBody()->GetWorldCenter();
+      Vec2 toTarget = GetSteeringTarget(GetBody()->GetPosition()) - GetBody()->GetWorldCenter();
       toTarget.Normalize();
       Vec2 desiredVel = GetMaxSpeed()*toTarget;
       Vec2 currentVel = GetBody()->GetLinearVelocity();
       Vec2 thrust = desiredVel - currentVel;
-      GetBody()->ApplyForceToCenter(GetMaxLinearAcceleration()*thrust);
+      ApplyForceToCenter(GetBody(),GetMaxLinearAcceleration()*thrust);
+      _thrust = GetMaxLinearAcceleration()*thrust.Length();
    }
    
    void EnterSeek()
@@ -144,6 +171,52 @@ private:
    }
    
    
+   // This entity can thrust in any direction, so it does
+   // not need a guidance law.  It seeks the point where it
+   // would meet the target if the target held its course.
+   void EnterIntercept()
+   {
+      SetupTurnController();
+   }
+   
+   void ExecuteIntercept()
+   {
+      const Body* target = GetTargetBody();
+      Vec2& targetPos = GetTargetPos();
+      targetPos = target->GetPosition();
+      if(IsNearTarget())
+      {  // Caught it.
+         ChangeState(ST_IDLE);
+         return;
+      }
+      targetPos = InterceptGuidance::PredictInterceptPoint(GetBody()->GetPosition(),GetMaxSpeed(),
+                                                           target->GetPosition(),target->GetLinearVelocity());
+      ApplyTurnTorque();
+      ApplyThrust();
+   }
+   
+   // Steer for a point a little way along the field, like
+   // a seek, until the goal is close.
+   void EnterFollowFlow()
+   {
+      SetupTurnController();
+   }
+   
+   void ExecuteFollowFlow()
+   {
+      const FlowField* field = GetFlowField();
+      Vec2& targetPos = GetTargetPos();
+      targetPos = field->GetGoal();
+      if(IsNearTarget())
+      {  // Made it.
+         ChangeState(ST_IDLE);
+         return;
+      }
+      targetPos = field->GetSteeringTarget(GetBody()->GetPosition());
+      ApplyTurnTorque();
+      ApplyThrust();
+   }
+   
    void EnterIdle()
    {
       StopBody();
@@ -165,16 +238,16 @@ private:
    
    void UpdatePathTarget()
    {
-      list<Vec2>& path = GetPath();
+      PathCursor& cursor = GetPathCursor();
       Vec2& targetPos = GetTargetPos();
       
-      if(path.size() > 0)
+      if(!cursor.IsDone())
       {
-         targetPos = *path.begin();
-         while(path.size() > 0 && IsNearTarget())
+         targetPos = cursor.GetPoint();
+         while(!cursor.IsDone() && IsNearTarget())
          {
-            targetPos = *path.begin();
-            path.pop_front();
+            targetPos = cursor.GetPoint();
+            cursor.Next();
          }
       }
       else
@@ -189,7 +262,7 @@ private:
       // then pop the first as the target
       // and follow it.  Otherwise, go idle.
       UpdatePathTarget();
-      if(GetPath().size() > 0)
+      if(!GetPathCursor().IsDone())
       {
          SetupTurnController();
       }
@@ -202,7 +275,7 @@ private:
    void ExecuteFollowPath()
    {
       UpdatePathTarget();
-      if(GetPath().size() > 0)
+      if(!GetPathCursor().IsDone())
       {
          ApplyThrust();
          ApplyTurnTorque();
@@ -229,6 +302,12 @@ private:
          case ST_FOLLOW_PATH:
             ExecuteFollowPath();
             break;
+         case ST_INTERCEPT:
+            ExecuteIntercept();
+            break;
+         case ST_FOLLOW_FLOW:
+            ExecuteFollowFlow();
+            break;
          default:
             assert(false);
       }
@@ -250,6 +329,12 @@ private:
          case ST_FOLLOW_PATH:
             EnterFollowPath();
             break;
+         case ST_INTERCEPT:
+            EnterIntercept();
+            break;
+         case ST_FOLLOW_FLOW:
+            EnterFollowFlow();
+            break;
          default:
             assert(false);
       }
@@ -258,14 +343,18 @@ private:
    void ChangeState(STATE_T state)
    {
       EnterState(state);
-      _state = state;
+      SetState(state);
    }
    
 public:
    // Constructor
 	MovingEntity(b2World& world,const Vec2& position) :
    Entity(Entity::ET_MISSILE,10),
-   _state(ST_IDLE)
+   _turnBank(NULL),
+   _turnBankIndex(0),
+   _turnTorquePending(false),
+   _angleError(0),
+   _thrust(0)
    {
       // Create the body.
       b2BodyDef bodyDef;
@@ -338,9 +427,9 @@ public:
    
    // Commands - Use thse to change the state
    // of the missile.
-   void CommandFollowPath(const list<Vec2> path)
+   void CommandFollowPath(const Path* path)
    {
-      GetPath() = path;
+      GetPathCursor().SetPath(path);
       ChangeState(ST_FOLLOW_PATH);
    }
    
@@ -362,6 +451,22 @@ public:
       GetTargetPos() = position;
    }
    
+   void CommandIntercept(const Body* target)
+   {
+      assert(target != NULL);
+      GetTargetBody() = target;
+      GetTargetPos() = target->GetPosition();
+      ChangeState(ST_INTERCEPT);
+   }
+   
+   void CommandFollowFlowField(const FlowField* field)
+   {
+      assert(field != NULL);
+      GetFlowField() = field;
+      GetTargetPos() = field->GetGoal();
+      ChangeState(ST_FOLLOW_FLOW);
+   }
+   
    void CommandIdle()
    {
       ChangeState(ST_IDLE);
@@ -369,8 +474,46 @@ public:
    
    virtual void Update()
    {
-      ExecuteState(_state);
-      NotifySpeed();
+      UpdateSteering();
+      UpdateNotifications();
+   }
+   
+   const Vec2& GetPosition()
+   {
+      return GetBody()->GetPosition();
+   }
+   
+   void UpdateSteering()
+   {
+      ExecuteState(GetState());
+   }
+   
+   void UpdateNotifications()
+   {
+      RecordTelemetry();
+   }
+   
+   void AttachTurnControllerBank(PIDControllerBank* bank)
+   {
+      assert(bank != NULL);
+      assert(_turnBank == NULL);
+      _turnBank = bank;
+      _turnBankIndex = bank->AddController();
+      // If already steering, restart the turn
+      // controller in the bank.
+      if(GetState() != ST_IDLE)
+      {
+         SetupTurnController();
+      }
+   }
+   
+   void ApplyBatchedTurnTorque()
+   {
+      if(_turnTorquePending)
+      {
+         ApplyTurnOutput(_turnBank->GetLastOutput(_turnBankIndex));
+         _turnTorquePending = false;
+      }
    }
    
 protected:
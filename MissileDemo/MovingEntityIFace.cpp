@@ -26,9 +26,21 @@
 
 
 #include "MovingEntityIFace.h"
+#include "EntityStateBuckets.h"
 
 
-MovingEntityIFace::MovingEntityIFace()
+MovingEntityIFace::MovingEntityIFace() :
+   _state(ST_IDLE),
+   _buckets(NULL),
+   _bucketState(ST_IDLE),
+   _bucketIndex(0),
+   _bucketMovePending(false),
+   _forceBuffer(NULL),
+   _targetBody(NULL),
+   _guidanceLaw(InterceptGuidance::GL_PN),
+   _navigationConstant(InterceptGuidance::DEFAULT_NAVIGATION_CONSTANT),
+   _avoidance(0,0),
+   _flowField(NULL)
 {
    SetMaxAngularAcceleration(2*M_PI);
    SetMaxLinearAcceleration(20);
@@ -39,4 +51,12 @@ MovingEntityIFace::MovingEntityIFace()
 MovingEntityIFace::~MovingEntityIFace()
 {
 	
-}
\ No newline at end of file
+}
+void MovingEntityIFace::SetState(STATE_T state)
+{
+   _state = state;
+   if(_buckets != NULL)
+   {
+      _buckets->StateChanged(this);
+   }
+}
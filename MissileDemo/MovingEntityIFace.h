@@ -35,28 +35,99 @@
  * via their interface.
  */
 
-#include "CommonProject.h"
+#include "CommonPhysics.h"
 #include "CommonSTL.h"
+#include "BodyForceBuffer.h"
+#include "Path.h"
+#include "InterceptGuidance.h"
+#include "SeparationSteering.h"
+
+class PIDControllerBank;
+class EntityStateBuckets;
+class FlowField;
 
 class MovingEntityIFace
 {
+public:
+   // The steering state machine states.
+   typedef enum
+   {
+      ST_IDLE,
+      ST_TURN_TOWARDS,
+      ST_SEEK,
+      ST_FOLLOW_PATH,
+      ST_INTERCEPT,
+      ST_FOLLOW_FLOW,
+      ST_MAX
+   } STATE_T;
+   
 private:
+   friend class EntityStateBuckets;
+   
+   STATE_T _state;
+   // The bucket this entity is in (see EntityStateBuckets).
+   // This lags behind _state until the buckets are
+   // reconciled.
+   EntityStateBuckets* _buckets;
+   STATE_T _bucketState;
+   uint32 _bucketIndex;
+   bool _bucketMovePending;
    Vec2 _targetPos;
    float32 _maxAngularAcceleration;
    float32 _maxLinearAcceleration;
    float32 _minSeekDistance;
    float32 _maxSpeed;
-   list<Vec2> _path;
+   PathCursor _pathCursor;
+   BodyForceBuffer* _forceBuffer;
+   // The body being intercepted (ST_INTERCEPT).
+   const Body* _targetBody;
+   InterceptGuidance::LAW_T _guidanceLaw;
+   float32 _navigationConstant;
+   // Steering away from the neighbors (see SetAvoidance(...)).
+   Vec2 _avoidance;
+   // The shared field for ST_FOLLOW_FLOW.
+   const FlowField* _flowField;
 protected:
    Vec2& GetTargetPos() { return _targetPos; }
-   list<Vec2>& GetPath() { return _path; }
+   // The point to steer for from position: the target
+   // position, bent by the avoidance.
+   inline Vec2 GetSteeringTarget(const Vec2& position)
+   {
+      return SeparationSteering::SteeringTarget(position,_targetPos,_avoidance);
+   }
+   const Body*& GetTargetBody() { return _targetBody; }
+   const FlowField*& GetFlowField() { return _flowField; }
+   PathCursor& GetPathCursor() { return _pathCursor; }
+   
+   // Records the new state and lets the buckets know.
+   void SetState(STATE_T state);
+   
+   // Use these instead of the Body functions so the
+   // forces go into the force buffer when there is one.
+   inline void ApplyForceToCenter(Body* body, const Vec2& force)
+   {
+      if(_forceBuffer != NULL)
+         _forceBuffer->AddForceToCenter(body,force);
+      else
+         body->ApplyForceToCenter(force);
+   }
+   
+   inline void ApplyTorque(Body* body, float32 torque)
+   {
+      if(_forceBuffer != NULL)
+         _forceBuffer->AddTorque(body,torque);
+      else
+         body->ApplyTorque(torque);
+   }
 
 public:
    MovingEntityIFace();
    
    virtual ~MovingEntityIFace();
    
-   virtual void CommandFollowPath(const list<Vec2> path) = 0;
+   // The entity keeps a reference to the path while it
+   // follows it; the caller can Release() its own.
+   virtual void CommandFollowPath(const Path* path) = 0;
    
    virtual void CommandTurnTowards(const Vec2& position) = 0;
    
@@ -64,10 +135,71 @@ public:
    
    virtual void SetTargetPosition(const Vec2& position) = 0;
    
+   // Fly into a moving body.  The entity goes idle when
+   // it gets within the minimum seek distance of it.  The
+   // body must outlive the command.
+   virtual void CommandIntercept(const Body* target) = 0;
+   
+   // Steer by the flow field to its goal, going idle
+   // within the minimum seek distance of it.  The field
+   // is shared, not copied; it must outlive the command
+   // and not change during UpdateSteering().
+   virtual void CommandFollowFlowField(const FlowField* field) = 0;
+   
    virtual void CommandIdle() = 0;
    
    virtual void Update() = 0;
    
+   /* Update() is the same as UpdateSteering() followed by
+    * UpdateNotifications().  The Simulation calls them
+    * separately so that UpdateSteering() can run on a
+    * worker thread.  It may only touch this entity, its
+    * body and its turn controller in the bank, and it
+    * must apply forces with ApplyForceToCenter(...) and
+    * ApplyTorque(...) above.  UpdateNotifications() is
+    * always called on the main thread.
+    */
+   virtual void UpdateSteering() = 0;
+   virtual void UpdateNotifications() = 0;
+   
+   inline STATE_T GetState() const { return _state; }
+   
+   // Where the entity is, for the neighbor queries.
+   virtual const Vec2& GetPosition() = 0;
+   
+   // The Simulation sets this each tick while it does
+   // separation steering (see SeparationSteering).
+   inline void SetAvoidance(const Vec2& avoidance) { _avoidance = avoidance; }
+   inline const Vec2& GetAvoidance() const { return _avoidance; }
+   
+   /* The per state parts of UpdateSteering().  The
+    * Simulation keeps the entities in buckets by state
+    * and calls the one for the bucket, so there is no
+    * switch on the state for each entity.  There is
+    * nothing to do for ST_IDLE.
+    */
+   virtual void ExecuteTurnTowards() = 0;
+   virtual void ExecuteSeek() = 0;
+   virtual void ExecuteFollowPath() = 0;
+   virtual void ExecuteIntercept() = 0;
+   virtual void ExecuteFollowFlow() = 0;
+   
+   // While set, forces and torques go into the buffer
+   // instead of being applied to the body.
+   inline void SetForceBuffer(BodyForceBuffer* forceBuffer) { _forceBuffer = forceBuffer; }
+   inline BodyForceBuffer* GetForceBuffer() { return _forceBuffer; }
+   
+   /* Batched turn control.  Once attached to a bank, the
+    * entity only posts its turn error to the bank during
+    * Update().  The owner evaluates the bank once for all
+    * the entities and then calls ApplyBatchedTurnTorque()
+    * on each entity to apply the result.
+    *
+    * The bank must outlive the entity.
+    */
+   virtual void AttachTurnControllerBank(PIDControllerBank* bank) = 0;
+   virtual void ApplyBatchedTurnTorque() = 0;
+   
    inline float32 GetMaxLinearAcceleration() { return _maxLinearAcceleration; }
    inline void SetMaxLinearAcceleration(float32 maxLinearAcceleration) { _maxLinearAcceleration = maxLinearAcceleration; }
    
@@ -80,6 +212,15 @@ public:
    inline float32 GetMaxSpeed() { return _maxSpeed; }
    inline void SetMaxSpeed(float32 maxSpeed) { _maxSpeed = maxSpeed; }
    
+   // The guidance law used for ST_INTERCEPT (see InterceptGuidance).
+   // GL_PN by default: it beats seek on straight, weaving and
+   // turning targets, where APN loses to seek on weaving ones.
+   inline InterceptGuidance::LAW_T GetGuidanceLaw() { return _guidanceLaw; }
+   inline void SetGuidanceLaw(InterceptGuidance::LAW_T guidanceLaw) { _guidanceLaw = guidanceLaw; }
+   
+   inline float32 GetNavigationConstant() { return _navigationConstant; }
+   inline void SetNavigationConstant(float32 navigationConstant) { _navigationConstant = navigationConstant; }
+   
 };
 
 #endif /* defined(__MovingEntityIFace__) */
@@ -25,15 +25,44 @@
  */
 
 #include "Notifier.h"
+#include "Profiler.h"
+#include <cstring>
 
 
 void Notifier::Reset()
 {
-   _notifiedMap.clear();
+   assert(NE_MAX <= 32);
+   // Anything still attached is not any more.
+   for(uint32 idx = 0; idx < _notifiedVector.size(); idx++)
+   {
+      NOTIFIED_VECTOR_T& notified = _notifiedVector[idx];
+      for(uint32 ndx = 0; ndx < notified.size(); ndx++)
+      {
+         if(notified[ndx] != NULL)
+         {
+            notified[ndx]->_notifierEvents = 0;
+         }
+      }
+   }
    _notifiedVector.clear();
    _notifiedVector.resize(NE_MAX);
-   _detached.clear();
+   _compactEvents = 0;
    _notifyDepth = 0;
+   ResetPosted();
+}
+
+void Notifier::ResetPosted()
+{
+   _posted.resize(POST_QUEUE_SIZE);
+   for(uint32 idx = 0; idx < _posted.size(); idx++)
+   {
+      _posted[idx].sequence = idx;
+   }
+   _postTail = 0;
+   _postHead = 0;
+   _postDropped = 0;
+   // Only the last message is ever shown.
+   _coalescedEvents = 1 << NE_DEBUG_MESSAGE;
 }
 
 void Notifier::Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType)
@@ -47,43 +76,24 @@ void Notifier::Attach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType)
       throw std::out_of_range("eventType out of range");
    }
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter == _notifiedMap.end())
-   {  // Registering for the first time.
-      NOTIFIED_EVENT_TYPE_VECTOR_T eventTypes;
-      eventTypes.push_back(eventType);
-      // Register it with this observer.
-      _notifiedMap[observer] = eventTypes;
-      // Register the observer for this type of event.
-      _notifiedVector[eventType].push_back(observer);
-   }
-   else
+   uint32 eventBit = 1 << eventType;
+   if((observer->_notifierEvents & eventBit) == 0)
    {
-      NOTIFIED_EVENT_TYPE_VECTOR_T& events = _mapIter->second;
-      bool found = false;
-      for(int idx = 0; idx < events.size() && !found; idx++)
-      {
-         if(events[idx] == eventType)
-         {
-            found = true;
-            break;
-         }
-      }
-      if(!found)
-      {
-         events.push_back(eventType);
-         _notifiedVector[eventType].push_back(observer);
-      }      
+      observer->_notifierEvents |= eventBit;
+      // If a Notify(...) is running, this observer will get
+      // the next one.
+      _notifiedVector[eventType].push_back(observer);
    }
 }
 
-void Notifier::RemoveEvent(NOTIFIED_EVENT_TYPE_VECTOR_T& eventTypes, NOTIFIED_EVENT_TYPE_T eventType)
+void Notifier::RemoveNotified(NOTIFIED_EVENT_TYPE_T eventType, Notified* observer)
 {
+   NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
    int foundAt = -1;
    
-   for(int idx = 0; idx < eventTypes.size(); idx++)
+   for(uint32 idx = 0; idx < notified.size(); idx++)
    {
-      if(eventTypes[idx] == eventType)
+      if(notified[idx] == observer)
       {
          foundAt = idx;
          break;
@@ -91,26 +101,30 @@ void Notifier::RemoveEvent(NOTIFIED_EVENT_TYPE_VECTOR_T& eventTypes, NOTIFIED_EV
    }
    if(foundAt >= 0)
    {
-      eventTypes.erase(eventTypes.begin()+foundAt);
+      if(_notifyDepth > 0)
+      {  // Someone is looping over this list.
+         notified[foundAt] = NULL;
+         _compactEvents |= 1 << eventType;
+      }
+      else
+      {
+         notified.erase(notified.begin()+foundAt);
+      }
    }
 }
 
-void Notifier::RemoveNotified(NOTIFIED_VECTOR_T& notified, Notified* observer)
+void Notifier::CompactNotified()
 {
-   int foundAt = -1;
-   
-   for(int idx = 0; idx < notified.size(); idx++)
+   for(int idx = NE_MIN; idx < NE_MAX && _compactEvents != 0; idx++)
    {
-      if(notified[idx] == observer)
+      uint32 eventBit = 1 << idx;
+      if(_compactEvents & eventBit)
       {
-         foundAt = idx;
-         break;
+         NOTIFIED_VECTOR_T& notified = _notifiedVector[idx];
+         notified.erase(std::remove(notified.begin(),notified.end(),(Notified*)NULL),notified.end());
+         _compactEvents &= ~eventBit;
       }
    }
-   if(foundAt >= 0)
-   {
-      notified.erase(notified.begin()+foundAt);
-   }
 }
 
 
@@ -125,21 +139,11 @@ void Notifier::Detach(Notified* observer, NOTIFIED_EVENT_TYPE_T eventType)
       throw std::out_of_range("eventType out of range");
    }
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter != _notifiedMap.end())
+   uint32 eventBit = 1 << eventType;
+   if(observer->_notifierEvents & eventBit)
    {  // Was registered
-      // Remove it from the map.
-      RemoveEvent(_mapIter->second, eventType);
-      // Remove it from the vector
-      RemoveNotified(_notifiedVector[eventType], observer);
-      // If there are no events left, remove this observer completely.
-      if(_mapIter->second.size() == 0)
-      {
-         _notifiedMap.erase(_mapIter);
-         // If this observer was being removed during a chain of operations,
-         // cache them temporarily so we know the pointer is "dead".
-         _detached.push_back(observer);
-      }
+      observer->_notifierEvents &= ~eventBit;
+      RemoveNotified(eventType, observer);
    }
 }
 
@@ -150,82 +154,155 @@ void Notifier::Detach(Notified* observer)
       throw std::out_of_range("observer == NULL");
    }
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter != _notifiedMap.end())
-   {
-      // These are all the event types this observer was registered for.
-      NOTIFIED_EVENT_TYPE_VECTOR_T& eventTypes = _mapIter->second;
-      for(int idx = 0; idx < eventTypes.size();idx++)
-      {  
-         NOTIFIED_EVENT_TYPE_T eventType = eventTypes[idx];
-         // Remove this observer from the Notified list for this event type.
-         RemoveNotified(_notifiedVector[eventType], observer);
+   for(int idx = NE_MIN; idx < NE_MAX && observer->_notifierEvents != 0; idx++)
+   {
+      uint32 eventBit = 1 << idx;
+      if(observer->_notifierEvents & eventBit)
+      {
+         observer->_notifierEvents &= ~eventBit;
+         RemoveNotified((NOTIFIED_EVENT_TYPE_T)idx, observer);
       }
-      _notifiedMap.erase(_mapIter);
    }
-   // If this observer was being removed during a chain of operations,
-   // cache them temporarily so we know the pointer is "dead".
-   _detached.push_back(observer);
 }
 
 
 
 void Notifier::Notify(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData)
 {
+   PROFILE_ZONE("Notifier::Notify");
    
    if(eventType < NE_MIN || eventType >= NE_MAX)
    {
       throw std::out_of_range("eventType out of range");
    }
    
-   // Keep a copy of the list.  If it changes while iterating over it because of a
-   // deletion, we may miss an object to update.  Instead, we keep track of Detach(...)
-   // calls during the Notify(...) cycle and ignore anything detached because it may
-   // have been deleted.
-   NOTIFIED_VECTOR_T notified = _notifiedVector[eventType];
-
    // If a call to Notify leads to a call to Notify, we need to keep track of
-   // the depth so that we can clear the detached list when we get to the end
+   // the depth so that we can clean up the lists when we get to the end
    // of the chain of Notify calls.
    _notifyDepth++;
 
-   // Loop over all the observers for this event.
-   // NOTE that the the size of the notified vector may change if
-   // a call to Notify(...) adds/removes observers.  This should not be a
-   // problem because the list is a simple vector.
-   for(int idx = 0; idx < notified.size(); idx++)
+   // Observers that attach during this call are added to the end of
+   // the list; they are not notified until the next call.  The
+   // list may grow (and move), so index it every time.
+   const NOTIFIED_VECTOR_T& notified = _notifiedVector[eventType];
+   const int count = notified.size();
+   for(int idx = 0; idx < count; idx++)
    {
       Notified* observer = notified[idx];
-      if(_detached.size() > 0)
-      {  // Instead of doing the search for all cases, let's try to speed it up a little
-         // by only doing the search if more than one observer dropped off during the call.
-         // This may be overkill or unnecessary optimization.
-         switch(_detached.size())
-         {
-            case 0:
-               break;
-            case 1:
-               if(_detached[0] == observer)
-                  continue;
-               break;
-            default:
-               if(std::find(_detached.begin(), _detached.end(), observer) != _detached.end())
-                  continue;
-               break;
-         }
+      if(observer != NULL)
+      {
+         observer->Notify(eventType,eventData);
       }
-      observer->Notify(eventType,eventData);
    }
    // Decrement this each time we exit.
    _notifyDepth--;
-   if(_notifyDepth == 0 && _detached.size() > 0)
-   {  // We reached the end of the Notify call chain.  Remove the temporary list
-      // of anything that detached while we were Notifying.
-      _detached.clear();
+   if(_notifyDepth == 0 && _compactEvents != 0)
+   {  // We reached the end of the Notify call chain.  Remove anything
+      // that detached while we were Notifying.
+      CompactNotified();
    }
    assert(_notifyDepth >= 0);
 }
 
+bool Notifier::Post(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData, uint32 dataSize)
+{
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   if(dataSize > POST_DATA_SIZE)
+   {
+      throw std::out_of_range("dataSize > POST_DATA_SIZE");
+   }
+   assert(!_posted.empty());
+   
+   const uint32 mask = POST_QUEUE_SIZE-1;
+   uint32 position = __atomic_load_n(&_postTail,__ATOMIC_RELAXED);
+   POSTED_EVENT_T* posted = NULL;
+   for(;;)
+   {
+      posted = &_posted[position & mask];
+      uint32 sequence = __atomic_load_n(&posted->sequence,__ATOMIC_ACQUIRE);
+      int32 diff = (int32)(sequence - position);
+      if(diff == 0)
+      {  // Free; try to claim it.
+         if(__sync_bool_compare_and_swap(&_postTail,position,position+1))
+            break;
+      }
+      else if(diff < 0)
+      {  // The consumer has not freed this one yet.
+         __sync_fetch_and_add(&_postDropped,1);
+         return false;
+      }
+      position = __atomic_load_n(&_postTail,__ATOMIC_RELAXED);
+   }
+   
+   posted->eventType = eventType;
+   if(dataSize > 0)
+   {
+      memcpy(posted->data,eventData,dataSize);
+      posted->eventData = posted->data;
+   }
+   else
+   {
+      posted->eventData = eventData;
+   }
+   // Publish it.
+   __atomic_store_n(&posted->sequence,position+1,__ATOMIC_RELEASE);
+   return true;
+}
+
+void Notifier::DispatchPosted()
+{
+   PROFILE_ZONE("Notifier::DispatchPosted");
+   assert(POST_QUEUE_SIZE > 0 && (POST_QUEUE_SIZE & (POST_QUEUE_SIZE-1)) == 0);
+   const uint32 mask = POST_QUEUE_SIZE-1;
+   
+   // Find the events that are ready.  Anything posted after
+   // this goes out next time.
+   uint32 count = 0;
+   uint32 lastPosted[NE_MAX];
+   for(; count < POST_QUEUE_SIZE; count++)
+   {
+      uint32 position = _postHead+count;
+      const POSTED_EVENT_T& posted = _posted[position & mask];
+      if(__atomic_load_n(&posted.sequence,__ATOMIC_ACQUIRE) != position+1)
+         break;
+      lastPosted[posted.eventType] = count;
+   }
+   
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      uint32 position = _postHead+idx;
+      POSTED_EVENT_T& posted = _posted[position & mask];
+      NOTIFIED_EVENT_TYPE_T eventType = posted.eventType;
+      if(!IsCoalesced(eventType) || lastPosted[eventType] == idx)
+      {
+         Notify(eventType,posted.eventData);
+      }
+   }
+   
+   // Hand the slots back to the producers.
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      uint32 position = _postHead+idx;
+      __atomic_store_n(&_posted[position & mask].sequence,position+POST_QUEUE_SIZE,__ATOMIC_RELEASE);
+   }
+   _postHead += count;
+}
+
+void Notifier::SetCoalesced(NOTIFIED_EVENT_TYPE_T eventType, bool coalesced)
+{
+   if(eventType < NE_MIN || eventType >= NE_MAX)
+   {
+      throw std::out_of_range("eventType out of range");
+   }
+   if(coalesced)
+      _coalescedEvents |= 1 << eventType;
+   else
+      _coalescedEvents &= ~(1 << eventType);
+}
+
 Notified::~Notified()
 {
    Notifier::Instance().Detach(this);
@@ -236,11 +313,12 @@ vector<Notifier::NOTIFIED_EVENT_TYPE_T> Notifier::GetEvents(Notified* observer)
 {
    vector<Notifier::NOTIFIED_EVENT_TYPE_T> result;
    
-   _mapIter = _notifiedMap.find(observer);
-   if(_mapIter != _notifiedMap.end())
+   for(int idx = NE_MIN; idx < NE_MAX; idx++)
    {
-      // These are all the event types this observer was registered for.
-      result = _mapIter->second;
+      if(observer->_notifierEvents & (1 << idx))
+      {
+         result.push_back((NOTIFIED_EVENT_TYPE_T)idx);
+      }
    }
 
    return result;
@@ -249,6 +327,15 @@ vector<Notifier::NOTIFIED_EVENT_TYPE_T> Notifier::GetEvents(Notified* observer)
 // Return all objects registered for this event.
 vector<Notified*> Notifier::GetNotified(NOTIFIED_EVENT_TYPE_T event)
 {
-   return _notifiedVector[event];
+   vector<Notified*> result;
+   const NOTIFIED_VECTOR_T& notified = _notifiedVector[event];
+   for(uint32 idx = 0; idx < notified.size(); idx++)
+   {
+      if(notified[idx] != NULL)
+      {
+         result.push_back(notified[idx]);
+      }
+   }
+   return result;
 }
 
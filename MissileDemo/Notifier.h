@@ -57,10 +57,16 @@
  dictionary keyed lookup mechanism.  Some loss of generality is implied 
  by this.
  
- This class/system is NOT thread safe, but could be made so with some
- mutex wrappers.  It is safe to call Attach/Detach as a consequence 
+ Attach/Detach/Notify are NOT thread safe; call them from the main
+ thread.  It is safe to call Attach/Detach as a consequence 
  of calling Notify(...).  
  
+ Any thread may Post(...) an event instead.  Posted events go into a
+ fixed size lock-free queue and are sent, in the order they were
+ posted, when the main thread calls DispatchPosted() (once a frame).
+ Events marked with SetCoalesced(...) are only sent once per
+ DispatchPosted(), with the data of the last one posted.
+ 
  */
 
 
@@ -82,28 +88,56 @@ public:
    } NOTIFIED_EVENT_TYPE_T;
    
 private:
-   typedef vector<NOTIFIED_EVENT_TYPE_T> NOTIFIED_EVENT_TYPE_VECTOR_T;
-   
-   typedef map<Notified*,NOTIFIED_EVENT_TYPE_VECTOR_T> NOTIFIED_MAP_T;
-   typedef map<Notified*,NOTIFIED_EVENT_TYPE_VECTOR_T>::iterator NOTIFIED_MAP_ITER_T;
-   
    typedef vector<Notified*> NOTIFIED_VECTOR_T;
    typedef vector<NOTIFIED_VECTOR_T> NOTIFIED_VECTOR_VECTOR_T;
    
-   NOTIFIED_MAP_T _notifiedMap;
+   // The observers for each event, in the order they attached.
    NOTIFIED_VECTOR_VECTOR_T _notifiedVector;
-   NOTIFIED_MAP_ITER_T _mapIter;
 
-   // This vector keeps a temporary list of observers that have completely
-   // detached since the current "Notify(...)" operation began.  This is
-   // to handle the problem where a Notified instance has called Detach(...)
-   // because of a Notify(...) call.  The removed instance could be a dead
-   // pointer, so don't try to talk to it.
-   vector<Notified*> _detached;
+   // Notify(...) walks the observer list in place, without a copy.
+   // While any Notify(...) is running, Detach(...) only sets the
+   // observer's slot to NULL, so nothing moves under the loop and a
+   // detached (maybe deleted) observer is never called.  The NULL
+   // slots are removed when the outermost Notify(...) returns.
+   //
+   // Bit N is set when the list for event N has NULL slots.
+   uint32 _compactEvents;
    int32 _notifyDepth;
    
-   void RemoveEvent(NOTIFIED_EVENT_TYPE_VECTOR_T& orgEventTypes, NOTIFIED_EVENT_TYPE_T eventType);
-   void RemoveNotified(NOTIFIED_VECTOR_T& orgNotified, Notified* observer);
+   void RemoveNotified(NOTIFIED_EVENT_TYPE_T eventType, Notified* observer);
+   void CompactNotified();
+   
+public:
+   enum
+   {
+      // Posted events waiting to be dispatched.  Post(...) fails
+      // when this many are waiting.
+      POST_QUEUE_SIZE = 256,
+      // The most event data that Post(...) can copy.
+      POST_DATA_SIZE = 128,
+   };
+   
+private:
+   // A bounded multi-producer queue (one slot per event,
+   // claimed with a compare-and-swap).  The sequence number
+   // of a slot says whether it is free for the producer at
+   // that position or full for the consumer.
+   typedef struct
+   {
+      uint32 sequence;
+      NOTIFIED_EVENT_TYPE_T eventType;
+      const void* eventData;
+      uint64 data[POST_DATA_SIZE/sizeof(uint64)];
+   } POSTED_EVENT_T;
+   
+   vector<POSTED_EVENT_T> _posted;
+   uint32 _postTail;
+   uint32 _postHead;
+   uint32 _postDropped;
+   // Bit N is set when event N is coalesced.
+   uint32 _coalescedEvents;
+   
+   void ResetPosted();
    
 public:
    
@@ -127,6 +161,27 @@ public:
     */
    void Notify(NOTIFIED_EVENT_TYPE_T, const void* eventData = NULL);
    
+   /* Thread safe, lock free.  Queue the event to be sent by the
+    * next DispatchPosted().
+    *
+    * If dataSize is 0, the eventData pointer is sent as is and must
+    * still be good at dispatch time (or just be a value, as in
+    * NE_DEBUG_BUTTON_PRESSED).  Otherwise dataSize bytes (up to
+    * POST_DATA_SIZE) are copied and the observers get a pointer to
+    * the copy.
+    *
+    * Returns false (and counts it) if the queue is full.
+    */
+   bool Post(NOTIFIED_EVENT_TYPE_T eventType, const void* eventData = NULL, uint32 dataSize = 0);
+   // Main thread only.  Sends everything posted so far.  Events
+   // posted by the observers go out with the next call.
+   void DispatchPosted();
+   // Number of Post(...) calls that failed since the last Reset().
+   uint32 GetPostDroppedCount() const { return __atomic_load_n(&_postDropped,__ATOMIC_RELAXED); }
+   // Main thread only.
+   void SetCoalesced(NOTIFIED_EVENT_TYPE_T eventType, bool coalesced);
+   bool IsCoalesced(NOTIFIED_EVENT_TYPE_T eventType) const { return (_coalescedEvents & (1 << eventType)) != 0; }
+   
    /* Used for CPPUnit.  Could create a Mock...maybe...but this seems
     * like it will get the job done with minimal fuss.  For now.
     */
@@ -140,7 +195,12 @@ public:
  */
 class Notified
 {
+private:
+   friend class Notifier;
+   // Bit N is set when this is attached for event N.
+   uint32 _notifierEvents;
 public:
+   Notified() : _notifierEvents(0) { }
    virtual void Notify(Notifier::NOTIFIED_EVENT_TYPE_T eventType, const void* eventData) = 0;
    virtual ~Notified();
 
@@ -36,10 +36,35 @@
  * to driving the state of a measured value
  * towards an expected value.
  *
+ * The error history is kept in a fixed size ring
+ * buffer (no allocations after construction) and
+ * only the last output is kept.  AddSample(...) is
+ * O(1):  the Extended Simpson's Rule integral over
+ * the history is built from two running sums, one
+ * for the samples at even positions in the window
+ * and one for the odd positions.  Sliding the window
+ * swaps which sum is "even" instead of reweighting
+ * every sample.
+ *
+ * Tolerance:  The running sums are rebuilt from the
+ * ring buffer every time it has been completely
+ * refilled, so the rounding error cannot build up.
+ * The integral term differs from a full recompute
+ * (CalculateSimpsonSum()) by at most a few ulps of
+ * the sum of |error| over the window (relative
+ * difference < 1.0E-12).  The proportional and
+ * derivative terms are computed exactly as before.
  */
 
 class PIDController
 {
+public:
+   enum
+   {
+      MIN_SAMPLES = 3,
+      MAX_HISTORY_CAPACITY = 32
+   };
+   
 private:
    double _dt;
    uint32 _maxHistory;
@@ -47,14 +72,26 @@ private:
    double _kProportional;
    double _kDerivative;
    double _kPlant;
-   vector<double> _errors;
-   vector<double> _outputs;
    
-   enum
-   {
-      MIN_SAMPLES = 3
-   };
+   // Ring buffer of the errors.  _first is the index of
+   // the oldest sample and _count is the number of samples.
+   double _errors[MAX_HISTORY_CAPACITY];
+   uint32 _first;
+   uint32 _count;
+   // Running sums of the samples, split by the parity of
+   // their position in the stream.  _firstParity is the
+   // parity of the oldest sample, so the samples at even
+   // positions in the window are in _paritySum[_firstParity].
+   double _paritySum[2];
+   uint32 _firstParity;
+   // Samples added since the sums were rebuilt.
+   uint32 _samplesSinceRebuild;
+   double _lastOutput;
    
+   inline double GetError(uint32 position) const
+   {
+      return _errors[(_first + position) % MAX_HISTORY_CAPACITY];
+   }
    
    /* Given two sample outputs and 
     * the corresponding inputs, make 
@@ -81,53 +118,88 @@ private:
       return result;
    }
    
+   // Drop the oldest sample.
+   void RemoveOldest()
+   {
+      assert(_count > 0);
+      _paritySum[_firstParity] -= _errors[_first];
+      _first = (_first + 1) % MAX_HISTORY_CAPACITY;
+      _firstParity ^= 1;
+      _count--;
+   }
+   
+   // Rebuild the running sums from the ring buffer.
+   void RebuildSums()
+   {
+      _paritySum[0] = 0.0;
+      _paritySum[1] = 0.0;
+      for(uint32 pos = 0; pos < _count; pos++)
+      {
+         _paritySum[_firstParity ^ (pos & 1)] += GetError(pos);
+      }
+      _samplesSinceRebuild = 0;
+   }
+   
+   /* Extended Simpson's Rule weights (1,4,2,4,...,2,4,1)
+    * applied to the window, from the running sums.
+    */
+   double CalculateSimpsonSumFast() const
+   {
+      double first = GetError(0);
+      double last = GetError(_count-1);
+      double oddSum = _paritySum[_firstParity ^ 1];
+      double evenSum = _paritySum[_firstParity] - first;
+      // The last sample only gets a weight of 1.
+      if((_count-1) & 1)
+      {
+         oddSum -= last;
+      }
+      else
+      {
+         evenSum -= last;
+      }
+      return first + last + 4*oddSum + 2*evenSum;
+   }
+   
    /* This funciton is called whenever
     * a new input record is added.
     */
    void CalculateNextOutput()
    {
-      if(_errors.size() < MIN_SAMPLES)
+      if(_count < MIN_SAMPLES)
       {  // We need a certain number of samples
          // before we can do ANYTHING at all.
-         _outputs.push_back(0.0);
+         _lastOutput = 0.0;
       }
       else
       {  // Estimate each part.
-         size_t errorSize = _errors.size();
+         double lastError = GetError(_count-1);
          // Proportional
-         double prop = _kProportional * _errors[errorSize-1];
+         double prop = _kProportional * lastError;
          
-          // Integral - Use Extended Simpson's Rule
-          double integral = 0;
-          for(uint32 idx = 1; idx < errorSize-1; idx+=2)
-          {
-          integral += 4*_errors[idx];
-          }
-          for(uint32 idx = 2; idx < errorSize-1; idx+=2)
-          {
-          integral += 2*_errors[idx];
-          }
-          integral += _errors[0];
-          integral += _errors[errorSize-1];
-          integral /= (3*_dt);
-          integral *= _kIntegral;
+         // Integral - Use Extended Simpson's Rule
+         double integral = CalculateSimpsonSumFast();
+         integral /= (3*_dt);
+         integral *= _kIntegral;
          
          // Derivative
-         double deriv = _kDerivative * (_errors[errorSize-1]-_errors[errorSize-2]) / _dt;
+         double deriv = _kDerivative * (lastError-GetError(_count-2)) / _dt;
          
          // Total P+I+D
-         double result = _kPlant * (prop + integral + deriv);
-         
-         _outputs.push_back(result);
-         
+         _lastOutput = _kPlant * (prop + integral + deriv);
       }
    }
    
 public:
    void ResetHistory()
    {
-      _errors.clear();
-      _outputs.clear();
+      _first = 0;
+      _count = 0;
+      _firstParity = 0;
+      _paritySum[0] = 0.0;
+      _paritySum[1] = 0.0;
+      _samplesSinceRebuild = 0;
+      _lastOutput = 0.0;
    }
    
    void ResetConstants()
@@ -157,26 +229,64 @@ public:
    double GetKPlant() { return _kPlant; }
    void SetTimeStep(double dt) { _dt = dt; assert(_dt > 100*numeric_limits<double>::epsilon());}
    double GetTimeStep() { return _dt; }
-   void SetMaxHistory(uint32 maxHistory) { _maxHistory = maxHistory; assert(_maxHistory >= MIN_SAMPLES); }
+   void SetMaxHistory(uint32 maxHistory)
+   {
+      _maxHistory = maxHistory;
+      assert(_maxHistory >= MIN_SAMPLES);
+      assert(_maxHistory <= MAX_HISTORY_CAPACITY);
+      while(_count > _maxHistory)
+      {
+         RemoveOldest();
+      }
+   }
    uint32 GetMaxHistory() { return _maxHistory; }
    
    void AddSample(double error)
    {
-      _errors.push_back(error);
-      while(_errors.size() > _maxHistory)
-      {  // If we got too big, remove the history.
-         // NOTE:  This is not terribly efficient.  We
-         // could keep all this in a fixed size array
-         // and then do the math using the offset from
-         // the beginning and module math.  But this
-         // gets complicated fast.  KISS.
-         _errors.erase(_errors.begin());
+      if(_count == _maxHistory)
+      {  // Full; the new sample replaces the oldest.
+         RemoveOldest();
+      }
+      uint32 parity = _firstParity ^ (_count & 1);
+      _errors[(_first + _count) % MAX_HISTORY_CAPACITY] = error;
+      _paritySum[parity] += error;
+      _count++;
+      
+      // Keep the rounding error from building up.
+      _samplesSinceRebuild++;
+      if(_samplesSinceRebuild >= _maxHistory)
+      {
+         RebuildSums();
       }
       CalculateNextOutput();
    }
    
-   double GetLastError() { size_t es = _errors.size(); if(es == 0) return 0.0; return _errors[es-1]; }
-   double GetLastOutput() { size_t os = _outputs.size(); if(os == 0) return 0.0; return _outputs[os-1]; }
+   /* The Extended Simpson's Rule sum over the whole
+    * history, computed the long way.  This is the
+    * reference the running sums are checked against.
+    */
+   double CalculateSimpsonSum() const
+   {
+      if(_count < MIN_SAMPLES)
+      {
+         return 0.0;
+      }
+      double integral = 0;
+      for(uint32 idx = 1; idx < _count-1; idx+=2)
+      {
+         integral += 4*GetError(idx);
+      }
+      for(uint32 idx = 2; idx < _count-1; idx+=2)
+      {
+         integral += 2*GetError(idx);
+      }
+      integral += GetError(0);
+      integral += GetError(_count-1);
+      return integral;
+   }
+   
+   double GetLastError() { if(_count == 0) return 0.0; return GetError(_count-1); }
+   double GetLastOutput() { return _lastOutput; }
    
 	virtual ~PIDController()
    {
@@ -0,0 +1,311 @@
+/********************************************************************
+ * File   : PIDControllerBank.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/8/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "PIDControllerBank.h"
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+PIDControllerBank::PIDControllerBank() :
+   _dt(1.0/100),
+   _maxHistory(7),
+   _kernel(KT_SIMD)
+{
+}
+
+void PIDControllerBank::Init(uint32 maxHistory, double dt)
+{
+   assert(maxHistory >= MIN_SAMPLES);
+   assert(dt > 100*numeric_limits<double>::epsilon());
+   Reset();
+   _maxHistory = maxHistory;
+   _dt = dt;
+}
+
+void PIDControllerBank::Reset()
+{
+   _kProportional.clear();
+   _kIntegral.clear();
+   _kDerivative.clear();
+   _kPlant.clear();
+   _history.clear();
+   _first.clear();
+   _count.clear();
+   _samplesSinceRebuild.clear();
+   _firstError.clear();
+   _lastError.clear();
+   _prevError.clear();
+   _evenSum.clear();
+   _oddSum.clear();
+   _lastIsEven.clear();
+   _ready.clear();
+   _outputs.clear();
+}
+
+void PIDControllerBank::Reserve(uint32 count)
+{
+   _kProportional.reserve(count);
+   _kIntegral.reserve(count);
+   _kDerivative.reserve(count);
+   _kPlant.reserve(count);
+   _history.reserve(count*_maxHistory);
+   _first.reserve(count);
+   _count.reserve(count);
+   _samplesSinceRebuild.reserve(count);
+   _firstError.reserve(count);
+   _lastError.reserve(count);
+   _prevError.reserve(count);
+   _evenSum.reserve(count);
+   _oddSum.reserve(count);
+   _lastIsEven.reserve(count);
+   _ready.reserve(count);
+   _outputs.reserve(count);
+}
+
+uint32 PIDControllerBank::AddController()
+{
+   // Same defaults as PIDController::ResetConstants().
+   _kProportional.push_back(0.0);
+   _kIntegral.push_back(0.0);
+   _kDerivative.push_back(0.0);
+   _kPlant.push_back(1.0);
+   _history.resize(_history.size()+_maxHistory,0.0);
+   _first.push_back(0);
+   _count.push_back(0);
+   _samplesSinceRebuild.push_back(0);
+   _firstError.push_back(0.0);
+   _lastError.push_back(0.0);
+   _prevError.push_back(0.0);
+   _evenSum.push_back(0.0);
+   _oddSum.push_back(0.0);
+   _lastIsEven.push_back(0.0);
+   _ready.push_back(0.0);
+   _outputs.push_back(0.0);
+   return _outputs.size()-1;
+}
+
+void PIDControllerBank::RemoveController(uint32 idx)
+{
+   assert(idx < GetCount());
+   uint32 last = GetCount()-1;
+   
+   _kProportional[idx] = _kProportional[last];
+   _kIntegral[idx] = _kIntegral[last];
+   _kDerivative[idx] = _kDerivative[last];
+   _kPlant[idx] = _kPlant[last];
+   for(uint32 hdx = 0; hdx < _maxHistory; hdx++)
+   {
+      _history[idx*_maxHistory+hdx] = _history[last*_maxHistory+hdx];
+   }
+   _first[idx] = _first[last];
+   _count[idx] = _count[last];
+   _samplesSinceRebuild[idx] = _samplesSinceRebuild[last];
+   _firstError[idx] = _firstError[last];
+   _lastError[idx] = _lastError[last];
+   _prevError[idx] = _prevError[last];
+   _evenSum[idx] = _evenSum[last];
+   _oddSum[idx] = _oddSum[last];
+   _lastIsEven[idx] = _lastIsEven[last];
+   _ready[idx] = _ready[last];
+   _outputs[idx] = _outputs[last];
+   
+   _kProportional.pop_back();
+   _kIntegral.pop_back();
+   _kDerivative.pop_back();
+   _kPlant.pop_back();
+   _history.resize(_history.size()-_maxHistory);
+   _first.pop_back();
+   _count.pop_back();
+   _samplesSinceRebuild.pop_back();
+   _firstError.pop_back();
+   _lastError.pop_back();
+   _prevError.pop_back();
+   _evenSum.pop_back();
+   _oddSum.pop_back();
+   _lastIsEven.pop_back();
+   _ready.pop_back();
+   _outputs.pop_back();
+}
+
+const char* PIDControllerBank::GetSIMDName()
+{
+#if defined(__AVX__)
+   return "AVX";
+#elif defined(__SSE2__)
+   return "SSE2";
+#else
+   return "None";
+#endif
+}
+
+void PIDControllerBank::ResetHistory(uint32 idx)
+{
+   _first[idx] = 0;
+   _count[idx] = 0;
+   _samplesSinceRebuild[idx] = 0;
+   _firstError[idx] = 0.0;
+   _lastError[idx] = 0.0;
+   _prevError[idx] = 0.0;
+   _evenSum[idx] = 0.0;
+   _oddSum[idx] = 0.0;
+   _lastIsEven[idx] = 0.0;
+   _ready[idx] = 0.0;
+   _outputs[idx] = 0.0;
+}
+
+void PIDControllerBank::RebuildSums(uint32 idx)
+{
+   const double* ring = &_history[idx*_maxHistory];
+   uint32 slot = _first[idx];
+   double sums[2] = { 0.0, 0.0 };
+   for(uint32 pos = 0; pos < _count[idx]; pos++)
+   {
+      sums[pos & 1] += ring[slot];
+      slot++;
+      if(slot == _maxHistory)
+         slot = 0;
+   }
+   _evenSum[idx] = sums[0];
+   _oddSum[idx] = sums[1];
+   _samplesSinceRebuild[idx] = 0;
+}
+
+/* The kernels below all do the same calculation, in the
+ * same order, as PIDController::CalculateNextOutput().
+ */
+void PIDControllerBank::EvaluateScalar(uint32 start, uint32 end)
+{
+   const double threeDt = 3*_dt;
+   for(uint32 idx = start; idx < end; idx++)
+   {
+      double first = _firstError[idx];
+      double last = _lastError[idx];
+      double lastIsEven = _lastIsEven[idx];
+      // The first and last samples only get a weight of 1.
+      double evenSum = (_evenSum[idx] - first) - lastIsEven*last;
+      double oddSum = _oddSum[idx] - (1.0-lastIsEven)*last;
+      
+      double prop = _kProportional[idx] * last;
+      double integral = first + last + 4*oddSum + 2*evenSum;
+      integral /= threeDt;
+      integral *= _kIntegral[idx];
+      double deriv = _kDerivative[idx] * (last-_prevError[idx]) / _dt;
+      
+      _outputs[idx] = _ready[idx] * (_kPlant[idx] * (prop + integral + deriv));
+   }
+}
+
+/* Returns the number of controllers calculated; the
+ * scalar kernel finishes the rest.
+ */
+uint32 PIDControllerBank::EvaluateSIMD()
+{
+   const uint32 count = GetCount();
+#if defined(__AVX__)
+   const __m256d threeDt = _mm256_set1_pd(3*_dt);
+   const __m256d dt = _mm256_set1_pd(_dt);
+   const __m256d one = _mm256_set1_pd(1.0);
+   const __m256d two = _mm256_set1_pd(2.0);
+   const __m256d four = _mm256_set1_pd(4.0);
+   uint32 idx = 0;
+   for(; idx + 4 <= count; idx += 4)
+   {
+      __m256d first = _mm256_loadu_pd(&_firstError[idx]);
+      __m256d last = _mm256_loadu_pd(&_lastError[idx]);
+      __m256d lastIsEven = _mm256_loadu_pd(&_lastIsEven[idx]);
+      __m256d evenSum = _mm256_sub_pd(_mm256_sub_pd(_mm256_loadu_pd(&_evenSum[idx]),first),
+                                      _mm256_mul_pd(lastIsEven,last));
+      __m256d oddSum = _mm256_sub_pd(_mm256_loadu_pd(&_oddSum[idx]),
+                                     _mm256_mul_pd(_mm256_sub_pd(one,lastIsEven),last));
+      
+      __m256d prop = _mm256_mul_pd(_mm256_loadu_pd(&_kProportional[idx]),last);
+      __m256d integral = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(first,last),
+                                                     _mm256_mul_pd(four,oddSum)),
+                                       _mm256_mul_pd(two,evenSum));
+      integral = _mm256_div_pd(integral,threeDt);
+      integral = _mm256_mul_pd(integral,_mm256_loadu_pd(&_kIntegral[idx]));
+      __m256d deriv = _mm256_mul_pd(_mm256_loadu_pd(&_kDerivative[idx]),
+                                    _mm256_sub_pd(last,_mm256_loadu_pd(&_prevError[idx])));
+      deriv = _mm256_div_pd(deriv,dt);
+      
+      __m256d result = _mm256_add_pd(_mm256_add_pd(prop,integral),deriv);
+      result = _mm256_mul_pd(_mm256_loadu_pd(&_kPlant[idx]),result);
+      result = _mm256_mul_pd(_mm256_loadu_pd(&_ready[idx]),result);
+      _mm256_storeu_pd(&_outputs[idx],result);
+   }
+   return idx;
+#elif defined(__SSE2__)
+   const __m128d threeDt = _mm_set1_pd(3*_dt);
+   const __m128d dt = _mm_set1_pd(_dt);
+   const __m128d one = _mm_set1_pd(1.0);
+   const __m128d two = _mm_set1_pd(2.0);
+   const __m128d four = _mm_set1_pd(4.0);
+   uint32 idx = 0;
+   for(; idx + 2 <= count; idx += 2)
+   {
+      __m128d first = _mm_loadu_pd(&_firstError[idx]);
+      __m128d last = _mm_loadu_pd(&_lastError[idx]);
+      __m128d lastIsEven = _mm_loadu_pd(&_lastIsEven[idx]);
+      __m128d evenSum = _mm_sub_pd(_mm_sub_pd(_mm_loadu_pd(&_evenSum[idx]),first),
+                                   _mm_mul_pd(lastIsEven,last));
+      __m128d oddSum = _mm_sub_pd(_mm_loadu_pd(&_oddSum[idx]),
+                                  _mm_mul_pd(_mm_sub_pd(one,lastIsEven),last));
+      
+      __m128d prop = _mm_mul_pd(_mm_loadu_pd(&_kProportional[idx]),last);
+      __m128d integral = _mm_add_pd(_mm_add_pd(_mm_add_pd(first,last),
+                                               _mm_mul_pd(four,oddSum)),
+                                    _mm_mul_pd(two,evenSum));
+      integral = _mm_div_pd(integral,threeDt);
+      integral = _mm_mul_pd(integral,_mm_loadu_pd(&_kIntegral[idx]));
+      __m128d deriv = _mm_mul_pd(_mm_loadu_pd(&_kDerivative[idx]),
+                                 _mm_sub_pd(last,_mm_loadu_pd(&_prevError[idx])));
+      deriv = _mm_div_pd(deriv,dt);
+      
+      __m128d result = _mm_add_pd(_mm_add_pd(prop,integral),deriv);
+      result = _mm_mul_pd(_mm_loadu_pd(&_kPlant[idx]),result);
+      result = _mm_mul_pd(_mm_loadu_pd(&_ready[idx]),result);
+      _mm_storeu_pd(&_outputs[idx],result);
+   }
+   return idx;
+#else
+   return 0;
+#endif
+}
+
+void PIDControllerBank::Evaluate()
+{
+   uint32 start = 0;
+   if(_kernel == KT_SIMD)
+   {
+      start = EvaluateSIMD();
+   }
+   EvaluateScalar(start,GetCount());
+}
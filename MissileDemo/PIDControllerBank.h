@@ -0,0 +1,199 @@
+/********************************************************************
+ * File   : PIDControllerBank.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/8/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__PIDControllerBank__
+#define __MissileDemo__PIDControllerBank__
+
+#include "CommonSTL.h"
+
+/* This class holds many PID controllers in "structure
+ * of arrays" form and calculates all their outputs in
+ * one call.  The math is the same as the PIDController
+ * (see PIDController.h), including the Extended Simpson's
+ * Rule integral built from even/odd position running
+ * sums, so a controller in the bank gives the same
+ * output as a PIDController with the same gains, to
+ * within the tolerance documented there.
+ *
+ * Usage:
+ * 1. Init(...) the bank with the history length and
+ *    time step (shared by all the controllers).
+ * 2. AddController() for each controller and set its
+ *    gains.  Controllers are referred to by index.
+ *    RemoveController(...) moves the last controller
+ *    into the removed slot.
+ * 3. Each tick, AddSample(...) for the controllers that
+ *    have a new error.  This is O(1) bookkeeping.
+ * 4. Call Evaluate() once.  This calculates the output
+ *    of every controller with an SSE2/AVX kernel (when
+ *    the compiler targets them) or the scalar kernel.
+ * 5. Read GetLastOutput(...).
+ *
+ * A controller that did not get a sample keeps the same
+ * output, just like a PIDController would.
+ */
+
+class PIDControllerBank
+{
+public:
+   enum
+   {
+      MIN_SAMPLES = 3
+   };
+   
+   typedef enum
+   {
+      KT_SCALAR,
+      KT_SIMD,
+   } KERNEL_TYPE_T;
+   
+private:
+   double _dt;
+   uint32 _maxHistory;
+   KERNEL_TYPE_T _kernel;
+   
+   // Gains
+   vector<double> _kProportional;
+   vector<double> _kIntegral;
+   vector<double> _kDerivative;
+   vector<double> _kPlant;
+   
+   // Error history.  Each controller has _maxHistory
+   // contiguous entries used as a ring buffer.
+   vector<double> _history;
+   vector<uint32> _first;
+   vector<uint32> _count;
+   vector<uint32> _samplesSinceRebuild;
+   
+   // Everything the kernel needs to know about the
+   // history, kept up to date by AddSample(...).
+   vector<double> _firstError;
+   vector<double> _lastError;
+   vector<double> _prevError;
+   // Sums of the errors at even/odd positions in the
+   // window (position 0 is the oldest).
+   vector<double> _evenSum;
+   vector<double> _oddSum;
+   // 1.0 if the last error is at an even position, else 0.0.
+   vector<double> _lastIsEven;
+   // 1.0 if there are at least MIN_SAMPLES, else 0.0.
+   vector<double> _ready;
+   
+   vector<double> _outputs;
+   
+   void RebuildSums(uint32 idx);
+   void EvaluateScalar(uint32 start, uint32 end);
+   uint32 EvaluateSIMD();
+   
+public:
+   PIDControllerBank();
+   
+   // The history length and time step are shared by all the
+   // controllers.  This removes all the controllers.
+   void Init(uint32 maxHistory = 7, double dt = 1.0/100);
+   void Reset();
+   void Reserve(uint32 count);
+   
+   uint32 AddController();
+   void RemoveController(uint32 idx);
+   inline uint32 GetCount() const { return _outputs.size(); }
+   
+   // Gains for controller idx.
+   inline void SetKProportional(uint32 idx, double value) { _kProportional[idx] = value; }
+   inline double GetKProportional(uint32 idx) const { return _kProportional[idx]; }
+   inline void SetKIntegral(uint32 idx, double value) { _kIntegral[idx] = value; }
+   inline double GetKIntegral(uint32 idx) const { return _kIntegral[idx]; }
+   inline void SetKDerivative(uint32 idx, double value) { _kDerivative[idx] = value; }
+   inline double GetKDerivative(uint32 idx) const { return _kDerivative[idx]; }
+   inline void SetKPlant(uint32 idx, double value) { _kPlant[idx] = value; }
+   inline double GetKPlant(uint32 idx) const { return _kPlant[idx]; }
+   
+   inline double GetTimeStep() const { return _dt; }
+   inline uint32 GetMaxHistory() const { return _maxHistory; }
+   
+   // Selects the Evaluate() kernel.  KT_SIMD falls back to
+   // the scalar kernel if there is no SIMD support.
+   inline void SetKernel(KERNEL_TYPE_T kernel) { _kernel = kernel; }
+   inline KERNEL_TYPE_T GetKernel() const { return _kernel; }
+   static const char* GetSIMDName();
+   
+   void ResetHistory(uint32 idx);
+   inline void AddSample(uint32 idx, double error)
+   {
+      double* ring = &_history[idx*_maxHistory];
+      uint32 first = _first[idx];
+      uint32 count = _count[idx];
+   
+      if(count == _maxHistory)
+      {  // Full; drop the oldest.  Every sample moves down
+         // one position, so the even and odd sums swap.
+         double evenSum = _evenSum[idx] - ring[first];
+         _evenSum[idx] = _oddSum[idx];
+         _oddSum[idx] = evenSum;
+         first++;
+         if(first == _maxHistory)
+            first = 0;
+         count--;
+      }
+   
+      uint32 slot = first + count;
+      if(slot >= _maxHistory)
+         slot -= _maxHistory;
+      ring[slot] = error;
+      if(count & 1)
+      {
+         _oddSum[idx] += error;
+      }
+      else
+      {
+         _evenSum[idx] += error;
+      }
+      _lastIsEven[idx] = (count & 1) ? 0.0 : 1.0;
+      count++;
+   
+      _first[idx] = first;
+      _count[idx] = count;
+      _prevError[idx] = _lastError[idx];
+      _lastError[idx] = error;
+      _firstError[idx] = ring[first];
+      _ready[idx] = (count >= MIN_SAMPLES) ? 1.0 : 0.0;
+   
+      // Keep the rounding error from building up.
+      _samplesSinceRebuild[idx]++;
+      if(_samplesSinceRebuild[idx] >= _maxHistory)
+      {
+         RebuildSums(idx);
+      }
+   }
+   // Calculate the output for every controller.
+   void Evaluate();
+   
+   inline double GetLastError(uint32 idx) const { return _count[idx] == 0 ? 0.0 : _lastError[idx]; }
+   inline double GetLastOutput(uint32 idx) const { return _outputs[idx]; }
+   inline const double* GetOutputs() const { return _outputs.empty() ? NULL : &_outputs[0]; }
+};
+
+#endif /* defined(__MissileDemo__PIDControllerBank__) */
@@ -0,0 +1,188 @@
+/********************************************************************
+ * File   : Path.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "Path.h"
+
+Path::Path() :
+_references(1)
+{
+   
+}
+
+Path::~Path()
+{
+   assert(_references == 0);
+}
+
+Path* Path::Create(const vector<Vec2>& points)
+{
+   Path* path = new Path();
+   path->_points = points;
+   path->CalculateDistances();
+   return path;
+}
+
+Path* Path::Create(const list<Vec2>& points)
+{
+   Path* path = new Path();
+   path->_points.assign(points.begin(),points.end());
+   path->CalculateDistances();
+   return path;
+}
+
+void Path::Retain() const
+{
+   __sync_fetch_and_add(&_references,1);
+}
+
+void Path::Release() const
+{
+   assert(_references > 0);
+   if(__sync_sub_and_fetch(&_references,1) == 0)
+   {
+      delete this;
+   }
+}
+
+void Path::CalculateDistances()
+{
+   _distances.resize(_points.size());
+   float32 distance = 0;
+   for(uint32 idx = 0; idx < _points.size(); idx++)
+   {
+      if(idx > 0)
+      {
+         distance += (_points[idx]-_points[idx-1]).Length();
+      }
+      _distances[idx] = distance;
+   }
+}
+
+uint32 Path::FindSegment(float32 distance) const
+{
+   if(_points.size() < 2)
+      return 0;
+   // The first point past distance ends the segment.
+   uint32 index = upper_bound(_distances.begin(),_distances.end(),distance) - _distances.begin();
+   if(index == 0)
+      return 0;
+   if(index > _points.size()-1)
+      return _points.size()-2;
+   return index-1;
+}
+
+Vec2 Path::GetPointAtDistance(float32 distance) const
+{
+   assert(_points.size() > 0);
+   if(_points.size() == 1)
+      return _points[0];
+   uint32 segment = FindSegment(distance);
+   float32 length = _distances[segment+1] - _distances[segment];
+   if(length <= 0)
+      return _points[segment];
+   float32 t = (distance - _distances[segment])/length;
+   if(t < 0)
+      t = 0;
+   if(t > 1)
+      t = 1;
+   return _points[segment] + t*(_points[segment+1]-_points[segment]);
+}
+
+float32 Path::FindClosestDistance(const Vec2& position, float32 minDistance, float32 maxDistance) const
+{
+   assert(_points.size() > 0);
+   assert(minDistance <= maxDistance);
+   if(_points.size() == 1)
+      return 0;
+   uint32 first = FindSegment(minDistance);
+   uint32 last = FindSegment(maxDistance);
+   float32 bestDistance = _distances[first];
+   float32 bestLengthSquared = numeric_limits<float32>::max();
+   for(uint32 segment = first; segment <= last; segment++)
+   {
+      const Vec2& start = _points[segment];
+      Vec2 along = _points[segment+1]-start;
+      float32 length = _distances[segment+1] - _distances[segment];
+      float32 t = 0;
+      if(length > 0)
+      {
+         t = b2Dot(position-start,along)/(length*length);
+         if(t < 0)
+            t = 0;
+         if(t > 1)
+            t = 1;
+      }
+      Vec2 closest = start + t*along;
+      float32 lengthSquared = (position-closest).LengthSquared();
+      if(lengthSquared < bestLengthSquared)
+      {
+         bestLengthSquared = lengthSquared;
+         bestDistance = _distances[segment] + t*length;
+      }
+   }
+   if(bestDistance < minDistance)
+      bestDistance = minDistance;
+   if(bestDistance > maxDistance)
+      bestDistance = maxDistance;
+   return bestDistance;
+}
+
+PathCursor::PathCursor() :
+_path(NULL),
+_index(0)
+{
+   
+}
+
+PathCursor::~PathCursor()
+{
+   SetPath(NULL);
+}
+
+void PathCursor::SetPath(const Path* path)
+{
+   // Retain first, in case it is the same path.
+   if(path != NULL)
+   {
+      path->Retain();
+   }
+   if(_path != NULL)
+   {
+      _path->Release();
+   }
+   _path = path;
+   _index = 0;
+}
+
+float32 PathCursor::GetDistance() const
+{
+   if(_path == NULL || _path->GetPointCount() == 0)
+      return 0;
+   if(IsDone())
+      return _path->GetLength();
+   return _path->GetDistance(_index);
+}
@@ -0,0 +1,131 @@
+/********************************************************************
+ * File   : Path.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__Path__
+#define __MissileDemo__Path__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+
+/* A path is a list of points stored end to end, along with
+ * the distance along the path (arc length) to each point.
+ *
+ * Paths do not change once they are created, so any number of
+ * entities can follow the same one.  They are reference
+ * counted; Create(...) returns a path with one reference, and
+ * the last Release() deletes it.  Retain()/Release() may be
+ * called from any thread.
+ *
+ * Each entity keeps its own position on the path in a
+ * PathCursor.
+ */
+class Path
+{
+private:
+   vector<Vec2> _points;
+   // _distances[i] is the arc length from the first point
+   // to point i.
+   vector<float32> _distances;
+   mutable int32 _references;
+   
+   Path();
+   ~Path();
+   // Not copyable.
+   Path(const Path&);
+   Path& operator=(const Path&);
+   
+   void CalculateDistances();
+   
+public:
+   static Path* Create(const vector<Vec2>& points);
+   static Path* Create(const list<Vec2>& points);
+   
+   void Retain() const;
+   void Release() const;
+   
+   uint32 GetPointCount() const { return _points.size(); }
+   const Vec2& GetPoint(uint32 index) const { return _points[index]; }
+   const vector<Vec2>& GetPoints() const { return _points; }
+   // Distance along the path to the point.
+   float32 GetDistance(uint32 index) const { return _distances[index]; }
+   float32 GetLength() const { return _distances.empty() ? 0 : _distances.back(); }
+   
+   // Returns the segment (the index of its first point) that
+   // contains distance along the path.  Distances off the ends
+   // are clamped to the first/last segment.  O(log n).
+   uint32 FindSegment(float32 distance) const;
+   
+   // Returns the point at distance along the path (clamped to
+   // the ends).  Use this for "look ahead" points.  O(log n).
+   Vec2 GetPointAtDistance(float32 distance) const;
+   
+   // Returns the distance along the path of the point on the
+   // path closest to position, looking only at the part of the
+   // path between minDistance and maxDistance.  This is
+   // O(log n) plus the number of segments in that part of the
+   // path, so keep the window small (e.g. around a cursor).
+   float32 FindClosestDistance(const Vec2& position, float32 minDistance, float32 maxDistance) const;
+};
+
+/* An entity's place on a (shared) path.  The cursor holds a
+ * reference to the path while it is set.
+ *
+ * The cursor is on a point of the path (GetIndex()); Next()
+ * moves it to the following one.  When it has gone past the
+ * last point, IsDone() is true.
+ */
+class PathCursor
+{
+private:
+   const Path* _path;
+   uint32 _index;
+   
+   // Not copyable.
+   PathCursor(const PathCursor&);
+   PathCursor& operator=(const PathCursor&);
+   
+public:
+   PathCursor();
+   ~PathCursor();
+   
+   // Starts at the first point of path.  Passing NULL
+   // clears the cursor.
+   void SetPath(const Path* path);
+   const Path* GetPath() const { return _path; }
+   
+   bool IsDone() const { return _path == NULL || _index >= _path->GetPointCount(); }
+   uint32 GetIndex() const { return _index; }
+   // The point the cursor is on.
+   const Vec2& GetPoint() const { assert(!IsDone()); return _path->GetPoint(_index); }
+   void Next() { assert(!IsDone()); _index++; }
+   // Distance along the path to the current point.
+   float32 GetDistance() const;
+   // Points left, including the current one.
+   uint32 GetRemaining() const { return IsDone() ? 0 : _path->GetPointCount() - _index; }
+};
+
+#endif /* defined(__MissileDemo__Path__) */
@@ -0,0 +1,108 @@
+/********************************************************************
+ * File   : PathSimplifier.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "PathSimplifier.h"
+
+PathSimplifier::PathSimplifier(float32 tolerance) :
+_tolerance(tolerance),
+_addedCount(0)
+{
+   assert(tolerance >= 0);
+   _window.reserve(MAX_WINDOW_SIZE+1);
+}
+
+void PathSimplifier::Reset()
+{
+   _points.clear();
+   _window.clear();
+   _addedCount = 0;
+}
+
+bool PathSimplifier::WindowFits(const Vec2& start, const Vec2& end) const
+{
+   // Check everything but the newest point (the end).
+   Vec2 along = end - start;
+   float32 lengthSquared = along.LengthSquared();
+   float32 toleranceSquared = _tolerance*_tolerance;
+   for(uint32 idx = 0; idx+1 < _window.size(); idx++)
+   {
+      Vec2 toPoint = _window[idx] - start;
+      float32 t = 0;
+      if(lengthSquared > 0)
+      {
+         t = b2Dot(toPoint,along)/lengthSquared;
+         if(t < 0)
+            t = 0;
+         if(t > 1)
+            t = 1;
+      }
+      if((toPoint - t*along).LengthSquared() > toleranceSquared)
+         return false;
+   }
+   return true;
+}
+
+void PathSimplifier::AddPoint(const Vec2& point)
+{
+   _addedCount++;
+   if(_points.empty())
+   {
+      _points.push_back(point);
+      return;
+   }
+   
+   const Vec2& last = _window.empty() ? _points.back() : _window.back();
+   if((point - last).LengthSquared() < _tolerance*_tolerance)
+   {  // Too close to matter.
+      return;
+   }
+   
+   _window.push_back(point);
+   if(_window.size() > MAX_WINDOW_SIZE || !WindowFits(_points.back(),point))
+   {  // The point before this one is needed; keep it and
+      // start a new window.
+      _points.push_back(_window[_window.size()-2]);
+      _window.clear();
+      _window.push_back(point);
+   }
+}
+
+void PathSimplifier::GetPoints(vector<Vec2>& points) const
+{
+   points = _points;
+   if(!_window.empty())
+   {
+      points.push_back(_window.back());
+   }
+}
+
+Path* PathSimplifier::CreatePath() const
+{
+   vector<Vec2> points;
+   GetPoints(points);
+   return Path::Create(points);
+}
@@ -0,0 +1,91 @@
+/********************************************************************
+ * File   : PathSimplifier.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/19/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__PathSimplifier__
+#define __MissileDemo__PathSimplifier__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Path.h"
+
+/* Thins out a path as its points come in (e.g. one per touch
+ * move while a path is drawn).
+ *
+ * Two filters are used:
+ * 1. Points closer than the tolerance to the last point kept are
+ *    dropped (radial distance).
+ * 2. A point is only kept if dropping it would move the path by
+ *    more than the tolerance.  The points since the last kept
+ *    point are held in a small window; while they all stay within
+ *    the tolerance of the line from the last kept point to the
+ *    newest point, none of them are needed.
+ *
+ * Every point added is within (about) the tolerance of the
+ * simplified path.  An entity following the path cannot tell
+ * points apart that are closer than its GetMinSeekDistance(), so
+ * a fraction of that is a good tolerance.
+ */
+class PathSimplifier
+{
+private:
+   enum
+   {
+      // Keep a point anyway once the window is this big, so
+      // AddPoint(...) stays cheap on long straight lines.
+      MAX_WINDOW_SIZE = 64,
+   };
+   
+   float32 _tolerance;
+   // The points kept so far.
+   vector<Vec2> _points;
+   // The points since the last one kept.  The newest one
+   // is the (provisional) end of the path.
+   vector<Vec2> _window;
+   uint32 _addedCount;
+   
+   bool WindowFits(const Vec2& start, const Vec2& end) const;
+   
+public:
+   PathSimplifier(float32 tolerance = 1.0);
+   
+   void SetTolerance(float32 tolerance) { assert(tolerance >= 0); _tolerance = tolerance; }
+   float32 GetTolerance() const { return _tolerance; }
+   
+   void Reset();
+   void AddPoint(const Vec2& point);
+   
+   // Number of points in the simplified path.
+   uint32 GetPointCount() const { return _points.size() + (_window.empty() ? 0 : 1); }
+   // Number of points given to AddPoint(...) since Reset().
+   uint32 GetAddedCount() const { return _addedCount; }
+   
+   void GetPoints(vector<Vec2>& points) const;
+   // Returns a new Path with one reference.
+   Path* CreatePath() const;
+};
+
+#endif /* defined(__MissileDemo__PathSimplifier__) */
@@ -0,0 +1,49 @@
+/********************************************************************
+ * File   : PhysicsTasks.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "PhysicsTasks.h"
+
+void PhysicsTasks::TaskJob(void* context, uint32 begin, uint32 end, uint32 worker)
+{
+   const TASK_T* task = (const TASK_T*)context;
+   task->task(task->context,(int32)begin,(int32)end,(int32)worker);
+}
+
+int32 PhysicsTasks::GetWorkerCount() const
+{
+   return (int32)_jobs->GetThreadCount();
+}
+
+void PhysicsTasks::ParallelFor(int32 count, int32 grainSize, b2TaskFunction task, void* context)
+{
+   assert(count >= 0);
+   assert(grainSize > 0);
+   TASK_T job;
+   job.task = task;
+   job.context = context;
+   _jobs->ParallelFor((uint32)count,(uint32)grainSize,TaskJob,&job);
+}
@@ -0,0 +1,63 @@
+/********************************************************************
+ * File   : PhysicsTasks.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__PhysicsTasks__
+#define __MissileDemo__PhysicsTasks__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "JobSystem.h"
+
+/* This class lets the physics world run its work on a
+ * JobSystem (b2World::SetTaskExecutor(...)), so the
+ * islands are solved on the same threads as the entity
+ * update.
+ *
+ * The JobSystem is not owned and may be Init(...)'ed
+ * again with a different number of threads at any time
+ * outside of a world step.
+ */
+class PhysicsTasks : public b2TaskExecutor
+{
+private:
+   typedef struct
+   {
+      b2TaskFunction task;
+      void* context;
+   } TASK_T;
+   
+   JobSystem* _jobs;
+   
+   static void TaskJob(void* context, uint32 begin, uint32 end, uint32 worker);
+   
+public:
+   PhysicsTasks(JobSystem* jobs) : _jobs(jobs) { }
+   
+   virtual int32 GetWorkerCount() const;
+   virtual void ParallelFor(int32 count, int32 grainSize, b2TaskFunction task, void* context);
+};
+
+#endif /* defined(__MissileDemo__PhysicsTasks__) */
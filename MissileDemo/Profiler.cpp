@@ -0,0 +1,335 @@
+/********************************************************************
+ * File   : Profiler.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/22/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "Profiler.h"
+#include <fstream>
+#include <iomanip>
+
+char Profiler::_unrecorded = 0;
+
+Profiler::Profiler() :
+_threadCount(0),
+_zoneCapacity(0),
+_enabled(false),
+_ticksPerSecond(0),
+_frameCount(0),
+_frameStart(0)
+{
+   pthread_key_create(&_threadKey,ReleaseThread);
+   for(uint32 idx = 0; idx < MAX_THREADS; idx++)
+   {
+      _threads[idx] = NULL;
+   }
+}
+
+Profiler::~Profiler()
+{
+   for(uint32 idx = 0; idx < MAX_THREADS; idx++)
+   {
+      delete _threads[idx];
+   }
+   pthread_key_delete(_threadKey);
+}
+
+void Profiler::AllocateZones(THREAD_BUFFER_T* buffer)
+{
+   buffer->zones.assign(_zoneCapacity,ZONE_T());
+   buffer->mask = _zoneCapacity > 0 ? _zoneCapacity-1 : 0;
+   buffer->recorded = 0;
+}
+
+bool Profiler::Init(uint32 zoneCapacity)
+{
+   assert(zoneCapacity > 0);
+   uint32 size = 1;
+   while(size < zoneCapacity)
+   {
+      size <<= 1;
+   }
+   _zoneCapacity = size;
+   uint32 threadCount = Min(_threadCount,(uint32)MAX_THREADS);
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      if(_threads[idx] != NULL)
+         AllocateZones(_threads[idx]);
+   }
+   _frameTimes.assign(FRAME_HISTORY,0.0);
+   _frameCount = 0;
+   _frameStart = 0;
+   _ticksPerSecond = 1.0/StopWatch::GetSecondsPerTick();
+   _enabled = true;
+   return true;
+}
+
+void Profiler::Reset()
+{
+   uint32 threadCount = Min(_threadCount,(uint32)MAX_THREADS);
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      if(_threads[idx] != NULL)
+         _threads[idx]->recorded = 0;
+   }
+   _frameCount = 0;
+   _frameStart = 0;
+}
+
+void Profiler::Shutdown()
+{
+   _enabled = false;
+   // The buffers themselves stay, the threads still
+   // point at them.
+   _zoneCapacity = 0;
+   uint32 threadCount = Min(_threadCount,(uint32)MAX_THREADS);
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      if(_threads[idx] != NULL)
+         AllocateZones(_threads[idx]);
+   }
+   vector<double>().swap(_frameTimes);
+   _frameCount = 0;
+   _frameStart = 0;
+}
+
+Profiler::THREAD_BUFFER_T* Profiler::RegisterThread()
+{
+   // Take over the buffer of a thread that has exited.
+   uint32 threadCount = Min(__atomic_load_n(&_threadCount,__ATOMIC_ACQUIRE),(uint32)MAX_THREADS);
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      THREAD_BUFFER_T* buffer = __atomic_load_n(&_threads[idx],__ATOMIC_ACQUIRE);
+      uint32 free = 0;
+      if(buffer != NULL &&
+         __atomic_compare_exchange_n(&buffer->inUse,&free,1,false,__ATOMIC_ACQ_REL,__ATOMIC_RELAXED))
+      {
+         buffer->depth = 0;
+         buffer->name = NULL;
+         buffer->recorded = 0;
+         pthread_setspecific(_threadKey,buffer);
+         return buffer;
+      }
+   }
+   
+   uint32 index = __atomic_fetch_add(&_threadCount,1,__ATOMIC_ACQ_REL);
+   if(index >= MAX_THREADS)
+   {  // Out of buffers; this thread is not recorded.
+      pthread_setspecific(_threadKey,Unrecorded());
+      return Unrecorded();
+   }
+   THREAD_BUFFER_T* buffer = new THREAD_BUFFER_T();
+   buffer->depth = 0;
+   buffer->index = index;
+   buffer->name = NULL;
+   buffer->inUse = 1;
+   AllocateZones(buffer);
+   __atomic_store_n(&_threads[index],buffer,__ATOMIC_RELEASE);
+   pthread_setspecific(_threadKey,buffer);
+   return buffer;
+}
+
+void Profiler::ReleaseThread(void* buffer)
+{
+   if(buffer != Unrecorded())
+   {
+      __atomic_store_n(&((THREAD_BUFFER_T*)buffer)->inUse,0,__ATOMIC_RELEASE);
+   }
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+   THREAD_BUFFER_T* buffer = (THREAD_BUFFER_T*)pthread_getspecific(_threadKey);
+   if(buffer == NULL)
+      buffer = RegisterThread();
+   if(buffer == Unrecorded())
+      return;
+   buffer->name = name;
+}
+
+void Profiler::RecordWorldProfile(const b2Profile& profile, uint64 stepStart)
+{
+   THREAD_BUFFER_T* buffer = BeginZone();
+   if(buffer == NULL)
+      return;
+   // BeginZone() counted a zone we are not going to make.
+   buffer->depth--;
+   uint32 depth = buffer->depth;
+   
+   const double ticksPerMs = _ticksPerSecond*1.0E-3;
+   uint64 collideStop = stepStart + (uint64)(profile.collide*ticksPerMs);
+   RecordZone(buffer,"Collide",stepStart,collideStop,depth);
+   
+   uint64 solveStop = collideStop + (uint64)(profile.solve*ticksPerMs);
+   if(profile.solve > 0)
+   {
+      RecordZone(buffer,"Solve",collideStop,solveStop,depth);
+      uint64 start = collideStop;
+      uint64 stop = start + (uint64)(profile.solveInit*ticksPerMs);
+      RecordZone(buffer,"SolveInit",start,stop,depth+1);
+      start = stop;
+      stop = start + (uint64)(profile.solveVelocity*ticksPerMs);
+      RecordZone(buffer,"SolveVelocity",start,stop,depth+1);
+      start = stop;
+      stop = start + (uint64)(profile.solvePosition*ticksPerMs);
+      RecordZone(buffer,"SolvePosition",start,stop,depth+1);
+      RecordZone(buffer,"Broadphase",solveStop - (uint64)(profile.broadphase*ticksPerMs),solveStop,depth+1);
+   }
+   if(profile.solveTOI > 0)
+   {
+      RecordZone(buffer,"SolveTOI",solveStop,solveStop + (uint64)(profile.solveTOI*ticksPerMs),depth);
+   }
+}
+
+void Profiler::NextFrame()
+{
+   uint64 now = StopWatch::GetTicks();
+   if(_frameStart != 0 && !_frameTimes.empty())
+   {
+      _frameTimes[_frameCount % FRAME_HISTORY] = StopWatch::TicksToSeconds(now - _frameStart);
+      _frameCount++;
+      THREAD_BUFFER_T* buffer = BeginZone();
+      if(buffer != NULL)
+      {
+         EndZone(buffer,"Frame",_frameStart,now);
+      }
+   }
+   _frameStart = now;
+}
+
+bool Profiler::GetFrameStats(FRAME_STATS_T& stats) const
+{
+   uint32 count = Min(_frameCount,(uint32)FRAME_HISTORY);
+   if(count == 0)
+      return false;
+   vector<double> times(_frameTimes.begin(),_frameTimes.begin()+count);
+   sort(times.begin(),times.end());
+   double total = 0;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      total += times[idx];
+   }
+   // Nearest rank.
+   stats.frames = count;
+   stats.average = total/count;
+   stats.p50 = times[(count*50+99)/100 - 1];
+   stats.p99 = times[(count*99+99)/100 - 1];
+   stats.max = times[count-1];
+   return true;
+}
+
+uint32 Profiler::GetRecordedCount() const
+{
+   uint32 total = 0;
+   uint32 threadCount = Min(__atomic_load_n(&_threadCount,__ATOMIC_ACQUIRE),(uint32)MAX_THREADS);
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      const THREAD_BUFFER_T* buffer = __atomic_load_n(&_threads[idx],__ATOMIC_ACQUIRE);
+      if(buffer != NULL)
+         total += __atomic_load_n(&buffer->recorded,__ATOMIC_ACQUIRE);
+   }
+   return total;
+}
+
+void Profiler::WriteJSONString(ostream& out, const char* str)
+{
+   out << '"';
+   for(; *str != 0; str++)
+   {
+      if(*str == '"' || *str == '\\')
+         out << '\\';
+      out << *str;
+   }
+   out << '"';
+}
+
+void Profiler::WriteChromeTrace(ostream& out) const
+{
+   uint32 threadCount = Min(__atomic_load_n(&_threadCount,__ATOMIC_ACQUIRE),(uint32)MAX_THREADS);
+   // The zones still in each buffer are [first,recorded).
+   vector<uint32> firsts(threadCount,0);
+   vector<uint32> counts(threadCount,0);
+   uint64 base = 0;
+   bool haveBase = false;
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      const THREAD_BUFFER_T* buffer = __atomic_load_n(&_threads[idx],__ATOMIC_ACQUIRE);
+      if(buffer == NULL || buffer->zones.empty())
+         continue;
+      uint32 recorded = __atomic_load_n(&buffer->recorded,__ATOMIC_ACQUIRE);
+      counts[idx] = Min(recorded,(uint32)buffer->zones.size());
+      firsts[idx] = recorded - counts[idx];
+      for(uint32 zdx = 0; zdx < counts[idx]; zdx++)
+      {
+         const ZONE_T& zone = buffer->zones[(firsts[idx]+zdx) & buffer->mask];
+         if(!haveBase || zone.start < base)
+         {
+            base = zone.start;
+            haveBase = true;
+         }
+      }
+   }
+   
+   ios::fmtflags flags = out.flags();
+   streamsize precision = out.precision();
+   out << fixed << setprecision(3);
+   out << "{\"traceEvents\":[";
+   bool first = true;
+   for(uint32 idx = 0; idx < threadCount; idx++)
+   {
+      const THREAD_BUFFER_T* buffer = __atomic_load_n(&_threads[idx],__ATOMIC_ACQUIRE);
+      if(buffer == NULL)
+         continue;
+      if(buffer->name != NULL)
+      {
+         out << (first ? "\n" : ",\n");
+         out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->index
+             << ",\"args\":{\"name\":";
+         WriteJSONString(out,buffer->name);
+         out << "}}";
+         first = false;
+      }
+      for(uint32 zdx = 0; zdx < counts[idx]; zdx++)
+      {
+         const ZONE_T& zone = buffer->zones[(firsts[idx]+zdx) & buffer->mask];
+         out << (first ? "\n" : ",\n");
+         out << "{\"name\":";
+         WriteJSONString(out,zone.name);
+         out << ",\"ph\":\"X\",\"ts\":" << StopWatch::TicksToSeconds(zone.start - base)*1.0E6
+             << ",\"dur\":" << StopWatch::TicksToSeconds(zone.stop - zone.start)*1.0E6
+             << ",\"pid\":1,\"tid\":" << buffer->index << "}";
+         first = false;
+      }
+   }
+   out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+   out.flags(flags);
+   out.precision(precision);
+}
+
+bool Profiler::WriteChromeTrace(const string& path) const
+{
+   ofstream out(path.c_str());
+   if(!out)
+      return false;
+   WriteChromeTrace(out);
+   return out.good();
+}
@@ -0,0 +1,243 @@
+/********************************************************************
+ * File   : Profiler.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/22/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__Profiler__
+#define __MissileDemo__Profiler__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "SingletonTemplate.h"
+#include "Stopwatch.h"
+#include <pthread.h>
+
+/* The Profiler singleton records timed, nested zones into a
+ * ring buffer per thread.
+ *
+ * A zone is marked with PROFILE_ZONE("Name") at the top of a
+ * block; it covers the rest of the block.  Each thread gets its
+ * own buffer the first time it records a zone, so recording
+ * takes no locks: it is two clock reads and a few stores.  When
+ * a buffer is full, the oldest zones are overwritten, so the
+ * buffers always hold the last few frames.  Zone names must
+ * be string literals (only the pointer is kept).
+ *
+ * NextFrame() is called once per frame (from the main thread).
+ * It keeps the last FRAME_HISTORY frame times for
+ * GetFrameStats(...) (average, p50, p99, max), so a spike shows
+ * up in the p99 long after it has scrolled off the screen.
+ *
+ * WriteChromeTrace(...) writes the recorded zones as Chrome
+ * trace event JSON (load it with chrome://tracing or Perfetto).
+ * It and GetFrameStats(...) must be called from the main thread
+ * between frames, when no other thread is recording.
+ *
+ * The Box2D phases are timed by b2World itself (b2Profile);
+ * RecordWorldProfile(...) turns them into zones under the
+ * zone around b2World::Step(...).
+ *
+ * Zones recorded before Init(...), after Shutdown() or while
+ * disabled are dropped.
+ *
+ * A thread's buffer is given back when the thread exits, and
+ * the next new thread reuses it (and drops what was in it), so
+ * restarting a JobSystem does not use up the MAX_THREADS
+ * buffers.  A thread that finds them all in use is not
+ * recorded at all.
+ */
+class Profiler : public SingletonDynamic<Profiler>
+{
+public:
+   typedef struct
+   {
+      const char* name;
+      uint64 start;
+      uint64 stop;
+      // Number of zones this one is nested in.
+      uint32 depth;
+   } ZONE_T;
+   
+   typedef struct
+   {
+      vector<ZONE_T> zones;
+      uint32 mask;
+      // Total zones recorded since the last Reset().  Only the
+      // owning thread writes this.
+      uint32 recorded;
+      uint32 depth;
+      uint32 index;
+      const char* name;
+      // Set while a thread owns the buffer.
+      uint32 inUse;
+   } THREAD_BUFFER_T;
+   
+   // All in seconds.
+   typedef struct
+   {
+      uint32 frames;
+      double average;
+      double p50;
+      double p99;
+      double max;
+   } FRAME_STATS_T;
+   
+   enum
+   {
+      DEFAULT_ZONE_CAPACITY = 8192,
+      MAX_THREADS = 32,
+      FRAME_HISTORY = 300,
+   };
+   
+private:
+   pthread_key_t _threadKey;
+   THREAD_BUFFER_T* _threads[MAX_THREADS];
+   uint32 _threadCount;
+   // Its address is stored for threads that could not get a
+   // buffer, so they do not try again on every zone.  It is
+   // only ever compared, never read or written, so there is
+   // nothing for those threads to share.
+   static char _unrecorded;
+   uint32 _zoneCapacity;
+   bool _enabled;
+   double _ticksPerSecond;
+   
+   // Frame times (seconds), a ring of FRAME_HISTORY.
+   vector<double> _frameTimes;
+   uint32 _frameCount;
+   uint64 _frameStart;
+   
+   static inline THREAD_BUFFER_T* Unrecorded() { return (THREAD_BUFFER_T*)&_unrecorded; }
+   // Returns Unrecorded() if there is no buffer for the thread.
+   THREAD_BUFFER_T* RegisterThread();
+   static void ReleaseThread(void* buffer);
+   void AllocateZones(THREAD_BUFFER_T* buffer);
+   static void WriteJSONString(ostream& out, const char* str);
+   
+public:
+   Profiler();
+   ~Profiler();
+   
+   virtual bool Init() { return Init(DEFAULT_ZONE_CAPACITY); }
+   // The capacity (per thread) is rounded up to a power of 2.
+   bool Init(uint32 zoneCapacity);
+   virtual void Reset();
+   virtual void Shutdown();
+   
+   void SetEnabled(bool enabled) { _enabled = enabled; }
+   bool IsEnabled() const { return _enabled; }
+   
+   // Names the calling thread in the trace.
+   void SetThreadName(const char* name);
+   
+   // Used by ProfileZone.  BeginZone() returns NULL if the
+   // zone should not be recorded.
+   inline THREAD_BUFFER_T* BeginZone()
+   {
+      if(!_enabled)
+         return NULL;
+      THREAD_BUFFER_T* buffer = (THREAD_BUFFER_T*)pthread_getspecific(_threadKey);
+      if(buffer == NULL)
+         buffer = RegisterThread();
+      if(buffer == Unrecorded())
+         return NULL;
+      buffer->depth++;
+      return buffer;
+   }
+   
+   inline void EndZone(THREAD_BUFFER_T* buffer, const char* name, uint64 start, uint64 stop)
+   {
+      assert(buffer != Unrecorded());
+      buffer->depth--;
+      RecordZone(buffer,name,start,stop,buffer->depth);
+   }
+   
+   inline void RecordZone(THREAD_BUFFER_T* buffer, const char* name, uint64 start, uint64 stop, uint32 depth)
+   {
+      if(buffer->zones.empty())
+         return;
+      ZONE_T& zone = buffer->zones[buffer->recorded & buffer->mask];
+      zone.name = name;
+      zone.start = start;
+      zone.stop = stop;
+      zone.depth = depth;
+      __atomic_store_n(&buffer->recorded,buffer->recorded+1,__ATOMIC_RELEASE);
+   }
+   
+   // Adds the b2World::Step(...) phases (from
+   // b2World::GetProfile()) as zones inside a step that
+   // started at stepStart.  b2Profile only has durations, so
+   // the phases are laid end to end in the order the step runs
+   // them (collide, solve, TOI).  The solver phases are summed
+   // over the islands, so they are laid end to end inside the
+   // solve zone, with the broadphase at its end.
+   void RecordWorldProfile(const b2Profile& profile, uint64 stepStart);
+   
+   // Marks the start of a new frame, and records the last one
+   // as a "Frame" zone.
+   void NextFrame();
+   uint32 GetFrameCount() const { return _frameCount; }
+   // Returns false if there are no frames yet.
+   bool GetFrameStats(FRAME_STATS_T& stats) const;
+   
+   // Total zones recorded (including overwritten ones).
+   uint32 GetRecordedCount() const;
+   
+   void WriteChromeTrace(ostream& out) const;
+   // Returns false if the file could not be written.
+   bool WriteChromeTrace(const string& path) const;
+};
+
+/* Records a zone from construction to destruction.  Use
+ * PROFILE_ZONE(...) instead of declaring these by hand.
+ */
+class ProfileZone
+{
+private:
+   Profiler::THREAD_BUFFER_T* _buffer;
+   const char* _name;
+   uint64 _start;
+   
+public:
+   inline ProfileZone(const char* name) :
+      _buffer(Profiler::Instance().BeginZone()),
+      _name(name),
+      _start(0)
+   {
+      if(_buffer != NULL)
+         _start = StopWatch::GetTicks();
+   }
+   
+   inline ~ProfileZone()
+   {
+      if(_buffer != NULL)
+         Profiler::Instance().EndZone(_buffer,_name,_start,StopWatch::GetTicks());
+   }
+};
+
+#define PROFILE_ZONE_NAME2(name,line) name##line
+#define PROFILE_ZONE_NAME(name,line) PROFILE_ZONE_NAME2(name,line)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_NAME(_profileZone,__LINE__)(name)
+
+#endif /* defined(__MissileDemo__Profiler__) */
@@ -0,0 +1,88 @@
+/********************************************************************
+ * File   : SeparationSteering.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "SeparationSteering.h"
+
+SeparationSteering::SeparationSteering() :
+   _count(0),
+   _radius(0),
+   _weight(1.0)
+{
+}
+
+void SeparationSteering::SetCount(uint32 count)
+{
+   _count = count;
+   if(count <= _positions.size())
+   {
+      return;
+   }
+   _positions.resize(count);
+   _avoidance.resize(count);
+}
+
+void SeparationSteering::Build()
+{
+   assert(IsEnabled());
+   // Cells the size of the radius, so a query looks
+   // at the 3x3 cells around the body.
+   _hash.Build(&_positions[0],_count,_radius);
+}
+
+void SeparationSteering::Calculate()
+{
+   Calculate(0,_count,_neighbors);
+}
+
+void SeparationSteering::Calculate(uint32 begin, uint32 end, vector<uint32>& neighbors)
+{
+   const float32 invRadius = 1.0f/_radius;
+   for(uint32 idx = begin; idx < end; idx++)
+   {
+      const Vec2& position = _positions[idx];
+      Vec2 avoidance(0,0);
+      neighbors.clear();
+      _hash.QueryRadius(position,_radius,neighbors);
+      for(uint32 ndx = 0; ndx < neighbors.size(); ndx++)
+      {
+         uint32 other = neighbors[ndx];
+         if(other == idx)
+         {
+            continue;
+         }
+         Vec2 away = position - _positions[other];
+         float32 distance = away.Length();
+         if(distance < b2_epsilon)
+         {  // On top of each other; split them by index.
+            avoidance.x += (idx < other) ? 1.0f : -1.0f;
+            continue;
+         }
+         avoidance += ((1.0f - distance*invRadius)/distance)*away;
+      }
+      _avoidance[idx] = _weight*avoidance;
+   }
+}
@@ -0,0 +1,119 @@
+/********************************************************************
+ * File   : SeparationSteering.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__SeparationSteering__
+#define __MissileDemo__SeparationSteering__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "SpatialHash.h"
+
+/* Keeps a crowd of bodies from running into each other.
+ *
+ * Left alone, the entities only find out about each other
+ * when Box2D resolves the collision, and a dense swarm
+ * turns into a pile of contacts.  This pushes each body
+ * away from the others within the separation radius,
+ * harder the closer they are, so they steer apart before
+ * they touch.
+ *
+ * The avoidance for the whole batch comes from one
+ * SpatialHash of the positions:
+ *
+ * 1. SetCount(...), then SetPosition(...) for each body.
+ * 2. Build().
+ * 3. Calculate(...) over the whole batch or in ranges
+ *    (each range can run on a different thread).
+ * 4. GetAvoidance(...) bends the steering; see
+ *    SteeringTarget(...).
+ *
+ * The avoidance of a body is the sum over its neighbors
+ * of (1 - distance/radius) in the direction away from the
+ * neighbor, times the weight.
+ */
+class SeparationSteering
+{
+private:
+   uint32 _count;
+   float32 _radius;
+   float32 _weight;
+   SpatialHash _hash;
+   vector<Vec2> _positions;
+   vector<Vec2> _avoidance;
+   // Scratch space for Calculate().
+   vector<uint32> _neighbors;
+   
+public:
+   SeparationSteering();
+   
+   // A radius of 0 turns it off.
+   inline void SetRadius(float32 radius) { _radius = radius; }
+   inline float32 GetRadius() const { return _radius; }
+   inline bool IsEnabled() const { return _radius > 0; }
+   inline void SetWeight(float32 weight) { _weight = weight; }
+   inline float32 GetWeight() const { return _weight; }
+   
+   // The arrays only grow, so after the first few
+   // ticks this does not allocate.
+   void SetCount(uint32 count);
+   inline uint32 GetCount() const { return _count; }
+   inline void SetPosition(uint32 idx, const Vec2& position) { _positions[idx] = position; }
+   
+   void Build();
+   
+   void Calculate();
+   // neighbors is scratch space for the caller's thread.
+   void Calculate(uint32 begin, uint32 end, vector<uint32>& neighbors);
+   
+   inline const Vec2& GetAvoidance(uint32 idx) const { return _avoidance[idx]; }
+   
+   // The point to steer for instead of targetPos: the
+   // direction to the target turned by the avoidance, at
+   // the same distance (so "close enough" checks do not
+   // change).  With no avoidance, this is targetPos.
+   static inline Vec2 SteeringTarget(const Vec2& position, const Vec2& targetPos, const Vec2& avoidance)
+   {
+      if(avoidance.x == 0 && avoidance.y == 0)
+      {
+         return targetPos;
+      }
+      Vec2 toTarget = targetPos - position;
+      float32 distance = toTarget.Length();
+      if(distance < b2_epsilon)
+      {
+         return targetPos;
+      }
+      Vec2 direction = (1.0f/distance)*toTarget + avoidance;
+      if(direction.Normalize() < b2_epsilon)
+      {
+         return targetPos;
+      }
+      return position + distance*direction;
+   }
+};
+
+#endif /* defined(__MissileDemo__SeparationSteering__) */
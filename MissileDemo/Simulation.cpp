@@ -0,0 +1,344 @@
+/********************************************************************
+ * File   : Simulation.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/2/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "Simulation.h"
+#include "MovingEntityIFace.h"
+#include "FlowField.h"
+#include "Profiler.h"
+
+Simulation::Simulation() :
+   _world(NULL),
+   _physicsTasks(&_jobs),
+   _velocityIterations(8),
+   _positionIterations(1),
+   _timeStep(SECONDS_PER_TICK),
+   _accumulator(0.0),
+   _droppedSeconds(0.0),
+   _maxSubsteps(4),
+   _bodyStateListener(this)
+{
+   SetThreadCount(0);
+}
+
+Simulation::~Simulation()
+{
+   Shutdown();
+}
+
+void Simulation::Init(b2ContactSolverType contactSolver)
+{
+   Shutdown();
+   _world = new b2World(Vec2(0.0,0.0),contactSolver);
+   // Do we want to let bodies sleep?
+   // No for now...makes the debug layer blink
+   // which is annoying.
+   _world->SetAllowSleeping(false);
+   _world->SetContinuousPhysics(true);
+   _world->SetTaskExecutor(&_physicsTasks);
+   _world->SetDestructionListener(&_bodyStateListener);
+   _accumulator = 0.0;
+   _droppedSeconds = 0.0;
+   _swarm.Init(_world);
+}
+
+void Simulation::Shutdown()
+{
+   // The entities and the swarm destroy their bodies,
+   // so they must go before the world does.
+   DestroyEntities();
+   _swarm.Init(NULL);
+   _previousStates.clear();
+   delete _world;
+   _world = NULL;
+}
+
+void Simulation::AddEntity(MovingEntityIFace* entity)
+{
+   assert(entity != NULL);
+   entity->AttachTurnControllerBank(&_turnControllers);
+   _entities.push_back(entity);
+   _buckets.Add(entity);
+}
+
+void Simulation::DestroyEntities()
+{
+   for(uint32 idx = 0; idx < _entities.size(); idx++)
+   {
+      delete _entities[idx];
+   }
+   _entities.clear();
+   _buckets.Clear();
+   _turnControllers.Reset();
+   // The bodies are gone.
+   _previousStates.clear();
+}
+
+void Simulation::SetThreadCount(uint32 threadCount)
+{
+   _jobs.Init(threadCount);
+   _forceBuffers.clear();
+   _forceBuffers.resize(_jobs.GetThreadCount());
+   _separationScratch.resize(_jobs.GetThreadCount());
+}
+
+void Simulation::SetSeparation(float32 radius, float32 weight)
+{
+   _separation.SetRadius(radius);
+   _separation.SetWeight(weight);
+   if(!_separation.IsEnabled())
+   {
+      for(uint32 idx = 0; idx < _entities.size(); idx++)
+      {
+         _entities[idx]->SetAvoidance(Vec2(0,0));
+      }
+   }
+}
+
+void Simulation::UpdateFlowField(FlowField* field)
+{
+   assert(field != NULL);
+   field->Update(&_jobs);
+}
+
+void Simulation::EntityJob(void* context, uint32 begin, uint32 end, uint32 worker)
+{
+   const ENTITY_JOB_T* job = (const ENTITY_JOB_T*)context;
+   const vector<MovingEntityIFace*>& entities = *job->entities;
+   BodyForceBuffer* forceBuffer = &job->simulation->_forceBuffers[worker];
+   forceBuffer->BeginSegment(job->firstKey + begin);
+   for(uint32 idx = begin; idx < end; idx++)
+   {
+      MovingEntityIFace* entity = entities[idx];
+      entity->SetForceBuffer(forceBuffer);
+      (entity->*job->function)();
+      entity->SetForceBuffer(NULL);
+   }
+}
+
+void Simulation::SeparationJob(void* context, uint32 begin, uint32 end, uint32 worker)
+{
+   Simulation* simulation = (Simulation*)context;
+   simulation->_separation.Calculate(begin,end,simulation->_separationScratch[worker]);
+}
+
+void Simulation::UpdateSeparation()
+{
+   PROFILE_ZONE("Simulation::UpdateSeparation");
+   const uint32 count = _entities.size();
+   if(count == 0)
+   {
+      return;
+   }
+   // Every entity is something to keep away from,
+   // whatever it is doing.
+   _separation.SetCount(count);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      _separation.SetPosition(idx,_entities[idx]->GetPosition());
+   }
+   _separation.Build();
+   _jobs.ParallelFor(count,ENTITY_GRAIN_SIZE,SeparationJob,this);
+   // Only the ones going somewhere steer away.
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      MovingEntityIFace* entity = _entities[idx];
+      MovingEntityIFace::STATE_T state = entity->GetState();
+      if(state == MovingEntityIFace::ST_SEEK ||
+         state == MovingEntityIFace::ST_FOLLOW_PATH ||
+         state == MovingEntityIFace::ST_FOLLOW_FLOW)
+      {
+         entity->SetAvoidance(_separation.GetAvoidance(idx));
+      }
+      else
+      {
+         entity->SetAvoidance(Vec2(0,0));
+      }
+   }
+}
+
+void Simulation::RunActiveEntities(void (MovingEntityIFace::*function)())
+{
+   static void (MovingEntityIFace::* const stateFunctions[])() =
+   {
+      NULL,
+      &MovingEntityIFace::ExecuteTurnTowards,
+      &MovingEntityIFace::ExecuteSeek,
+      &MovingEntityIFace::ExecuteFollowPath,
+      &MovingEntityIFace::ExecuteIntercept,
+      &MovingEntityIFace::ExecuteFollowFlow,
+   };
+   
+   ENTITY_JOB_T job;
+   job.simulation = this;
+   job.firstKey = 0;
+   for(uint32 state = MovingEntityIFace::ST_IDLE+1; state < MovingEntityIFace::ST_MAX; state++)
+   {
+      job.entities = &_buckets.GetBucket((MovingEntityIFace::STATE_T)state);
+      job.function = (function != NULL) ? function : stateFunctions[state];
+      _jobs.ParallelFor(job.entities->size(),ENTITY_GRAIN_SIZE,EntityJob,&job);
+      job.firstKey += job.entities->size();
+   }
+   BodyForceBuffer::ApplyInOrder(_forceBuffers);
+}
+
+void Simulation::ReconcileBuckets()
+{
+   _buckets.Reconcile(&_stopped);
+   // One last notification for the entities that
+   // stopped, they are not updated any more.
+   for(uint32 idx = 0; idx < _stopped.size(); idx++)
+   {
+      _stopped[idx]->UpdateNotifications();
+   }
+   _stopped.clear();
+}
+
+void Simulation::UpdateEntities()
+{
+   PROFILE_ZONE("Simulation::UpdateEntities");
+   // Commands given since the last tick.
+   ReconcileBuckets();
+   
+   if(_separation.IsEnabled())
+   {
+      UpdateSeparation();
+   }
+   RunActiveEntities(NULL);
+   
+   // All the turn errors are in; calculate the
+   // turn controller outputs in one go.
+   _turnControllers.Evaluate();
+   RunActiveEntities(&MovingEntityIFace::ApplyBatchedTurnTorque);
+   
+   // State changes made during the update.
+   ReconcileBuckets();
+   
+   // Telemetry is only recorded from this thread.
+   for(uint32 state = MovingEntityIFace::ST_IDLE+1; state < MovingEntityIFace::ST_MAX; state++)
+   {
+      const vector<MovingEntityIFace*>& bucket = _buckets.GetBucket((MovingEntityIFace::STATE_T)state);
+      for(uint32 idx = 0; idx < bucket.size(); idx++)
+      {
+         bucket[idx]->UpdateNotifications();
+      }
+   }
+   _swarm.Update();
+}
+
+void Simulation::UpdatePhysics()
+{
+   // Instruct the world to perform a single step of simulation. It is
+   // generally best to keep the time step and iterations fixed.
+   PROFILE_ZONE("b2World::Step");
+   uint64 stepStart = StopWatch::GetTicks();
+   _world->Step(_timeStep, _velocityIterations, _positionIterations);
+   Profiler::Instance().RecordWorldProfile(_world->GetProfile(),stepStart);
+}
+
+void Simulation::SavePreviousStates()
+{
+   _previousStates.resize(_world->GetBodyCount());
+   uint32 idx = 0;
+   for(const Body* body = _world->GetBodyList(); body != NULL; body = body->GetNext(), idx++)
+   {
+      BODY_STATE_T& state = _previousStates[idx];
+      state.body = body;
+      state.worldCenter = body->GetWorldCenter();
+      state.angle = body->GetAngle();
+   }
+   sort(_previousStates.begin(),_previousStates.end(),BodyStateLess);
+}
+
+bool Simulation::BodyStateLess(const BODY_STATE_T& lhs, const BODY_STATE_T& rhs)
+{
+   return less<const Body*>()(lhs.body,rhs.body);
+}
+
+void Simulation::ForgetPreviousState(const Body* body)
+{
+   BODY_STATE_T key;
+   key.body = body;
+   vector<BODY_STATE_T>::iterator iter = lower_bound(_previousStates.begin(),_previousStates.end(),key,BodyStateLess);
+   if(iter != _previousStates.end() && iter->body == body)
+   {
+      _previousStates.erase(iter);
+   }
+}
+
+uint32 Simulation::Advance(float32 elapsedSeconds)
+{
+   assert(elapsedSeconds >= 0);
+   PROFILE_ZONE("Simulation::Advance");
+   _accumulator += elapsedSeconds;
+   uint32 ticks = (uint32)(_accumulator/_timeStep);
+   if(ticks > _maxSubsteps)
+   {  // Can't keep up.  Drop the whole ticks we have no
+      // time for, keep the fraction so the alpha is smooth.
+      double dropped = (ticks - _maxSubsteps)*(double)_timeStep;
+      _droppedSeconds += dropped;
+      _accumulator -= dropped;
+      ticks = _maxSubsteps;
+   }
+   for(uint32 tick = 0; tick < ticks; tick++)
+   {
+      // Only the state before the last tick is needed
+      // for interpolation.
+      if(tick == ticks-1)
+      {
+         SavePreviousStates();
+      }
+      Update();
+      _accumulator -= _timeStep;
+   }
+   if(_accumulator < 0.0)
+   {
+      _accumulator = 0.0;
+   }
+   return ticks;
+}
+
+b2Transform Simulation::GetInterpolatedTransform(const Body* body) const
+{
+   BODY_STATE_T key;
+   key.body = body;
+   vector<BODY_STATE_T>::const_iterator iter = lower_bound(_previousStates.begin(),_previousStates.end(),key,BodyStateLess);
+   if(iter == _previousStates.end() || iter->body != body)
+   {
+      return body->GetTransform();
+   }
+   const BODY_STATE_T& state = *iter;
+   float32 alpha = GetInterpolationAlpha();
+   // Blend the center of mass and angle (the angle is not
+   // wrapped by Box2D, so it can be blended directly), then
+   // put the origin back relative to the center.
+   Vec2 worldCenter = state.worldCenter + alpha*(body->GetWorldCenter() - state.worldCenter);
+   float32 angle = state.angle + alpha*(body->GetAngle() - state.angle);
+   b2Transform xf;
+   xf.q.Set(angle);
+   xf.p = worldCenter - b2Mul(xf.q,body->GetLocalCenter());
+   return xf;
+}
@@ -0,0 +1,248 @@
+/********************************************************************
+ * File   : Simulation.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/2/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+#ifndef __MissileDemo__Simulation__
+#define __MissileDemo__Simulation__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "MissileSwarm.h"
+#include "PIDControllerBank.h"
+#include "JobSystem.h"
+#include "PhysicsTasks.h"
+#include "BodyForceBuffer.h"
+#include "EntityStateBuckets.h"
+#include "SeparationSteering.h"
+
+class MovingEntityIFace;
+class FlowField;
+
+/* This class owns the physics world and the moving
+ * entities in it and knows how to advance them by
+ * one tick.  It has no knowledge of cocos2d-x, so
+ * it can be driven by the MainScene (once per frame)
+ * or by a headless application (e.g. the benchmark)
+ * as fast as it can go.
+ *
+ * The Simulation owns the entities added to it and
+ * will delete them before it deletes the world.
+ *
+ * The turn controllers of all the entities live in one
+ * PIDControllerBank, so their outputs are calculated in
+ * a single batch each tick.
+ *
+ * The entities are kept in buckets by steering state.
+ * Each bucket is run as a batch of the same state
+ * function, and idle entities are not touched at all.
+ *
+ * The entity steering runs on a JobSystem, one thread per
+ * core by default.  The forces go into per-worker
+ * BodyForceBuffers and are applied in entity order, so the
+ * results are the same for any number of threads.
+ *
+ * The physics world solves its islands on the same
+ * JobSystem (see PhysicsTasks).  Islands do not depend
+ * on each other, so the world steps the same way for
+ * any number of threads too.
+ *
+ * Advance(...) runs the fixed ticks for a variable
+ * amount of elapsed (frame) time.  Time left over that is
+ * less than a tick is carried to the next call, and
+ * GetInterpolationAlpha() says how far into the next tick
+ * the leftover is, so rendering can blend between the
+ * last two physics states (GetInterpolatedTransform(...)).
+ * At most GetMaxSubsteps() ticks are run per call; if
+ * the simulation cannot keep up, the extra time is
+ * dropped instead of piling up (the "spiral of death").
+ *
+ * SetSeparation(...) makes the seeking, path and flow
+ * following entities steer away from each other before
+ * they collide (see SeparationSteering).  The neighbor
+ * queries run on the JobSystem too.
+ *
+ * Flow fields (see FlowField) are shared by the entities
+ * following them, not owned.  UpdateFlowField(...) brings
+ * one up to date on the JobSystem; call it between ticks.
+ *
+ * Large numbers of missiles should go into the swarm
+ * (GetSwarm()) instead of being added as entities; the
+ * swarm is updated right after the entities.
+ */
+class Simulation
+{
+private:
+   enum
+   {
+      // Entities per job chunk.
+      ENTITY_GRAIN_SIZE = 64
+   };
+   
+   // A batch of entities for the JobSystem.
+   typedef struct
+   {
+      Simulation* simulation;
+      const vector<MovingEntityIFace*>* entities;
+      void (MovingEntityIFace::*function)();
+      // Force buffer segment key of the first entity.
+      uint32 firstKey;
+   } ENTITY_JOB_T;
+   
+   // A body's position before the last tick.
+   typedef struct
+   {
+      const Body* body;
+      Vec2 worldCenter;
+      float32 angle;
+   } BODY_STATE_T;
+   
+   // Drops a body's previous state when the body is destroyed,
+   // so a body created later at the same address does not
+   // pick it up.  Box2D says goodbye to each of the body's
+   // fixtures; every body here has at least one.
+   class BodyStateListener : public b2DestructionListener
+   {
+   private:
+      Simulation* _simulation;
+   public:
+      BodyStateListener(Simulation* simulation) : _simulation(simulation) { }
+      virtual void SayGoodbye(b2Joint* /*joint*/) { }
+      virtual void SayGoodbye(b2Fixture* fixture) { _simulation->ForgetPreviousState(fixture->GetBody()); }
+   };
+   
+   b2World* _world;
+   vector<MovingEntityIFace*> _entities;
+   EntityStateBuckets _buckets;
+   // Entities that went idle, for UpdateEntities().
+   vector<MovingEntityIFace*> _stopped;
+   PIDControllerBank _turnControllers;
+   MissileSwarm _swarm;
+   JobSystem _jobs;
+   // Runs the world's island solving on _jobs.
+   PhysicsTasks _physicsTasks;
+   // One per worker thread.
+   vector<BodyForceBuffer> _forceBuffers;
+   SeparationSteering _separation;
+   // Neighbor scratch space, one per worker thread.
+   vector< vector<uint32> > _separationScratch;
+   int32 _velocityIterations;
+   int32 _positionIterations;
+   float32 _timeStep;
+   
+   // Fixed time step state for Advance(...).
+   double _accumulator;
+   double _droppedSeconds;
+   uint32 _maxSubsteps;
+   // Sorted by body, so creating or destroying a body (which
+   // shifts the world body list) does not mix up the states.
+   vector<BODY_STATE_T> _previousStates;
+   BodyStateListener _bodyStateListener;
+   
+   void SavePreviousStates();
+   void ForgetPreviousState(const Body* body);
+   static bool BodyStateLess(const BODY_STATE_T& lhs, const BODY_STATE_T& rhs);
+   static void EntityJob(void* context, uint32 begin, uint32 end, uint32 worker);
+   static void SeparationJob(void* context, uint32 begin, uint32 end, uint32 worker);
+   void UpdateSeparation();
+   // Calls the function for each of the active (not idle)
+   // entities, bucket by bucket, on the JobSystem.  A NULL
+   // function calls the function for the bucket's state.
+   void RunActiveEntities(void (MovingEntityIFace::*function)());
+   void ReconcileBuckets();
+   
+public:
+   Simulation();
+   ~Simulation();
+   
+   // Create the physics world.  Calling this again
+   // destroys all the entities and the old world.
+   // b2_wideContactSolver solves the contacts several at a
+   // time with SIMD; the results are not the same as the
+   // (default) scalar solver's.
+   void Init(b2ContactSolverType contactSolver = b2_scalarContactSolver);
+   void Shutdown();
+   
+   b2World* GetWorld() { return _world; }
+   const b2Profile& GetProfile() const { return _world->GetProfile(); }
+   
+   // The Simulation takes ownership of the entity.
+   void AddEntity(MovingEntityIFace* entity);
+   void DestroyEntities();
+   uint32 GetEntityCount() const { return _entities.size(); }
+   MovingEntityIFace* GetEntity(uint32 idx) { return _entities[idx]; }
+   
+   MissileSwarm& GetSwarm() { return _swarm; }
+   
+   // Threads used for the entity update and the physics
+   // islands, including the calling thread.  Zero means one
+   // per core.
+   void SetThreadCount(uint32 threadCount);
+   inline uint32 GetThreadCount() const { return _jobs.GetThreadCount(); }
+   
+   inline float32 GetTimeStep() const { return _timeStep; }
+   inline void SetTimeStep(float32 timeStep) { _timeStep = timeStep; }
+   inline int32 GetVelocityIterations() const { return _velocityIterations; }
+   inline void SetVelocityIterations(int32 iterations) { _velocityIterations = iterations; }
+   inline int32 GetPositionIterations() const { return _positionIterations; }
+   inline void SetPositionIterations(int32 iterations) { _positionIterations = iterations; }
+   
+   // Entities within radius of each other steer apart.  A
+   // radius of 0 (the default) turns it off.  This is for
+   // the entities; the swarm has its own.
+   void SetSeparation(float32 radius, float32 weight = 1.0);
+   inline float32 GetSeparationRadius() const { return _separation.GetRadius(); }
+   
+   // Rebuilds or repairs the field using the entity threads.
+   void UpdateFlowField(FlowField* field);
+   
+   // Run the entity logic (steering, etc.) for every entity
+   // and the swarm.
+   void UpdateEntities();
+   // Advance the physics world one fixed time step.
+   void UpdatePhysics();
+   // A full tick:  entities, then physics.
+   void Update()
+   {
+      UpdateEntities();
+      UpdatePhysics();
+   }
+   
+   // Run the ticks for elapsedSeconds of wall time.
+   // Returns the number of ticks run.
+   uint32 Advance(float32 elapsedSeconds);
+   // 0..1, how far the leftover time is into the next tick.
+   inline float32 GetInterpolationAlpha() const { return Min((float32)(_accumulator/_timeStep),1.0f); }
+   inline uint32 GetMaxSubsteps() const { return _maxSubsteps; }
+   inline void SetMaxSubsteps(uint32 maxSubsteps) { assert(maxSubsteps > 0); _maxSubsteps = maxSubsteps; }
+   // Total time thrown away because of the substep cap.
+   inline double GetDroppedSeconds() const { return _droppedSeconds; }
+   
+   // The body's transform GetInterpolationAlpha() of the way
+   // from the previous tick to the current one.  Bodies
+   // created since the last tick get their current transform.
+   b2Transform GetInterpolatedTransform(const Body* body) const;
+};
+
+#endif /* defined(__MissileDemo__Simulation__) */
@@ -0,0 +1,263 @@
+/********************************************************************
+ * File   : SpatialHash.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "SpatialHash.h"
+
+SpatialHash::SpatialHash() :
+   _count(0),
+   _cellSize(1),
+   _invCellSize(1),
+   _tableMask(0),
+   _minCellX(0),
+   _minCellY(0),
+   _maxCellX(-1),
+   _maxCellY(-1)
+{
+}
+
+void SpatialHash::Build(const Vec2* positions, uint32 count, float32 cellSize)
+{
+   _count = count;
+   _minCellX = _minCellY = 0;
+   _maxCellX = _maxCellY = -1;
+   if(count == 0)
+   {
+      return;
+   }
+   
+   if(cellSize <= 0)
+   {  // About two points per cell of the bounding box.
+      Vec2 lower = positions[0];
+      Vec2 upper = positions[0];
+      for(uint32 idx = 1; idx < count; idx++)
+      {
+         lower = b2Min(lower,positions[idx]);
+         upper = b2Max(upper,positions[idx]);
+      }
+      Vec2 extent = upper - lower;
+      cellSize = sqrtf(2*extent.x*extent.y/count);
+      if(cellSize < b2_epsilon)
+      {  // The points are all in a line (or one place).
+         cellSize = Max(Max(extent.x,extent.y)*2/count,1.0f);
+      }
+   }
+   _cellSize = cellSize;
+   _invCellSize = 1.0f/cellSize;
+   
+   uint32 tableSize = 16;
+   while(tableSize < 2*count)
+   {
+      tableSize *= 2;
+   }
+   _tableMask = tableSize-1;
+   
+   // Count the points in each bucket.
+   _bucketStart.assign(tableSize+1,0);
+   _buckets.resize(count);
+   _cellX.resize(count);
+   _cellY.resize(count);
+   _positions.resize(count);
+   _indexes.resize(count);
+   _minCellX = _maxCellX = CellCoord(positions[0].x);
+   _minCellY = _maxCellY = CellCoord(positions[0].y);
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      int32 cellX = CellCoord(positions[idx].x);
+      int32 cellY = CellCoord(positions[idx].y);
+      _minCellX = Min(_minCellX,cellX);
+      _minCellY = Min(_minCellY,cellY);
+      _maxCellX = Max(_maxCellX,cellX);
+      _maxCellY = Max(_maxCellY,cellY);
+      uint32 bucket = CellBucket(cellX,cellY);
+      _buckets[idx] = bucket;
+      _bucketStart[bucket+1]++;
+   }
+   for(uint32 bucket = 0; bucket < tableSize; bucket++)
+   {
+      _bucketStart[bucket+1] += _bucketStart[bucket];
+   }
+   
+   // Scatter the points into their buckets.  _bucketStart[b]
+   // is used as the insert point and ends up at the end of
+   // bucket b, so it is shifted back after.
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      uint32 slot = _bucketStart[_buckets[idx]]++;
+      _positions[slot] = positions[idx];
+      _indexes[slot] = idx;
+      _cellX[slot] = CellCoord(positions[idx].x);
+      _cellY[slot] = CellCoord(positions[idx].y);
+   }
+   for(uint32 bucket = tableSize; bucket > 0; bucket--)
+   {
+      _bucketStart[bucket] = _bucketStart[bucket-1];
+   }
+   _bucketStart[0] = 0;
+}
+
+uint32 SpatialHash::QueryRadius(const Vec2& center, float32 radius, vector<uint32>& results) const
+{
+   if(_count == 0)
+   {
+      return 0;
+   }
+   const float32 radiusSquared = radius*radius;
+   const int32 lowX = Max(CellCoord(center.x - radius),_minCellX);
+   const int32 lowY = Max(CellCoord(center.y - radius),_minCellY);
+   const int32 highX = Min(CellCoord(center.x + radius),_maxCellX);
+   const int32 highY = Min(CellCoord(center.y + radius),_maxCellY);
+   uint32 found = 0;
+   for(int32 cellY = lowY; cellY <= highY; cellY++)
+   {
+      for(int32 cellX = lowX; cellX <= highX; cellX++)
+      {
+         uint32 bucket = CellBucket(cellX,cellY);
+         for(uint32 slot = _bucketStart[bucket]; slot < _bucketStart[bucket+1]; slot++)
+         {
+            if(_cellX[slot] == cellX && _cellY[slot] == cellY &&
+               (_positions[slot] - center).LengthSquared() <= radiusSquared)
+            {
+               results.push_back(_indexes[slot]);
+               found++;
+            }
+         }
+      }
+   }
+   return found;
+}
+
+void SpatialHash::QueryCellNearest(int32 cellX, int32 cellY, const Vec2& center, uint32 k, float32 maxDistanceSquared,
+                                   NEIGHBOR_T* results, uint32& found) const
+{
+   uint32 bucket = CellBucket(cellX,cellY);
+   for(uint32 slot = _bucketStart[bucket]; slot < _bucketStart[bucket+1]; slot++)
+   {
+      if(_cellX[slot] != cellX || _cellY[slot] != cellY)
+      {
+         continue;
+      }
+      float32 distanceSquared = (_positions[slot] - center).LengthSquared();
+      uint32 index = _indexes[slot];
+      if(distanceSquared > maxDistanceSquared)
+      {
+         continue;
+      }
+      if(found == k &&
+         (distanceSquared > results[k-1].distanceSquared ||
+          (distanceSquared == results[k-1].distanceSquared && index > results[k-1].index)))
+      {
+         continue;
+      }
+      // Insertion sort; k is small.  Ties go to the lower
+      // index, so the order does not depend on the buckets.
+      uint32 pos = (found < k) ? found++ : k-1;
+      while(pos > 0 &&
+            (results[pos-1].distanceSquared > distanceSquared ||
+             (results[pos-1].distanceSquared == distanceSquared && results[pos-1].index > index)))
+      {
+         results[pos] = results[pos-1];
+         pos--;
+      }
+      results[pos].index = index;
+      results[pos].distanceSquared = distanceSquared;
+   }
+}
+
+uint32 SpatialHash::QueryNearest(const Vec2& center, uint32 k, NEIGHBOR_T* results, float32 maxRadius) const
+{
+   if(_count == 0 || k == 0)
+   {
+      return 0;
+   }
+   const float32 maxDistanceSquared = (maxRadius < sqrtf(numeric_limits<float32>::max())) ?
+                                      maxRadius*maxRadius : numeric_limits<float32>::max();
+   const int32 centerX = CellCoord(center.x);
+   const int32 centerY = CellCoord(center.y);
+   // Far enough out to take in every point.
+   const int32 maxRing = Max(Max(centerX - _minCellX,_maxCellX - centerX),
+                             Max(centerY - _minCellY,_maxCellY - centerY));
+   uint32 found = 0;
+   
+   // Look at the cells in rings around the center cell.
+   for(int32 ring = 0; ring <= maxRing; ring++)
+   {
+      if(ring > 0)
+      {  // Every point not looked at yet is at least
+         // this far away.
+         float32 reach = (ring-1)*_cellSize;
+         if(reach*reach > maxDistanceSquared ||
+            (found == k && results[k-1].distanceSquared < reach*reach))
+         {
+            break;
+         }
+      }
+      const int32 lowX = Max(centerX - ring,_minCellX);
+      const int32 highX = Min(centerX + ring,_maxCellX);
+      const int32 lowY = Max(centerY - ring + 1,_minCellY);
+      const int32 highY = Min(centerY + ring - 1,_maxCellY);
+      // Bottom and top rows.
+      if(centerY - ring >= _minCellY)
+      {
+         for(int32 cellX = lowX; cellX <= highX; cellX++)
+         {
+            QueryCellNearest(cellX,centerY - ring,center,k,maxDistanceSquared,results,found);
+         }
+      }
+      if(ring > 0 && centerY + ring <= _maxCellY)
+      {
+         for(int32 cellX = lowX; cellX <= highX; cellX++)
+         {
+            QueryCellNearest(cellX,centerY + ring,center,k,maxDistanceSquared,results,found);
+         }
+      }
+      // Left and right columns, without the corners.
+      if(ring > 0 && centerX - ring >= _minCellX)
+      {
+         for(int32 cellY = lowY; cellY <= highY; cellY++)
+         {
+            QueryCellNearest(centerX - ring,cellY,center,k,maxDistanceSquared,results,found);
+         }
+      }
+      if(ring > 0 && centerX + ring <= _maxCellX)
+      {
+         for(int32 cellY = lowY; cellY <= highY; cellY++)
+         {
+            QueryCellNearest(centerX + ring,cellY,center,k,maxDistanceSquared,results,found);
+         }
+      }
+   }
+   return found;
+}
+
+void SpatialHash::QueryNearest(const Vec2* centers, uint32 count, uint32 k, NEIGHBOR_T* results, uint32* found,
+                               float32 maxRadius) const
+{
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      found[idx] = QueryNearest(centers[idx],k,results + idx*k,maxRadius);
+   }
+}
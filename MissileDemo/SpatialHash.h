@@ -0,0 +1,121 @@
+/********************************************************************
+ * File   : SpatialHash.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__SpatialHash__
+#define __MissileDemo__SpatialHash__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+
+/* A uniform grid over a set of points, for finding the
+ * points near a position without looking at all of them.
+ *
+ * The grid is hashed into a table about twice the size
+ * of the point set, so it covers any area and costs
+ * nothing for empty cells.  Build(...) sorts the points
+ * by bucket with a counting sort; it is cheap enough to
+ * rebuild every tick, which is simpler than moving points
+ * between cells.
+ *
+ * Points are referred to by their index in the array
+ * passed to Build(...).
+ *
+ * The queries give the same points (and for the nearest
+ * ones, in the same order) as checking every point.
+ */
+class SpatialHash
+{
+public:
+   typedef struct
+   {
+      uint32 index;
+      float32 distanceSquared;
+   } NEIGHBOR_T;
+   
+private:
+   uint32 _count;
+   float32 _cellSize;
+   float32 _invCellSize;
+   uint32 _tableMask;
+   // The cells the points cover.
+   int32 _minCellX;
+   int32 _minCellY;
+   int32 _maxCellX;
+   int32 _maxCellY;
+   // The points in bucket b are [_bucketStart[b],_bucketStart[b+1]).
+   vector<uint32> _bucketStart;
+   // The points, sorted by bucket.  Different cells can
+   // land in the same bucket, so the cell is kept too.
+   vector<Vec2> _positions;
+   vector<uint32> _indexes;
+   vector<int32> _cellX;
+   vector<int32> _cellY;
+   // Scratch space for Build(...).
+   vector<uint32> _buckets;
+   
+   inline int32 CellCoord(float32 value) const
+   {
+      return (int32)floorf(value*_invCellSize);
+   }
+   
+   inline uint32 CellBucket(int32 cellX, int32 cellY) const
+   {
+      return (((uint32)cellX*73856093u) ^ ((uint32)cellY*19349663u)) & _tableMask;
+   }
+   
+   void QueryCellNearest(int32 cellX, int32 cellY, const Vec2& center, uint32 k, float32 maxDistanceSquared,
+                         NEIGHBOR_T* results, uint32& found) const;
+   
+public:
+   SpatialHash();
+   
+   // A cellSize of 0 picks one that puts about two
+   // points in each cell of the bounding box.  Queries
+   // are fastest when the cell is about the size of the
+   // query radius.
+   void Build(const Vec2* positions, uint32 count, float32 cellSize = 0);
+   
+   inline uint32 GetCount() const { return _count; }
+   inline float32 GetCellSize() const { return _cellSize; }
+   
+   // Appends the points within radius of center to results
+   // (in no particular order) and returns how many.
+   uint32 QueryRadius(const Vec2& center, float32 radius, vector<uint32>& results) const;
+   
+   // Finds up to k points nearest to center, no farther
+   // than maxRadius.  results (k of them) is sorted by
+   // distance, nearest first.  Returns how many were found.
+   uint32 QueryNearest(const Vec2& center, uint32 k, NEIGHBOR_T* results,
+                       float32 maxRadius = numeric_limits<float32>::max()) const;
+   
+   // QueryNearest(...) for a batch of centers.  results has
+   // k entries for each center and found one count each.
+   void QueryNearest(const Vec2* centers, uint32 count, uint32 k, NEIGHBOR_T* results, uint32* found,
+                     float32 maxRadius = numeric_limits<float32>::max()) const;
+};
+
+#endif /* defined(__MissileDemo__SpatialHash__) */
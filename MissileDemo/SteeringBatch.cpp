@@ -0,0 +1,274 @@
+/********************************************************************
+ * File   : SteeringBatch.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/9/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "SteeringBatch.h"
+#include "MathUtilities.h"
+#include "MathSIMD.h"
+
+SteeringBatch::SteeringBatch() :
+   _count(0)
+{
+}
+
+void SteeringBatch::SetCount(uint32 count)
+{
+   _count = count;
+   if(count <= _posX.size())
+   {
+      return;
+   }
+   _posX.resize(count);
+   _posY.resize(count);
+   _angle.resize(count);
+   _velX.resize(count);
+   _velY.resize(count);
+   _dirX.resize(count);
+   _dirY.resize(count);
+   _inertia.resize(count);
+   _mass.resize(count);
+   _targetX.resize(count);
+   _targetY.resize(count);
+   _maxAngularAcceleration.resize(count);
+   _maxLinearAcceleration.resize(count);
+   _maxSpeed.resize(count);
+   _turnOutput.resize(count);
+   _turnError.resize(count);
+   _torque.resize(count);
+   _newVelX.resize(count);
+   _newVelY.resize(count);
+   _forceX.resize(count);
+   _forceY.resize(count);
+}
+
+const char* SteeringBatch::AccuracyString(ACCURACY_T accuracy)
+{
+   switch(accuracy)
+   {
+      case SA_EXACT:
+         return "exact";
+      case SA_FAST:
+         return "fast";
+      case SA_FASTEST:
+         return "fastest";
+      default:
+         assert(false);
+         return "unknown";
+   }
+}
+
+const char* SteeringBatch::GetSIMDName()
+{
+#if defined(__AVX__)
+   return "AVX";
+#elif defined(__SSE2__)
+   return "SSE2";
+#else
+   return "None";
+#endif
+}
+
+/* Exactly the same calculation as Missile::ApplyTurnTorque().
+ */
+void SteeringBatch::CalculateTurnErrorsExact()
+{
+   for(uint32 idx = 0; idx < _count; idx++)
+   {
+      Vec2 toTarget(_targetX[idx]-_posX[idx],_targetY[idx]-_posY[idx]);
+      Vec2 vel(_velX[idx],_velY[idx]);
+      float32 angleBodyRads = MathUtilities::AdjustAngle(_angle[idx]);
+      if(vel.LengthSquared() > 0)
+      {  // Body is moving
+         angleBodyRads = MathUtilities::AdjustAngle(atan2f(vel.y,vel.x));
+      }
+      float32 angleTargetRads = MathUtilities::AdjustAngle(atan2f(toTarget.y, toTarget.x));
+      _turnError[idx] = MathUtilities::AdjustAngle(angleBodyRads - angleTargetRads);
+   }
+}
+
+void SteeringBatch::CalculateTurnErrorsScalar(uint32 start, ACCURACY_T accuracy)
+{
+   const bool fastest = (accuracy == SA_FASTEST);
+   for(uint32 idx = start; idx < _count; idx++)
+   {
+      float32 toX = _targetX[idx]-_posX[idx];
+      float32 toY = _targetY[idx]-_posY[idx];
+      float32 velX = _velX[idx];
+      float32 velY = _velY[idx];
+      float32 angleBodyRads = _angle[idx];
+      if(velX*velX + velY*velY > 0)
+      {  // Body is moving
+         angleBodyRads = fastest ? MathUtilities::Atan2Fastest(velY,velX) : MathUtilities::Atan2Fast(velY,velX);
+      }
+      float32 angleTargetRads = fastest ? MathUtilities::Atan2Fastest(toY,toX) : MathUtilities::Atan2Fast(toY,toX);
+      // The difference is wrapped, so the angles do
+      // not need to be.
+      _turnError[idx] = MathUtilities::WrapAngle(angleBodyRads - angleTargetRads);
+   }
+}
+
+/* Returns the number of bodies calculated; the scalar
+ * kernel finishes the rest.
+ */
+uint32 SteeringBatch::CalculateTurnErrorsSIMD(ACCURACY_T accuracy)
+{
+   const bool fastest = (accuracy == SA_FASTEST);
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + 8 <= _count; idx += 8)
+   {
+      __m256 toX = _mm256_sub_ps(_mm256_loadu_ps(&_targetX[idx]),_mm256_loadu_ps(&_posX[idx]));
+      __m256 toY = _mm256_sub_ps(_mm256_loadu_ps(&_targetY[idx]),_mm256_loadu_ps(&_posY[idx]));
+      __m256 velX = _mm256_loadu_ps(&_velX[idx]);
+      __m256 velY = _mm256_loadu_ps(&_velY[idx]);
+      __m256 speedSq = _mm256_add_ps(_mm256_mul_ps(velX,velX),_mm256_mul_ps(velY,velY));
+      __m256 moving = _mm256_cmp_ps(speedSq,_mm256_setzero_ps(),_CMP_GT_OQ);
+      __m256 angleBodyRads = _mm256_blendv_ps(_mm256_loadu_ps(&_angle[idx]),Atan2AVX(velY,velX,fastest),moving);
+      __m256 angleTargetRads = Atan2AVX(toY,toX,fastest);
+      _mm256_storeu_ps(&_turnError[idx],WrapAngleAVX(_mm256_sub_ps(angleBodyRads,angleTargetRads)));
+   }
+#elif defined(__SSE2__)
+   for(; idx + 4 <= _count; idx += 4)
+   {
+      __m128 toX = _mm_sub_ps(_mm_loadu_ps(&_targetX[idx]),_mm_loadu_ps(&_posX[idx]));
+      __m128 toY = _mm_sub_ps(_mm_loadu_ps(&_targetY[idx]),_mm_loadu_ps(&_posY[idx]));
+      __m128 velX = _mm_loadu_ps(&_velX[idx]);
+      __m128 velY = _mm_loadu_ps(&_velY[idx]);
+      __m128 speedSq = _mm_add_ps(_mm_mul_ps(velX,velX),_mm_mul_ps(velY,velY));
+      __m128 moving = _mm_cmpgt_ps(speedSq,_mm_setzero_ps());
+      __m128 angleBodyRads = SelectSSE(moving,Atan2SSE(velY,velX,fastest),_mm_loadu_ps(&_angle[idx]));
+      __m128 angleTargetRads = Atan2SSE(toY,toX,fastest);
+      _mm_storeu_ps(&_turnError[idx],WrapAngleSSE(_mm_sub_ps(angleBodyRads,angleTargetRads)));
+   }
+#else
+   (void)fastest;
+#endif
+   return idx;
+}
+
+void SteeringBatch::CalculateTurnErrors(ACCURACY_T accuracy)
+{
+   if(accuracy == SA_EXACT)
+   {
+      CalculateTurnErrorsExact();
+   }
+   else
+   {
+      CalculateTurnErrorsScalar(CalculateTurnErrorsSIMD(accuracy),accuracy);
+   }
+}
+
+/* Same as Missile::ApplyTurnOutput(...).
+ */
+void SteeringBatch::CalculateTurnTorques()
+{
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + 8 <= _count; idx += 8)
+   {
+      __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(&_turnOutput[idx]));
+      __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(&_turnOutput[idx+4]));
+      __m256 maxAngAcc = _mm256_loadu_ps(&_maxAngularAcceleration[idx]);
+      // Negative Feedback
+      __m256 angAcc = _mm256_xor_ps(_mm256_insertf128_ps(_mm256_castps128_ps256(lo),hi,1),_mm256_set1_ps(-0.0f));
+      angAcc = _mm256_min_ps(angAcc,maxAngAcc);
+      angAcc = _mm256_max_ps(angAcc,_mm256_xor_ps(maxAngAcc,_mm256_set1_ps(-0.0f)));
+      _mm256_storeu_ps(&_torque[idx],_mm256_mul_ps(angAcc,_mm256_loadu_ps(&_inertia[idx])));
+   }
+#elif defined(__SSE2__)
+   for(; idx + 4 <= _count; idx += 4)
+   {
+      __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(&_turnOutput[idx]));
+      __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(&_turnOutput[idx+2]));
+      __m128 maxAngAcc = _mm_loadu_ps(&_maxAngularAcceleration[idx]);
+      // Negative Feedback
+      __m128 angAcc = _mm_xor_ps(_mm_movelh_ps(lo,hi),_mm_set1_ps(-0.0f));
+      angAcc = _mm_min_ps(angAcc,maxAngAcc);
+      angAcc = _mm_max_ps(angAcc,_mm_xor_ps(maxAngAcc,_mm_set1_ps(-0.0f)));
+      _mm_storeu_ps(&_torque[idx],_mm_mul_ps(angAcc,_mm_loadu_ps(&_inertia[idx])));
+   }
+#endif
+   for(; idx < _count; idx++)
+   {
+      // Negative Feedback
+      float32 angAcc = -_turnOutput[idx];
+      float32 maxAngAcc = _maxAngularAcceleration[idx];
+      if(angAcc > maxAngAcc)
+         angAcc = maxAngAcc;
+      if(angAcc < -maxAngAcc)
+         angAcc = -maxAngAcc;
+      _torque[idx] = angAcc * _inertia[idx];
+   }
+}
+
+/* Same as Missile::ApplyThrust().
+ */
+void SteeringBatch::CalculateThrust()
+{
+   uint32 idx = 0;
+#if defined(__AVX__)
+   for(; idx + 8 <= _count; idx += 8)
+   {
+      __m256 velX = _mm256_loadu_ps(&_velX[idx]);
+      __m256 velY = _mm256_loadu_ps(&_velY[idx]);
+      __m256 dirX = _mm256_loadu_ps(&_dirX[idx]);
+      __m256 dirY = _mm256_loadu_ps(&_dirY[idx]);
+      __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(velX,velX),_mm256_mul_ps(velY,velY)));
+      speed = _mm256_min_ps(speed,_mm256_loadu_ps(&_maxSpeed[idx]));
+      __m256 thrust = _mm256_mul_ps(_mm256_loadu_ps(&_maxLinearAcceleration[idx]),_mm256_loadu_ps(&_mass[idx]));
+      _mm256_storeu_ps(&_newVelX[idx],_mm256_mul_ps(speed,dirX));
+      _mm256_storeu_ps(&_newVelY[idx],_mm256_mul_ps(speed,dirY));
+      _mm256_storeu_ps(&_forceX[idx],_mm256_mul_ps(thrust,dirX));
+      _mm256_storeu_ps(&_forceY[idx],_mm256_mul_ps(thrust,dirY));
+   }
+#elif defined(__SSE2__)
+   for(; idx + 4 <= _count; idx += 4)
+   {
+      __m128 velX = _mm_loadu_ps(&_velX[idx]);
+      __m128 velY = _mm_loadu_ps(&_velY[idx]);
+      __m128 dirX = _mm_loadu_ps(&_dirX[idx]);
+      __m128 dirY = _mm_loadu_ps(&_dirY[idx]);
+      __m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(velX,velX),_mm_mul_ps(velY,velY)));
+      speed = _mm_min_ps(speed,_mm_loadu_ps(&_maxSpeed[idx]));
+      __m128 thrust = _mm_mul_ps(_mm_loadu_ps(&_maxLinearAcceleration[idx]),_mm_loadu_ps(&_mass[idx]));
+      _mm_storeu_ps(&_newVelX[idx],_mm_mul_ps(speed,dirX));
+      _mm_storeu_ps(&_newVelY[idx],_mm_mul_ps(speed,dirY));
+      _mm_storeu_ps(&_forceX[idx],_mm_mul_ps(thrust,dirX));
+      _mm_storeu_ps(&_forceY[idx],_mm_mul_ps(thrust,dirY));
+   }
+#endif
+   for(; idx < _count; idx++)
+   {
+      float32 speed = Vec2(_velX[idx],_velY[idx]).Length();
+      if(speed >= _maxSpeed[idx])
+         speed = _maxSpeed[idx];
+      float32 thrust = _maxLinearAcceleration[idx] * _mass[idx];
+      _newVelX[idx] = speed*_dirX[idx];
+      _newVelY[idx] = speed*_dirY[idx];
+      _forceX[idx] = thrust*_dirX[idx];
+      _forceY[idx] = thrust*_dirY[idx];
+   }
+}
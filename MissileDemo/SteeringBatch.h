@@ -0,0 +1,157 @@
+/********************************************************************
+ * File   : SteeringBatch.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/9/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__SteeringBatch__
+#define __MissileDemo__SteeringBatch__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+
+/* This class runs the missile steering calculations
+ * (Missile::ApplyTurnTorque() and Missile::ApplyThrust())
+ * for a whole batch of bodies at once.
+ *
+ * The body state is copied into parallel arrays with
+ * SetBody(...), the kernels run over the arrays with
+ * SSE2/AVX (when the compiler targets them) and the
+ * results are read back and applied to the bodies:
+ *
+ * 1. SetCount(...), then SetBody(...) for each body.
+ * 2. CalculateTurnErrors(...).  GetTurnError(...) is the
+ *    error to feed the turn controller.
+ * 3. SetTurnOutput(...) with the turn controller output,
+ *    then CalculateTurnTorques().  GetTorque(...) is the
+ *    torque to apply.
+ * 4. CalculateThrust().  GetVelocity(...) and GetForce(...)
+ *    are the new linear velocity and the thrust force.
+ *
+ * The turn error needs atan2 twice and an angle wrap.
+ * That is most of the cost, so it comes in different
+ * accuracies:
+ *
+ * SA_EXACT   - atan2f(...) and MathUtilities::AdjustAngle(...).
+ *              Same results as a Missile.  Only the
+ *              torque and thrust kernels use SIMD.
+ * SA_FAST    - MathUtilities::Atan2Fast(...) and WrapAngle(...),
+ *              about 1e-5 rads.
+ * SA_FASTEST - MathUtilities::Atan2Fastest(...) and WrapAngle(...),
+ *              about 2e-3 rads.
+ *
+ * The torque and thrust kernels give the same results as
+ * a Missile in every mode.
+ */
+class SteeringBatch
+{
+public:
+   typedef enum
+   {
+      SA_EXACT,
+      SA_FAST,
+      SA_FASTEST,
+      SA_MAX
+   } ACCURACY_T;
+   
+private:
+   uint32 _count;
+   
+   // Body state (inputs).
+   vector<float32> _posX;
+   vector<float32> _posY;
+   vector<float32> _angle;
+   vector<float32> _velX;
+   vector<float32> _velY;
+   // The body x axis in world coordinates.
+   vector<float32> _dirX;
+   vector<float32> _dirY;
+   vector<float32> _inertia;
+   vector<float32> _mass;
+   vector<float32> _targetX;
+   vector<float32> _targetY;
+   vector<float32> _maxAngularAcceleration;
+   vector<float32> _maxLinearAcceleration;
+   vector<float32> _maxSpeed;
+   vector<double> _turnOutput;
+   
+   // Results.
+   vector<float32> _turnError;
+   vector<float32> _torque;
+   vector<float32> _newVelX;
+   vector<float32> _newVelY;
+   vector<float32> _forceX;
+   vector<float32> _forceY;
+   
+   void CalculateTurnErrorsExact();
+   void CalculateTurnErrorsScalar(uint32 start, ACCURACY_T accuracy);
+   uint32 CalculateTurnErrorsSIMD(ACCURACY_T accuracy);
+   
+public:
+   SteeringBatch();
+   
+   // The arrays only grow, so after the first few
+   // ticks this does not allocate.
+   void SetCount(uint32 count);
+   inline uint32 GetCount() const { return _count; }
+   
+   inline void SetBody(uint32 idx, const Body* body, const Vec2& targetPos,
+                       float32 maxAngularAcceleration, float32 maxLinearAcceleration, float32 maxSpeed)
+   {
+      const b2Transform& xf = body->GetTransform();
+      const Vec2& vel = body->GetLinearVelocity();
+      _posX[idx] = xf.p.x;
+      _posY[idx] = xf.p.y;
+      _angle[idx] = body->GetAngle();
+      _velX[idx] = vel.x;
+      _velY[idx] = vel.y;
+      // Same as body->GetWorldVector(Vec2(1.0,0.0)).
+      _dirX[idx] = xf.q.c;
+      _dirY[idx] = xf.q.s;
+      _inertia[idx] = body->GetInertia();
+      _mass[idx] = body->GetMass();
+      _targetX[idx] = targetPos.x;
+      _targetY[idx] = targetPos.y;
+      _maxAngularAcceleration[idx] = maxAngularAcceleration;
+      _maxLinearAcceleration[idx] = maxLinearAcceleration;
+      _maxSpeed[idx] = maxSpeed;
+   }
+   
+   inline void SetTurnOutput(uint32 idx, double output) { _turnOutput[idx] = output; }
+   
+   inline float32 GetTurnError(uint32 idx) const { return _turnError[idx]; }
+   inline float32 GetTorque(uint32 idx) const { return _torque[idx]; }
+   inline Vec2 GetVelocity(uint32 idx) const { return Vec2(_newVelX[idx],_newVelY[idx]); }
+   inline Vec2 GetForce(uint32 idx) const { return Vec2(_forceX[idx],_forceY[idx]); }
+   
+   // The kernels.
+   void CalculateTurnErrors(ACCURACY_T accuracy);
+   void CalculateTurnTorques();
+   void CalculateThrust();
+   
+   static const char* AccuracyString(ACCURACY_T accuracy);
+   static const char* GetSIMDName();
+};
+
+#endif /* defined(__MissileDemo__SteeringBatch__) */
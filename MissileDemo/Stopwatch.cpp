@@ -25,19 +25,184 @@
  */
 
 #include "Stopwatch.h"
+#include <cmath>
+#include <limits>
+
+#if defined(__APPLE__)
 #include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(STOPWATCH_NO_TSC)
+#define STOPWATCH_TSC
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+
+typedef struct
+{
+   bool useTSC;
+   double secondsPerTick;
+   const char* name;
+} CLOCK_T;
+
+#if defined(__APPLE__)
+static inline uint64 ReadClock()
+{
+   return mach_absolute_time();
+}
+
+static double ClockSecondsPerTick()
+{
+   mach_timebase_info_data_t timeBaseInfo;
+   mach_timebase_info(&timeBaseInfo);
+   return 1.0E-9 * timeBaseInfo.numer / timeBaseInfo.denom;
+}
 
+static const char* const CLOCK_NAME = "mach_absolute_time";
+#else
+static inline uint64 ReadClock()
+{
+   timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+static double ClockSecondsPerTick()
+{
+   return 1.0E-9;
+}
+
+static const char* const CLOCK_NAME = "clock_gettime";
+#endif
+
+#if defined(STOPWATCH_TSC)
+// The TSC only makes a good clock if it ticks at a constant
+// rate through power state changes (CPUID 0x80000007, EDX
+// bit 8).
+static bool HasInvariantTSC()
+{
+   unsigned int eax, ebx, ecx, edx;
+   if(!__get_cpuid(0x80000000,&eax,&ebx,&ecx,&edx) || eax < 0x80000007)
+      return false;
+   __get_cpuid(0x80000007,&eax,&ebx,&ecx,&edx);
+   return (edx & (1 << 8)) != 0;
+}
+
+// Reads the monotonic clock and the TSC at (close to) the
+// same moment: the TSC is read on both sides of the clock
+// read and the two are averaged.  A clock read that took
+// long (the first one, or one interrupted) would throw the
+// pairing off, so the tightest of a few tries is kept.
+static void ReadClockAndTSC(uint64& clock, uint64& tsc)
+{
+   uint64 bestSpan = numeric_limits<uint64>::max();
+   for(uint32 idx = 0; idx < 8; idx++)
+   {
+      uint64 before = __rdtsc();
+      uint64 now = ReadClock();
+      uint64 after = __rdtsc();
+      if(after - before < bestSpan)
+      {
+         bestSpan = after - before;
+         clock = now;
+         tsc = before + (after - before)/2;
+      }
+   }
+}
+
+// Counts TSC ticks over a few milliseconds of the monotonic
+// clock.  The error is about the cost of a clock read over
+// the calibration time (a few parts per million).
+static double CalibrateTSC(double clockSecondsPerTick)
+{
+   const double CALIBRATION_SECONDS = 0.01;
+   uint64 clockStart = 0;
+   uint64 tscStart = 0;
+   uint64 clockNow = 0;
+   uint64 tscNow = 0;
+   ReadClockAndTSC(clockStart,tscStart);
+   do
+   {
+      ReadClockAndTSC(clockNow,tscNow);
+   }
+   while((clockNow - clockStart)*clockSecondsPerTick < CALIBRATION_SECONDS);
+   return (clockNow - clockStart)*clockSecondsPerTick/(tscNow - tscStart);
+}
+#endif
+
+static CLOCK_T CreateClock()
+{
+   CLOCK_T clock;
+   clock.useTSC = false;
+   clock.secondsPerTick = ClockSecondsPerTick();
+   clock.name = CLOCK_NAME;
+#if defined(STOPWATCH_TSC)
+   if(HasInvariantTSC())
+   {
+      clock.secondsPerTick = CalibrateTSC(clock.secondsPerTick);
+      clock.useTSC = true;
+      clock.name = "rdtsc";
+   }
+#endif
+   return clock;
+}
+
+// Picked on first use, so every StopWatch (and anything
+// comparing ticks) agrees on what a tick is.
+static inline const CLOCK_T& GetClock()
+{
+   static const CLOCK_T clock = CreateClock();
+   return clock;
+}
+
+uint64 StopWatch::GetTicks()
+{
+#if defined(STOPWATCH_TSC)
+   if(GetClock().useTSC)
+   {
+      return __rdtsc();
+   }
+#endif
+   return ReadClock();
+}
+
+double StopWatch::TicksToSeconds(uint64 ticks)
+{
+   return ticks * GetClock().secondsPerTick;
+}
+
+double StopWatch::GetSecondsPerTick()
+{
+   return GetClock().secondsPerTick;
+}
+
+const char* StopWatch::GetClockName()
+{
+   return GetClock().name;
+}
+
+StopWatch::StopWatch() :
+   _start(0),
+   _stop(0),
+   _elapsed(0),
+   _lapStart(0)
+{
+   ResetLaps();
+}
 
 void StopWatch::Start()
 {
 	_stop = 0;
 	_elapsed = 0;
-	_start = mach_absolute_time();
+	_start = GetTicks();
+   _lapStart = _start;
 }
 
 void StopWatch::Stop()
 {
-	_stop = mach_absolute_time();
+	_stop = GetTicks();
    if(_start > 0)
    {
       if(_stop > _start)
@@ -63,19 +228,15 @@ void StopWatch::Continue()
 double StopWatch::GetSeconds()
 {
    double elapsedSeconds = 0.0;
-   uint64 elapsedTimeNano = 0;
    
 	if(_elapsed > 0)
 	{  // Stopped
-		mach_timebase_info_data_t timeBaseInfo;
-		mach_timebase_info(&timeBaseInfo);
-		elapsedTimeNano = _elapsed * timeBaseInfo.numer / timeBaseInfo.denom;
-		elapsedSeconds = elapsedTimeNano * 1.0E-9;
+		elapsedSeconds = TicksToSeconds(_elapsed);
 	}
 	else if(_start > 0)
 	{  // Running or Continued
-      uint64_t elapsedTemp;
-		uint64_t stopTemp = mach_absolute_time();
+      uint64 elapsedTemp;
+		uint64 stopTemp = GetTicks();
       if(stopTemp > _start)
       {
          elapsedTemp = stopTemp - _start;
@@ -84,10 +245,54 @@ double StopWatch::GetSeconds()
       {
          elapsedTemp = 0;
       }
-		mach_timebase_info_data_t timeBaseInfo;
-		mach_timebase_info(&timeBaseInfo);
-		elapsedTimeNano = elapsedTemp * timeBaseInfo.numer / timeBaseInfo.denom;
-		elapsedSeconds = elapsedTimeNano * 1.0E-9;
+		elapsedSeconds = TicksToSeconds(elapsedTemp);
 	}
    return elapsedSeconds;
 }
+
+void StopWatch::StartLap()
+{
+   _lapStart = GetTicks();
+}
+
+double StopWatch::Lap()
+{
+   uint64 now = GetTicks();
+   uint64 ticks = (now > _lapStart) ? now - _lapStart : 0;
+   _lapStart = now;
+   
+   _lapCount++;
+   _lapTotal += ticks;
+   if(ticks < _lapMin)
+      _lapMin = ticks;
+   if(ticks > _lapMax)
+      _lapMax = ticks;
+   double delta = ticks - _lapMean;
+   _lapMean += delta/_lapCount;
+   _lapM2 += delta*(ticks - _lapMean);
+   return TicksToSeconds(ticks);
+}
+
+void StopWatch::ResetLaps()
+{
+   _lapCount = 0;
+   _lapTotal = 0;
+   _lapMin = numeric_limits<uint64>::max();
+   _lapMax = 0;
+   _lapMean = 0;
+   _lapM2 = 0;
+}
+
+bool StopWatch::GetLapStats(LAP_STATS_T& stats) const
+{
+   if(_lapCount == 0)
+      return false;
+   double secondsPerTick = GetSecondsPerTick();
+   stats.count = _lapCount;
+   stats.total = _lapTotal*secondsPerTick;
+   stats.min = _lapMin*secondsPerTick;
+   stats.max = _lapMax*secondsPerTick;
+   stats.mean = _lapMean*secondsPerTick;
+   stats.stdDev = (_lapCount > 1) ? sqrt(_lapM2/(_lapCount-1))*secondsPerTick : 0.0;
+   return true;
+}
@@ -28,18 +28,76 @@
 
 #include "CommonSTL.h"
 
+/* Times things from whole frames down to short stretches
+ * of a hot loop.
+ *
+ * The clock is picked (and the tick to second conversion
+ * worked out) once, the first time any StopWatch uses it:
+ * - x86 with an invariant TSC: rdtsc, calibrated against the
+ *   monotonic clock.  Reading it is not a system call.
+ * - Apple: mach_absolute_time().
+ * - Anything else: clock_gettime(CLOCK_MONOTONIC).
+ *
+ * Lap() times the stretch since Start(), StartLap() or the
+ * last Lap() and adds it to the lap statistics, so a region
+ * that runs many times can be timed without keeping every
+ * sample:
+ *
+ *    watch.StartLap();
+ *    ...region...
+ *    watch.Lap();
+ */
 class StopWatch
 {
+public:
+   // All in seconds.
+   typedef struct
+   {
+      uint32 count;
+      double total;
+      double min;
+      double max;
+      double mean;
+      double stdDev;
+   } LAP_STATS_T;
+   
 private:
 	uint64 _start;
 	uint64 _stop;
 	uint64 _elapsed;
+   // Lap statistics, in ticks.  The mean and spread are
+   // kept with Welford's method.
+   uint64 _lapStart;
+   uint32 _lapCount;
+   uint64 _lapTotal;
+   uint64 _lapMin;
+   uint64 _lapMax;
+   double _lapMean;
+   double _lapM2;
 public:
+   StopWatch();
    void Start();
    void Stop();
    void Reset();
    void Continue();
    double GetSeconds();
+   
+   // Starts timing a lap without touching Start()/Stop().
+   void StartLap();
+   // Ends the current lap, starts the next one and returns
+   // the length of the lap just ended (seconds).
+   double Lap();
+   void ResetLaps();
+   // Returns false if there are no laps.
+   bool GetLapStats(LAP_STATS_T& stats) const;
+   
+   // The raw clock the StopWatch uses.  Ticks are only
+   // good for differences.
+   static uint64 GetTicks();
+   static double TicksToSeconds(uint64 ticks);
+   static double GetSecondsPerTick();
+   // "rdtsc", "mach_absolute_time" or "clock_gettime".
+   static const char* GetClockName();
 };
 
 
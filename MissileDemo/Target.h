@@ -0,0 +1,126 @@
+/********************************************************************
+ * File   : Target.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__Target__
+#define __MissileDemo__Target__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "Entity.h"
+
+/* Something for the missiles to intercept.
+ *
+ * The target is a kinematic body, so it flies the course
+ * it is given and nothing pushes it around.  It moves at
+ * a constant speed, optionally turning at a constant rate
+ * and/or weaving from side to side (a sine wave on the
+ * heading).
+ *
+ * The fixture is a sensor, so the missiles fly through
+ * it instead of bouncing off; whether a missile hit is
+ * decided by its minimum seek distance.
+ *
+ * Call Update() once per tick, before stepping the world.
+ */
+class Target : public Entity
+{
+private:
+   float32 _speed;
+   float32 _heading;
+   float32 _turnRate;
+   float32 _weaveAmplitude;
+   float32 _weavePeriod;
+   float32 _time;
+   
+   void UpdateVelocity()
+   {
+      float32 heading = _heading + _turnRate*_time;
+      if(_weavePeriod > 0)
+      {
+         heading += _weaveAmplitude*sinf(2*M_PI*_time/_weavePeriod);
+      }
+      GetBody()->SetLinearVelocity(_speed*Vec2(cosf(heading),sinf(heading)));
+   }
+   
+public:
+   Target(b2World& world, const Vec2& position, const Vec2& velocity) :
+      Entity(Entity::ET_TARGET,20),
+      _speed(0),
+      _heading(0),
+      _turnRate(0),
+      _weaveAmplitude(0),
+      _weavePeriod(0),
+      _time(0)
+   {
+      b2BodyDef bodyDef;
+      bodyDef.position = position;
+      bodyDef.type = b2_kinematicBody;
+      Body* body = world.CreateBody(&bodyDef);
+      assert(body != NULL);
+      
+      b2CircleShape circleShape;
+      circleShape.m_radius = GetSizeMeters()/2;
+      FixtureDef fixtureDef;
+      fixtureDef.shape = &circleShape;
+      fixtureDef.isSensor = true;
+      body->CreateFixture(&fixtureDef);
+      
+      Init(body);
+      SetVelocity(velocity);
+   }
+   
+   void SetVelocity(const Vec2& velocity)
+   {
+      _speed = velocity.Length();
+      _heading = atan2f(velocity.y,velocity.x);
+      UpdateVelocity();
+   }
+   
+   // Rads/s, + is CCW.
+   void SetTurnRate(float32 turnRate)
+   {
+      _turnRate = turnRate;
+   }
+   
+   // Swings the heading +/- amplitudeRads around the
+   // velocity direction every periodSeconds.  A period
+   // of 0 stops the weave.
+   void SetWeave(float32 amplitudeRads, float32 periodSeconds)
+   {
+      _weaveAmplitude = amplitudeRads;
+      _weavePeriod = periodSeconds;
+      UpdateVelocity();
+   }
+   
+   void Update()
+   {
+      _time += SECONDS_PER_TICK;
+      UpdateVelocity();
+   }
+};
+
+#endif /* defined(__MissileDemo__Target__) */
@@ -0,0 +1,139 @@
+/********************************************************************
+ * File   : TargetAssigner.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "TargetAssigner.h"
+
+void TargetAssigner::Assign(const Vec2* missiles, uint32 missileCount, const Vec2* targets, uint32 targetCount,
+                            vector<int32>& assignment, uint32 capacity)
+{
+   assignment.assign(missileCount,-1);
+   _targets.Build(targets,targetCount);
+   if(missileCount == 0 || targetCount == 0)
+   {
+      return;
+   }
+   uint32 evenShare = (missileCount + targetCount - 1)/targetCount;
+   if(capacity < evenShare)
+   {
+      capacity = evenShare;
+   }
+   
+   _load.assign(targetCount,0);
+   _unassigned.resize(missileCount);
+   for(uint32 idx = 0; idx < missileCount; idx++)
+   {
+      _unassigned[idx] = idx;
+   }
+   _open.resize(targetCount);
+   _openPositions.resize(targetCount);
+   for(uint32 tdx = 0; tdx < targetCount; tdx++)
+   {
+      _open[tdx] = tdx;
+      _openPositions[tdx] = targets[tdx];
+   }
+   
+   uint32 candidates = INITIAL_CANDIDATES;
+   while(!_unassigned.empty())
+   {
+      // The candidates are the nearest targets that
+      // still have room.
+      const uint32 count = _unassigned.size();
+      const uint32 open = _open.size();
+      const uint32 k = Min(candidates,open);
+      if(open < targetCount)
+      {
+         _openHash.Build(&_openPositions[0],open);
+      }
+      const SpatialHash& hash = (open < targetCount) ? _openHash : _targets;
+      _centers.resize(count);
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         _centers[idx] = missiles[_unassigned[idx]];
+      }
+      _neighbors.resize(count*k);
+      _found.resize(count);
+      hash.QueryNearest(&_centers[0],count,k,&_neighbors[0],&_found[0]);
+      
+      // The pairs, nearest first.
+      _candidates.clear();
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         const SpatialHash::NEIGHBOR_T* neighbors = &_neighbors[idx*k];
+         for(uint32 ndx = 0; ndx < _found[idx]; ndx++)
+         {
+            CANDIDATE_T candidate;
+            candidate.distanceSquared = neighbors[ndx].distanceSquared;
+            candidate.missile = _unassigned[idx];
+            candidate.target = _open[neighbors[ndx].index];
+            _candidates.push_back(candidate);
+         }
+      }
+      sort(_candidates.begin(),_candidates.end(),CandidateLess);
+      
+      // The nearest pair is always taken, so every
+      // round makes progress.
+      for(uint32 idx = 0; idx < _candidates.size(); idx++)
+      {
+         const CANDIDATE_T& candidate = _candidates[idx];
+         if(assignment[candidate.missile] < 0 && _load[candidate.target] < capacity)
+         {
+            assignment[candidate.missile] = candidate.target;
+            _load[candidate.target]++;
+         }
+      }
+      
+      // Whoever is left goes round again, with more
+      // candidates, against the targets with room.
+      uint32 left = 0;
+      for(uint32 idx = 0; idx < count; idx++)
+      {
+         if(assignment[_unassigned[idx]] < 0)
+         {
+            _unassigned[left++] = _unassigned[idx];
+         }
+      }
+      _unassigned.resize(left);
+      uint32 stillOpen = 0;
+      for(uint32 odx = 0; odx < open; odx++)
+      {
+         uint32 target = _open[odx];
+         if(_load[target] < capacity)
+         {
+            _open[stillOpen] = target;
+            _openPositions[stillOpen] = targets[target];
+            stillOpen++;
+         }
+      }
+      _open.resize(stillOpen);
+      _openPositions.resize(stillOpen);
+      assert(left == 0 || stillOpen > 0);
+      if(candidates < stillOpen)
+      {
+         candidates *= 2;
+      }
+   }
+}
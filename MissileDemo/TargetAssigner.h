@@ -0,0 +1,103 @@
+/********************************************************************
+ * File   : TargetAssigner.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/23/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__TargetAssigner__
+#define __MissileDemo__TargetAssigner__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "SpatialHash.h"
+
+/* Spreads missiles over targets.  Each missile gets a
+ * near target, and no target gets more than its share.
+ *
+ * The assignment is greedy.  The candidate pairs are the
+ * few nearest targets to each missile (from a SpatialHash
+ * of the targets), and they are taken nearest first as
+ * long as the missile has no target yet and the target
+ * has room.  Missiles whose candidates all filled up go
+ * round again against the targets that still have room,
+ * with twice as many candidates.
+ *
+ * This is not the best possible assignment (that is the
+ * Hungarian algorithm, O(n^3), which is far too slow for
+ * thousands of missiles), but the closest pairs always go
+ * first.  The cost is about O(n log n) instead of the
+ * O(missiles * targets) of checking every pair.
+ */
+class TargetAssigner
+{
+private:
+   typedef struct
+   {
+      float32 distanceSquared;
+      uint32 missile;
+      uint32 target;
+   } CANDIDATE_T;
+   
+   static inline bool CandidateLess(const CANDIDATE_T& left, const CANDIDATE_T& right)
+   {
+      if(left.distanceSquared != right.distanceSquared)
+         return left.distanceSquared < right.distanceSquared;
+      if(left.missile != right.missile)
+         return left.missile < right.missile;
+      return left.target < right.target;
+   }
+   
+   SpatialHash _targets;
+   // Scratch space for Assign(...).  The targets that
+   // still have room, and a hash of them.
+   vector<uint32> _open;
+   vector<Vec2> _openPositions;
+   SpatialHash _openHash;
+   vector<CANDIDATE_T> _candidates;
+   vector<SpatialHash::NEIGHBOR_T> _neighbors;
+   vector<uint32> _found;
+   vector<uint32> _load;
+   vector<uint32> _unassigned;
+   vector<Vec2> _centers;
+   
+public:
+   // Starting number of candidate targets per missile.
+   enum
+   {
+      INITIAL_CANDIDATES = 4
+   };
+   
+   // assignment[missile] is the index of the missile's
+   // target, or -1 if there are no targets.  Each target
+   // gets at most capacity missiles; 0 spreads them as
+   // evenly as possible.  Capacity is raised to the even
+   // share if it is too small for all the missiles.
+   void Assign(const Vec2* missiles, uint32 missileCount, const Vec2* targets, uint32 targetCount,
+               vector<int32>& assignment, uint32 capacity = 0);
+   
+   // The targets from the last Assign(...).
+   inline const SpatialHash& GetTargetHash() const { return _targets; }
+};
+
+#endif /* defined(__MissileDemo__TargetAssigner__) */
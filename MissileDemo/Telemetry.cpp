@@ -0,0 +1,85 @@
+/********************************************************************
+ * File   : Telemetry.cpp
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/18/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#include "Telemetry.h"
+
+Telemetry::Telemetry() :
+_mask(0),
+_recorded(0)
+{
+   
+}
+
+bool Telemetry::Init(uint32 capacity)
+{
+   assert(capacity > 0);
+   uint32 size = 1;
+   while(size < capacity)
+   {
+      size <<= 1;
+   }
+   _samples.assign(size,SAMPLE_T());
+   _mask = size-1;
+   _recorded = 0;
+   return true;
+}
+
+void Telemetry::Reset()
+{
+   _recorded = 0;
+}
+
+void Telemetry::Shutdown()
+{
+   vector<SAMPLE_T>().swap(_samples);
+   _mask = 0;
+   _recorded = 0;
+}
+
+bool Telemetry::GetLatest(SAMPLE_T& sample) const
+{
+   if(_recorded == 0 || _samples.empty())
+      return false;
+   sample = _samples[(_recorded-1) & _mask];
+   return true;
+}
+
+uint32 Telemetry::GetLatest(SAMPLE_T* samples, uint32 maxSamples) const
+{
+   assert(samples != NULL);
+   uint32 count = _recorded;
+   if(count > _samples.size())
+      count = _samples.size();
+   if(count > maxSamples)
+      count = maxSamples;
+   uint32 first = _recorded - count;
+   for(uint32 idx = 0; idx < count; idx++)
+   {
+      samples[idx] = _samples[(first+idx) & _mask];
+   }
+   return count;
+}
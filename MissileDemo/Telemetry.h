@@ -0,0 +1,113 @@
+/********************************************************************
+ * File   : Telemetry.h
+ * Project: MissileDemo
+ *
+ ********************************************************************
+ * Created on 11/18/13 By Nonlinear Ideas Inc.
+ * Copyright (c) 2013 Nonlinear Ideas Inc. All rights reserved.
+ ********************************************************************
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any
+ * damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any
+ * purpose, including commercial applications, and to alter it and
+ * redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must
+ *    not claim that you wrote the original software. If you use this
+ *    software in a product, an acknowledgment in the product
+ *    documentation would be appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and
+ *    must not be misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+
+
+#ifndef __MissileDemo__Telemetry__
+#define __MissileDemo__Telemetry__
+
+#include "CommonSTL.h"
+#include "CommonPhysics.h"
+#include "SingletonTemplate.h"
+
+class Entity;
+
+/* The Telemetry singleton is a ring buffer of numeric samples
+ * (speed, angle error, thrust) written by the entities every
+ * tick.
+ *
+ * The buffer is allocated in Init(...), so recording a sample
+ * is a few stores; there is no formatting, no allocation and no
+ * notification.  Anything that wants to show the values (e.g. the
+ * DebugMessageLayer) reads the latest samples at whatever rate it
+ * likes.  When the buffer is full, the oldest samples are
+ * overwritten.
+ *
+ * Like the Notifier, this is NOT thread safe.  The Simulation
+ * only records samples from its own thread (see
+ * MovingEntityIFace::UpdateNotifications()).
+ *
+ * Samples recorded before Init(...) or after Shutdown() are
+ * dropped.
+ */
+class Telemetry : public SingletonDynamic<Telemetry>
+{
+public:
+   typedef struct
+   {
+      const Entity* entity;
+      // Linear speed (m/s).
+      float32 speed;
+      // Turn controller input (rads).
+      float32 angleError;
+      // Magnitude of the thrust force (N).
+      float32 thrust;
+   } SAMPLE_T;
+   
+   enum
+   {
+      DEFAULT_CAPACITY = 256,
+   };
+   
+private:
+   vector<SAMPLE_T> _samples;
+   uint32 _mask;
+   // Total samples recorded since the last Reset().
+   uint32 _recorded;
+   
+public:
+   Telemetry();
+   
+   virtual bool Init() { return Init(DEFAULT_CAPACITY); }
+   // The capacity is rounded up to a power of 2.
+   bool Init(uint32 capacity);
+   virtual void Reset();
+   virtual void Shutdown();
+   
+   inline void Record(const Entity* entity, float32 speed, float32 angleError, float32 thrust)
+   {
+      if(_samples.empty())
+         return;
+      SAMPLE_T& sample = _samples[_recorded & _mask];
+      sample.entity = entity;
+      sample.speed = speed;
+      sample.angleError = angleError;
+      sample.thrust = thrust;
+      _recorded++;
+   }
+   
+   uint32 GetCapacity() const { return _samples.size(); }
+   // This keeps counting when old samples are overwritten,
+   // so it can be used to check for new samples.
+   uint32 GetRecordedCount() const { return _recorded; }
+   
+   // Returns false if there are no samples.
+   bool GetLatest(SAMPLE_T& sample) const;
+   // Copies up to maxSamples of the most recent samples into
+   // samples, oldest first.  Returns the number copied.
+   uint32 GetLatest(SAMPLE_T* samples, uint32 maxSamples) const;
+};
+
+#endif /* defined(__MissileDemo__Telemetry__) */
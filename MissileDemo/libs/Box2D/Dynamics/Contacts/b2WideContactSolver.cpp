@@ -0,0 +1,553 @@
+/*
+* Copyright (c) 2013 Nonlinear Ideas Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// b2_wideLanes floats, and the operations the solver needs. b2MinW and
+// b2MaxW pick the same operand as b2Min and b2Max (even for equal values
+// of different sign), and nothing is fused, so each lane gets exactly
+// the result the scalar solver would.
+#if defined(__AVX__)
+
+typedef __m256 b2FloatW;
+
+inline b2FloatW b2LoadW(const float32* p) { return _mm256_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a); }
+inline b2FloatW b2ZeroW() { return _mm256_setzero_ps(); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm256_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm256_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm256_mul_ps(a, b); }
+inline b2FloatW b2NegW(b2FloatW a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm256_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm256_max_ps(a, b); }
+// All ones where a >= b.
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm256_and_ps(a, b); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm256_or_ps(a, b); }
+// a where the mask is set, otherwise b.
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm256_blendv_ps(b, a, mask); }
+
+#elif defined(__SSE2__)
+
+typedef __m128 b2FloatW;
+
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2ZeroW() { return _mm_setzero_ps(); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2NegW(b2FloatW a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm_cmpge_ps(a, b); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm_and_ps(a, b); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm_or_ps(a, b); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+#else
+
+// Plain code for other CPUs. Masks are 1 (set) or 0.
+struct b2FloatW
+{
+    float32 v[b2_wideLanes];
+};
+
+inline b2FloatW b2LoadW(const float32* p) { b2FloatW r; memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void b2StoreW(float32* p, b2FloatW a) { memcpy(p, a.v, sizeof(a.v)); }
+inline b2FloatW b2ZeroW() { b2FloatW r; for (int32 i = 0; i < b2_wideLanes; ++i) r.v[i] = 0.0f; return r; }
+#define B2_WIDE_OP(name, expr) \
+    inline b2FloatW name(b2FloatW a, b2FloatW b) \
+    { \
+        b2FloatW r; \
+        for (int32 i = 0; i < b2_wideLanes; ++i) r.v[i] = (expr); \
+        return r; \
+    }
+B2_WIDE_OP(b2AddW, a.v[i] + b.v[i])
+B2_WIDE_OP(b2SubW, a.v[i] - b.v[i])
+B2_WIDE_OP(b2MulW, a.v[i] * b.v[i])
+B2_WIDE_OP(b2MinW, b2Min(a.v[i], b.v[i]))
+B2_WIDE_OP(b2MaxW, b2Max(a.v[i], b.v[i]))
+B2_WIDE_OP(b2GreaterEqualW, a.v[i] >= b.v[i] ? 1.0f : 0.0f)
+B2_WIDE_OP(b2AndW, (a.v[i] != 0.0f && b.v[i] != 0.0f) ? 1.0f : 0.0f)
+B2_WIDE_OP(b2OrW, (a.v[i] != 0.0f || b.v[i] != 0.0f) ? 1.0f : 0.0f)
+#undef B2_WIDE_OP
+inline b2FloatW b2NegW(b2FloatW a) { for (int32 i = 0; i < b2_wideLanes; ++i) a.v[i] = -a.v[i]; return a; }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+    for (int32 i = 0; i < b2_wideLanes; ++i) a.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+    return a;
+}
+
+#endif
+
+// b2_wideLanes contact velocity constraints, lane by lane.
+struct b2WideContactConstraint
+{
+    int32 indexA[b2_wideLanes];
+    int32 indexB[b2_wideLanes];
+    // Into the contact solver's constraints, -1 for an empty lane.
+    int32 constraintIndex[b2_wideLanes];
+    int32 pointCount;
+    float32 normalX[b2_wideLanes];
+    float32 normalY[b2_wideLanes];
+    float32 friction[b2_wideLanes];
+    float32 invMassA[b2_wideLanes];
+    float32 invIA[b2_wideLanes];
+    float32 invMassB[b2_wideLanes];
+    float32 invIB[b2_wideLanes];
+    float32 rAX[b2_maxManifoldPoints][b2_wideLanes];
+    float32 rAY[b2_maxManifoldPoints][b2_wideLanes];
+    float32 rBX[b2_maxManifoldPoints][b2_wideLanes];
+    float32 rBY[b2_maxManifoldPoints][b2_wideLanes];
+    float32 normalImpulse[b2_maxManifoldPoints][b2_wideLanes];
+    float32 tangentImpulse[b2_maxManifoldPoints][b2_wideLanes];
+    float32 normalMass[b2_maxManifoldPoints][b2_wideLanes];
+    float32 tangentMass[b2_maxManifoldPoints][b2_wideLanes];
+    float32 velocityBias[b2_maxManifoldPoints][b2_wideLanes];
+    // K and its inverse for the two point block solver, by row and column.
+    float32 K11[b2_wideLanes], K12[b2_wideLanes], K21[b2_wideLanes], K22[b2_wideLanes];
+    float32 blockMass11[b2_wideLanes], blockMass12[b2_wideLanes];
+    float32 blockMass21[b2_wideLanes], blockMass22[b2_wideLanes];
+};
+
+b2WideContactSolver::b2WideContactSolver(b2ContactSolver* solver, int32 bodyCount)
+{
+    m_solver = solver;
+    m_allocator = solver->m_allocator;
+    int32 count = solver->m_count;
+    const b2ContactVelocityConstraint* constraints = solver->m_velocityConstraints;
+
+    // Color the constraints greedily, in island order. Each body keeps a
+    // bit for each color it is used in.
+    m_colors = (int32*)m_allocator->Allocate(count * sizeof(int32));
+    uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+    memset(bodyColors, 0, bodyCount * sizeof(uint32));
+    int32 colorCounts[b2_wideColorCount][b2_maxManifoldPoints];
+    memset(colorCounts, 0, sizeof(colorCounts));
+    int32 overflowCount = 0;
+    for (int32 i = 0; i < count; ++i)
+    {
+        const b2ContactVelocityConstraint* vc = constraints + i;
+        bool movableA = vc->invMassA != 0.0f || vc->invIA != 0.0f;
+        bool movableB = vc->invMassB != 0.0f || vc->invIB != 0.0f;
+        uint32 used = 0;
+        if (movableA)
+        {
+            used |= bodyColors[vc->indexA];
+        }
+        if (movableB)
+        {
+            used |= bodyColors[vc->indexB];
+        }
+
+        int32 color = -1;
+        for (int32 c = 0; c < b2_wideColorCount; ++c)
+        {
+            if ((used & (1u << c)) == 0)
+            {
+                color = c;
+                break;
+            }
+        }
+        m_colors[i] = color;
+        if (color < 0)
+        {
+            ++overflowCount;
+            continue;
+        }
+
+        if (movableA)
+        {
+            bodyColors[vc->indexA] |= 1u << color;
+        }
+        if (movableB)
+        {
+            bodyColors[vc->indexB] |= 1u << color;
+        }
+        ++colorCounts[color][vc->pointCount - 1];
+    }
+    m_allocator->Free(bodyColors);
+
+    // The first batch for each color and point count.
+    int32 nextBatch[b2_wideColorCount][b2_maxManifoldPoints];
+    int32 nextLane[b2_wideColorCount][b2_maxManifoldPoints];
+    m_batchCount = 0;
+    for (int32 c = 0; c < b2_wideColorCount; ++c)
+    {
+        for (int32 p = 0; p < b2_maxManifoldPoints; ++p)
+        {
+            nextBatch[c][p] = m_batchCount;
+            nextLane[c][p] = 0;
+            m_batchCount += (colorCounts[c][p] + b2_wideLanes - 1) / b2_wideLanes;
+        }
+    }
+    int32 overflowBatch = m_batchCount;
+    m_batchCount += overflowCount;
+
+    // Empty lanes are all zeros, so they do nothing.
+    m_batches = (b2WideContactConstraint*)m_allocator->Allocate(m_batchCount * sizeof(b2WideContactConstraint));
+    memset(m_batches, 0, m_batchCount * sizeof(b2WideContactConstraint));
+    for (int32 i = 0; i < m_batchCount; ++i)
+    {
+        for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+        {
+            m_batches[i].constraintIndex[lane] = -1;
+        }
+    }
+
+    for (int32 i = 0; i < count; ++i)
+    {
+        const b2ContactVelocityConstraint* vc = constraints + i;
+        int32 color = m_colors[i];
+        b2WideContactConstraint* wc;
+        int32 lane;
+        if (color < 0)
+        {
+            wc = m_batches + overflowBatch;
+            ++overflowBatch;
+            lane = 0;
+        }
+        else
+        {
+            int32 p = vc->pointCount - 1;
+            wc = m_batches + nextBatch[color][p];
+            lane = nextLane[color][p];
+            if (++nextLane[color][p] == b2_wideLanes)
+            {
+                ++nextBatch[color][p];
+                nextLane[color][p] = 0;
+            }
+        }
+
+        wc->pointCount = vc->pointCount;
+        wc->indexA[lane] = vc->indexA;
+        wc->indexB[lane] = vc->indexB;
+        wc->constraintIndex[lane] = i;
+        wc->normalX[lane] = vc->normal.x;
+        wc->normalY[lane] = vc->normal.y;
+        wc->friction[lane] = vc->friction;
+        wc->invMassA[lane] = vc->invMassA;
+        wc->invIA[lane] = vc->invIA;
+        wc->invMassB[lane] = vc->invMassB;
+        wc->invIB[lane] = vc->invIB;
+        for (int32 j = 0; j < vc->pointCount; ++j)
+        {
+            const b2VelocityConstraintPoint* vcp = vc->points + j;
+            wc->rAX[j][lane] = vcp->rA.x;
+            wc->rAY[j][lane] = vcp->rA.y;
+            wc->rBX[j][lane] = vcp->rB.x;
+            wc->rBY[j][lane] = vcp->rB.y;
+            wc->normalImpulse[j][lane] = vcp->normalImpulse;
+            wc->tangentImpulse[j][lane] = vcp->tangentImpulse;
+            wc->normalMass[j][lane] = vcp->normalMass;
+            wc->tangentMass[j][lane] = vcp->tangentMass;
+            wc->velocityBias[j][lane] = vcp->velocityBias;
+        }
+        if (vc->pointCount == 2)
+        {
+            wc->K11[lane] = vc->K.ex.x;
+            wc->K12[lane] = vc->K.ey.x;
+            wc->K21[lane] = vc->K.ex.y;
+            wc->K22[lane] = vc->K.ey.y;
+            wc->blockMass11[lane] = vc->normalMass.ex.x;
+            wc->blockMass12[lane] = vc->normalMass.ey.x;
+            wc->blockMass21[lane] = vc->normalMass.ex.y;
+            wc->blockMass22[lane] = vc->normalMass.ey.y;
+        }
+    }
+}
+
+b2WideContactSolver::~b2WideContactSolver()
+{
+    m_allocator->Free(m_batches);
+    m_allocator->Free(m_colors);
+}
+
+// The velocities of the bodies in a batch.
+struct b2WideBodyVelocities
+{
+    b2FloatW vAX, vAY, wA;
+    b2FloatW vBX, vBY, wB;
+};
+
+// dv = vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA)
+inline void b2RelativeVelocityW(const b2WideBodyVelocities& v, b2FloatW rAX, b2FloatW rAY, b2FloatW rBX, b2FloatW rBY,
+                                b2FloatW& dvX, b2FloatW& dvY)
+{
+    dvX = b2SubW(b2SubW(b2AddW(v.vBX, b2MulW(b2NegW(v.wB), rBY)), v.vAX), b2MulW(b2NegW(v.wA), rAY));
+    dvY = b2SubW(b2SubW(b2AddW(v.vBY, b2MulW(v.wB, rBX)), v.vAY), b2MulW(v.wA, rAX));
+}
+
+// b2Cross(r, P)
+inline b2FloatW b2CrossW(b2FloatW rX, b2FloatW rY, b2FloatW pX, b2FloatW pY)
+{
+    return b2SubW(b2MulW(rX, pY), b2MulW(rY, pX));
+}
+
+static void b2SolveWideConstraint(b2WideContactConstraint* wc, b2Velocity* velocities)
+{
+    // Gather the velocities. Empty lanes get zeros.
+    float32 gathered[6][b2_wideLanes];
+    for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+    {
+        if (wc->constraintIndex[lane] < 0)
+        {
+            for (int32 k = 0; k < 6; ++k)
+            {
+                gathered[k][lane] = 0.0f;
+            }
+            continue;
+        }
+        const b2Velocity& velocityA = velocities[wc->indexA[lane]];
+        const b2Velocity& velocityB = velocities[wc->indexB[lane]];
+        gathered[0][lane] = velocityA.v.x;
+        gathered[1][lane] = velocityA.v.y;
+        gathered[2][lane] = velocityA.w;
+        gathered[3][lane] = velocityB.v.x;
+        gathered[4][lane] = velocityB.v.y;
+        gathered[5][lane] = velocityB.w;
+    }
+    b2WideBodyVelocities v;
+    v.vAX = b2LoadW(gathered[0]);
+    v.vAY = b2LoadW(gathered[1]);
+    v.wA = b2LoadW(gathered[2]);
+    v.vBX = b2LoadW(gathered[3]);
+    v.vBY = b2LoadW(gathered[4]);
+    v.wB = b2LoadW(gathered[5]);
+
+    b2FloatW mA = b2LoadW(wc->invMassA);
+    b2FloatW iA = b2LoadW(wc->invIA);
+    b2FloatW mB = b2LoadW(wc->invMassB);
+    b2FloatW iB = b2LoadW(wc->invIB);
+    b2FloatW normalX = b2LoadW(wc->normalX);
+    b2FloatW normalY = b2LoadW(wc->normalY);
+    // b2Cross(normal, 1.0f)
+    b2FloatW tangentX = normalY;
+    b2FloatW tangentY = b2NegW(normalX);
+    b2FloatW friction = b2LoadW(wc->friction);
+    b2FloatW zero = b2ZeroW();
+    int32 pointCount = wc->pointCount;
+
+    b2FloatW rAX[b2_maxManifoldPoints], rAY[b2_maxManifoldPoints];
+    b2FloatW rBX[b2_maxManifoldPoints], rBY[b2_maxManifoldPoints];
+    for (int32 j = 0; j < pointCount; ++j)
+    {
+        rAX[j] = b2LoadW(wc->rAX[j]);
+        rAY[j] = b2LoadW(wc->rAY[j]);
+        rBX[j] = b2LoadW(wc->rBX[j]);
+        rBY[j] = b2LoadW(wc->rBY[j]);
+    }
+
+    // Solve tangent constraints first because non-penetration is more important
+    // than friction.
+    for (int32 j = 0; j < pointCount; ++j)
+    {
+        b2FloatW dvX, dvY;
+        b2RelativeVelocityW(v, rAX[j], rAY[j], rBX[j], rBY[j], dvX, dvY);
+
+        b2FloatW vt = b2AddW(b2MulW(dvX, tangentX), b2MulW(dvY, tangentY));
+        b2FloatW lambda = b2MulW(b2LoadW(wc->tangentMass[j]), b2NegW(vt));
+
+        b2FloatW tangentImpulse = b2LoadW(wc->tangentImpulse[j]);
+        b2FloatW maxFriction = b2MulW(friction, b2LoadW(wc->normalImpulse[j]));
+        b2FloatW newImpulse = b2MaxW(b2NegW(maxFriction), b2MinW(b2AddW(tangentImpulse, lambda), maxFriction));
+        lambda = b2SubW(newImpulse, tangentImpulse);
+        b2StoreW(wc->tangentImpulse[j], newImpulse);
+
+        b2FloatW PX = b2MulW(lambda, tangentX);
+        b2FloatW PY = b2MulW(lambda, tangentY);
+
+        v.vAX = b2SubW(v.vAX, b2MulW(mA, PX));
+        v.vAY = b2SubW(v.vAY, b2MulW(mA, PY));
+        v.wA = b2SubW(v.wA, b2MulW(iA, b2CrossW(rAX[j], rAY[j], PX, PY)));
+
+        v.vBX = b2AddW(v.vBX, b2MulW(mB, PX));
+        v.vBY = b2AddW(v.vBY, b2MulW(mB, PY));
+        v.wB = b2AddW(v.wB, b2MulW(iB, b2CrossW(rBX[j], rBY[j], PX, PY)));
+    }
+
+    if (pointCount == 1)
+    {
+        b2FloatW dvX, dvY;
+        b2RelativeVelocityW(v, rAX[0], rAY[0], rBX[0], rBY[0], dvX, dvY);
+
+        b2FloatW vn = b2AddW(b2MulW(dvX, normalX), b2MulW(dvY, normalY));
+        b2FloatW lambda = b2MulW(b2NegW(b2LoadW(wc->normalMass[0])), b2SubW(vn, b2LoadW(wc->velocityBias[0])));
+
+        b2FloatW normalImpulse = b2LoadW(wc->normalImpulse[0]);
+        b2FloatW newImpulse = b2MaxW(b2AddW(normalImpulse, lambda), zero);
+        lambda = b2SubW(newImpulse, normalImpulse);
+        b2StoreW(wc->normalImpulse[0], newImpulse);
+
+        b2FloatW PX = b2MulW(lambda, normalX);
+        b2FloatW PY = b2MulW(lambda, normalY);
+
+        v.vAX = b2SubW(v.vAX, b2MulW(mA, PX));
+        v.vAY = b2SubW(v.vAY, b2MulW(mA, PY));
+        v.wA = b2SubW(v.wA, b2MulW(iA, b2CrossW(rAX[0], rAY[0], PX, PY)));
+
+        v.vBX = b2AddW(v.vBX, b2MulW(mB, PX));
+        v.vBY = b2AddW(v.vBY, b2MulW(mB, PY));
+        v.wB = b2AddW(v.wB, b2MulW(iB, b2CrossW(rBX[0], rBY[0], PX, PY)));
+    }
+    else
+    {
+        // The block solver, see b2ContactSolver::SolveVelocityConstraints. All
+        // four cases are worked out for every lane and the first that holds is
+        // used; lanes where none holds are left alone.
+        b2FloatW aX = b2LoadW(wc->normalImpulse[0]);
+        b2FloatW aY = b2LoadW(wc->normalImpulse[1]);
+
+        b2FloatW dv1X, dv1Y, dv2X, dv2Y;
+        b2RelativeVelocityW(v, rAX[0], rAY[0], rBX[0], rBY[0], dv1X, dv1Y);
+        b2RelativeVelocityW(v, rAX[1], rAY[1], rBX[1], rBY[1], dv2X, dv2Y);
+
+        b2FloatW vn1 = b2AddW(b2MulW(dv1X, normalX), b2MulW(dv1Y, normalY));
+        b2FloatW vn2 = b2AddW(b2MulW(dv2X, normalX), b2MulW(dv2Y, normalY));
+
+        b2FloatW K11 = b2LoadW(wc->K11);
+        b2FloatW K12 = b2LoadW(wc->K12);
+        b2FloatW K21 = b2LoadW(wc->K21);
+        b2FloatW K22 = b2LoadW(wc->K22);
+
+        // b = vn - velocityBias - K * a
+        b2FloatW bX = b2SubW(vn1, b2LoadW(wc->velocityBias[0]));
+        b2FloatW bY = b2SubW(vn2, b2LoadW(wc->velocityBias[1]));
+        bX = b2SubW(bX, b2AddW(b2MulW(K11, aX), b2MulW(K12, aY)));
+        bY = b2SubW(bY, b2AddW(b2MulW(K21, aX), b2MulW(K22, aY)));
+
+        // Case 1: vn = 0, x = - inv(K) * b
+        b2FloatW x1X = b2NegW(b2AddW(b2MulW(b2LoadW(wc->blockMass11), bX), b2MulW(b2LoadW(wc->blockMass12), bY)));
+        b2FloatW x1Y = b2NegW(b2AddW(b2MulW(b2LoadW(wc->blockMass21), bX), b2MulW(b2LoadW(wc->blockMass22), bY)));
+        b2FloatW case1 = b2AndW(b2GreaterEqualW(x1X, zero), b2GreaterEqualW(x1Y, zero));
+
+        // Case 2: vn1 = 0 and x2 = 0
+        b2FloatW x2X = b2MulW(b2NegW(b2LoadW(wc->normalMass[0])), bX);
+        b2FloatW case2vn2 = b2AddW(b2MulW(K21, x2X), bY);
+        b2FloatW case2 = b2AndW(b2GreaterEqualW(x2X, zero), b2GreaterEqualW(case2vn2, zero));
+
+        // Case 3: vn2 = 0 and x1 = 0
+        b2FloatW x3Y = b2MulW(b2NegW(b2LoadW(wc->normalMass[1])), bY);
+        b2FloatW case3vn1 = b2AddW(b2MulW(K12, x3Y), bX);
+        b2FloatW case3 = b2AndW(b2GreaterEqualW(x3Y, zero), b2GreaterEqualW(case3vn1, zero));
+
+        // Case 4: x1 = 0 and x2 = 0
+        b2FloatW case4 = b2AndW(b2GreaterEqualW(bX, zero), b2GreaterEqualW(bY, zero));
+
+        // The first case that holds wins.
+        b2FloatW xX = b2SelectW(case1, x1X, b2SelectW(case2, x2X, zero));
+        b2FloatW xY = b2SelectW(case1, x1Y, b2SelectW(case2, zero, b2SelectW(case3, x3Y, zero)));
+        b2FloatW solved = b2OrW(b2OrW(case1, case2), b2OrW(case3, case4));
+
+        // Incremental impulse
+        b2FloatW dX = b2SubW(xX, aX);
+        b2FloatW dY = b2SubW(xY, aY);
+
+        b2FloatW P1X = b2MulW(dX, normalX);
+        b2FloatW P1Y = b2MulW(dX, normalY);
+        b2FloatW P2X = b2MulW(dY, normalX);
+        b2FloatW P2Y = b2MulW(dY, normalY);
+
+        b2FloatW vAX = b2SubW(v.vAX, b2MulW(mA, b2AddW(P1X, P2X)));
+        b2FloatW vAY = b2SubW(v.vAY, b2MulW(mA, b2AddW(P1Y, P2Y)));
+        b2FloatW wA = b2SubW(v.wA, b2MulW(iA, b2AddW(b2CrossW(rAX[0], rAY[0], P1X, P1Y),
+                                                     b2CrossW(rAX[1], rAY[1], P2X, P2Y))));
+
+        b2FloatW vBX = b2AddW(v.vBX, b2MulW(mB, b2AddW(P1X, P2X)));
+        b2FloatW vBY = b2AddW(v.vBY, b2MulW(mB, b2AddW(P1Y, P2Y)));
+        b2FloatW wB = b2AddW(v.wB, b2MulW(iB, b2AddW(b2CrossW(rBX[0], rBY[0], P1X, P1Y),
+                                                     b2CrossW(rBX[1], rBY[1], P2X, P2Y))));
+
+        v.vAX = b2SelectW(solved, vAX, v.vAX);
+        v.vAY = b2SelectW(solved, vAY, v.vAY);
+        v.wA = b2SelectW(solved, wA, v.wA);
+        v.vBX = b2SelectW(solved, vBX, v.vBX);
+        v.vBY = b2SelectW(solved, vBY, v.vBY);
+        v.wB = b2SelectW(solved, wB, v.wB);
+
+        b2StoreW(wc->normalImpulse[0], b2SelectW(solved, xX, aX));
+        b2StoreW(wc->normalImpulse[1], b2SelectW(solved, xY, aY));
+    }
+
+    // Scatter the velocities. No body that can move is in two lanes; the
+    // others get back the velocity they had.
+    b2StoreW(gathered[0], v.vAX);
+    b2StoreW(gathered[1], v.vAY);
+    b2StoreW(gathered[2], v.wA);
+    b2StoreW(gathered[3], v.vBX);
+    b2StoreW(gathered[4], v.vBY);
+    b2StoreW(gathered[5], v.wB);
+    for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+    {
+        if (wc->constraintIndex[lane] < 0)
+        {
+            continue;
+        }
+        b2Velocity& velocityA = velocities[wc->indexA[lane]];
+        b2Velocity& velocityB = velocities[wc->indexB[lane]];
+        velocityA.v.Set(gathered[0][lane], gathered[1][lane]);
+        velocityA.w = gathered[2][lane];
+        velocityB.v.Set(gathered[3][lane], gathered[4][lane]);
+        velocityB.w = gathered[5][lane];
+    }
+}
+
+void b2WideContactSolver::SolveVelocityConstraints()
+{
+    b2Velocity* velocities = m_solver->m_velocities;
+    for (int32 i = 0; i < m_batchCount; ++i)
+    {
+        b2SolveWideConstraint(m_batches + i, velocities);
+    }
+}
+
+void b2WideContactSolver::StoreImpulses()
+{
+    b2ContactVelocityConstraint* constraints = m_solver->m_velocityConstraints;
+    for (int32 i = 0; i < m_batchCount; ++i)
+    {
+        const b2WideContactConstraint* wc = m_batches + i;
+        for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+        {
+            int32 index = wc->constraintIndex[lane];
+            if (index < 0)
+            {
+                continue;
+            }
+            b2ContactVelocityConstraint* vc = constraints + index;
+            for (int32 j = 0; j < vc->pointCount; ++j)
+            {
+                vc->points[j].normalImpulse = wc->normalImpulse[j][lane];
+                vc->points[j].tangentImpulse = wc->tangentImpulse[j][lane];
+            }
+        }
+    }
+}
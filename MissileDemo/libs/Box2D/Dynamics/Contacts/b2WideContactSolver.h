@@ -0,0 +1,80 @@
+/*
+* Copyright (c) 2013 Nonlinear Ideas Inc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WIDE_CONTACT_SOLVER_H
+#define B2_WIDE_CONTACT_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2ContactSolver;
+class b2StackAllocator;
+struct b2WideContactConstraint;
+
+/// The number of contacts solved at once: 8 with AVX, otherwise 4 (SSE2,
+/// or plain code on other CPUs).
+#if defined(__AVX__)
+const int32 b2_wideLanes = 8;
+#else
+const int32 b2_wideLanes = 4;
+#endif
+
+/// The most colors the contacts of an island are put in. Contacts that
+/// do not fit are solved one at a time after the others.
+const int32 b2_wideColorCount = 16;
+
+/// Solves the contact velocity constraints of a b2ContactSolver
+/// b2_wideLanes at a time.
+///
+/// The constraints are colored so that no two of the same color share a
+/// body that can move. Bodies with no mass and no inertia (static and
+/// kinematic bodies) can be shared, since the contacts never change their
+/// velocity. Each color is cut into batches of constraints with the same
+/// point count, stored lane by lane, and a batch is solved with the same
+/// math as b2ContactSolver::SolveVelocityConstraints, one lane per
+/// constraint.
+///
+/// The constraints are solved a color at a time instead of in island
+/// order, so the results are close to but not the same as the scalar
+/// solver's. They do not depend on anything but the island (not even on
+/// the number of lanes), so they are the same from run to run.
+/// This is an internal class.
+class b2WideContactSolver
+{
+public:
+    /// Call after the contact solver's velocity constraints are initialized
+    /// and warm started.
+    b2WideContactSolver(b2ContactSolver* solver, int32 bodyCount);
+    ~b2WideContactSolver();
+
+    void SolveVelocityConstraints();
+
+    /// Copy the impulses back to the contact solver's velocity constraints
+    /// (call before b2ContactSolver::StoreImpulses).
+    void StoreImpulses();
+
+private:
+    b2ContactSolver* m_solver;
+    b2StackAllocator* m_allocator;
+    // The color of each constraint (-1 if it did not fit).
+    int32* m_colors;
+    // The colored batches, then one batch per constraint that did not fit.
+    b2WideContactConstraint* m_batches;
+    int32 m_batchCount;
+};
+
+#endif
@@ -427,6 +427,10 @@ private:
 
     int32 m_islandIndex;
 
+    // Static bodies only: the first wave of islands this body
+    // is not in yet, when solving islands in parallel.
+    int32 m_islandWave;
+
     b2Transform m_xf;        // the body origin transform
     b2Sweep m_sweep;        // the swept motion for CCD
 
@@ -23,6 +23,7 @@
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
@@ -161,6 +162,7 @@ b2Island::b2Island(
 
     m_allocator = allocator;
     m_listener = listener;
+    m_impulses = NULL;
 
     m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
     m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity     * sizeof(b2Contact*));
@@ -257,14 +259,31 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
     // Solve velocity constraints
     timer.Reset();
-    for (int32 i = 0; i < step.velocityIterations; ++i)
+    if (step.contactSolverType == b2_wideContactSolver)
     {
-        for (int32 j = 0; j < m_jointCount; ++j)
+        b2WideContactSolver wideSolver(&contactSolver, m_bodyCount);
+        for (int32 i = 0; i < step.velocityIterations; ++i)
         {
-            m_joints[j]->SolveVelocityConstraints(solverData);
+            for (int32 j = 0; j < m_jointCount; ++j)
+            {
+                m_joints[j]->SolveVelocityConstraints(solverData);
+            }
+
+            wideSolver.SolveVelocityConstraints();
         }
+        wideSolver.StoreImpulses();
+    }
+    else
+    {
+        for (int32 i = 0; i < step.velocityIterations; ++i)
+        {
+            for (int32 j = 0; j < m_jointCount; ++j)
+            {
+                m_joints[j]->SolveVelocityConstraints(solverData);
+            }
 
-        contactSolver.SolveVelocityConstraints();
+            contactSolver.SolveVelocityConstraints();
+        }
     }
 
     // Store impulses for warm starting
@@ -515,7 +534,7 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 {
-    if (m_listener == NULL)
+    if (m_listener == NULL && m_impulses == NULL)
     {
         return;
     }
@@ -534,6 +553,12 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
             impulse.tangentImpulses[j] = vc->points[j].tangentImpulse;
         }
 
+        if (m_impulses != NULL)
+        {
+            m_impulses[i] = impulse;
+            continue;
+        }
+
         m_listener->PostSolve(c, &impulse);
     }
 }
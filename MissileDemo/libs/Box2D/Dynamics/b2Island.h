@@ -28,6 +28,7 @@ class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
@@ -74,6 +75,11 @@ public:
     b2StackAllocator* m_allocator;
     b2ContactListener* m_listener;
 
+    // If not NULL, Report saves the impulses here (one per contact)
+    // instead of calling the listener, so the world can report them
+    // in order after the islands solved in parallel are done.
+    b2ContactImpulse* m_impulses;
+
     b2Body** m_bodies;
     b2Contact** m_contacts;
     b2Joint** m_joints;
@@ -34,6 +34,13 @@ struct b2Profile
     float32 solveTOI;
 };
 
+/// How the contact velocity constraints are solved. See b2World::b2World.
+enum b2ContactSolverType
+{
+    b2_scalarContactSolver,
+    b2_wideContactSolver
+};
+
 /// This is an internal structure.
 struct b2TimeStep
 {
@@ -43,6 +50,7 @@ struct b2TimeStep
     int32 velocityIterations;
     int32 positionIterations;
     bool warmStarting;
+    b2ContactSolverType contactSolverType;
 };
 
 /// This is an internal structure.
@@ -34,7 +34,7 @@
 #include <Box2D/Common/b2Timer.h>
 #include <new>
 
-b2World::b2World(const b2Vec2& gravity)
+b2World::b2World(const b2Vec2& gravity, b2ContactSolverType contactSolver)
 {
     m_destructionListener = NULL;
     m_debugDraw = NULL;
@@ -60,6 +60,11 @@ b2World::b2World(const b2Vec2& gravity)
 
     m_contactManager.m_allocator = &m_blockAllocator;
 
+    m_workerAllocators = NULL;
+    m_workerAllocatorCount = 0;
+    m_taskExecutor = NULL;
+    m_contactSolverType = contactSolver;
+
     memset(&m_profile, 0, sizeof(b2Profile));
 }
 
@@ -82,6 +87,12 @@ b2World::~b2World()
 
         b = bNext;
     }
+
+    for (int32 i = 0; i < m_workerAllocatorCount; ++i)
+    {
+        m_workerAllocators[i].~b2StackAllocator();
+    }
+    b2Free(m_workerAllocators);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -99,6 +110,11 @@ void b2World::SetContactListener(b2ContactListener* listener)
     m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetTaskExecutor(b2TaskExecutor* executor)
+{
+    m_taskExecutor = executor;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
     m_debugDraw = debugDraw;
@@ -389,6 +405,143 @@ void b2World::Solve(const b2TimeStep& step)
     m_profile.solveVelocity = 0.0f;
     m_profile.solvePosition = 0.0f;
 
+    if (m_taskExecutor != NULL && m_taskExecutor->GetWorkerCount() > 1)
+    {
+        SolveIslandsParallel(step);
+    }
+    else
+    {
+        SolveIslands(step);
+    }
+
+    {
+        b2Timer timer;
+        // Synchronize fixtures, check for out of range bodies.
+        for (b2Body* b = m_bodyList; b; b = b->GetNext())
+        {
+            // If a body was not in an island then it did not move.
+            if ((b->m_flags & b2Body::e_islandFlag) == 0)
+            {
+                continue;
+            }
+
+            if (b->GetType() == b2_staticBody)
+            {
+                continue;
+            }
+
+            // Update fixtures (for broad-phase).
+            b->SynchronizeFixtures();
+        }
+
+        // Look for new contacts.
+        m_contactManager.FindNewContacts();
+        m_profile.broadphase = timer.GetMilliseconds();
+    }
+}
+
+// Add the bodies, contacts and joints connected to the seed to the island.
+void b2World::BuildIsland(b2Body* seed, b2Body** stack, int32 stackSize, b2Island* island)
+{
+    B2_NOT_USED(stackSize);
+    int32 stackCount = 0;
+    stack[stackCount++] = seed;
+    seed->m_flags |= b2Body::e_islandFlag;
+
+    // Perform a depth first search (DFS) on the constraint graph.
+    while (stackCount > 0)
+    {
+        // Grab the next body off the stack and add it to the island.
+        b2Body* b = stack[--stackCount];
+        b2Assert(b->IsActive() == true);
+        island->Add(b);
+
+        // Make sure the body is awake.
+        b->SetAwake(true);
+
+        // To keep islands as small as possible, we don't
+        // propagate islands across static bodies.
+        if (b->GetType() == b2_staticBody)
+        {
+            continue;
+        }
+
+        // Search all contacts connected to this body.
+        for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+        {
+            b2Contact* contact = ce->contact;
+
+            // Has this contact already been added to an island?
+            if (contact->m_flags & b2Contact::e_islandFlag)
+            {
+                continue;
+            }
+
+            // Is this contact solid and touching?
+            if (contact->IsEnabled() == false ||
+                contact->IsTouching() == false)
+            {
+                continue;
+            }
+
+            // Skip sensors.
+            bool sensorA = contact->m_fixtureA->m_isSensor;
+            bool sensorB = contact->m_fixtureB->m_isSensor;
+            if (sensorA || sensorB)
+            {
+                continue;
+            }
+
+            island->Add(contact);
+            contact->m_flags |= b2Contact::e_islandFlag;
+
+            b2Body* other = ce->other;
+
+            // Was the other body already added to this island?
+            if (other->m_flags & b2Body::e_islandFlag)
+            {
+                continue;
+            }
+
+            b2Assert(stackCount < stackSize);
+            stack[stackCount++] = other;
+            other->m_flags |= b2Body::e_islandFlag;
+        }
+
+        // Search all joints connect to this body.
+        for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+        {
+            if (je->joint->m_islandFlag == true)
+            {
+                continue;
+            }
+
+            b2Body* other = je->other;
+
+            // Don't simulate joints connected to inactive bodies.
+            if (other->IsActive() == false)
+            {
+                continue;
+            }
+
+            island->Add(je->joint);
+            je->joint->m_islandFlag = true;
+
+            if (other->m_flags & b2Body::e_islandFlag)
+            {
+                continue;
+            }
+
+            b2Assert(stackCount < stackSize);
+            stack[stackCount++] = other;
+            other->m_flags |= b2Body::e_islandFlag;
+        }
+    }
+}
+
+// Build and solve the islands one at a time.
+void b2World::SolveIslands(const b2TimeStep& step)
+{
     // Size the island for the worst case.
     b2Island island(m_bodyCount,
                     m_contactManager.m_contactCount,
@@ -433,143 +586,293 @@ void b2World::Solve(const b2TimeStep& step)
 
         // Reset island and stack.
         island.Clear();
-        int32 stackCount = 0;
-        stack[stackCount++] = seed;
-        seed->m_flags |= b2Body::e_islandFlag;
+        BuildIsland(seed, stack, stackSize, &island);
 
-        // Perform a depth first search (DFS) on the constraint graph.
-        while (stackCount > 0)
-        {
-            // Grab the next body off the stack and add it to the island.
-            b2Body* b = stack[--stackCount];
-            b2Assert(b->IsActive() == true);
-            island.Add(b);
-
-            // Make sure the body is awake.
-            b->SetAwake(true);
+        b2Profile profile;
+        island.Solve(&profile, step, m_gravity, m_allowSleep);
+        m_profile.solveInit += profile.solveInit;
+        m_profile.solveVelocity += profile.solveVelocity;
+        m_profile.solvePosition += profile.solvePosition;
 
-            // To keep islands as small as possible, we don't
-            // propagate islands across static bodies.
+        // Post solve cleanup.
+        for (int32 i = 0; i < island.m_bodyCount; ++i)
+        {
+            // Allow static bodies to participate in other islands.
+            b2Body* b = island.m_bodies[i];
             if (b->GetType() == b2_staticBody)
             {
-                continue;
+                b->m_flags &= ~b2Body::e_islandFlag;
             }
+        }
+    }
 
-            // Search all contacts connected to this body.
-            for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
-            {
-                b2Contact* contact = ce->contact;
-
-                // Has this contact already been added to an island?
-                if (contact->m_flags & b2Contact::e_islandFlag)
-                {
-                    continue;
-                }
-
-                // Is this contact solid and touching?
-                if (contact->IsEnabled() == false ||
-                    contact->IsTouching() == false)
-                {
-                    continue;
-                }
-
-                // Skip sensors.
-                bool sensorA = contact->m_fixtureA->m_isSensor;
-                bool sensorB = contact->m_fixtureB->m_isSensor;
-                if (sensorA || sensorB)
-                {
-                    continue;
-                }
+    m_stackAllocator.Free(stack);
+}
 
-                island.Add(contact);
-                contact->m_flags |= b2Contact::e_islandFlag;
+// Where an island is in the list of all of them.
+struct b2IslandRange
+{
+    int32 bodyStart, bodyCount;
+    int32 contactStart, contactCount;
+    int32 jointStart, jointCount;
+    int32 wave;
+};
 
-                b2Body* other = ce->other;
+struct b2IslandsTask
+{
+    b2World* world;
+    const b2TimeStep* step;
+    const b2Island* islands;
+    const b2IslandRange* ranges;
+    // The islands to solve, by index into ranges.
+    const int32* order;
+    b2Profile* profiles;
+    b2ContactImpulse* impulses;
+};
 
-                // Was the other body already added to this island?
-                if (other->m_flags & b2Body::e_islandFlag)
-                {
-                    continue;
-                }
+// Islands per task.
+const int32 b2_islandGrainSize = 16;
 
-                b2Assert(stackCount < stackSize);
-                stack[stackCount++] = other;
-                other->m_flags |= b2Body::e_islandFlag;
-            }
+// Build all the islands first, then solve them on the task executor.
+//
+// The islands are built in the same order as SolveIslands, back to back
+// in one list. Each island is then copied into its own b2Island on a
+// worker, with the worker's stack allocator, and solved just as it would
+// be on one thread. Nothing is shared between islands except static
+// bodies, which are read only but carry the island index of the island
+// using them. So the islands are put in waves, where no two islands in a
+// wave touch the same static body, and the waves are solved one after
+// the other.
+//
+// Sleeping is decided per island and only touches the bodies in it,
+// except for the static bodies: an island that falls asleep puts its
+// static bodies to sleep too, and the serial loop wakes them again when
+// it builds the next island with them. That is replayed in island order
+// once all the waves are done. The profile times and the contact listener
+// reports are also gathered per island and merged in island order.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+    int32 workerCount = m_taskExecutor->GetWorkerCount();
+    if (m_workerAllocatorCount < workerCount - 1)
+    {
+        for (int32 i = 0; i < m_workerAllocatorCount; ++i)
+        {
+            m_workerAllocators[i].~b2StackAllocator();
+        }
+        b2Free(m_workerAllocators);
+        m_workerAllocatorCount = workerCount - 1;
+        m_workerAllocators = (b2StackAllocator*)b2Alloc(m_workerAllocatorCount * sizeof(b2StackAllocator));
+        for (int32 i = 0; i < m_workerAllocatorCount; ++i)
+        {
+            new (m_workerAllocators + i) b2StackAllocator();
+        }
+    }
 
-            // Search all joints connect to this body.
-            for (b2JointEdge* je = b->m_jointList; je; je = je->next)
-            {
-                if (je->joint->m_islandFlag == true)
-                {
-                    continue;
-                }
+    // A static body can be in any number of islands, once for each
+    // contact or joint with it.
+    b2ContactListener* listener = m_contactManager.m_contactListener;
+    b2Island islands(m_bodyCount + m_contactManager.m_contactCount + m_jointCount,
+                     m_contactManager.m_contactCount,
+                     m_jointCount,
+                     &m_stackAllocator,
+                     NULL);
 
-                b2Body* other = je->other;
+    // Clear all the island flags.
+    for (b2Body* b = m_bodyList; b; b = b->m_next)
+    {
+        b->m_flags &= ~b2Body::e_islandFlag;
+        b->m_islandWave = 0;
+    }
+    for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+    {
+        c->m_flags &= ~b2Contact::e_islandFlag;
+    }
+    for (b2Joint* j = m_jointList; j; j = j->m_next)
+    {
+        j->m_islandFlag = false;
+    }
 
-                // Don't simulate joints connected to inactive bodies.
-                if (other->IsActive() == false)
-                {
-                    continue;
-                }
+    // Build all awake islands.
+    int32 stackSize = m_bodyCount;
+    b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+    b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+    int32 islandCount = 0;
+    int32 waveCount = 0;
+    for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+    {
+        if (seed->m_flags & b2Body::e_islandFlag)
+        {
+            continue;
+        }
 
-                island.Add(je->joint);
-                je->joint->m_islandFlag = true;
+        if (seed->IsAwake() == false || seed->IsActive() == false)
+        {
+            continue;
+        }
 
-                if (other->m_flags & b2Body::e_islandFlag)
-                {
-                    continue;
-                }
+        // The seed can be dynamic or kinematic.
+        if (seed->GetType() == b2_staticBody)
+        {
+            continue;
+        }
 
-                b2Assert(stackCount < stackSize);
-                stack[stackCount++] = other;
-                other->m_flags |= b2Body::e_islandFlag;
+        b2IslandRange* range = ranges + islandCount;
+        ++islandCount;
+        range->bodyStart = islands.m_bodyCount;
+        range->contactStart = islands.m_contactCount;
+        range->jointStart = islands.m_jointCount;
+        BuildIsland(seed, stack, stackSize, &islands);
+        range->bodyCount = islands.m_bodyCount - range->bodyStart;
+        range->contactCount = islands.m_contactCount - range->contactStart;
+        range->jointCount = islands.m_jointCount - range->jointStart;
+
+        // The first wave after all the others using its static bodies.
+        range->wave = 0;
+        for (int32 i = range->bodyStart; i < islands.m_bodyCount; ++i)
+        {
+            b2Body* b = islands.m_bodies[i];
+            if (b->GetType() == b2_staticBody)
+            {
+                range->wave = b2Max(range->wave, b->m_islandWave);
             }
         }
-
-        b2Profile profile;
-        island.Solve(&profile, step, m_gravity, m_allowSleep);
-        m_profile.solveInit += profile.solveInit;
-        m_profile.solveVelocity += profile.solveVelocity;
-        m_profile.solvePosition += profile.solvePosition;
-
-        // Post solve cleanup.
-        for (int32 i = 0; i < island.m_bodyCount; ++i)
+        for (int32 i = range->bodyStart; i < islands.m_bodyCount; ++i)
         {
             // Allow static bodies to participate in other islands.
-            b2Body* b = island.m_bodies[i];
+            b2Body* b = islands.m_bodies[i];
             if (b->GetType() == b2_staticBody)
             {
+                b->m_islandWave = range->wave + 1;
                 b->m_flags &= ~b2Body::e_islandFlag;
             }
         }
+        waveCount = b2Max(waveCount, range->wave + 1);
     }
 
-    m_stackAllocator.Free(stack);
+    // Sort the islands by wave, keeping the order within a wave.
+    int32* waveStarts = (int32*)m_stackAllocator.Allocate((waveCount + 1) * sizeof(int32));
+    int32* order = (int32*)m_stackAllocator.Allocate(islandCount * sizeof(int32));
+    for (int32 i = 0; i <= waveCount; ++i)
+    {
+        waveStarts[i] = 0;
+    }
+    for (int32 i = 0; i < islandCount; ++i)
+    {
+        ++waveStarts[ranges[i].wave + 1];
+    }
+    for (int32 i = 0; i < waveCount; ++i)
+    {
+        waveStarts[i + 1] += waveStarts[i];
+    }
+    for (int32 i = 0; i < islandCount; ++i)
+    {
+        order[waveStarts[ranges[i].wave]++] = i;
+    }
+    // The starts were moved to the ends; move them back.
+    for (int32 i = waveCount; i > 0; --i)
+    {
+        waveStarts[i] = waveStarts[i - 1];
+    }
+    waveStarts[0] = 0;
 
+    b2Profile* profiles = (b2Profile*)m_stackAllocator.Allocate(islandCount * sizeof(b2Profile));
+    b2ContactImpulse* impulses = NULL;
+    if (listener != NULL)
     {
-        b2Timer timer;
-        // Synchronize fixtures, check for out of range bodies.
-        for (b2Body* b = m_bodyList; b; b = b->GetNext())
-        {
-            // If a body was not in an island then it did not move.
-            if ((b->m_flags & b2Body::e_islandFlag) == 0)
-            {
-                continue;
-            }
+        impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(islands.m_contactCount * sizeof(b2ContactImpulse));
+    }
 
+    b2IslandsTask task;
+    task.world = this;
+    task.step = &step;
+    task.islands = &islands;
+    task.ranges = ranges;
+    task.profiles = profiles;
+    task.impulses = impulses;
+    for (int32 wave = 0; wave < waveCount; ++wave)
+    {
+        task.order = order + waveStarts[wave];
+        int32 count = waveStarts[wave + 1] - waveStarts[wave];
+        m_taskExecutor->ParallelFor(count, b2_islandGrainSize, SolveIslandsTask, &task);
+    }
+
+    // The static bodies end up awake or asleep with the last island (in
+    // island order) using them, just as in SolveIslands.
+    for (int32 i = 0; i < islandCount; ++i)
+    {
+        const b2IslandRange* range = ranges + i;
+        // The seed is never static.
+        bool awake = islands.m_bodies[range->bodyStart]->IsAwake();
+        for (int32 j = range->bodyStart; j < range->bodyStart + range->bodyCount; ++j)
+        {
+            b2Body* b = islands.m_bodies[j];
             if (b->GetType() == b2_staticBody)
             {
-                continue;
+                b->SetAwake(awake);
             }
+        }
+    }
 
-            // Update fixtures (for broad-phase).
-            b->SynchronizeFixtures();
+    for (int32 i = 0; i < islandCount; ++i)
+    {
+        m_profile.solveInit += profiles[i].solveInit;
+        m_profile.solveVelocity += profiles[i].solveVelocity;
+        m_profile.solvePosition += profiles[i].solvePosition;
+    }
+
+    if (listener != NULL)
+    {
+        for (int32 i = 0; i < islands.m_contactCount; ++i)
+        {
+            listener->PostSolve(islands.m_contacts[i], impulses + i);
         }
+        m_stackAllocator.Free(impulses);
+    }
 
-        // Look for new contacts.
-        m_contactManager.FindNewContacts();
-        m_profile.broadphase = timer.GetMilliseconds();
+    m_stackAllocator.Free(profiles);
+    m_stackAllocator.Free(order);
+    m_stackAllocator.Free(waveStarts);
+    m_stackAllocator.Free(ranges);
+    m_stackAllocator.Free(stack);
+}
+
+void b2World::SolveIslandsTask(void* context, int32 begin, int32 end, int32 worker)
+{
+    b2IslandsTask* task = (b2IslandsTask*)context;
+    b2World* world = task->world;
+    b2StackAllocator* allocator = &world->m_stackAllocator;
+    if (worker > 0)
+    {
+        b2Assert(worker <= world->m_workerAllocatorCount);
+        allocator = world->m_workerAllocators + worker - 1;
+    }
+
+    for (int32 k = begin; k < end; ++k)
+    {
+        int32 index = task->order[k];
+        const b2IslandRange* range = task->ranges + index;
+        b2Island island(range->bodyCount,
+                        range->contactCount,
+                        range->jointCount,
+                        allocator,
+                        world->m_contactManager.m_contactListener);
+        for (int32 i = 0; i < range->bodyCount; ++i)
+        {
+            island.Add(task->islands->m_bodies[range->bodyStart + i]);
+        }
+        for (int32 i = 0; i < range->contactCount; ++i)
+        {
+            island.Add(task->islands->m_contacts[range->contactStart + i]);
+        }
+        for (int32 i = 0; i < range->jointCount; ++i)
+        {
+            island.Add(task->islands->m_joints[range->jointStart + i]);
+        }
+        if (task->impulses != NULL)
+        {
+            island.m_impulses = task->impulses + range->contactStart;
+        }
+        island.Solve(task->profiles + index, *task->step, world->m_gravity, world->m_allowSleep);
     }
 }
 
@@ -860,6 +1163,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
         subStep.positionIterations = 20;
         subStep.velocityIterations = step.velocityIterations;
         subStep.warmStarting = false;
+        subStep.contactSolverType = b2_scalarContactSolver;
         island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
         // Reset island flags and synchronize broad-phase proxies.
@@ -923,6 +1227,7 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
     step.dtRatio = m_inv_dt0 * dt;
 
     step.warmStarting = m_warmStarting;
+    step.contactSolverType = m_contactSolverType;
     
     // Update contacts. This is where some contacts are destroyed.
     {
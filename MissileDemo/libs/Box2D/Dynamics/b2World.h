@@ -34,6 +34,7 @@ class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2Island;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -43,7 +44,12 @@ class b2World
 public:
     /// Construct a world object.
     /// @param gravity the world gravity vector.
-    b2World(const b2Vec2& gravity);
+    /// @param contactSolver how the contact velocity constraints are solved.
+    /// b2_wideContactSolver solves several contacts at once with SIMD (see
+    /// b2WideContactSolver); the results are close to, but not the same as,
+    /// the scalar solver's. Time of impact sub-steps always use the scalar
+    /// solver.
+    b2World(const b2Vec2& gravity, b2ContactSolverType contactSolver = b2_scalarContactSolver);
 
     /// Destruct the world. All physics entities are destroyed and all heap memory is released.
     ~b2World();
@@ -61,6 +67,23 @@ public:
     /// remain in scope.
     void SetContactListener(b2ContactListener* listener);
 
+    /// Register a task executor to solve the islands on worker threads.
+    /// The executor is owned by you and must remain in scope. With NULL
+    /// (the default) or a single worker the islands are solved one at a
+    /// time on the calling thread, as usual.
+    /// Islands are independent, so the results are the same for any
+    /// number of workers. Islands that touch the same static body are
+    /// solved one after the other. Contact listener PostSolve calls are
+    /// made on the calling thread, in the usual order, after all the
+    /// islands are solved.
+    void SetTaskExecutor(b2TaskExecutor* executor);
+
+    /// Get the task executor (may be NULL).
+    b2TaskExecutor* GetTaskExecutor() const;
+
+    /// Get the contact solver the world was constructed with.
+    b2ContactSolverType GetContactSolverType() const;
+
     /// Register a routine for debug drawing. The debug draw functions are called
     /// inside with b2World::DrawDebugData method. The debug draw object is owned
     /// by you and must remain in scope.
@@ -220,14 +243,27 @@ private:
     friend class b2Controller;
 
     void Solve(const b2TimeStep& step);
+    void SolveIslands(const b2TimeStep& step);
+    void SolveIslandsParallel(const b2TimeStep& step);
+    void BuildIsland(b2Body* seed, b2Body** stack, int32 stackSize, b2Island* island);
     void SolveTOI(const b2TimeStep& step);
 
+    static void SolveIslandsTask(void* context, int32 begin, int32 end, int32 worker);
+
     void DrawJoint(b2Joint* joint);
     void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
     b2BlockAllocator m_blockAllocator;
     b2StackAllocator m_stackAllocator;
 
+    // One per worker after the first (which uses m_stackAllocator).
+    b2StackAllocator* m_workerAllocators;
+    int32 m_workerAllocatorCount;
+
+    b2TaskExecutor* m_taskExecutor;
+
+    b2ContactSolverType m_contactSolverType;
+
     int32 m_flags;
 
     b2ContactManager m_contactManager;
@@ -258,6 +294,16 @@ private:
     b2Profile m_profile;
 };
 
+inline b2TaskExecutor* b2World::GetTaskExecutor() const
+{
+    return m_taskExecutor;
+}
+
+inline b2ContactSolverType b2World::GetContactSolverType() const
+{
+    return m_contactSolverType;
+}
+
 inline b2Body* b2World::GetBodyList()
 {
     return m_bodyList;
@@ -152,4 +152,25 @@ public:
                                     const b2Vec2& normal, float32 fraction) = 0;
 };
 
+/// Runs work for the world on worker threads.
+/// See b2World::SetTaskExecutor
+class b2TaskExecutor
+{
+public:
+    /// Called for the items [begin, end) on worker number worker.
+    typedef void (*b2TaskFunction)(void* context, int32 begin, int32 end, int32 worker);
+
+    virtual ~b2TaskExecutor() {}
+
+    /// The number of workers, including the calling thread. Worker
+    /// numbers go from 0 to this minus 1.
+    virtual int32 GetWorkerCount() const = 0;
+
+    /// Call task for all of the items [0, count), in ranges of about
+    /// grainSize items, and return when they are all done. Each range
+    /// must be run by one worker, and a worker must finish one range
+    /// before it starts another.
+    virtual void ParallelFor(int32 count, int32 grainSize, b2TaskFunction task, void* context) = 0;
+};
+
 #endif